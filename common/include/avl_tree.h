@@ -50,6 +50,11 @@ struct avl_tree {
     /* This should be a total order (<=) on tree nodes. If two elements compare equal, the newer
      * will be on the left (side of smaller elements) from the older one. */
     bool (*cmp)(struct avl_tree_node*, struct avl_tree_node*);
+    /* Optional (can be NULL). Used for augmented trees, where each node caches some data computed
+     * from its subtree (e.g. the maximum of some value): this function should recompute that data
+     * for the given node, assuming its children are already up to date. It is called on every node
+     * whose subtree changes on insertion, deletion and rebalancing. */
+    void (*update)(struct avl_tree_node*);
 };
 
 void avl_tree_insert(struct avl_tree* tree, struct avl_tree_node* node);
@@ -64,6 +69,13 @@ void avl_tree_delete(struct avl_tree* tree, struct avl_tree_node* node);
 void avl_tree_swap_node(struct avl_tree* tree, struct avl_tree_node* old_node,
                         struct avl_tree_node* new_node);
 
+/*
+ * Recomputes augmented data (see `avl_tree.update`) of `node` and all its ancestors. Should be
+ * called after modifying a node in place in a way that changes its augmented data, but not its
+ * position in the tree.
+ */
+void avl_tree_update(struct avl_tree* tree, struct avl_tree_node* node);
+
 /* These functions return respectively previous and next node or NULL if such does not exist.
  * O(log(n)) in worst case, but amortized O(1). */
 struct avl_tree_node* avl_tree_prev(struct avl_tree_node* node);
@@ -295,42 +295,17 @@ static inline int maybe_enlarge_slab_mgr(SLAB_MGR mgr, int level) {
     return 0;
 }
 
+// SYSTEM_LOCK needs to be held by the caller on entry. Returns NULL if out of memory.
 __attribute_no_sanitize_address
-static inline void* slab_alloc(SLAB_MGR mgr, size_t size) {
-    SLAB_OBJ mobj;
-    size_t level = -1;
-
-    for (size_t i = 0; i < SLAB_LEVEL; i++)
-        if (size <= slab_levels[i]) {
-            level = i;
-            break;
-        }
-
-    if (level == (size_t)-1) {
-        size = ALIGN_UP_POW2(size, MIN_MALLOC_ALIGNMENT);
-
-        LARGE_MEM_OBJ mem = (LARGE_MEM_OBJ)system_malloc(sizeof(LARGE_MEM_OBJ_TYPE) + size);
-        if (!mem)
-            return NULL;
-
-        mem->size = size;
-        OBJ_LEVEL(mem) = (unsigned char)-1;
-
-#ifdef ASAN
-        asan_unpoison_region((uintptr_t)OBJ_RAW(mem), size);
-#endif
-        return OBJ_RAW(mem);
-    }
-
-    SYSTEM_LOCK();
+static inline SLAB_OBJ __slab_get_obj(SLAB_MGR mgr, size_t level) {
+    assert(SYSTEM_LOCKED());
     assert(mgr->addr[level] <= mgr->addr_top[level]);
 
     int ret = maybe_enlarge_slab_mgr(mgr, level);
-    if (ret < 0) {
-        SYSTEM_UNLOCK();
+    if (ret < 0)
         return NULL;
-    }
 
+    SLAB_OBJ mobj;
     bool use_free_list;
 #ifdef ASAN
     /* With ASan enabled, prefer using new memory instead of recycling already freed objects, so
@@ -351,7 +326,42 @@ static inline void* slab_alloc(SLAB_MGR mgr, size_t size) {
     }
     assert(mgr->addr[level] <= mgr->addr_top[level]);
     OBJ_LEVEL(mobj) = level;
+    return mobj;
+}
+
+// Returns the level of objects of `size` bytes, or SLAB_LEVEL if they are too big for the slabs.
+static inline size_t slab_size_to_level(size_t size) {
+    for (size_t i = 0; i < SLAB_LEVEL; i++)
+        if (size <= slab_levels[i])
+            return i;
+    return SLAB_LEVEL;
+}
+
+__attribute_no_sanitize_address
+static inline void* slab_alloc(SLAB_MGR mgr, size_t size) {
+    size_t level = slab_size_to_level(size);
+
+    if (level == SLAB_LEVEL) {
+        size = ALIGN_UP_POW2(size, MIN_MALLOC_ALIGNMENT);
+
+        LARGE_MEM_OBJ mem = (LARGE_MEM_OBJ)system_malloc(sizeof(LARGE_MEM_OBJ_TYPE) + size);
+        if (!mem)
+            return NULL;
+
+        mem->size = size;
+        OBJ_LEVEL(mem) = (unsigned char)-1;
+
+#ifdef ASAN
+        asan_unpoison_region((uintptr_t)OBJ_RAW(mem), size);
+#endif
+        return OBJ_RAW(mem);
+    }
+
+    SYSTEM_LOCK();
+    SLAB_OBJ mobj = __slab_get_obj(mgr, level);
     SYSTEM_UNLOCK();
+    if (!mobj)
+        return NULL;
 
 #ifdef SLAB_CANARY
     unsigned long* m = (unsigned long*)((void*)OBJ_RAW(mobj) + slab_levels[level]);
@@ -364,6 +374,35 @@ static inline void* slab_alloc(SLAB_MGR mgr, size_t size) {
     return OBJ_RAW(mobj);
 }
 
+/*
+ * Allocates up to `cnt` objects of `level` at once (taking SYSTEM_LOCK only once) and stores them
+ * in `objs`. Returns the number of allocated objects, which is less than `cnt` only if out of
+ * memory. Together with slab_free_batch(), this is meant for per-thread caches of free objects on
+ * top of the slab manager; the objects are not unpoisoned for ASan.
+ */
+__attribute_no_sanitize_address
+static inline size_t slab_alloc_batch(SLAB_MGR mgr, size_t level, void** objs, size_t cnt) {
+    assert(level < SLAB_LEVEL);
+
+    size_t i;
+    SYSTEM_LOCK();
+    for (i = 0; i < cnt; i++) {
+        SLAB_OBJ mobj = __slab_get_obj(mgr, level);
+        if (!mobj)
+            break;
+        objs[i] = OBJ_RAW(mobj);
+    }
+    SYSTEM_UNLOCK();
+
+#ifdef SLAB_CANARY
+    for (size_t j = 0; j < i; j++) {
+        unsigned long* m = (unsigned long*)(objs[j] + slab_levels[level]);
+        *m = SLAB_CANARY_STRING;
+    }
+#endif
+    return i;
+}
+
 // Returns user buffer size (i.e. excluding size of control structures).
 __attribute_no_sanitize_address
 static inline size_t slab_get_buf_size(const void* ptr) {
@@ -390,6 +429,36 @@ static inline size_t slab_get_buf_size(const void* ptr) {
     return slab_levels[level];
 }
 
+/*
+ * Returns the level of `obj` (returned by slab_alloc()), or (unsigned char)-1 for large objects.
+ * Aborts if the header of the object is corrupted.
+ */
+__attribute_no_sanitize_address
+static inline unsigned char slab_get_obj_level(const void* obj) {
+    unsigned char level = RAW_TO_LEVEL(obj);
+    if (level == (unsigned char)-1)
+        return level;
+
+    /* If this happens, either the heap is already corrupted, or someone's
+     * freeing something that's wrong, which will most likely lead to heap
+     * corruption. Either way, panic if this happens. TODO: this doesn't allow
+     * us to detect cases where the heap headers have been zeroed, which
+     * is a common type of heap corruption. We could make this case slightly
+     * more likely to be detected by adding a non-zero offset to the level,
+     * so a level of 0 in the header would no longer be a valid level. */
+    if (level >= SLAB_LEVEL) {
+        log_always("Heap corruption detected: invalid heap level %d", level);
+        abort();
+    }
+
+#ifdef SLAB_CANARY
+    const unsigned long* m = (const unsigned long*)(obj + slab_levels[level]);
+    __UNUSED(m);
+    assert(*m == SLAB_CANARY_STRING);
+#endif
+    return level;
+}
+
 __attribute_no_sanitize_address
 static inline void slab_free(SLAB_MGR mgr, void* obj) {
     /* In a general purpose allocator, free of NULL is allowed (and is a
@@ -398,7 +467,7 @@ static inline void slab_free(SLAB_MGR mgr, void* obj) {
     if (!obj)
         return;
 
-    unsigned char level = RAW_TO_LEVEL(obj);
+    unsigned char level = slab_get_obj_level(obj);
 
     if (level == (unsigned char)-1) {
         LARGE_MEM_OBJ mem = RAW_TO_OBJ(obj, LARGE_MEM_OBJ_TYPE);
@@ -412,24 +481,6 @@ static inline void slab_free(SLAB_MGR mgr, void* obj) {
         return;
     }
 
-    /* If this happens, either the heap is already corrupted, or someone's
-     * freeing something that's wrong, which will most likely lead to heap
-     * corruption. Either way, panic if this happens. TODO: this doesn't allow
-     * us to detect cases where the heap headers have been zeroed, which
-     * is a common type of heap corruption. We could make this case slightly
-     * more likely to be detected by adding a non-zero offset to the level,
-     * so a level of 0 in the header would no longer be a valid level. */
-    if (level >= SLAB_LEVEL) {
-        log_always("Heap corruption detected: invalid heap level %d", level);
-        abort();
-    }
-
-#ifdef SLAB_CANARY
-    unsigned long* m = (unsigned long*)(obj + slab_levels[level]);
-    __UNUSED(m);
-    assert(*m == SLAB_CANARY_STRING);
-#endif
-
     SLAB_OBJ mobj = RAW_TO_OBJ(obj, SLAB_OBJ_TYPE);
 #ifdef DEBUG
     _real_memset(obj, 0xCC, slab_levels[level]);
@@ -443,3 +494,21 @@ static inline void slab_free(SLAB_MGR mgr, void* obj) {
     LISTP_ADD_TAIL(mobj, &mgr->free_list[level], __list);
     SYSTEM_UNLOCK();
 }
+
+/*
+ * Returns `cnt` free objects of `level` (checked with slab_get_obj_level() by the caller) to the
+ * slab manager at once, taking SYSTEM_LOCK only once. Counterpart of slab_alloc_batch().
+ */
+__attribute_no_sanitize_address
+static inline void slab_free_batch(SLAB_MGR mgr, size_t level, void* const* objs, size_t cnt) {
+    assert(level < SLAB_LEVEL);
+
+    SYSTEM_LOCK();
+    for (size_t i = 0; i < cnt; i++) {
+        assert(RAW_TO_LEVEL(objs[i]) == level);
+        SLAB_OBJ mobj = RAW_TO_OBJ(objs[i], SLAB_OBJ_TYPE);
+        INIT_LIST_HEAD(mobj, __list);
+        LISTP_ADD_TAIL(mobj, &mgr->free_list[level], __list);
+    }
+    SYSTEM_UNLOCK();
+}
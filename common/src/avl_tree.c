@@ -204,10 +204,33 @@ static void rot2LR(struct avl_tree_node* r, struct avl_tree_node* q, struct avl_
     r->balance = 0;
 }
 
+static void avl_tree_update_node(struct avl_tree* tree, struct avl_tree_node* node) {
+    if (tree->update) {
+        tree->update(node);
+    }
+}
+
+/* Calls `tree->update` on `node` and all its ancestors, bottom-up. */
+static void avl_tree_update_path(struct avl_tree* tree, struct avl_tree_node* node) {
+    if (!tree->update) {
+        return;
+    }
+
+    while (node) {
+        tree->update(node);
+        node = node->parent;
+    }
+}
+
 /* Does appropriate rotation of node, which mush have disturbed balance (i.e. +2/-2).
  * Returns whether height might have changed and sets `new_root_ptr` to root of this subtree after
- * rotation. */
-static bool avl_tree_do_balance(struct avl_tree_node* node, struct avl_tree_node** new_root_ptr) {
+ * rotation.
+ *
+ * The nodes moved down by the rotation get their augmented data recomputed here (bottom-up). The
+ * new root of the subtree is recomputed too, but it might still depend on a stale child: callers
+ * have to run `avl_tree_update_path` from the lowest modified node afterwards. */
+static bool avl_tree_do_balance(struct avl_tree* tree, struct avl_tree_node* node,
+                                struct avl_tree_node** new_root_ptr) {
     assert(node->balance == -2 || node->balance == 2);
 
     struct avl_tree_node* child = NULL;
@@ -219,11 +242,16 @@ static bool avl_tree_do_balance(struct avl_tree_node* node, struct avl_tree_node
             assert(child->right);
             *new_root_ptr = child->right;
             rot2LR(child->right, child, node);
+            avl_tree_update_node(tree, child);
+            avl_tree_update_node(tree, node);
+            avl_tree_update_node(tree, *new_root_ptr);
             return true;
         } else { // child->balance <= 0
             *new_root_ptr = child;
             ret = child->balance != 0;
             rot1R(child, node);
+            avl_tree_update_node(tree, node);
+            avl_tree_update_node(tree, child);
             return ret;
         }
     } else { // node->balance == 2
@@ -232,11 +260,16 @@ static bool avl_tree_do_balance(struct avl_tree_node* node, struct avl_tree_node
             *new_root_ptr = child;
             ret = child->balance != 0;
             rot1L(child, node);
+            avl_tree_update_node(tree, node);
+            avl_tree_update_node(tree, child);
             return ret;
         } else { // child->balance == -1
             assert(child->left);
             *new_root_ptr = child->left;
             rot2RL(child->left, child, node);
+            avl_tree_update_node(tree, child);
+            avl_tree_update_node(tree, node);
+            avl_tree_update_node(tree, *new_root_ptr);
             return true;
         }
     }
@@ -255,8 +288,8 @@ enum side {
  *
  * Returns the root of the subtree that balancing stopped at.
  */
-static struct avl_tree_node* avl_tree_balance(struct avl_tree_node* node, enum side side,
-                                              bool height_increased) {
+static struct avl_tree_node* avl_tree_balance(struct avl_tree* tree, struct avl_tree_node* node,
+                                              enum side side, bool height_increased) {
     assert(node);
 
     while (1) {
@@ -283,7 +316,7 @@ static struct avl_tree_node* avl_tree_balance(struct avl_tree_node* node, enum s
 
         assert(-2 <= node->balance && node->balance <= 2);
         if (node->balance == -2 || node->balance == 2) {
-            height_changed = avl_tree_do_balance(node, &node);
+            height_changed = avl_tree_do_balance(tree, node, &node);
             /* On inserting height never changes. */
             height_changed = height_increased ? false : height_changed;
         }
@@ -309,6 +342,7 @@ void avl_tree_insert(struct avl_tree* tree, struct avl_tree_node* node) {
     /* Inserting into an empty tree. */
     if (!tree->root) {
         tree->root = node;
+        avl_tree_update_node(tree, node);
         return;
     }
 
@@ -319,15 +353,17 @@ void avl_tree_insert(struct avl_tree* tree, struct avl_tree_node* node) {
     struct avl_tree_node* new_root;
 
     if (node->parent->left == node) {
-        new_root = avl_tree_balance(node->parent, LEFT, /*height_increased=*/true);
+        new_root = avl_tree_balance(tree, node->parent, LEFT, /*height_increased=*/true);
     } else {
         assert(node->parent->right == node);
-        new_root = avl_tree_balance(node->parent, RIGHT, /*height_increased=*/true);
+        new_root = avl_tree_balance(tree, node->parent, RIGHT, /*height_increased=*/true);
     }
 
     if (!new_root->parent) {
         tree->root = new_root;
     }
+
+    avl_tree_update_path(tree, node);
 }
 
 void avl_tree_swap_node(struct avl_tree* tree, struct avl_tree_node* old_node,
@@ -352,6 +388,8 @@ void avl_tree_swap_node(struct avl_tree* tree, struct avl_tree_node* old_node,
     if (tree->root == old_node) {
         tree->root = new_node;
     }
+
+    avl_tree_update_path(tree, new_node);
 }
 
 struct avl_tree_node* avl_tree_prev(struct avl_tree_node* node) {
@@ -481,12 +519,19 @@ void avl_tree_delete(struct avl_tree* tree, struct avl_tree_node* node) {
 
     /* After removal the tree might need balancing. */
     if (node->parent) {
-        new_root = avl_tree_balance(node->parent, side, /*height_increased=*/false);
+        new_root = avl_tree_balance(tree, node->parent, side, /*height_increased=*/false);
     }
 
     if ((new_root && !new_root->parent) || !node->parent) {
         tree->root = new_root;
     }
+
+    /* `node->parent` is still in the tree and is the lowest node whose subtree changed. */
+    avl_tree_update_path(tree, node->parent);
+}
+
+void avl_tree_update(struct avl_tree* tree, struct avl_tree_node* node) {
+    avl_tree_update_path(tree, node);
 }
 
 static struct avl_tree_node* avl_tree_find_fn_to(struct avl_tree* tree,
@@ -13,6 +13,7 @@
 /* Host callbacks */
 static pf_read_f     g_cb_read     = NULL;
 static pf_write_f    g_cb_write    = NULL;
+static pf_write_batch_f g_cb_write_batch = NULL;
 static pf_fsync_f    g_cb_fsync    = NULL;
 static pf_truncate_f g_cb_truncate = NULL;
 static pf_debug_f    g_cb_debug    = NULL;
@@ -198,21 +199,54 @@ static void ipf_init_root_mht(file_node_t* mht) {
     mht->need_writing         = false;
 }
 
+// Collects all dirty data and MHT nodes from the cache (in the LRU order) into a newly allocated
+// array. The array has one spare slot at the end (for the root MHT node, which is not in the cache).
+static file_node_t** ipf_get_dirty_nodes(pf_context_t* pf, size_t* out_count) {
+    size_t count = 0;
+    for (void* node = lruc_get_first(pf->cache); node != NULL; node = lruc_get_next(pf->cache)) {
+        if (((file_node_t*)node)->need_writing)
+            count++;
+    }
+
+    file_node_t** nodes = malloc((count + 1) * sizeof(*nodes));
+    if (!nodes) {
+        pf->last_error = PF_STATUS_NO_MEMORY;
+        return NULL;
+    }
+
+    size_t idx = 0;
+    for (void* node = lruc_get_first(pf->cache); node != NULL; node = lruc_get_next(pf->cache)) {
+        if (((file_node_t*)node)->need_writing)
+            nodes[idx++] = (file_node_t*)node;
+    }
+    assert(idx == count);
+
+    *out_count = count;
+    return nodes;
+}
+
 static bool ipf_update_all_data_and_mht_nodes(pf_context_t* pf) {
     bool ret = false;
-    file_node_t** mht_array = NULL;
     pf_status_t status;
 
+    size_t dirty_count;
+    file_node_t** dirty_nodes = ipf_get_dirty_nodes(pf, &dirty_count);
+    if (!dirty_nodes)
+        return false;
+
     // 1. encrypt the changed data nodes
     // 2. set the key + MAC in the parent MHT nodes
     // 3. set the need_writing flag for all the parent MHT nodes
-    for (void* node = lruc_get_first(pf->cache); node != NULL; node = lruc_get_next(pf->cache)) {
-        if (((file_node_t*)node)->type != FILE_DATA_NODE_TYPE)
-            continue;
-
-        file_node_t* data_node = (file_node_t*)node;
-        if (!data_node->need_writing)
+    //
+    // Data nodes are independent of each other, so they are all encrypted in one pass; the dirty
+    // MHT nodes are moved to the beginning of the array on the way (`mht_count <= idx` always).
+    size_t mht_count = 0;
+    for (size_t idx = 0; idx < dirty_count; idx++) {
+        file_node_t* data_node = dirty_nodes[idx];
+        if (data_node->type != FILE_DATA_NODE_TYPE) {
+            dirty_nodes[mht_count++] = data_node;
             continue;
+        }
 
         gcm_crypto_data_t* gcm_crypto_data = &data_node->parent->decrypted.mht
             .data_nodes_crypto[data_node->logical_node_number % ATTACHED_DATA_NODES_COUNT];
@@ -238,38 +272,12 @@ static bool ipf_update_all_data_and_mht_nodes(pf_context_t* pf) {
 #endif
     }
 
-    // count dirty MHT nodes
-    size_t dirty_count = 0;
-    for (void* node = lruc_get_first(pf->cache); node != NULL; node = lruc_get_next(pf->cache)) {
-        if (((file_node_t*)node)->type == FILE_MHT_NODE_TYPE) {
-            if (((file_node_t*)node)->need_writing)
-                dirty_count++;
-        }
-    }
-
-    // add all the MHT nodes that needs writing to a list
-    mht_array = malloc(dirty_count * sizeof(*mht_array));
-    if (!mht_array) {
-        pf->last_error = PF_STATUS_NO_MEMORY;
-        goto out;
-    }
-
-    uint64_t dirty_idx = 0;
-    for (void* node = lruc_get_first(pf->cache); node != NULL; node = lruc_get_next(pf->cache)) {
-        if (((file_node_t*)node)->type == FILE_MHT_NODE_TYPE) {
-            file_node_t* file_mht_node = (file_node_t*)node;
-
-            if (file_mht_node->need_writing)
-                mht_array[dirty_idx++] = file_mht_node;
-        }
-    }
-
-    if (dirty_count > 0)
-        sort_nodes(mht_array, 0, dirty_count - 1);
+    if (mht_count > 0)
+        sort_nodes(dirty_nodes, 0, mht_count - 1);
 
     // update the keys and MACs in the parents from last node to first (bottom layers first)
-    for (dirty_idx = dirty_count; dirty_idx > 0; dirty_idx--) {
-        file_node_t* file_mht_node = mht_array[dirty_idx - 1];
+    for (size_t idx = mht_count; idx > 0; idx--) {
+        file_node_t* file_mht_node = dirty_nodes[idx - 1];
 
         gcm_crypto_data_t* gcm_crypto_data =
             &file_mht_node->parent->decrypted.mht
@@ -304,7 +312,7 @@ static bool ipf_update_all_data_and_mht_nodes(pf_context_t* pf) {
     ret = true;
 
 out:
-    free(mht_array);
+    free(dirty_nodes);
     return ret;
 }
 
@@ -376,29 +384,138 @@ static void get_node_numbers(uint64_t offset, uint64_t* logical_mht_node_number,
         *physical_data_node_number = _physical_data_node_number;
 }
 
-static bool ipf_write_all_changes_to_disk(pf_context_t* pf) {
-    if (pf->metadata_decrypted.file_size > MD_USER_DATA_SIZE && pf->root_mht_node.need_writing) {
-        uint64_t physical_node_number;
+// maximum number of writes passed to the write-batch callback at once
+#define MAX_WRITES_IN_BATCH 32
+// maximum number of physically contiguous nodes coalesced into one write
+#define MAX_NODES_IN_WRITE 16
 
-        void* node;
-        for (node = lruc_get_first(pf->cache); node != NULL; node = lruc_get_next(pf->cache)) {
-            file_node_t* file_node = (file_node_t*)node;
-            if (!file_node->need_writing)
-                continue;
+static bool ipf_write_nodes(pf_context_t* pf, const void* const* buffers, const uint64_t* offsets,
+                            const size_t* sizes, size_t count) {
+    pf_status_t status = PF_STATUS_SUCCESS;
+
+    if (g_cb_write_batch) {
+        status = g_cb_write_batch(pf->host_file_handle, buffers, offsets, sizes, count);
+    } else {
+        for (size_t i = 0; i < count && PF_SUCCESS(status); i++)
+            status = g_cb_write(pf->host_file_handle, buffers[i], offsets[i], sizes[i]);
+    }
+
+    if (PF_FAILURE(status)) {
+        pf->last_error = status;
+        return false;
+    }
+
+    return true;
+}
 
-            uint8_t* data_to_write = (uint8_t*)&file_node->encrypted;
-            physical_node_number = file_node->physical_node_number;
+static void sift_down_by_physical_number(file_node_t** nodes, size_t root, size_t count) {
+    while (2 * root + 1 < count) {
+        size_t child = 2 * root + 1;
+        if (child + 1 < count
+                && nodes[child + 1]->physical_node_number > nodes[child]->physical_node_number)
+            child++;
+        if (nodes[root]->physical_node_number >= nodes[child]->physical_node_number)
+            return;
+        swap_nodes(nodes, root, child);
+        root = child;
+    }
+}
+
+// heapsort: the number of dirty nodes is bounded only by the (configurable) cache size
+static void sort_nodes_by_physical_number(file_node_t** nodes, size_t count) {
+    for (size_t i = count / 2; i > 0; i--)
+        sift_down_by_physical_number(nodes, i - 1, count);
+    for (size_t end = count; end > 1; end--) {
+        swap_nodes(nodes, 0, end - 1);
+        sift_down_by_physical_number(nodes, 0, end - 1);
+    }
+}
 
-            if (!ipf_write_node(pf, physical_node_number, data_to_write))
-                return false;
+// Returns the number of physically contiguous nodes starting at `nodes[i]`, at most
+// MAX_NODES_IN_WRITE.
+static size_t get_contiguous_run(file_node_t** nodes, size_t i, size_t count) {
+    size_t run = 1;
+    while (i + run < count && run < MAX_NODES_IN_WRITE
+            && nodes[i + run]->physical_node_number == nodes[i]->physical_node_number + run)
+        run++;
+    return run;
+}
 
-            file_node->need_writing = false;
+// Writes all dirty data and MHT nodes and the root MHT node. Data and MHT nodes may be written in
+// any order, they only become visible once the metadata node (written last, separately) is updated.
+// Thus the nodes are sorted by their position in the file, and runs of physically contiguous nodes
+// (e.g. after a sequential write) are coalesced into single writes through a staging buffer. The
+// writes are issued in batches of MAX_WRITES_IN_BATCH, so the staging buffer is reused between
+// batches and never holds more than one batch.
+static bool ipf_write_all_data_and_mht_nodes(pf_context_t* pf) {
+    bool ret = false;
+    const void* buffers[MAX_WRITES_IN_BATCH];
+    uint64_t offsets[MAX_WRITES_IN_BATCH];
+    size_t sizes[MAX_WRITES_IN_BATCH];
+    uint8_t* staging = NULL;
+
+    size_t count;
+    file_node_t** nodes = ipf_get_dirty_nodes(pf, &count);
+    if (!nodes)
+        return false;
+    nodes[count++] = &pf->root_mht_node;
+    sort_nodes_by_physical_number(nodes, count);
+
+    // only nodes in runs of two or more go through the staging buffer
+    size_t staged_cnt = 0;
+    for (size_t i = 0; i < count;) {
+        size_t run = get_contiguous_run(nodes, i, count);
+        if (run > 1)
+            staged_cnt += run;
+        i += run;
+    }
+    staged_cnt = MIN(staged_cnt, (size_t)MAX_WRITES_IN_BATCH * MAX_NODES_IN_WRITE);
+    if (staged_cnt) {
+        staging = malloc(staged_cnt * PF_NODE_SIZE);
+        // coalescing is only an optimization, write the nodes one by one if out of memory
+    }
+
+    size_t writes_cnt = 0;
+    size_t staging_used = 0;
+    for (size_t i = 0; i < count;) {
+        size_t run = staging ? get_contiguous_run(nodes, i, count) : 1;
+
+        offsets[writes_cnt] = nodes[i]->physical_node_number * PF_NODE_SIZE;
+        sizes[writes_cnt]   = run * PF_NODE_SIZE;
+        if (run == 1) {
+            buffers[writes_cnt] = &nodes[i]->encrypted;
+        } else {
+            buffers[writes_cnt] = staging + staging_used;
+            for (size_t j = 0; j < run; j++) {
+                memcpy(staging + staging_used, &nodes[i + j]->encrypted, PF_NODE_SIZE);
+                staging_used += PF_NODE_SIZE;
+            }
+        }
+        writes_cnt++;
+        i += run;
+
+        if (writes_cnt == MAX_WRITES_IN_BATCH || i == count) {
+            if (!ipf_write_nodes(pf, buffers, offsets, sizes, writes_cnt))
+                goto out;
+            writes_cnt = 0;
+            staging_used = 0;
         }
+    }
 
-        if (!ipf_write_node(pf, /*physical_node_number=*/1, &pf->root_mht_node.encrypted))
-            return false;
+    for (size_t i = 0; i < count; i++)
+        nodes[i]->need_writing = false;
+
+    ret = true;
+out:
+    free(staging);
+    free(nodes);
+    return ret;
+}
 
-        pf->root_mht_node.need_writing = false;
+static bool ipf_write_all_changes_to_disk(pf_context_t* pf) {
+    if (pf->metadata_decrypted.file_size > MD_USER_DATA_SIZE && pf->root_mht_node.need_writing) {
+        if (!ipf_write_all_data_and_mht_nodes(pf))
+            return false;
     }
 
     if (!ipf_write_node(pf, /*physical_node_number=*/0, &pf->metadata_node))
@@ -544,7 +661,7 @@ static file_node_t* ipf_get_data_node(pf_context_t* pf, uint64_t offset) {
     }
 
     // even if we didn't get the required data_node, we might have read other nodes in the process
-    while (lruc_size(pf->cache) > MAX_NODES_IN_CACHE) {
+    while (lruc_size(pf->cache) > pf->max_cache_nodes) {
         void* node = lruc_get_last(pf->cache);
         assert(node);
 
@@ -597,24 +714,10 @@ static file_node_t* ipf_append_data_node(pf_context_t* pf, uint64_t offset) {
     return new_file_data_node;
 }
 
-static file_node_t* ipf_read_data_node(pf_context_t* pf, uint64_t offset) {
-    file_node_t* file_mht_node;
-    pf_status_t status;
-
-    uint64_t logical_data_node_number;
-    uint64_t physical_node_number;
-    get_node_numbers(offset, NULL, &logical_data_node_number, NULL, &physical_node_number);
-
-    file_node_t* file_data_node = (file_node_t*)lruc_get(pf->cache, physical_node_number);
-    if (file_data_node != NULL)
-        return file_data_node;
-
-    // need to read the data node from the disk
-    file_mht_node = ipf_get_mht_node(pf, offset);
-    if (file_mht_node == NULL)
-        return NULL;
-
-    file_data_node = calloc(1, sizeof(*file_data_node));
+static file_node_t* ipf_alloc_data_node(pf_context_t* pf, file_node_t* file_mht_node,
+                                        uint64_t logical_node_number,
+                                        uint64_t physical_node_number) {
+    file_node_t* file_data_node = calloc(1, sizeof(*file_data_node));
     if (!file_data_node) {
         pf->last_error = PF_STATUS_NO_MEMORY;
         return NULL;
@@ -622,36 +725,134 @@ static file_node_t* ipf_read_data_node(pf_context_t* pf, uint64_t offset) {
 
     file_data_node->type = FILE_DATA_NODE_TYPE;
     file_data_node->parent = file_mht_node;
-    file_data_node->logical_node_number = logical_data_node_number;
+    file_data_node->logical_node_number = logical_node_number;
     file_data_node->physical_node_number = physical_node_number;
+    return file_data_node;
+}
 
-    if (!ipf_read_node(pf, file_data_node->physical_node_number,
-                       file_data_node->encrypted.bytes)) {
-        free(file_data_node);
-        return NULL;
-    }
-
+// Decrypts the data node (already read from disk), checks its integrity and adds it to the cache.
+// On failure, the node is freed.
+static bool ipf_decrypt_and_cache_data_node(pf_context_t* pf, file_node_t* file_data_node) {
     gcm_crypto_data_t* gcm_crypto_data =
         &file_data_node->parent->decrypted.mht
              .data_nodes_crypto[file_data_node->logical_node_number % ATTACHED_DATA_NODES_COUNT];
 
     // decrypt data and check integrity against the MAC in corresponding array item in MHT node
-    status = g_cb_aes_gcm_decrypt(&gcm_crypto_data->key, &g_empty_iv, NULL, 0,
-                                  file_data_node->encrypted.bytes, PF_NODE_SIZE,
-                                  file_data_node->decrypted.data.bytes, &gcm_crypto_data->mac);
-
+    pf_status_t status = g_cb_aes_gcm_decrypt(&gcm_crypto_data->key, &g_empty_iv, NULL, 0,
+                                              file_data_node->encrypted.bytes, PF_NODE_SIZE,
+                                              file_data_node->decrypted.data.bytes,
+                                              &gcm_crypto_data->mac);
     if (PF_FAILURE(status)) {
+        erase_memory(&file_data_node->decrypted, sizeof(file_data_node->decrypted));
         free(file_data_node);
         pf->last_error = status;
-        if (status == PF_STATUS_MAC_MISMATCH)
-            pf->file_status = PF_STATUS_CORRUPTED;
-        return NULL;
+        return false;
     }
 
     if (!lruc_add(pf->cache, file_data_node->physical_node_number, file_data_node)) {
         erase_memory(&file_data_node->decrypted, sizeof(file_data_node->decrypted));
         free(file_data_node);
         pf->last_error = PF_STATUS_NO_MEMORY;
+        return false;
+    }
+
+    return true;
+}
+
+// Returns the number of data nodes to read ahead after `file_data_node`. Only data nodes attached
+// to the same MHT node are physically contiguous, and the read-ahead stops before the first node
+// that is already cached (it may be dirty) and at the end of file.
+static size_t ipf_get_readahead_count(pf_context_t* pf, const file_node_t* file_data_node) {
+    if (!pf->readahead_nodes)
+        return 0;
+
+    uint64_t logical_node_number = file_data_node->logical_node_number;
+    uint64_t last_logical_node_number = (pf->metadata_decrypted.file_size - MD_USER_DATA_SIZE - 1)
+                                        / PF_NODE_SIZE;
+    if (logical_node_number >= last_logical_node_number)
+        return 0;
+
+    uint64_t count = MIN(pf->readahead_nodes,
+                         ATTACHED_DATA_NODES_COUNT - 1
+                             - logical_node_number % ATTACHED_DATA_NODES_COUNT);
+    count = MIN(count, last_logical_node_number - logical_node_number);
+
+    for (uint64_t i = 1; i <= count; i++) {
+        if (lruc_find(pf->cache, file_data_node->physical_node_number + i))
+            return i - 1;
+    }
+    return count;
+}
+
+// Reads the data node `file_data_node` from disk, together with the data nodes to read ahead (with
+// a single read callback). The read-ahead nodes are decrypted and added to the cache right away;
+// failures to read or decrypt them are ignored (such nodes are read again when accessed).
+static bool ipf_read_data_node_with_readahead(pf_context_t* pf, file_node_t* file_data_node) {
+    size_t count = ipf_get_readahead_count(pf, file_data_node);
+    uint8_t* buffer = count ? malloc((count + 1) * PF_NODE_SIZE) : NULL;
+    if (!buffer)
+        return ipf_read_node(pf, file_data_node->physical_node_number,
+                             file_data_node->encrypted.bytes);
+
+    pf_status_t status = g_cb_read(pf->host_file_handle, buffer,
+                                   file_data_node->physical_node_number * PF_NODE_SIZE,
+                                   (count + 1) * PF_NODE_SIZE);
+    if (PF_FAILURE(status)) {
+        free(buffer);
+        return ipf_read_node(pf, file_data_node->physical_node_number,
+                             file_data_node->encrypted.bytes);
+    }
+
+    memcpy(file_data_node->encrypted.bytes, buffer, PF_NODE_SIZE);
+
+    pf_status_t last_error = pf->last_error;
+    for (size_t i = 1; i <= count; i++) {
+        file_node_t* node = ipf_alloc_data_node(pf, file_data_node->parent,
+                                                file_data_node->logical_node_number + i,
+                                                file_data_node->physical_node_number + i);
+        if (!node)
+            break;
+        memcpy(node->encrypted.bytes, buffer + i * PF_NODE_SIZE, PF_NODE_SIZE);
+        if (!ipf_decrypt_and_cache_data_node(pf, node))
+            break;
+    }
+    pf->last_error = last_error;
+
+    free(buffer);
+    return true;
+}
+
+static file_node_t* ipf_read_data_node(pf_context_t* pf, uint64_t offset) {
+    file_node_t* file_mht_node;
+
+    uint64_t logical_data_node_number;
+    uint64_t physical_node_number;
+    get_node_numbers(offset, NULL, &logical_data_node_number, NULL, &physical_node_number);
+
+    file_node_t* file_data_node = (file_node_t*)lruc_get(pf->cache, physical_node_number);
+    if (file_data_node != NULL)
+        return file_data_node;
+
+    // need to read the data node from the disk
+    file_mht_node = ipf_get_mht_node(pf, offset);
+    if (file_mht_node == NULL)
+        return NULL;
+
+    file_data_node = ipf_alloc_data_node(pf, file_mht_node, logical_data_node_number,
+                                         physical_node_number);
+    if (!file_data_node)
+        return NULL;
+
+    if (!ipf_read_data_node_with_readahead(pf, file_data_node)) {
+        free(file_data_node);
+        return NULL;
+    }
+
+    // the requested node is added to the cache after the read-ahead nodes, so that it is evicted
+    // after them
+    if (!ipf_decrypt_and_cache_data_node(pf, file_data_node)) {
+        if (pf->last_error == PF_STATUS_MAC_MISMATCH)
+            pf->file_status = PF_STATUS_CORRUPTED;
         return NULL;
     }
 
@@ -755,7 +956,10 @@ static bool ipf_init_fields(pf_context_t* pf) {
     pf->file_status      = PF_STATUS_UNINITIALIZED;
     pf->last_error       = PF_STATUS_SUCCESS;
 
-    pf->cache = lruc_create();
+    pf->cache           = lruc_create();
+    pf->max_cache_nodes = PF_DEFAULT_NODES_IN_CACHE;
+    pf->last_read_end   = 0;
+    pf->readahead_nodes = 0;
     return true;
 }
 
@@ -944,6 +1148,10 @@ static size_t ipf_write(pf_context_t* pf, const void* ptr, uint64_t offset, size
     if (!ipf_check_writable(pf))
         return 0;
 
+    // writes break sequential reads
+    pf->readahead_nodes = 0;
+    pf->last_read_end   = UINT64_MAX;
+
     size_t data_left_to_write = size;
     const unsigned char* data_to_write = (const unsigned char*)ptr;
 
@@ -1006,6 +1214,10 @@ static size_t ipf_write(pf_context_t* pf, const void* ptr, uint64_t offset, size
     return size - data_left_to_write;
 }
 
+// bounds of the read-ahead window (in data nodes) for sequential reads
+#define MIN_READAHEAD_NODES 4UL
+#define MAX_READAHEAD_NODES 64UL
+
 static size_t ipf_read(pf_context_t* pf, void* ptr, uint64_t offset, size_t size) {
     if (ptr == NULL) {
         pf->last_error = PF_STATUS_INVALID_PARAMETER;
@@ -1034,6 +1246,16 @@ static size_t ipf_read(pf_context_t* pf, void* ptr, uint64_t offset, size_t size
 
     unsigned char* out_buffer = (unsigned char*)ptr;
 
+    // grow the read-ahead window on sequential reads, disable read-ahead on random reads (the
+    // window must be much smaller than the cache so that read-ahead doesn't thrash the cache)
+    if (offset == pf->last_read_end) {
+        size_t max_readahead_nodes = MIN(MAX_READAHEAD_NODES, pf->max_cache_nodes / 4);
+        pf->readahead_nodes = MIN(MAX(pf->readahead_nodes * 2, MIN_READAHEAD_NODES),
+                                  max_readahead_nodes);
+    } else {
+        pf->readahead_nodes = 0;
+    }
+
     // the first MD_USER_DATA_SIZE bytes of user data are read from metadata node's encrypted part
     if (offset < MD_USER_DATA_SIZE) {
         size_t data_left_in_md = MD_USER_DATA_SIZE - (size_t)offset;
@@ -1063,6 +1285,7 @@ static size_t ipf_read(pf_context_t* pf, void* ptr, uint64_t offset, size_t size
         data_left_to_read -= size_to_read;
     }
 
+    pf->last_read_end = offset;
     return data_attempted_to_read - data_left_to_read;
 }
 
@@ -1125,6 +1348,10 @@ void pf_set_callbacks(pf_read_f read_f, pf_write_f write_f, pf_fsync_f fsync_f,
     g_initialized = true;
 }
 
+void pf_set_write_batch_callback(pf_write_batch_f write_batch_f) {
+    g_cb_write_batch = write_batch_f;
+}
+
 pf_status_t pf_open(pf_handle_t handle, const char* path, uint64_t underlying_size,
                     pf_file_mode_t mode, bool create, const pf_key_t* key, pf_context_t** context) {
     if (!g_initialized)
@@ -1277,6 +1504,18 @@ pf_status_t pf_write(pf_context_t* pf, uint64_t offset, size_t size, const void*
     return PF_STATUS_SUCCESS;
 }
 
+pf_status_t pf_set_cache_size(pf_context_t* pf, size_t nodes) {
+    if (!g_initialized)
+        return PF_STATUS_UNINITIALIZED;
+
+    if (nodes < PF_MIN_NODES_IN_CACHE)
+        return PF_STATUS_INVALID_PARAMETER;
+
+    // if the cache shrinks, excess nodes are evicted on the next node access
+    pf->max_cache_nodes = nodes;
+    return PF_STATUS_SUCCESS;
+}
+
 pf_status_t pf_flush(pf_context_t* pf) {
     if (!g_initialized)
         return PF_STATUS_UNINITIALIZED;
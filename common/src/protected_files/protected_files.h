@@ -14,6 +14,10 @@
 
 #define PF_NODE_SIZE 4096U
 
+/* default and minimal number of (data and MHT) nodes cached for each file, see pf_set_cache_size() */
+#define PF_DEFAULT_NODES_IN_CACHE 48
+#define PF_MIN_NODES_IN_CACHE     16
+
 /*! Size of IV for AES-GCM */
 #define PF_IV_SIZE 12
 
@@ -92,6 +96,23 @@ typedef pf_status_t (*pf_read_f)(pf_handle_t handle, void* buffer, uint64_t offs
 typedef pf_status_t (*pf_write_f)(pf_handle_t handle, const void* buffer, uint64_t offset,
                                   size_t size);
 
+/*!
+ * \brief File write-batch callback: write several independent buffers.
+ *
+ * \param handle   File handle.
+ * \param buffers  Buffers to write from.
+ * \param offsets  Offsets to write to, one for each buffer.
+ * \param sizes    Number of bytes to write, one for each buffer.
+ * \param count    Number of buffers.
+ *
+ * \returns PF status.
+ *
+ * The writes are not ordered with respect to each other.
+ */
+typedef pf_status_t (*pf_write_batch_f)(pf_handle_t handle, const void* const* buffers,
+                                        const uint64_t* offsets, const size_t* sizes,
+                                        size_t count);
+
 /*!
  * \brief File sync callback.
  *
@@ -198,6 +219,16 @@ void pf_set_callbacks(pf_read_f read_f, pf_write_f write_f, pf_fsync_f fsync_f,
                       pf_aes_gcm_decrypt_f aes_gcm_decrypt_f, pf_random_f random_f,
                       pf_debug_f debug_f);
 
+/*!
+ * \brief Set the optional write-batch callback.
+ *
+ * \param write_batch_f  File write-batch callback (if NULL, nodes are written one by one with the
+ *                       write callback).
+ *
+ * If used, must be called before any actual APIs.
+ */
+void pf_set_write_batch_callback(pf_write_batch_f write_batch_f);
+
 /* Public API */
 
 /*!
@@ -294,6 +325,19 @@ pf_status_t pf_set_size(pf_context_t* pf, uint64_t size);
  */
 pf_status_t pf_rename(pf_context_t* pf, const char* new_path);
 
+/*!
+ * \brief Set the maximum number of nodes cached for a PF.
+ *
+ * \param pf     PF context.
+ * \param nodes  Maximum number of data and MHT nodes (each of PF_NODE_SIZE bytes) kept in memory.
+ *
+ * \returns PF status.
+ *
+ * Must be at least PF_MIN_NODES_IN_CACHE. The default is PF_DEFAULT_NODES_IN_CACHE. A larger cache
+ * also allows reading ahead more nodes on sequential reads.
+ */
+pf_status_t pf_set_cache_size(pf_context_t* pf, size_t nodes);
+
 /*!
  * \brief Flush any pending data of a protected file to disk.
  *
@@ -31,8 +31,6 @@ static_assert(sizeof(METADATA_KEY_NAME) <= MAX_LABEL_SIZE, "label too long");
 #define MD_USER_DATA_SIZE (PF_NODE_SIZE * 3 / 4)
 static_assert(MD_USER_DATA_SIZE == 3072, "bad struct size");
 
-#define MAX_NODES_IN_CACHE 48
-
 enum {
     FILE_MHT_NODE_TYPE  = 1,
     FILE_DATA_NODE_TYPE = 2,
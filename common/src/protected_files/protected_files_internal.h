@@ -27,7 +27,11 @@ struct pf_context {
 
     file_node_t root_mht_node;     // needed for files bigger than MD_USER_DATA_SIZE bytes
 
-    lruc_context_t* cache;         // up to MAX_NODES_IN_CACHE nodes are cached for each file
+    lruc_context_t* cache;         // up to `max_cache_nodes` nodes are cached for each file
+    size_t max_cache_nodes;
+
+    uint64_t last_read_end;        // end of the last read, to detect sequential reads
+    size_t readahead_nodes;        // data nodes to read ahead on cache miss (0 for random reads)
 #ifdef DEBUG
     char* debug_buffer;            // buffer for debug output
 #endif
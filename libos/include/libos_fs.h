@@ -19,6 +19,7 @@
 #include "linux_abi/limits.h"
 #include "list.h"
 #include "pal.h"
+#include "seqlock.h"
 
 enum file_check_policy {
     FILE_CHECK_POLICY_STRICT = 0,
@@ -33,15 +34,33 @@ struct trusted_chunk_hash {
     uint8_t bytes[16];
 };
 struct trusted_file;
+struct trusted_file_tree;
 struct allowed_file;
 
+struct trusted_files_cache_stats {
+    size_t size;
+    size_t max_size;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
 struct trusted_file* get_trusted_file(const char* path);
 struct allowed_file* get_allowed_file(const char* path);
+const struct trusted_file_hash* get_trusted_file_id(struct trusted_file* tf);
 size_t get_chunk_hashes_size(size_t file_size);
 int load_trusted_file(struct trusted_file* tf, size_t file_size,
-                      struct trusted_chunk_hash** out_chunk_hashes);
+                      struct trusted_chunk_hash** out_chunk_hashes,
+                      struct trusted_file_tree** out_tree);
 int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t count, uint8_t* buf,
-                                 size_t file_size, struct trusted_chunk_hash* chunk_hashes);
+                                 size_t file_size, struct trusted_chunk_hash* chunk_hashes,
+                                 struct trusted_file_tree* tree,
+                                 const struct trusted_file_hash* file_id);
+void get_trusted_files_cache_stats(struct trusted_files_cache_stats* stats);
+void free_trusted_file_tree(struct trusted_file_tree* tree);
+int checkpoint_trusted_file_tree(struct trusted_file_tree* tree, void** out_data, size_t* out_size);
+int restore_trusted_file_tree(const void* data, size_t size, size_t file_size,
+                              struct trusted_file_tree** out_tree);
 int register_allowed_file(const char* path);
 int init_trusted_files(void);
 int init_allowed_files(void);
@@ -62,6 +81,10 @@ struct libos_mount_params {
 
     /* Key name (used by `chroot_encrypted` filesystem), or NULL if not applicable */
     const char* key_name;
+
+    /* Per-file node cache size in bytes (used by `chroot_encrypted` filesystem), or 0 for
+     * default */
+    uint64_t cache_size;
 };
 
 struct libos_fs_ops {
@@ -132,6 +155,37 @@ struct libos_fs_ops {
     ssize_t (*writev)(struct libos_handle* handle, struct iovec* iov, size_t iov_len,
                       file_off_t* pos);
 
+    /*!
+     * \brief Get the PAL handle from which file data can be read directly on the host.
+     *
+     * \param hdl  File handle.
+     *
+     * \returns PAL handle, or NULL if data must be read with `read` (e.g. because it is verified or
+     *          decrypted in LibOS).
+     *
+     * Optional. Used by `sendfile`, `copy_file_range` and `splice` as the source for
+     * `write_from_host` below.
+     */
+    PAL_HANDLE (*host_read_handle)(struct libos_handle* hdl);
+
+    /*!
+     * \brief Write data transferred directly from a host file (see `PalStreamTransfer`).
+     *
+     * \param         hdl         File handle.
+     * \param         src         PAL handle to read from, as returned by `host_read_handle`.
+     * \param         src_offset  Offset in \p src to start reading at.
+     * \param         count       Number of bytes to transfer.
+     * \param[in,out] pos         Position at which to start writing. Might be updated on success.
+     *
+     * \returns Number of bytes written on success (0 if \p src_offset is at or past the end of
+     *          \p src), negative error code on failure.
+     *
+     * Optional. Returns -EOPNOTSUPP (without any side effects) if data cannot be transferred this
+     * way; the caller should then use `read` and `write`.
+     */
+    ssize_t (*write_from_host)(struct libos_handle* hdl, PAL_HANDLE src, file_off_t src_offset,
+                               size_t count, file_off_t* pos);
+
     /*
      * \brief Map file at an address.
      *
@@ -270,12 +324,18 @@ struct libos_dentry {
     LISTP_TYPE(libos_dentry) children; /* These children and siblings link */
     LIST_TYPE(libos_dentry) siblings;
 
+    /* Next dentry in the same bucket of the global dentry hash table (which indexes all dentries
+     * with a parent by parent and name, see `lookup_dcache`). Protected by `g_dcache_lock`, but
+     * also read by lockless lookups. */
+    struct libos_dentry* hash_next;
+
     /* Filesystem mounted under this dentry. If set, this dentry is a mountpoint: filesystem
      * operations should use `attached_mount->root` instead of this dentry. Protected by
      * `g_dcache_lock`. */
     struct libos_mount* attached_mount;
 
-    /* File locks information, stored only in the main process. Managed by `libos_fs_lock.c`. */
+    /* File locks information, stored only in the main process, and in processes holding a lease on
+     * the file. Managed by `libos_fs_lock.c`. */
     struct dent_file_locks* file_locks;
 
     /* True if the file might have locks placed by current process. Used in processes other than
@@ -598,9 +658,18 @@ int walk_mounts(int (*walk)(struct libos_mount* mount, void* arg), void* arg);
 
 /* functions for dcache supports */
 int init_dcache(void);
+int init_inodes(void);
 
 extern struct libos_lock g_dcache_lock;
 
+/*
+ * Sequence lock for lockless lookups in the dentry cache (see `path_lookupat_cached`). Has to be
+ * taken for writing (in addition to holding `g_dcache_lock`) when removing a dentry from the dentry
+ * cache, when detaching an inode from a dentry (or replacing it), and when attaching or detaching a
+ * mount. Adding a dentry, or setting the inode of a negative dentry, does not need it.
+ */
+extern seqlock_t g_dcache_seqlock;
+
 /*!
  * \brief Dump dentry cache.
  *
@@ -692,6 +761,31 @@ int check_permissions(struct libos_dentry* dent, mode_t mask);
 int path_lookupat(struct libos_dentry* start, const char* path, int flags,
                   struct libos_dentry** found);
 
+/*!
+ * \brief Look up a path in the dentry cache, without taking `g_dcache_lock`.
+ *
+ * \param      start        The start dentry for relative paths, or NULL (in which case it will
+ *                          default to process' cwd).
+ * \param      path         The path to look up.
+ * \param      flags        Lookup flags (only LOOKUP_FOLLOW and LOOKUP_DIRECTORY are supported).
+ * \param[out] found        Pointer to retrieved dentry.
+ * \param[out] found_inode  Pointer to inode of the retrieved dentry.
+ *
+ * This is a fast path for `path_lookupat`, for paths that are already cached: it walks the dentry
+ * cache optimistically, and validates the walk with `g_dcache_seqlock`. The caller must *not* hold
+ * `g_dcache_lock`.
+ *
+ * On success, returns 0, and puts the retrieved (positive) dentry and its inode in `*found` and
+ * `*found_inode`. The reference counts of both are increased by one.
+ *
+ * Returns -EAGAIN (and sets `*found` and `*found_inode` to NULL) if the path cannot be resolved
+ * this way: some path segments are not cached or negative, the path contains symbolic links to be
+ * followed, the lookup would fail, or the dentry cache was modified during the walk. In this case,
+ * the caller should retry with `path_lookupat`.
+ */
+int path_lookupat_cached(struct libos_dentry* start, const char* path, int flags,
+                         struct libos_dentry** found, struct libos_inode** found_inode);
+
 /*!
  * This function returns a dentry (in *dir) from a handle corresponding to dirfd.
  * If dirfd == AT_FDCWD returns current working directory.
@@ -902,6 +996,9 @@ ino_t dentry_ino(struct libos_dentry* dent);
  * The `mount` parameter should typically be `parent->mount`, but is passed explicitly to support
  * initializing the root dentry of a newly mounted filesystem. The `fs` field will be initialized to
  * `mount->fs`, but you can later change it to support special files.
+ *
+ * Adding a child to `parent` also garbage-collects a few unused children of `parent` (see
+ * `dentry_gc`), so that dentries left by failed lookups do not accumulate.
  */
 struct libos_dentry* get_new_dentry(struct libos_mount* mount, struct libos_dentry* parent,
                                     const char* name, size_t name_len);
@@ -917,10 +1014,28 @@ struct libos_dentry* get_new_dentry(struct libos_mount* mount, struct libos_dent
  *
  * The caller should hold `g_dcache_lock`.
  *
- * If found, the reference count on the returned dentry is incremented.
+ * If found, the reference count on the returned dentry is incremented. The lookup takes constant
+ * time, regardless of the number of children.
  */
 struct libos_dentry* lookup_dcache(struct libos_dentry* parent, const char* name, size_t name_len);
 
+/*!
+ * \brief Search for a child of a dentry with a given name, without taking `g_dcache_lock`.
+ *
+ * \param parent    The dentry to search under.
+ * \param name      Name of searched dentry.
+ * \param name_len  Length of the name.
+ * \param seq       Value returned by `read_seqbegin(&g_dcache_seqlock)`.
+ *
+ * \returns The dentry, or NULL if not found or if the dentry cache was modified since `seq`.
+ *
+ * The reference count of the returned dentry is *not* incremented, and the result is valid only if
+ * a later `read_seqretry(&g_dcache_seqlock, seq)` returns false. Dentry memory is never returned to
+ * the system (see `alloc_dentry`), so the returned pointer can be always dereferenced.
+ */
+struct libos_dentry* lookup_dcache_lockless(struct libos_dentry* parent, const char* name,
+                                            size_t name_len, uint32_t seq);
+
 /*
  * Returns true if `anc` is an ancestor of `dent`. Both dentries need to be within the same mounted
  * filesystem.
@@ -998,10 +1113,14 @@ int generic_seek(file_off_t pos, file_off_t size, file_off_t offset, int origin,
 int generic_readdir(struct libos_dentry* dent, readdir_callback_t callback, void* arg);
 
 int generic_inode_stat(struct libos_dentry* dent, struct stat* buf);
+/* Same as `generic_inode_stat`, but takes only the inode (and does not require `g_dcache_lock`). */
+int generic_istat(struct libos_inode* inode, struct stat* buf);
 int generic_inode_hstat(struct libos_handle* hdl, struct stat* buf);
 file_off_t generic_inode_seek(struct libos_handle* hdl, file_off_t offset, int origin);
 int generic_inode_poll(struct libos_handle* hdl, int in_events, int* out_events);
 
+/* Reads `fs.experimental__enable_lazy_mmap` from the manifest. */
+int init_emulated_mmap(void);
 int generic_emulated_mmap(struct libos_handle* hdl, void* addr, size_t size, int prot, int flags,
                           uint64_t offset, size_t* valid_size);
 int generic_emulated_msync(struct libos_handle* hdl, void* addr, size_t size, int prot, int flags,
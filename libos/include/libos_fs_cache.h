@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * This file defines a write-back page cache for files accessed through PAL handles. It is used by
+ * the `chroot` filesystem, for mounts with the `cache_size` parameter.
+ *
+ * The cache keeps up to `max_pages` 4KB pages of a single file. Reads that miss the cache fetch
+ * several pages with one host read (and read ahead if the file is read sequentially). Writes only
+ * modify the cached pages; dirty pages are written back in runs of adjacent pages, each with a
+ * single host write, when the caller flushes the cache or when too many pages are dirty.
+ *
+ * Each cache has its own lock, which the caller has to hold (see `page_cache_lock`) during all
+ * operations below, except for creating and destroying the cache. The operations do host I/O, so
+ * the caller should avoid holding other locks (such as the inode lock) while calling them. The
+ * caller also keeps track of the file size and passes it to the operations below; the size may be
+ * stale (smaller) if another write through the cache has not updated it yet.
+ */
+
+#pragma once
+
+#include "libos_types.h"
+#include "pal.h"
+
+#define PAGE_CACHE_PAGE_SIZE 4096
+
+/* minimum number of pages in a cache */
+#define PAGE_CACHE_MIN_PAGES 16
+
+/* Flags for `page_cache_read` and `page_cache_write`. */
+/* Access the host file directly (e.g. for `O_DIRECT` and `O_SYNC`), keeping the cached pages
+ * up to date. */
+#define PAGE_CACHE_DIRECT     0x1
+/* The PAL handle is write-only, so missing parts of partially written pages cannot be read. */
+#define PAGE_CACHE_WRITE_ONLY 0x2
+
+struct libos_page_cache;
+
+int page_cache_create(size_t max_pages, struct libos_page_cache** out_cache);
+
+/* Frees the cache together with all its pages. Dirty pages are discarded (see `page_cache_flush`
+ * below). */
+void page_cache_destroy(struct libos_page_cache* cache);
+
+void page_cache_lock(struct libos_page_cache* cache);
+void page_cache_unlock(struct libos_page_cache* cache);
+
+bool page_cache_has_dirty_pages(struct libos_page_cache* cache);
+
+/*
+ * \brief Read from file through the cache.
+ *
+ * \param cache      The cache.
+ * \param handle     PAL handle of the file, used for reading pages missing from the cache.
+ * \param file_size  Current size of the file.
+ * \param pos        Position at which to start reading.
+ * \param buf        Buffer to read into.
+ * \param count      Size of \p buf.
+ * \param flags      `PAGE_CACHE_*` flags. With `PAGE_CACHE_DIRECT`, the data is read directly from
+ *                   the host file (but cached pages still take precedence), and nothing is added to
+ *                   the cache.
+ *
+ * \returns Number of bytes read (less than \p count only at the end of file), or negative error
+ *          code on failure.
+ */
+ssize_t page_cache_read(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size,
+                        file_off_t pos, void* buf, size_t count, int flags);
+
+/*
+ * \brief Write to file through the cache.
+ *
+ * \param cache      The cache.
+ * \param handle     PAL handle of the file, must be opened for writing.
+ * \param file_size  Current size of the file.
+ * \param pos        Position at which to start writing.
+ * \param buf        Buffer to write from.
+ * \param count      Size of \p buf.
+ * \param flags      `PAGE_CACHE_*` flags. With `PAGE_CACHE_DIRECT`, the data is written directly
+ *                   to the host file (and the cached pages are updated), i.e. the cache works in
+ *                   write-through mode.
+ *
+ * \returns Number of bytes written, or negative error code on failure.
+ *
+ * On success, the caller should update the file size if the write ended past it.
+ */
+ssize_t page_cache_write(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size,
+                         file_off_t pos, const void* buf, size_t count, int flags);
+
+/* Writes back all dirty pages of the cache. `handle` must be opened for writing. */
+int page_cache_flush(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size);
+
+/* Removes the cached data past `size`. Should be called when the file is truncated. */
+void page_cache_truncate(struct libos_page_cache* cache, file_off_t size);
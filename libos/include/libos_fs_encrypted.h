@@ -45,6 +45,7 @@ struct libos_encrypted_file {
     size_t use_count;
     char* uri;
     struct libos_encrypted_files_key* key;
+    size_t cache_nodes; /* size of the node cache of `pf`, 0 for default */
 
     /* `pf` and `pal_handle` are non-null as long as `use_count` is greater than 0 */
     pf_context_t* pf;
@@ -109,31 +110,33 @@ void update_encrypted_files_key(struct libos_encrypted_files_key* key, const pf_
 /*
  * \brief Open an existing encrypted file.
  *
- * \param      uri      PAL URI to open, has to begin with "file:".
- * \param      key      Key, has to be already set.
- * \param[out] out_enc  On success, set to a newly created `libos_encrypted_file` object.
+ * \param      uri          PAL URI to open, has to begin with "file:".
+ * \param      key          Key, has to be already set.
+ * \param      cache_nodes  Number of nodes cached for the file, 0 for default.
+ * \param[out] out_enc      On success, set to a newly created `libos_encrypted_file` object.
  *
  * `uri` has to correspond to an existing file that can be decrypted with `key`.
  *
  * The newly created `libos_encrypted_file` object will have `use_count` set to 1.
  */
-int encrypted_file_open(const char* uri, struct libos_encrypted_files_key* key,
+int encrypted_file_open(const char* uri, struct libos_encrypted_files_key* key, size_t cache_nodes,
                         struct libos_encrypted_file** out_enc);
 
 /*
  * \brief Create a new encrypted file.
  *
- * \param      uri      PAL URI to open, has to begin with "file:".
- * \param      perm     Permissions for the new file.
- * \param      key      Key, has to be already set.
- * \param[out] out_enc  On success, set to a newly created `libos_encrypted_file` object.
+ * \param      uri          PAL URI to open, has to begin with "file:".
+ * \param      perm         Permissions for the new file.
+ * \param      key          Key, has to be already set.
+ * \param      cache_nodes  Number of nodes cached for the file, 0 for default.
+ * \param[out] out_enc      On success, set to a newly created `libos_encrypted_file` object.
  *
  * `uri` must not correspond to an existing file.
  *
  * The newly created `libos_encrypted_file` object will have `use_count` set to 1.
  */
 int encrypted_file_create(const char* uri, mode_t perm, struct libos_encrypted_files_key* key,
-                          struct libos_encrypted_file** out_enc);
+                          size_t cache_nodes, struct libos_encrypted_file** out_enc);
 
 /*
  * \brief Deallocate an encrypted file.
@@ -12,6 +12,7 @@
 
 #include <stdbool.h>
 
+#include "avl_tree.h"
 #include "libos_types.h"
 #include "list.h"
 
@@ -26,11 +27,16 @@ int init_fs_lock(void);
  * File locks. Describes both POSIX locks aka advisory record locks (fcntl syscall) and BSD locks
  * (flock syscall). See `man fcntl` and `man flock` for details.
  *
- * The current implementation works over IPC and handles all requests in the main process. It has
- * the following caveats:
+ * The current implementation works over IPC and handles all requests in the main process. To avoid
+ * an IPC round-trip on every uncontested POSIX lock operation, the main process can grant another
+ * process a *lease* on a file: as long as no other process is interested in the file, all POSIX
+ * locks on it are held and managed locally by the lease holder. The lease is revoked (and the locks
+ * are sent back to the main process) as soon as another process operates on locks of that file.
  *
- * - Lock requests from other processes will always have the overhead of IPC round-trip, even if the
- *   lock is uncontested.
+ * The implementation has the following caveats:
+ *
+ * - Lock requests from other processes have the overhead of IPC round-trip, unless the process
+ *   holds a lease on the file. In particular, BSD (flock) locks are never leased.
  * - The main process has to be able to look up the same file, so locking will not work for files in
  *   local-process-only filesystems (tmpfs).
  * - The lock requests cannot be interrupted (EINTR).
@@ -56,6 +62,10 @@ struct libos_file_lock {
     /* List node, used internally */
     LIST_TYPE(libos_file_lock) list;
 
+    /* Tree node and maximum `end` in its subtree, used internally (for FILE_LOCK_POSIX) */
+    struct avl_tree_node tree_node;
+    uint64_t subtree_max_end;
+
     /* FILE_LOCK_POSIX fields */
     uint64_t start; /* First byte of range */
     uint64_t end;   /* Last byte of range (use FS_LOCK_EOF for a range until end of file) */
@@ -126,7 +136,11 @@ int file_lock_clear_pid(IDTYPE pid);
  *
  * This is a version of `file_lock_set` called from an IPC callback. This function is responsible
  * for either sending an IPC response immediately, or scheduling one for later (if `wait` is true
- * and the lock cannot be taken immediately).
+ * and the lock cannot be taken immediately, or if the file is leased to another process).
+ *
+ * If the file is not locked by anyone, the response might grant the requesting process a lease on
+ * the file: the process then applies the lock locally, and handles further POSIX lock requests for
+ * the file by itself until the lease is revoked.
  *
  * This function will only return a negative error code when failing to send a response. A failure
  * to add a lock (-EAGAIN, -ENOMEM etc.) will be sent in the response instead.
@@ -137,12 +151,42 @@ int file_lock_set_from_ipc(const char* path, struct libos_file_lock* file_lock,
 /*!
  * \brief Check for conflicting locks on a file (IPC handler).
  *
- * \param      path           Absolute path for a file.
- * \param      file_lock      Parameters of new lock (type cannot be `F_UNLCK`).
- * \param[out] out_file_lock  On success, set to `F_UNLCK` or details of a conflicting lock.
+ * \param path       Absolute path for a file.
+ * \param file_lock  Parameters of new lock (type cannot be `F_UNLCK`).
+ * \param vmid       Target process for IPC response.
+ * \param seq        Sequence number for IPC response.
+ *
+ * This is a version of `file_lock_get` called from an IPC callback. Similarly to
+ * `file_lock_set_from_ipc`, this function is responsible for sending an IPC response, either
+ * immediately or after the lease on the file (held by another process) is returned.
+ *
+ * This function will only return a negative error code when failing to send a response.
+ */
+int file_lock_get_from_ipc(const char* path, struct libos_file_lock* file_lock, IDTYPE vmid,
+                           unsigned long seq);
+
+/*!
+ * \brief Revoke a lease on a file (IPC handler).
+ *
+ * \param path    Absolute path for a file.
+ * \param grants  Number of IPC responses granting the lease that the main process sent.
+ *
+ * Called in the lease holder. Sends all POSIX locks held on the file back to the main process, once
+ * the lease holder has processed all `grants` responses granting the lease (some of them might
+ * still be in flight when the lease is revoked).
+ */
+int file_lock_revoke_lease_from_ipc(const char* path, unsigned int grants);
+
+/*!
+ * \brief Take back a revoked lease on a file (IPC handler).
+ *
+ * \param path         Absolute path for a file.
+ * \param file_locks   POSIX locks held on the file by the lease holder (only the `type`, `start`,
+ *                     `end` and `pid` fields are used).
+ * \param locks_count  Number of elements in `file_locks`.
+ * \param vmid         The lease holder.
  *
- * This is a version of `file_lock_get` called from an IPC callback. The caller is responsible to
- * send the returned value and `out_file_lock` in an IPC response.
+ * Called in the main process. Installs the locks, and processes requests waiting for the lease.
  */
-int file_lock_get_from_ipc(const char* path, struct libos_file_lock* file_lock,
-                           struct libos_file_lock* out_file_lock);
+int file_lock_return_lease_from_ipc(const char* path, struct libos_file_lock* file_locks,
+                                    size_t locks_count, IDTYPE vmid);
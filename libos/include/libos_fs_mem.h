@@ -6,6 +6,9 @@
 /*
  * This file defines helper functions for in-memory files. They're used for implementing
  * pseudo-FSes and the `tmpfs` filesystem.
+ *
+ * The file data is kept in 4KB pages, allocated on first write. Parts of the file that were never
+ * written (holes) read as zeros and take no memory.
  */
 
 #pragma once
@@ -13,11 +16,13 @@
 #include "libos_types.h"
 
 struct libos_mem_file {
-    char* buf;
+    /* root of the radix tree of pages (see `libos_fs_mem.c`), NULL if there are no pages */
+    void* root;
+    unsigned int height;
     file_off_t size;
-    size_t buf_size;
 };
 
+/* Initializes `mem` with a copy of `data` (which can be NULL if `size` is 0), and frees `data`. */
 void mem_file_init(struct libos_mem_file* mem, char* data, size_t size);
 void mem_file_destroy(struct libos_mem_file* mem);
 
@@ -31,3 +36,11 @@ ssize_t mem_file_write(struct libos_mem_file* mem, file_off_t pos_start, const v
                        size_t size);
 int mem_file_truncate(struct libos_mem_file* mem, file_off_t size);
 int mem_file_poll(struct libos_mem_file* mem, file_off_t pos, int events, int* out_events);
+
+/*
+ * Serializes the file into a newly allocated buffer, for checkpointing. Only the pages which are
+ * present are saved, so holes take no space in the checkpoint.
+ */
+int mem_file_checkpoint(struct libos_mem_file* mem, void** out_data, size_t* out_size);
+/* Initializes `mem` with the contents of the checkpoint created by `mem_file_checkpoint()`. */
+int mem_file_restore(struct libos_mem_file* mem, const void* data);
@@ -212,6 +212,12 @@ int init_procfs(void);
 int proc_meminfo_load(struct libos_dentry* dent, char** out_data, size_t* out_size);
 int proc_cpuinfo_load(struct libos_dentry* dent, char** out_data, size_t* out_size);
 int proc_stat_load(struct libos_dentry* dent, char** out_data, size_t* out_size);
+int proc_gramine_ocalls_load(struct libos_dentry* dent, char** out_data, size_t* out_size);
+int proc_gramine_trusted_files_cache_load(struct libos_dentry* dent, char** out_data,
+                                          size_t* out_size);
+int proc_gramine_malloc_load(struct libos_dentry* dent, char** out_data, size_t* out_size);
+int proc_gramine_memory_reclaim_load(struct libos_dentry* dent, char** out_data,
+                                     size_t* out_size);
 int proc_self_follow_link(struct libos_dentry* dent, char** out_target);
 bool proc_thread_pid_name_exists(struct libos_dentry* parent, const char* name);
 int proc_thread_pid_list_names(struct libos_dentry* parent, readdir_callback_t callback, void* arg);
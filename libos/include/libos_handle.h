@@ -119,6 +119,12 @@ struct libos_dir_handle {
     size_t count;
 };
 
+struct libos_chroot_handle {
+    /* Whether the handle is counted as a user of the page cache of its inode (see
+     * `chroot_get_page_cache()`). Protected by the inode lock. */
+    bool uses_page_cache;
+};
+
 struct libos_str_handle {
     struct libos_mem_file mem;
 };
@@ -204,7 +210,7 @@ struct libos_handle {
     /* Type-specific fields: when accessing, ensure that `type` field is appropriate first (at least
      * by using assert()) */
     union {
-        /* (no data) */                         /* TYPE_CHROOT */
+        struct libos_chroot_handle chroot;      /* TYPE_CHROOT */
         /* (no data) */                         /* TYPE_CHROOT_ENCRYPTED */
         /* (no data) */                         /* TYPE_DEV */
         struct libos_str_handle str;            /* TYPE_STR */
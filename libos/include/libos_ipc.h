@@ -36,6 +36,8 @@ enum {
     IPC_MSG_FILE_LOCK_SET,
     IPC_MSG_FILE_LOCK_GET,
     IPC_MSG_FILE_LOCK_CLEAR_PID,
+    IPC_MSG_FILE_LOCK_REVOKE_LEASE,
+    IPC_MSG_FILE_LOCK_RETURN_LEASE,
     IPC_MSG_CODE_BOUND,
 };
 
@@ -272,9 +274,11 @@ int ipc_sync_confirm_downgrade_callback(IDTYPE src, void* data, unsigned long se
 int ipc_sync_confirm_close_callback(IDTYPE src, void* data, unsigned long seq);
 
 /*
- * FILE_LOCK_SET: `struct libos_ipc_file_lock` -> `int`
+ * FILE_LOCK_SET: `struct libos_ipc_file_lock` -> `struct libos_ipc_file_lock_set_resp`
  * FILE_LOCK_GET: `struct libos_ipc_file_lock` -> `struct libos_ipc_file_lock_resp`
  * FILE_LOCK_CLEAR_PID: `IDTYPE` -> `int`
+ * FILE_LOCK_REVOKE_LEASE: `struct libos_ipc_file_lock_revoke_lease` (no response)
+ * FILE_LOCK_RETURN_LEASE: `struct libos_ipc_file_lock_return_lease` (no response)
  */
 
 struct libos_ipc_file_lock {
@@ -302,13 +306,47 @@ struct libos_ipc_file_lock_resp {
     uint64_t handle_id;
 };
 
+struct libos_ipc_file_lock_set_resp {
+    int result;
+    /* If true, the requesting process was granted a lease on the file, and should apply the lock
+     * locally (see `libos_fs_lock.h`). */
+    bool lease;
+};
+
+struct libos_ipc_file_lock_revoke_lease {
+    unsigned int grants;
+    char path[]; /* null-terminated */
+};
+
+struct libos_ipc_file_lock_range {
+    /* see `struct libos_file_lock` in `libos_fs_lock.h` */
+    int type;
+    uint64_t start;
+    uint64_t end;
+    IDTYPE pid;
+};
+
+struct libos_ipc_file_lock_return_lease {
+    size_t locks_count;
+    /* `locks_count` elements, followed by null-terminated path */
+    struct libos_ipc_file_lock_range locks[];
+};
+
 struct libos_file_lock;
 
-int ipc_file_lock_set(const char* path, struct libos_file_lock* file_lock, bool wait);
-int ipc_file_lock_set_send_response(IDTYPE vmid, unsigned long seq, int result);
+int ipc_file_lock_set(const char* path, struct libos_file_lock* file_lock, bool wait,
+                      bool* out_lease);
+int ipc_file_lock_set_send_response(IDTYPE vmid, unsigned long seq, int result, bool lease);
 int ipc_file_lock_get(const char* path, struct libos_file_lock* file_lock,
                       struct libos_file_lock* out_file_lock);
+int ipc_file_lock_get_send_response(IDTYPE vmid, unsigned long seq, int result,
+                                    struct libos_file_lock* file_lock);
 int ipc_file_lock_clear_pid(IDTYPE pid);
+int ipc_file_lock_revoke_lease(IDTYPE vmid, const char* path, unsigned int grants);
+int ipc_file_lock_return_lease(const char* path, struct libos_file_lock* file_locks,
+                               size_t locks_count);
 int ipc_file_lock_set_callback(IDTYPE src, void* data, unsigned long seq);
 int ipc_file_lock_get_callback(IDTYPE src, void* data, unsigned long seq);
 int ipc_file_lock_clear_pid_callback(IDTYPE src, void* data, unsigned long seq);
+int ipc_file_lock_revoke_lease_callback(IDTYPE src, void* data, unsigned long seq);
+int ipc_file_lock_return_lease_callback(IDTYPE src, void* data, unsigned long seq);
@@ -39,3 +39,20 @@ static inline refcount_t _refcount_dec(refcount_t* ref, const char* fname, size_
 }
 
 #define refcount_dec(ref) _refcount_dec((ref), __FILE_NAME__, __LINE__)
+
+/*
+ * Increments the reference count, but only if it is positive (i.e. the object has not been freed
+ * yet). Returns true if the count was incremented. This is intended for objects found without
+ * holding a reference (e.g. in lockless lookups), whose memory is never returned to the system: a
+ * freed object has a count of 0 (or a poison value, which is negative).
+ */
+__attribute_no_sanitize_address
+static inline bool refcount_inc_not_zero(refcount_t* ref) {
+    refcount_t count = __atomic_load_n(ref, __ATOMIC_RELAXED);
+    do {
+        if (count <= 0)
+            return false;
+    } while (!__atomic_compare_exchange_n(ref, &count, count + 1, /*weak=*/true, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_RELAXED));
+    return true;
+}
@@ -94,6 +94,20 @@ struct libos_sock_ops {
                 size_t msg_controllen, size_t* out_size, void* addr, size_t addrlen,
                 bool force_nonblocking);
 
+    /*!
+     * \brief Send data directly from a host file, without copying it through LibOS.
+     *
+     * \param         handle      A handle.
+     * \param         src         PAL handle of the file to send from.
+     * \param         src_offset  Offset in \p src to start reading at.
+     * \param[in,out] size        Number of bytes to send. On success contains the number of bytes
+     *                            sent.
+     *
+     * Optional. Returns -EOPNOTSUPP if data cannot be sent this way (see `PalStreamTransfer`).
+     */
+    int (*sendfile)(struct libos_handle* handle, PAL_HANDLE src, uint64_t src_offset,
+                    size_t* size);
+
     /*!
      * \brief Receive continuous data into an array of buffers.
      *
@@ -132,3 +146,5 @@ ssize_t do_recvmsg(struct libos_handle* handle, struct iovec* iov, size_t iov_le
 ssize_t do_sendmsg(struct libos_handle* handle, struct iovec* iov, size_t iov_len,
                    void* msg_control, size_t msg_controllen, void* addr, size_t addrlen,
                    unsigned int flags);
+ssize_t do_sendfile(struct libos_handle* handle, PAL_HANDLE src, uint64_t src_offset,
+                    size_t count);
@@ -142,16 +142,10 @@
 
 #include "libos_refcount.h"
 #include "libos_types.h"
+#include "libos_uthash.h"
 #include "list.h"
 #include "pal.h"
 
-#define uthash_fatal(msg)                      \
-    do {                                       \
-        log_error("uthash error: %s", msg);    \
-        PalProcessExit(1);                     \
-    } while (0)
-#include "uthash.h"
-
 /* Describes a state of a client handle, as recognized by client and server. */
 enum {
     /* No state, used for {client,server}_req_state */
@@ -27,6 +27,10 @@ struct libos_tcb {
      * an SGX enclave) we lack a way to restore all (or at least some) registers atomically. */
     void*                syscall_scratch_pc;
     void*                vma_cache;
+    /* Per-thread cache of free heap objects, see libos_malloc.c. */
+    void*                malloc_cache;
+    /* Page of the last handled memory fault on a lazily populated file mapping. */
+    uintptr_t            lazy_fault_addr;
     char                 log_prefix[32];
 };
 
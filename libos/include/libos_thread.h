@@ -134,6 +134,12 @@ struct libos_thread {
 
     unsigned long* cpu_affinity_mask;
 
+    /* Buffer used by `sendfile`, `copy_file_range` and `splice` when data cannot be transferred
+     * directly on the host. Allocated on first use and grown as needed; accessible only by the
+     * current thread. */
+    char* copy_buf;
+    size_t copy_buf_size;
+
     refcount_t ref_count;
     struct libos_lock lock;
 };
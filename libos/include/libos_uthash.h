@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Wrapper for `uthash.h`, which makes any fatal uthash error (out of memory) terminate the process.
+ * LibOS code should include this file instead of `uthash.h`.
+ */
+
+#pragma once
+
+#include "api.h"
+#include "pal.h"
+
+#define uthash_fatal(msg)                      \
+    do {                                       \
+        log_error("uthash error: %s", msg);    \
+        PalProcessExit(1);                     \
+    } while (0)
+#include "uthash.h"
@@ -25,6 +25,20 @@ static inline uint64_t hash64(uint64_t key) {
 
 /* heap allocation functions */
 int init_slab(void);
+/* Must be called by each thread before it exits. */
+void flush_thread_malloc_cache(void);
+
+/* Statistics of the LibOS heap for one size class (slab level). */
+struct malloc_stats {
+    size_t obj_size;
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t refills; /* of per-thread caches from the shared slab allocator */
+    uint64_t flushes; /* of per-thread caches to the shared slab allocator */
+};
+
+#define MALLOC_STATS_MAX_CNT 16
+size_t get_malloc_stats(struct malloc_stats* stats, size_t stats_cnt);
 
 void* malloc(size_t size);
 void free(void* mem);
@@ -21,6 +21,8 @@
 
 #define VMA_COMMENT_LEN 16
 
+struct libos_lazy_pages;
+
 /* Public version of libos_vma, used when we want to copy out the VMA and use it without holding
  * the VMA list lock. */
 struct libos_vma_info {
@@ -31,6 +33,9 @@ struct libos_vma_info {
     int flags; // MAP_* and VMA_*
     struct libos_handle* file;
     uint64_t file_offset;
+    /* state of a lazily populated file mapping; only set by `dump_all_vmas` and
+     * `dump_vmas_in_range` (and released by `free_vma_info_array`) */
+    struct libos_lazy_pages* lazy_pages;
     char comment[VMA_COMMENT_LEN];
 };
 
@@ -44,6 +49,9 @@ struct libos_vma_info {
 
 int init_vma(void);
 
+/* Starts the thread which returns freed memory to the host, if the PAL supports it */
+int init_memory_reclaimer(void);
+
 /*
  * Bookkeeping a removal of mapped memory. On success returns a temporary VMA pointer in
  * `tmp_vma_ptr`, which must be subsequently freed by calling `bkeep_remove_tmp_vma` - but this
@@ -103,6 +111,36 @@ int bkeep_mmap_any_aslr(size_t length, int prot, int flags, struct libos_handle*
 /* Looks up VMA that starts at `begin_addr` and if found, updates `vma->valid_length`. */
 int bkeep_vma_update_valid_length(void* begin_addr, size_t valid_length);
 
+/*
+ * Marks the file-backed VMA that starts at `begin_addr` and has `length` bytes as lazily populated:
+ * its memory was allocated inaccessible and each page is read from the file on first access (in
+ * `handle_lazy_page_fault`). Pages of MAP_SHARED mappings are additionally tracked as dirty on first
+ * write, so that `msync` writes back only the modified pages (see `msync_lazy_pages`).
+ */
+int bkeep_vma_set_lazy(void* begin_addr, size_t length);
+
+/* Populates the page containing `addr` if it is a not yet populated page of a lazily populated file
+ * mapping (or marks it as dirty on write). Returns true if the faulting access should be retried. */
+bool handle_lazy_page_fault(void* addr);
+
+/* Populates all pages of lazily populated file mappings in range [`addr`, `addr` + `length`), and
+ * marks them as dirty if `write` is true. Needed before memory is accessed outside of LibOS, e.g. by
+ * the host when used as a syscall buffer. */
+int populate_lazy_pages(const void* addr, size_t length, bool write);
+
+/*
+ * Calls `write_back` on each run of dirty pages of a lazily populated MAP_SHARED file mapping in
+ * range [`addr`, `addr` + `length`), which must be inside one VMA. The pages are marked as clean
+ * before calling `write_back`. Returns -ENOENT if the range is not in a lazily populated mapping.
+ */
+int msync_lazy_pages(void* addr, size_t length,
+                     int (*write_back)(void* addr, size_t size, void* arg), void* arg);
+
+/* Applies memory protections `prot` (already bookkept with `bkeep_mprotect`) to range [`addr`,
+ * `addr` + `length`), keeping not yet populated and clean pages of lazily populated file mappings
+ * inaccessible and write-protected, respectively. */
+int protect_user_memory(void* addr, size_t length, int prot);
+
 /* Looking up VMA that contains `addr`. If one is found, returns its description in `vma_info`.
  * This function increases ref-count of `vma_info->file` by one (if it is not NULL). */
 int lookup_vma(void* addr, struct libos_vma_info* vma_info);
@@ -128,6 +166,9 @@ void free_vma_info_array(struct libos_vma_info* vma_infos, size_t count);
 /* Implementation of madvise(MADV_DONTNEED) syscall */
 int madvise_dontneed_range(uintptr_t begin, uintptr_t end);
 
+/* Implementation of madvise(MADV_FREE) syscall */
+int madvise_free_range(uintptr_t begin, uintptr_t end);
+
 /* Call `msync` for file mappings in given range (should be page-aligned) */
 int msync_range(uintptr_t begin, uintptr_t end);
 
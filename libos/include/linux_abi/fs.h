@@ -51,5 +51,10 @@ struct linux_dirent_tail {
 #define SEEK_DATA 3 /* seek to the next data */
 #define SEEK_HOLE 4 /* seek to the next hole */
 
+#define SPLICE_F_MOVE     1
+#define SPLICE_F_NONBLOCK 2
+#define SPLICE_F_MORE     4
+#define SPLICE_F_GIFT     8
+
 #define CLOSE_RANGE_UNSHARE (1U << 1)
 #define CLOSE_RANGE_CLOEXEC (1U << 2)
@@ -289,7 +289,7 @@ libos_syscall_t libos_syscall_table[LIBOS_SYSCALL_BOUND] = {
     [__NR_unshare]                 = (libos_syscall_t)0, // libos_syscall_unshare
     [__NR_set_robust_list]         = (libos_syscall_t)libos_syscall_set_robust_list,
     [__NR_get_robust_list]         = (libos_syscall_t)libos_syscall_get_robust_list,
-    [__NR_splice]                  = (libos_syscall_t)0, // libos_syscall_splice
+    [__NR_splice]                  = (libos_syscall_t)libos_syscall_splice,
     [__NR_tee]                     = (libos_syscall_t)0, // libos_syscall_tee
     [__NR_sync_file_range]         = (libos_syscall_t)0, // libos_syscall_sync_file_range
     [__NR_vmsplice]                = (libos_syscall_t)0, // libos_syscall_vmsplice
@@ -340,7 +340,7 @@ libos_syscall_t libos_syscall_table[LIBOS_SYSCALL_BOUND] = {
     [__NR_userfaultfd]             = (libos_syscall_t)0, // libos_syscall_userfaultfd
     [__NR_membarrier]              = (libos_syscall_t)0, // libos_syscall_membarrier
     [__NR_mlock2]                  = (libos_syscall_t)libos_syscall_mlock2,
-    [__NR_copy_file_range]         = (libos_syscall_t)0, // libos_syscall_copy_file_range
+    [__NR_copy_file_range]         = (libos_syscall_t)libos_syscall_copy_file_range,
     [__NR_preadv2]                 = (libos_syscall_t)0, // libos_syscall_preadv2
     [__NR_pwritev2]                = (libos_syscall_t)0, // libos_syscall_pwritev2
     [__NR_pkey_mprotect]           = (libos_syscall_t)0, // libos_syscall_pkey_mprotect
@@ -344,6 +344,11 @@ static void memfault_upcall(bool is_in_pal, uintptr_t addr, PAL_CONTEXT* context
     assert(!is_in_pal);
     assert(context);
 
+    /* first access to a page of a lazily populated file mapping (also from LibOS code, e.g. when
+     * copying syscall arguments); retry the faulting instruction after populating the page */
+    if (handle_lazy_page_fault((void*)addr))
+        return;
+
     if (is_internal(get_cur_thread()) || context_is_libos(context)) {
         internal_fault("Internal memory fault", addr, context);
     }
@@ -397,7 +402,12 @@ static bool test_user_memory(const void* addr, size_t size, bool writable) {
         return false;
     }
 
-    return is_in_adjacent_user_vmas(addr, size, writable ? PROT_WRITE : PROT_READ);
+    if (!is_in_adjacent_user_vmas(addr, size, writable ? PROT_WRITE : PROT_READ))
+        return false;
+
+    /* the memory may be accessed by the host (e.g. as a buffer for read or write), which does not
+     * trigger population of lazily mapped pages */
+    return populate_lazy_pages(addr, size, writable) == 0;
 }
 
 bool is_user_memory_readable(const void* addr, size_t size) {
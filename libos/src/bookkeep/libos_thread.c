@@ -410,6 +410,8 @@ void put_thread(struct libos_thread* thread) {
 
         free(thread->cpu_affinity_mask);
 
+        free(thread->copy_buf);
+
         destroy_pollable_event(&thread->pollable_event);
 
         destroy_lock(&thread->lock);
@@ -601,6 +603,8 @@ BEGIN_CP_FUNC(thread) {
         new_thread->handle_map = NULL;
         memset(&new_thread->signal_queue, 0, sizeof(new_thread->signal_queue));
         new_thread->robust_list = NULL;
+        new_thread->copy_buf = NULL;
+        new_thread->copy_buf_size = 0;
         refcount_set(&new_thread->ref_count, 0);
 
         DO_CP_MEMBER(signal_dispositions, thread, new_thread, signal_dispositions);
@@ -615,9 +619,10 @@ BEGIN_CP_FUNC(thread) {
             struct libos_tcb* new_tcb = new_thread->libos_tcb;
             *new_tcb = *thread->libos_tcb;
             /* don't export stale pointers */
-            new_tcb->self      = NULL;
-            new_tcb->tp        = NULL;
-            new_tcb->vma_cache = NULL;
+            new_tcb->self         = NULL;
+            new_tcb->tp           = NULL;
+            new_tcb->vma_cache    = NULL;
+            new_tcb->malloc_cache = NULL;
 
             new_tcb->log_prefix[0] = '\0';
 
@@ -687,8 +692,11 @@ BEGIN_RS_FUNC(thread) {
     CP_REBASE(thread->libos_tcb->context.regs);
 
     libos_tcb_t* tcb = libos_get_tcb();
+    /* this thread may have already cached some heap objects, keep them */
+    void* malloc_cache = tcb->malloc_cache;
     *tcb = *thread->libos_tcb;
     __libos_tcb_init(tcb);
+    tcb->malloc_cache = malloc_cache;
 
     assert(tcb->context.regs);
     set_tls(tcb->context.tls);
@@ -20,10 +20,13 @@
 #include "libos_handle.h"
 #include "libos_internal.h"
 #include "libos_lock.h"
+#include "libos_refcount.h"
 #include "libos_tcb.h"
+#include "libos_thread.h"
 #include "libos_utils.h"
 #include "libos_vma.h"
 #include "linux_abi/memory.h"
+#include "seqlock.h"
 #include "spinlock.h"
 
 /* The amount of total memory usage, all accesses must be protected by `vma_tree_lock`. */
@@ -50,6 +53,7 @@ struct libos_vma {
     int flags;
     struct libos_handle* file;
     uint64_t offset; // offset inside `file`, where `begin` starts
+    struct libos_lazy_pages* lazy_pages; // non-NULL for lazily populated file mappings
     union {
         /* If this `vma` is used, it is included in `vma_tree` using this node. */
         struct avl_tree_node tree_node;
@@ -57,9 +61,108 @@ struct libos_vma {
          * of to-be-freed vmas (used by _vma_bkeep_remove). Such lists use the field below. */
         struct libos_vma* next_free;
     };
+    /* Augmented data of `vma_tree` describing the subtree rooted at this VMA (valid only while the
+     * VMA is in the tree): the lowest and highest address covered by the VMAs in the subtree, and
+     * the size of the largest free range between them. See `vma_tree_update()`. */
+    uintptr_t subtree_begin;
+    uintptr_t subtree_end;
+    size_t subtree_max_gap;
     char comment[VMA_COMMENT_LEN];
 };
 
+/*
+ * State of pages of a lazily populated file mapping (see `generic_emulated_mmap()`). Memory of such
+ * mapping is allocated inaccessible and each page is read from the file on first access, in the
+ * memory fault handler. Pages of shared writable mappings are populated write-protected, so that
+ * the first write to a page marks it as dirty and `msync` can write back only the dirty pages.
+ *
+ * The object is shared by all VMAs split from the original mapping, page indices are relative to
+ * `begin`. Page protections of the mapping must be changed only with `lock` held, according to
+ * the state of the pages (see `lazy_page_prot()`).
+ */
+struct libos_lazy_pages {
+    refcount_t ref_count;
+    struct libos_lock lock;
+    uintptr_t begin;
+    size_t pages_cnt;
+    uint8_t* populated; /* bitvector; bits are read without `lock` in `pal_mem_bkeep_get_vma_info` */
+    uint8_t* dirty;     /* bitvector */
+};
+
+/* number of existing `struct libos_lazy_pages` objects, used to skip lookups if there are none */
+static size_t g_lazy_pages_cnt = 0;
+
+static void get_lazy_pages(struct libos_lazy_pages* lazy) {
+    refcount_inc(&lazy->ref_count);
+}
+
+static void put_lazy_pages(struct libos_lazy_pages* lazy) {
+    if (refcount_dec(&lazy->ref_count))
+        return;
+
+    destroy_lock(&lazy->lock);
+    free(lazy->populated);
+    free(lazy->dirty);
+    free(lazy);
+    __atomic_sub_fetch(&g_lazy_pages_cnt, 1, __ATOMIC_RELAXED);
+}
+
+static bool lazy_page_test(const uint8_t* bitvector, size_t idx) {
+    return __atomic_load_n(&bitvector[idx / 8], __ATOMIC_RELAXED) & (1 << (idx % 8));
+}
+
+static void lazy_page_set(uint8_t* bitvector, size_t idx) {
+    __atomic_or_fetch(&bitvector[idx / 8], 1 << (idx % 8), __ATOMIC_RELAXED);
+}
+
+static void lazy_page_clear(uint8_t* bitvector, size_t idx) {
+    __atomic_and_fetch(&bitvector[idx / 8], ~(1 << (idx % 8)), __ATOMIC_RELAXED);
+}
+
+static size_t lazy_page_idx(struct libos_lazy_pages* lazy, uintptr_t addr) {
+    assert(lazy->begin <= addr && addr < lazy->begin + lazy->pages_cnt * PAGE_SIZE);
+    return (addr - lazy->begin) / PAGE_SIZE;
+}
+
+/* Returns the PAL protection a page of lazily populated mapping must currently have: not yet
+ * populated pages are inaccessible and clean pages of shared mappings are write-protected. */
+static pal_prot_flags_t lazy_page_prot(struct libos_lazy_pages* lazy, size_t idx, int prot,
+                                       int flags) {
+    if (!lazy_page_test(lazy->populated, idx))
+        return 0;
+
+    pal_prot_flags_t pal_prot = LINUX_PROT_TO_PAL(prot, flags);
+    if ((flags & MAP_SHARED) && (pal_prot & PAL_PROT_WRITE) && !lazy_page_test(lazy->dirty, idx)) {
+        /* writable pages are readable anyway on x86, keep them readable for `msync` */
+        pal_prot = (pal_prot & ~PAL_PROT_WRITE) | PAL_PROT_READ;
+    }
+    return pal_prot;
+}
+
+/* Applies protections to pages in [begin; end) according to their state, merging runs of pages
+ * with equal protections into one PAL call. */
+static int lazy_pages_protect(struct libos_lazy_pages* lazy, uintptr_t begin, uintptr_t end,
+                              int prot, int flags) {
+    assert(locked(&lazy->lock));
+
+    uintptr_t run_begin = begin;
+    while (run_begin < end) {
+        pal_prot_flags_t pal_prot = lazy_page_prot(lazy, lazy_page_idx(lazy, run_begin), prot,
+                                                   flags);
+        uintptr_t run_end = run_begin + PAGE_SIZE;
+        while (run_end < end
+                && lazy_page_prot(lazy, lazy_page_idx(lazy, run_end), prot, flags) == pal_prot) {
+            run_end += PAGE_SIZE;
+        }
+
+        int ret = PalVirtualMemoryProtect((void*)run_begin, run_end - run_begin, pal_prot);
+        if (ret < 0)
+            return pal_to_unix_errno(ret);
+        run_begin = run_end;
+    }
+    return 0;
+}
+
 static void copy_comment(struct libos_vma* vma, const char* comment) {
     size_t size = MIN(sizeof(vma->comment), strlen(comment) + 1);
     memcpy(vma->comment, comment, size);
@@ -80,6 +183,9 @@ static void copy_vma(struct libos_vma* old_vma, struct libos_vma* new_vma) {
         get_handle(new_vma->file);
     }
     new_vma->offset = old_vma->offset;
+    new_vma->lazy_pages = old_vma->lazy_pages;
+    if (new_vma->lazy_pages)
+        get_lazy_pages(new_vma->lazy_pages);
     copy_comment(new_vma, old_vma->comment);
 }
 
@@ -94,6 +200,25 @@ static bool is_addr_in_vma(uintptr_t addr, struct libos_vma* vma) {
     return vma->begin <= addr && addr < vma->end;
 }
 
+static void vma_tree_update(struct avl_tree_node* node) {
+    struct libos_vma* vma = container_of(node, struct libos_vma, tree_node);
+
+    vma->subtree_begin = vma->begin;
+    vma->subtree_end = vma->end;
+    vma->subtree_max_gap = 0;
+    if (node->left) {
+        struct libos_vma* left = container_of(node->left, struct libos_vma, tree_node);
+        vma->subtree_begin = left->subtree_begin;
+        vma->subtree_max_gap = MAX(left->subtree_max_gap, vma->begin - left->subtree_end);
+    }
+    if (node->right) {
+        struct libos_vma* right = container_of(node->right, struct libos_vma, tree_node);
+        vma->subtree_end = right->subtree_end;
+        vma->subtree_max_gap = MAX(vma->subtree_max_gap,
+                                   MAX(right->subtree_max_gap, right->subtree_begin - vma->end));
+    }
+}
+
 /* Returns whether `addr` is smaller or inside a vma (`node`). */
 static bool cmp_addr_to_vma(void* addr, struct avl_tree_node* node) {
     struct libos_vma* vma = container_of(node, struct libos_vma, tree_node);
@@ -106,11 +231,38 @@ static bool cmp_addr_to_vma(void* addr, struct avl_tree_node* node) {
  * Currently we do not merge similar adjacent vmas - if we ever start doing it, this code needs
  * to be revisited as there might be some optimizations that would break due to it.
  */
-static struct avl_tree vma_tree = {.cmp = vma_tree_cmp};
-static spinlock_t vma_tree_lock = INIT_SPINLOCK_UNLOCKED;
+static struct avl_tree vma_tree = {.cmp = vma_tree_cmp, .update = vma_tree_update};
+
+/*
+ * Protects `vma_tree` and all VMAs in it. Code that modifies them must take the lock for writing,
+ * which also bumps the sequence number, so that lockless readers notice the change and retry (see
+ * `lookup_vma_lockless()`). Code that only reads them, but cannot be done locklessly (e.g. because
+ * it takes references to objects pointed to by VMAs) can take the lock for reading: this excludes
+ * writers, but does not disturb lockless readers.
+ */
+static seqlock_t vma_tree_lock = INIT_SEQLOCK_UNLOCKED;
+
+static void vma_tree_write_lock(void) {
+    write_seqbegin(&vma_tree_lock);
+}
+
+static void vma_tree_write_unlock(void) {
+    write_seqend(&vma_tree_lock);
+}
+
+static void vma_tree_read_lock(void) {
+    spinlock_lock(&vma_tree_lock.lock);
+}
+
+static void vma_tree_read_unlock(void) {
+    spinlock_unlock(&vma_tree_lock.lock);
+}
+
+/* only for use in asserts: `spinlock_is_locked()` is defined only with `DEBUG_SPINLOCKS` */
+#define vma_tree_is_locked() spinlock_is_locked(&vma_tree_lock.lock)
 
 static void total_memory_size_add(size_t length) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     g_total_memory_size += length;
 
@@ -122,7 +274,7 @@ static void total_memory_size_add(size_t length) {
 }
 
 static void total_memory_size_sub(size_t length) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     assert(g_total_memory_size >= length);
 
     g_total_memory_size -= length;
@@ -136,29 +288,19 @@ static struct libos_vma* node2vma(struct avl_tree_node* node) {
 }
 
 static struct libos_vma* _get_next_vma(struct libos_vma* vma) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     return node2vma(avl_tree_next(&vma->tree_node));
 }
 
-static struct libos_vma* _get_prev_vma(struct libos_vma* vma) {
-    assert(spinlock_is_locked(&vma_tree_lock));
-    return node2vma(avl_tree_prev(&vma->tree_node));
-}
-
-static struct libos_vma* _get_last_vma(void) {
-    assert(spinlock_is_locked(&vma_tree_lock));
-    return node2vma(avl_tree_last(&vma_tree));
-}
-
 static struct libos_vma* _get_first_vma(void) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     return node2vma(avl_tree_first(&vma_tree));
 }
 
 /* Returns the vma that contains `addr`. If there is no such vma, returns the closest vma with
  * higher address. */
 static struct libos_vma* _lookup_vma(uintptr_t addr) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     struct avl_tree_node* node = avl_tree_lower_bound_fn(&vma_tree, (void*)addr, cmp_addr_to_vma);
     if (!node) {
@@ -167,6 +309,122 @@ static struct libos_vma* _lookup_vma(uintptr_t addr) {
     return container_of(node, struct libos_vma, tree_node);
 }
 
+/* Must be called after changing `begin` or `end` of a VMA that is in `vma_tree`. */
+static void _vma_bounds_changed(struct libos_vma* vma) {
+    assert(vma_tree_is_locked());
+    avl_tree_update(&vma_tree, &vma->tree_node);
+}
+
+/*
+ * Finds the highest range of `length` free bytes in [`bottom_addr`, `top_addr`), in the part of the
+ * address space covered by the subtree of `node`: `lower` is the end of the VMA preceding the
+ * subtree and `upper` is the beginning of the VMA following it (or the limits of the address
+ * space). Subtrees without a large enough free range are skipped using the augmented data of the
+ * tree, so only O(log n) nodes are visited.
+ *
+ * Returns the end of the found range, or 0 if there is none.
+ */
+static uintptr_t _find_free_range(struct avl_tree_node* node, uintptr_t lower, uintptr_t upper,
+                                  uintptr_t bottom_addr, uintptr_t top_addr, size_t length) {
+    assert(vma_tree_is_locked());
+
+    uintptr_t range_begin = MAX(lower, bottom_addr);
+    uintptr_t range_end = MIN(upper, top_addr);
+    if (range_end <= range_begin || range_end - range_begin < length)
+        return 0;
+    if (!node)
+        return range_end;
+
+    struct libos_vma* vma = node2vma(node);
+    if (vma->subtree_max_gap < length && vma->subtree_begin - lower < length
+            && upper - vma->subtree_end < length)
+        return 0;
+
+    uintptr_t found = _find_free_range(node->right, vma->end, upper, bottom_addr, top_addr, length);
+    if (found)
+        return found;
+    return _find_free_range(node->left, lower, vma->begin, bottom_addr, top_addr, length);
+}
+
+/* Number of attempts of a lockless lookup before falling back to taking `vma_tree_lock`. */
+#define VMA_LOCKLESS_ATTEMPTS 3
+
+/*
+ * Lockless counterparts of `_lookup_vma()` and `_get_next_vma()`, to be used without holding
+ * `vma_tree_lock`, after `seq = read_seqbegin(&vma_tree_lock)`.
+ *
+ * Every pointer read from the tree is validated with `read_seqretry()` before it is followed, so
+ * the walk only follows pointers of a consistent tree. A VMA can still be removed (and reused) by a
+ * writer right after it was found, but the memory of VMAs is never unmapped (see `_vma_free()`), so
+ * reading it is harmless. The caller must read the VMA fields it needs with atomic loads, and then
+ * check `read_seqretry()` again before using them.
+ *
+ * Both functions return false if the sequence number changed, i.e. the caller has to retry.
+ */
+static bool lookup_vma_lockless(uint32_t seq, uintptr_t addr, struct libos_vma** out_vma) {
+    struct avl_tree_node* found = NULL;
+    struct avl_tree_node* node = __atomic_load_n(&vma_tree.root, __ATOMIC_RELAXED);
+    while (true) {
+        if (read_seqretry(&vma_tree_lock, seq))
+            return false;
+        if (!node)
+            break;
+
+        struct libos_vma* vma = node2vma(node);
+        if (addr < __atomic_load_n(&vma->end, __ATOMIC_RELAXED)) {
+            found = node;
+            node = __atomic_load_n(&node->left, __ATOMIC_RELAXED);
+        } else {
+            node = __atomic_load_n(&node->right, __ATOMIC_RELAXED);
+        }
+    }
+    *out_vma = node2vma(found);
+    return true;
+}
+
+static bool get_next_vma_lockless(uint32_t seq, struct libos_vma* vma,
+                                  struct libos_vma** out_next) {
+    struct avl_tree_node* node = &vma->tree_node;
+    struct avl_tree_node* right = __atomic_load_n(&node->right, __ATOMIC_RELAXED);
+    if (read_seqretry(&vma_tree_lock, seq))
+        return false;
+
+    if (right) {
+        /* the next node is the leftmost node in the right subtree */
+        node = right;
+        while (true) {
+            struct avl_tree_node* left = __atomic_load_n(&node->left, __ATOMIC_RELAXED);
+            if (read_seqretry(&vma_tree_lock, seq))
+                return false;
+            if (!left)
+                break;
+            node = left;
+        }
+        *out_next = node2vma(node);
+        return true;
+    }
+
+    /* the next node is the first ancestor, of which `node` is in the left subtree */
+    while (true) {
+        struct avl_tree_node* parent = __atomic_load_n(&node->parent, __ATOMIC_RELAXED);
+        if (read_seqretry(&vma_tree_lock, seq))
+            return false;
+        if (!parent) {
+            *out_next = NULL;
+            return true;
+        }
+
+        struct avl_tree_node* parent_left = __atomic_load_n(&parent->left, __ATOMIC_RELAXED);
+        if (read_seqretry(&vma_tree_lock, seq))
+            return false;
+        if (parent_left == node) {
+            *out_next = node2vma(parent);
+            return true;
+        }
+        node = parent;
+    }
+}
+
 typedef bool (*traverse_visitor)(struct libos_vma* vma, void* visitor_arg);
 
 /*
@@ -193,7 +451,7 @@ typedef bool (*traverse_visitor)(struct libos_vma* vma, void* visitor_arg);
 // TODO: Probably other VMA functions could make use of this helper.
 static bool _traverse_vmas_in_range(uintptr_t begin, uintptr_t end, bool use_only_valid_part,
                                     traverse_visitor visitor, void* visitor_arg) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     assert(begin <= end);
 
     if (begin == end)
@@ -241,6 +499,7 @@ static void split_vma(struct libos_vma* old_vma, struct libos_vma* new_vma, uint
     if (old_vma->valid_end > old_vma->end) {
         old_vma->valid_end = old_vma->end;
     }
+    _vma_bounds_changed(old_vma);
 
     assert(old_vma->begin <= old_vma->valid_end && old_vma->valid_end <= old_vma->end);
     assert(new_vma->begin <= new_vma->valid_end && new_vma->valid_end <= new_vma->end);
@@ -256,7 +515,7 @@ static void split_vma(struct libos_vma* old_vma, struct libos_vma* new_vma, uint
  */
 static int _vma_bkeep_remove(uintptr_t begin, uintptr_t end, bool is_internal,
                              struct libos_vma** new_vma_ptr, struct libos_vma** vmas_to_free) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     assert(!new_vma_ptr || *new_vma_ptr);
     assert(IS_ALLOC_ALIGNED_PTR(begin) && IS_ALLOC_ALIGNED_PTR(end));
 
@@ -296,6 +555,7 @@ static int _vma_bkeep_remove(uintptr_t begin, uintptr_t end, bool is_internal,
             if (vma->valid_end > vma->end) {
                 vma->valid_end = vma->end;
             }
+            _vma_bounds_changed(vma);
 
             avl_tree_insert(&vma_tree, &new_vma->tree_node);
             total_memory_size_sub(end - begin);
@@ -308,6 +568,7 @@ static int _vma_bkeep_remove(uintptr_t begin, uintptr_t end, bool is_internal,
         if (vma->valid_end > vma->end) {
             vma->valid_end = vma->end;
         }
+        _vma_bounds_changed(vma);
 
         vma = _get_next_vma(vma);
         if (!vma) {
@@ -341,6 +602,7 @@ static int _vma_bkeep_remove(uintptr_t begin, uintptr_t end, bool is_internal,
         if (vma->valid_end < vma->begin) {
             vma->valid_end = vma->begin;
         }
+        _vma_bounds_changed(vma);
     }
 
     return 0;
@@ -362,11 +624,11 @@ static void* _vma_malloc(size_t size) {
     if (ret < 0) {
         struct libos_vma* vmas_to_free = NULL;
 
-        spinlock_lock(&vma_tree_lock);
+        vma_tree_write_lock();
         /* Since we are freeing a range we just created, additional vma is not needed. */
         ret = _vma_bkeep_remove((uintptr_t)addr, (uintptr_t)addr + size, /*is_internal=*/true, NULL,
                                 &vmas_to_free);
-        spinlock_unlock(&vma_tree_lock);
+        vma_tree_write_unlock();
         if (ret < 0) {
             log_error("Removing a vma we just created failed: %s", unix_strerror(ret));
             BUG();
@@ -502,8 +764,10 @@ static struct libos_vma* alloc_vma(void) {
     vma = get_mem_obj_from_mgr(vma_mgr);
     if (!vma) {
         /* `enlarge_mem_mgr` below will call _vma_malloc, which uses at most 1 vma - so we
-         * temporarily provide it. */
-        struct libos_vma tmp_vma = {0};
+         * temporarily provide it. It is not on stack, because lockless readers of `vma_tree` rely
+         * on VMA memory never being unmapped; it is protected by `vma_mgr_lock`. */
+        static struct libos_vma tmp_vma;
+        memset(&tmp_vma, 0, sizeof(tmp_vma));
         /* vma cache is empty, as we checked it before. */
         if (!add_to_thread_vma_cache(&tmp_vma)) {
             log_error("Failed to add tmp vma to cache!");
@@ -520,7 +784,7 @@ static struct libos_vma* alloc_vma(void) {
             BUG();
         }
 
-        spinlock_lock(&vma_tree_lock);
+        vma_tree_write_lock();
         /* Currently `tmp_vma` is always used (added to `vma_tree`), but this assumption could
          * easily be changed (e.g. if we implement VMAs merging).*/
         struct avl_tree_node* node = &tmp_vma.tree_node;
@@ -530,7 +794,7 @@ static struct libos_vma* alloc_vma(void) {
             avl_tree_swap_node(&vma_tree, node, &vma_migrate->tree_node);
             vma_migrate = NULL;
         }
-        spinlock_unlock(&vma_tree_lock);
+        vma_tree_write_unlock();
 
         if (vma_migrate) {
             free_mem_obj_to_mgr(vma_mgr, vma_migrate);
@@ -559,6 +823,9 @@ static void free_vma(struct libos_vma* vma) {
         }
         put_handle(vma->file);
     }
+    if (vma->lazy_pages) {
+        put_lazy_pages(vma->lazy_pages);
+    }
 
     if (add_to_thread_vma_cache(vma)) {
         return;
@@ -578,7 +845,7 @@ static void free_vmas_freelist(struct libos_vma* vma) {
 }
 
 static int _bkeep_initial_vma(struct libos_vma* new_vma) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     struct libos_vma* tmp_vma = _lookup_vma(new_vma->begin);
     if (tmp_vma && tmp_vma->begin < new_vma->end) {
@@ -593,7 +860,8 @@ static int _bkeep_initial_vma(struct libos_vma* new_vma) {
 
 static int pal_mem_bkeep_alloc(size_t size, uintptr_t* out_addr);
 static int pal_mem_bkeep_free(uintptr_t addr, size_t size);
-static int pal_mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags);
+static int pal_mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags,
+                                      uintptr_t* out_begin, uintptr_t* out_end);
 
 #define ASLR_BITS 12
 /* This variable is written to only once, during initialization, so it does not need to
@@ -637,7 +905,7 @@ int init_vma(void) {
     }
     assert(1 + idx == ARRAY_SIZE(init_vmas));
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     int ret = 0;
     /* First of init_vmas is reserved for later usage. */
     for (size_t i = 1; i < ARRAY_SIZE(init_vmas); i++) {
@@ -663,7 +931,7 @@ int init_vma(void) {
         log_debug("Initial VMA region 0x%lx-0x%lx (%s) bookkeeped", init_vmas[i].begin,
                   init_vmas[i].end, init_vmas[i].comment);
     }
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
     /* From now on if we return with an error we might leave a structure local to this function in
      * vma_tree. We do not bother with removing them - this is initialization of VMA subsystem, if
      * it fails the whole application startup fails and we should never call any of functions in
@@ -721,7 +989,7 @@ int init_vma(void) {
         }
     }
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     for (size_t i = 0; i < ARRAY_SIZE(init_vmas); i++) {
         /* Skip empty areas. */
         if (init_vmas[i].begin == init_vmas[i].end) {
@@ -731,7 +999,7 @@ int init_vma(void) {
         avl_tree_swap_node(&vma_tree, &init_vmas[i].tree_node, &vmas_to_migrate_to[i]->tree_node);
         vmas_to_migrate_to[i] = NULL;
     }
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
 
     for (size_t i = 0; i < ARRAY_SIZE(vmas_to_migrate_to); i++) {
         if (vmas_to_migrate_to[i]) {
@@ -743,7 +1011,7 @@ int init_vma(void) {
 }
 
 static void _add_unmapped_vma(uintptr_t begin, uintptr_t end, struct libos_vma* vma) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     vma->begin     = begin;
     vma->end       = end;
@@ -776,7 +1044,7 @@ int bkeep_munmap(void* addr, size_t length, bool is_internal, void** tmp_vma_ptr
 
     struct libos_vma* vmas_to_free = NULL;
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     int ret = _vma_bkeep_remove((uintptr_t)addr, (uintptr_t)addr + length, is_internal,
                                 vma2 ? &vma2 : NULL, &vmas_to_free);
     if (ret >= 0) {
@@ -784,7 +1052,7 @@ int bkeep_munmap(void* addr, size_t length, bool is_internal, void** tmp_vma_ptr
         *tmp_vma_ptr = (void*)vma1;
         vma1 = NULL;
     }
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
 
     free_vmas_freelist(vmas_to_free);
     if (vma1) {
@@ -808,10 +1076,10 @@ void bkeep_remove_tmp_vma(void* _vma) {
 
     assert(vma->flags == (VMA_INTERNAL | VMA_UNMAPPED));
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     avl_tree_delete(&vma_tree, &vma->tree_node);
     total_memory_size_sub(vma->end - vma->begin);
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
 
     free_vma(vma);
 }
@@ -819,10 +1087,10 @@ void bkeep_remove_tmp_vma(void* _vma) {
 void bkeep_convert_tmp_vma_to_user(void* _vma) {
     struct libos_vma* vma = (struct libos_vma*)_vma;
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     assert(vma->flags == (VMA_INTERNAL | VMA_UNMAPPED));
     vma->flags &= ~VMA_INTERNAL;
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
 }
 
 static bool is_file_prot_matching(struct libos_handle* file_hdl, int prot) {
@@ -864,7 +1132,7 @@ int bkeep_mmap_fixed(void* addr, size_t length, int prot, int flags, struct libo
 
     struct libos_vma* vmas_to_free = NULL;
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     int ret = 0;
     if (flags & MAP_FIXED_NOREPLACE) {
         struct libos_vma* tmp_vma = _lookup_vma(new_vma->begin);
@@ -879,7 +1147,7 @@ int bkeep_mmap_fixed(void* addr, size_t length, int prot, int flags, struct libo
         avl_tree_insert(&vma_tree, &new_vma->tree_node);
         total_memory_size_add(new_vma->end - new_vma->begin);
     }
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
 
     free_vmas_freelist(vmas_to_free);
     if (vma1) {
@@ -901,7 +1169,7 @@ static void vma_update_prot(struct libos_vma* vma, int prot) {
 
 static int _vma_bkeep_change(uintptr_t begin, uintptr_t end, int prot, bool is_internal,
                              struct libos_vma** new_vma_ptr1, struct libos_vma** new_vma_ptr2) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     assert(IS_ALLOC_ALIGNED_PTR(begin) && IS_ALLOC_ALIGNED_PTR(end));
     assert(begin < end);
 
@@ -1030,10 +1298,10 @@ int bkeep_mprotect(void* addr, size_t length, int prot, bool is_internal) {
         return -ENOMEM;
     }
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     int ret = _vma_bkeep_change((uintptr_t)addr, (uintptr_t)addr + length, prot, is_internal, &vma1,
                                 &vma2);
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
 
     if (vma1) {
         free_vma(vma1);
@@ -1113,35 +1381,15 @@ int bkeep_mmap_any_in_range(void* _bottom_addr, void* _top_addr, size_t length,
     new_vma->offset = file ? offset : 0;
     copy_comment(new_vma, comment ?: "");
 
-    spinlock_lock(&vma_tree_lock);
-
-    struct libos_vma* vma = _lookup_vma(top_addr);
-    uintptr_t max_addr;
-    if (!vma) {
-        vma = _get_last_vma();
-        max_addr = top_addr;
-    } else {
-        max_addr = MIN(top_addr, vma->begin);
-        vma = _get_prev_vma(vma);
-    }
-    assert(!vma || vma->end <= max_addr);
-
-    while (vma && bottom_addr <= vma->end) {
-        assert(vma->end <= max_addr);
-        if (max_addr - vma->end >= length) {
-            goto out_found;
-        }
-
-        max_addr = vma->begin;
-        vma = _get_prev_vma(vma);
-    }
+    vma_tree_write_lock();
 
-    if (!(bottom_addr <= max_addr && max_addr - bottom_addr >= length)) {
+    uintptr_t max_addr = _find_free_range(vma_tree.root, /*lower=*/0, /*upper=*/UINTPTR_MAX,
+                                          bottom_addr, top_addr, length);
+    if (!max_addr) {
         ret = -ENOMEM;
         goto out;
     }
 
-out_found:
     new_vma->end   = max_addr;
     new_vma->begin = new_vma->end - length;
 
@@ -1156,7 +1404,7 @@ out_found:
     new_vma = NULL;
 
 out:
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
     if (new_vma) {
         free_vma(new_vma);
     }
@@ -1188,7 +1436,7 @@ int bkeep_mmap_any_aslr(size_t length, int prot, int flags, struct libos_handle*
 int bkeep_vma_update_valid_length(void* begin_addr, size_t valid_length) {
     int ret;
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_write_lock();
     struct libos_vma* vma = _lookup_vma((uintptr_t)begin_addr);
     if (!vma || !is_addr_in_vma((uintptr_t)begin_addr, vma)) {
         ret = -ENOENT;
@@ -1203,7 +1451,362 @@ int bkeep_vma_update_valid_length(void* begin_addr, size_t valid_length) {
     vma->valid_end = vma->begin + valid_length;
     ret = 0;
 out:
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_write_unlock();
+    return ret;
+}
+
+int bkeep_vma_set_lazy(void* begin_addr, size_t length) {
+    assert(IS_ALLOC_ALIGNED_PTR(begin_addr) && IS_ALLOC_ALIGNED(length));
+
+    struct libos_lazy_pages* lazy = calloc(1, sizeof(*lazy));
+    if (!lazy)
+        return -ENOMEM;
+
+    lazy->begin = (uintptr_t)begin_addr;
+    lazy->pages_cnt = length / PAGE_SIZE;
+    lazy->populated = calloc(1, UDIV_ROUND_UP(lazy->pages_cnt, 8));
+    lazy->dirty = calloc(1, UDIV_ROUND_UP(lazy->pages_cnt, 8));
+    if (!lazy->populated || !lazy->dirty || !create_lock(&lazy->lock)) {
+        free(lazy->populated);
+        free(lazy->dirty);
+        free(lazy);
+        return -ENOMEM;
+    }
+    refcount_set(&lazy->ref_count, 1);
+
+    int ret;
+    vma_tree_write_lock();
+    struct libos_vma* vma = _lookup_vma((uintptr_t)begin_addr);
+    if (!vma || vma->begin != (uintptr_t)begin_addr || vma->end - vma->begin != length
+            || !vma->file || vma->lazy_pages) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    vma->lazy_pages = lazy;
+    lazy = NULL;
+    __atomic_add_fetch(&g_lazy_pages_cnt, 1, __ATOMIC_RELAXED);
+    ret = 0;
+out:
+    vma_tree_write_unlock();
+    if (lazy) {
+        destroy_lock(&lazy->lock);
+        free(lazy->populated);
+        free(lazy->dirty);
+        free(lazy);
+    }
+    return ret;
+}
+
+/* Returns (with a reference taken) the lazily populated pages state of the VMA containing `addr`,
+ * or NULL if `addr` is not in a lazily populated file mapping. */
+static struct libos_lazy_pages* get_lazy_pages_at(uintptr_t addr, struct libos_handle** out_file) {
+    struct libos_lazy_pages* lazy = NULL;
+
+    vma_tree_read_lock();
+    struct libos_vma* vma = _lookup_vma(addr);
+    if (vma && is_addr_in_vma(addr, vma) && vma->lazy_pages) {
+        lazy = vma->lazy_pages;
+        get_lazy_pages(lazy);
+        if (out_file) {
+            *out_file = vma->file;
+            get_handle(*out_file);
+        }
+    }
+    vma_tree_read_unlock();
+    return lazy;
+}
+
+/* Re-reads the VMA attributes of a lazily populated page under `lazy->lock`: these cannot change
+ * in a way that matters for page protections until the lock is released, because `mprotect` and
+ * file size changes re-apply the protections with the lock held after updating the VMAs. */
+static bool get_lazy_vma_attrs(struct libos_lazy_pages* lazy, uintptr_t addr, int* out_prot,
+                               int* out_flags, uintptr_t* out_valid_end, uint64_t* out_offset) {
+    assert(locked(&lazy->lock));
+
+    bool found = false;
+    vma_tree_read_lock();
+    struct libos_vma* vma = _lookup_vma(addr);
+    if (vma && is_addr_in_vma(addr, vma) && vma->lazy_pages == lazy) {
+        *out_prot = vma->prot;
+        *out_flags = vma->flags;
+        *out_valid_end = vma->valid_end;
+        *out_offset = vma->offset + (addr - vma->begin);
+        found = true;
+    }
+    vma_tree_read_unlock();
+    return found;
+}
+
+/* Fills the (inaccessible) page at `addr` with the file contents at `pos`, leaving it readable and
+ * writable; the caller then applies the final protection. The file is read into a bounce buffer
+ * first, so other threads touching the page keep faulting (and wait on `lazy->lock`) while the file
+ * is being read. They can still observe the page being filled during the final copy, as the page
+ * cannot be written by the enclave without making it accessible to all threads. */
+static int read_lazy_page(struct libos_handle* file, uintptr_t addr, file_off_t pos) {
+    char* buf = malloc(PAGE_SIZE);
+    if (!buf)
+        return -ENOMEM;
+
+    int ret;
+    size_t read = 0;
+    while (read < PAGE_SIZE) {
+        ssize_t count = file->fs->fs_ops->read(file, buf + read, PAGE_SIZE - read, &pos);
+        if (count < 0) {
+            if (count == -EINTR || count == -EAGAIN)
+                continue;
+            ret = count;
+            goto out;
+        }
+        if (count == 0)
+            break;
+        read += count;
+    }
+    /* the page may have been populated before (and dropped on reload or truncate) */
+    memset(buf + read, 0, PAGE_SIZE - read);
+
+    ret = PalVirtualMemoryProtect((void*)addr, PAGE_SIZE, PAL_PROT_READ | PAL_PROT_WRITE);
+    if (ret < 0) {
+        ret = pal_to_unix_errno(ret);
+        goto out;
+    }
+    memcpy((void*)addr, buf, PAGE_SIZE);
+    ret = 0;
+out:
+    free(buf);
+    return ret;
+}
+
+/*
+ * Makes the page at `addr` of a lazily populated file mapping accessible: reads it from the file if
+ * it is not populated yet and, if `write` is true, marks it as dirty. `*out_changed` is set to
+ * whether the page state was changed. `write` is ignored for mappings without PROT_WRITE. Returns
+ * -ENOENT if `addr` is not in a lazily populated part of a file mapping, and -EACCES if the mapping
+ * is not accessible at all.
+ */
+static int fault_in_lazy_page(uintptr_t addr, bool write, bool* out_changed) {
+    addr = ALIGN_DOWN(addr, PAGE_SIZE);
+    *out_changed = false;
+
+    struct libos_handle* file;
+    struct libos_lazy_pages* lazy = get_lazy_pages_at(addr, &file);
+    if (!lazy)
+        return -ENOENT;
+
+    int ret;
+    lock(&lazy->lock);
+
+    int prot;
+    int flags;
+    uintptr_t valid_end;
+    uint64_t offset;
+    if (!get_lazy_vma_attrs(lazy, addr, &prot, &flags, &valid_end, &offset)
+            || addr >= valid_end) {
+        ret = -ENOENT;
+        goto out;
+    }
+    if (!(prot & (PROT_READ | PROT_WRITE | PROT_EXEC))) {
+        ret = -EACCES;
+        goto out;
+    }
+    if (!(prot & PROT_WRITE))
+        write = false;
+
+    size_t idx = lazy_page_idx(lazy, addr);
+    bool changed = false;
+    if (!lazy_page_test(lazy->populated, idx)) {
+        ret = read_lazy_page(file, addr, (file_off_t)offset);
+        if (ret < 0)
+            goto out;
+        lazy_page_set(lazy->populated, idx);
+        changed = true;
+    }
+    if (write && (flags & MAP_SHARED) && !lazy_page_test(lazy->dirty, idx)) {
+        lazy_page_set(lazy->dirty, idx);
+        changed = true;
+    }
+    if (changed) {
+        ret = PalVirtualMemoryProtect((void*)addr, PAGE_SIZE,
+                                      lazy_page_prot(lazy, idx, prot, flags));
+        if (ret < 0) {
+            ret = pal_to_unix_errno(ret);
+            goto out;
+        }
+    }
+
+    *out_changed = changed;
+    ret = 0;
+out:
+    unlock(&lazy->lock);
+    put_handle(file);
+    put_lazy_pages(lazy);
+    return ret;
+}
+
+bool handle_lazy_page_fault(void* addr) {
+    if (!__atomic_load_n(&g_lazy_pages_cnt, __ATOMIC_RELAXED))
+        return false;
+
+    /* The access type is not known here, so a fault is handled as a read access, and a fault that
+     * repeats on the same page right after it was handled is handled as a write access (it can only
+     * be a write to a clean page of a shared mapping, otherwise it is a genuine access violation). */
+    uintptr_t page = ALIGN_DOWN((uintptr_t)addr, PAGE_SIZE);
+    bool write = LIBOS_TCB_GET(lazy_fault_addr) == page;
+
+    bool changed;
+    int ret = fault_in_lazy_page(page, write, &changed);
+    if (ret < 0) {
+        LIBOS_TCB_SET(lazy_fault_addr, 0);
+        if (ret != -ENOENT && ret != -EACCES)
+            log_warning("populating lazily mapped page at 0x%lx failed: %s", page,
+                        unix_strerror(ret));
+        return false;
+    }
+
+    if (!changed) {
+        if (write) {
+            /* the page is already accessible as a write, so it is a genuine access violation */
+            LIBOS_TCB_SET(lazy_fault_addr, 0);
+            return false;
+        }
+        /* the page was populated by another thread in the meantime, or this is a write to a clean
+         * page of a shared mapping */
+    }
+    LIBOS_TCB_SET(lazy_fault_addr, page);
+    return true;
+}
+
+int populate_lazy_pages(const void* addr, size_t length, bool write) {
+    if (!__atomic_load_n(&g_lazy_pages_cnt, __ATOMIC_RELAXED))
+        return 0;
+
+    uintptr_t begin = ALIGN_DOWN((uintptr_t)addr, PAGE_SIZE);
+    uintptr_t end = ALIGN_UP((uintptr_t)addr + length, PAGE_SIZE);
+    while (begin < end) {
+        vma_tree_read_lock();
+        struct libos_vma* vma = _lookup_vma(begin);
+        bool is_lazy = vma && is_addr_in_vma(begin, vma) && vma->lazy_pages;
+        uintptr_t next = vma ? (is_addr_in_vma(begin, vma) ? vma->end : vma->begin) : end;
+        uintptr_t populate_end = is_lazy ? MIN(vma->valid_end, end) : begin;
+        vma_tree_read_unlock();
+
+        for (uintptr_t page = begin; page < populate_end; page += PAGE_SIZE) {
+            bool changed;
+            int ret = fault_in_lazy_page(page, write, &changed);
+            if (ret < 0 && ret != -ENOENT)
+                return ret;
+        }
+        begin = next;
+    }
+    return 0;
+}
+
+int msync_lazy_pages(void* addr, size_t length,
+                     int (*write_back)(void* addr, size_t size, void* arg), void* arg) {
+    uintptr_t begin = (uintptr_t)addr;
+    uintptr_t end = begin + length;
+    assert(IS_ALIGNED(begin, PAGE_SIZE) && IS_ALIGNED(end, PAGE_SIZE));
+
+    struct libos_lazy_pages* lazy = get_lazy_pages_at(begin, /*out_file=*/NULL);
+    if (!lazy)
+        return -ENOENT;
+
+    int ret = 0;
+    uintptr_t run_begin = begin;
+    while (run_begin < end) {
+        lock(&lazy->lock);
+
+        int prot;
+        int flags;
+        uintptr_t valid_end;
+        uint64_t offset;
+        if (!get_lazy_vma_attrs(lazy, run_begin, &prot, &flags, &valid_end, &offset)) {
+            /* the mapping was changed concurrently, nothing to write back anymore */
+            unlock(&lazy->lock);
+            break;
+        }
+
+        while (run_begin < end && !lazy_page_test(lazy->dirty, lazy_page_idx(lazy, run_begin)))
+            run_begin += PAGE_SIZE;
+        uintptr_t run_end = run_begin;
+        while (run_end < end && lazy_page_test(lazy->dirty, lazy_page_idx(lazy, run_end))) {
+            lazy_page_clear(lazy->dirty, lazy_page_idx(lazy, run_end));
+            run_end += PAGE_SIZE;
+        }
+        if (run_begin == run_end) {
+            unlock(&lazy->lock);
+            break;
+        }
+
+        /* write-protect the run before writing it back, so that any concurrent writes mark the
+         * pages dirty again */
+        ret = lazy_pages_protect(lazy, run_begin, run_end, prot, flags);
+        unlock(&lazy->lock);
+        if (ret < 0)
+            BUG();
+
+        /* `write_back` may reload mappings of the file, so it must be called without the lock */
+        ret = write_back((void*)run_begin, run_end - run_begin, arg);
+        if (ret < 0) {
+            lock(&lazy->lock);
+            for (uintptr_t page = run_begin; page < run_end; page += PAGE_SIZE)
+                lazy_page_set(lazy->dirty, lazy_page_idx(lazy, page));
+            if (lazy_pages_protect(lazy, run_begin, run_end, prot, flags) < 0)
+                BUG();
+            unlock(&lazy->lock);
+            break;
+        }
+        run_begin = run_end;
+    }
+
+    put_lazy_pages(lazy);
+    return ret;
+}
+
+int protect_user_memory(void* addr, size_t length, int prot) {
+    if (!__atomic_load_n(&g_lazy_pages_cnt, __ATOMIC_RELAXED)) {
+        int ret = PalVirtualMemoryProtect(addr, length, LINUX_PROT_TO_PAL(prot, /*map_flags=*/0));
+        return ret < 0 ? pal_to_unix_errno(ret) : 0;
+    }
+
+    struct libos_vma_info* vma_infos;
+    size_t count;
+    uintptr_t begin = (uintptr_t)addr;
+    uintptr_t end = begin + length;
+    int ret = dump_vmas_in_range(begin, end, /*include_unmapped=*/false, &vma_infos, &count);
+    if (ret < 0)
+        return ret;
+
+    /* the range was successfully mprotected in bookkeeping, so it has no holes */
+    for (size_t i = 0; i < count; i++) {
+        struct libos_vma_info* vma_info = &vma_infos[i];
+        uintptr_t vma_begin = MAX(begin, (uintptr_t)vma_info->addr);
+        uintptr_t vma_end = MIN(end, (uintptr_t)vma_info->addr + vma_info->length);
+        uintptr_t lazy_end = vma_begin;
+
+        if (vma_info->lazy_pages) {
+            lazy_end = MAX(vma_begin, MIN(vma_end, (uintptr_t)vma_info->addr
+                                                   + vma_info->valid_length));
+            lock(&vma_info->lazy_pages->lock);
+            ret = lazy_pages_protect(vma_info->lazy_pages, vma_begin, lazy_end, vma_info->prot,
+                                     vma_info->flags);
+            unlock(&vma_info->lazy_pages->lock);
+            if (ret < 0)
+                goto out;
+        }
+        if (lazy_end < vma_end) {
+            ret = PalVirtualMemoryProtect((void*)lazy_end, vma_end - lazy_end,
+                                          LINUX_PROT_TO_PAL(prot, /*map_flags=*/0));
+            if (ret < 0) {
+                ret = pal_to_unix_errno(ret);
+                goto out;
+            }
+        }
+    }
+
+    ret = 0;
+out:
+    free_vma_info_array(vma_infos, count);
     return ret;
 }
 
@@ -1230,25 +1833,85 @@ static int pal_mem_bkeep_free(uintptr_t addr, size_t size) {
     return 0;
 }
 
-static int pal_mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags) {
-    struct libos_vma_info vma_info;
-    int ret = lookup_vma((void*)addr, &vma_info);
-    if (ret < 0)
-        return ret;
+/* Lockless version of `pal_mem_bkeep_get_vma_info()`, returns false if it has to be retried (or
+ * cannot be done locklessly). */
+static bool get_vma_info_lockless(uintptr_t addr, pal_prot_flags_t* out_prot_flags,
+                                  uintptr_t* out_begin, uintptr_t* out_end, int* out_ret) {
+    uint32_t seq = read_seqbegin(&vma_tree_lock);
+
+    struct libos_vma* vma;
+    if (!lookup_vma_lockless(seq, addr, &vma))
+        return false;
+
+    int ret = -ENOENT;
+    pal_prot_flags_t prot_flags = 0;
+    uintptr_t begin = 0;
+    uintptr_t valid_end = 0;
+    if (vma && (begin = __atomic_load_n(&vma->begin, __ATOMIC_RELAXED)) <= addr) {
+        /* lazily populated pages need to be looked up in `vma->lazy_pages`, which could be freed
+         * under our feet */
+        if (__atomic_load_n(&vma->lazy_pages, __ATOMIC_RELAXED))
+            return false;
+
+        valid_end = __atomic_load_n(&vma->valid_end, __ATOMIC_RELAXED);
+        if (addr >= valid_end) {
+            ret = -EACCES;
+        } else {
+            prot_flags = LINUX_PROT_TO_PAL(__atomic_load_n(&vma->prot, __ATOMIC_RELAXED),
+                                           __atomic_load_n(&vma->flags, __ATOMIC_RELAXED));
+            ret = 0;
+        }
+    }
+
+    if (read_seqretry(&vma_tree_lock, seq))
+        return false;
 
-    if (addr >= (uintptr_t)vma_info.addr + vma_info.valid_length) {
+    if (ret == 0) {
+        *out_prot_flags = prot_flags;
+        *out_begin = begin;
+        *out_end = valid_end;
+    }
+    *out_ret = ret;
+    return true;
+}
+
+static int pal_mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags,
+                                      uintptr_t* out_begin, uintptr_t* out_end) {
+    int ret;
+
+    for (size_t i = 0; i < VMA_LOCKLESS_ATTEMPTS; i++)
+        if (get_vma_info_lockless(addr, out_prot_flags, out_begin, out_end, &ret))
+            return ret;
+
+    vma_tree_read_lock();
+    struct libos_vma* vma = _lookup_vma(addr);
+    if (!vma || !is_addr_in_vma(addr, vma)) {
+        ret = -ENOENT;
+        goto out;
+    }
+
+    if (addr >= vma->valid_end) {
         ret = -EACCES;
         goto out;
     }
 
-    *out_prot_flags = LINUX_PROT_TO_PAL(vma_info.prot, vma_info.flags);
+    if (vma->lazy_pages) {
+        /* not yet populated pages are reported as inaccessible, so that the fault is propagated to
+         * LibOS and handled in `handle_lazy_page_fault()` */
+        size_t idx = lazy_page_idx(vma->lazy_pages, ALIGN_DOWN(addr, PAGE_SIZE));
+        *out_prot_flags = lazy_page_prot(vma->lazy_pages, idx, vma->prot, vma->flags);
+        /* neighbouring pages may be in a different state */
+        *out_begin = ALIGN_DOWN(addr, PAGE_SIZE);
+        *out_end = *out_begin + PAGE_SIZE;
+    } else {
+        *out_prot_flags = LINUX_PROT_TO_PAL(vma->prot, vma->flags);
+        *out_begin = vma->begin;
+        *out_end = vma->valid_end;
+    }
 
     ret = 0;
 out:
-    if (vma_info.file) {
-        put_handle(vma_info.file);
-    }
-
+    vma_tree_read_unlock();
     return ret;
 }
 
@@ -1263,15 +1926,59 @@ static void dump_vma(struct libos_vma_info* vma_info, struct libos_vma* vma) {
     if (vma_info->file) {
         get_handle(vma_info->file);
     }
+    /* set (with a reference taken) only in arrays of VMA infos, see `dump_vmas_with_buf()` */
+    vma_info->lazy_pages   = NULL;
     static_assert(sizeof(vma_info->comment) == sizeof(vma->comment), "Comments sizes do not match");
     memcpy(vma_info->comment, vma->comment, sizeof(vma_info->comment));
 }
 
+/* Lockless version of `lookup_vma()`, returns false if it has to be retried (or cannot be done
+ * locklessly). */
+static bool lookup_vma_info_lockless(uintptr_t addr, struct libos_vma_info* vma_info,
+                                     int* out_ret) {
+    uint32_t seq = read_seqbegin(&vma_tree_lock);
+
+    struct libos_vma* vma;
+    if (!lookup_vma_lockless(seq, addr, &vma))
+        return false;
+
+    int ret = -ENOENT;
+    struct libos_vma_info info = {0};
+    uintptr_t begin = vma ? __atomic_load_n(&vma->begin, __ATOMIC_RELAXED) : 0;
+    if (vma && begin <= addr) {
+        /* we would have to take a reference to the file, which could be freed under our feet */
+        if (__atomic_load_n(&vma->file, __ATOMIC_RELAXED))
+            return false;
+
+        info.addr         = (void*)begin;
+        info.length       = __atomic_load_n(&vma->end, __ATOMIC_RELAXED) - begin;
+        info.valid_length = __atomic_load_n(&vma->valid_end, __ATOMIC_RELAXED) - begin;
+        info.prot         = __atomic_load_n(&vma->prot, __ATOMIC_RELAXED);
+        info.flags        = __atomic_load_n(&vma->flags, __ATOMIC_RELAXED);
+        info.file_offset  = __atomic_load_n(&vma->offset, __ATOMIC_RELAXED);
+        for (size_t i = 0; i < sizeof(info.comment); i++)
+            info.comment[i] = __atomic_load_n(&vma->comment[i], __ATOMIC_RELAXED);
+        ret = 0;
+    }
+
+    if (read_seqretry(&vma_tree_lock, seq))
+        return false;
+
+    if (ret == 0)
+        *vma_info = info;
+    *out_ret = ret;
+    return true;
+}
+
 int lookup_vma(void* addr, struct libos_vma_info* vma_info) {
     assert(vma_info);
     int ret = 0;
 
-    spinlock_lock(&vma_tree_lock);
+    for (size_t i = 0; i < VMA_LOCKLESS_ATTEMPTS; i++)
+        if (lookup_vma_info_lockless((uintptr_t)addr, vma_info, &ret))
+            return ret;
+
+    vma_tree_read_lock();
     struct libos_vma* vma = _lookup_vma((uintptr_t)addr);
     if (!vma || !is_addr_in_vma((uintptr_t)addr, vma)) {
         ret = -ENOENT;
@@ -1281,7 +1988,7 @@ int lookup_vma(void* addr, struct libos_vma_info* vma_info) {
     dump_vma(vma_info, vma);
 
 out:
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
     return ret;
 }
 
@@ -1298,20 +2005,75 @@ static bool adj_visitor(struct libos_vma* vma, void* visitor_arg) {
     return is_ok;
 }
 
+/* Lockless version of `is_in_adjacent_user_vmas()` (see `_traverse_vmas_in_range()` and
+ * `adj_visitor()`), returns false if it has to be retried. */
+static bool is_in_adjacent_user_vmas_lockless(uintptr_t begin, uintptr_t end, int prot,
+                                              bool* out_result) {
+    if (begin == end) {
+        *out_result = true;
+        return true;
+    }
+
+    uint32_t seq = read_seqbegin(&vma_tree_lock);
+
+    struct libos_vma* vma;
+    if (!lookup_vma_lockless(seq, begin, &vma))
+        return false;
+
+    bool result = false;
+    uintptr_t vma_begin = vma ? __atomic_load_n(&vma->begin, __ATOMIC_RELAXED) : 0;
+    if (!vma || end <= vma_begin)
+        goto out;
+
+    bool is_continuous = vma_begin <= begin;
+    while (true) {
+        int vma_flags = __atomic_load_n(&vma->flags, __ATOMIC_RELAXED);
+        int vma_prot = __atomic_load_n(&vma->prot, __ATOMIC_RELAXED);
+        uintptr_t vma_valid_end = __atomic_load_n(&vma->valid_end, __ATOMIC_RELAXED);
+        if ((vma_flags & (VMA_INTERNAL | VMA_UNMAPPED)) || (vma_prot & prot) != prot)
+            goto out;
+
+        struct libos_vma* next;
+        if (!get_next_vma_lockless(seq, vma, &next))
+            return false;
+        uintptr_t next_begin = next ? __atomic_load_n(&next->begin, __ATOMIC_RELAXED) : 0;
+        if (!next || end <= next_begin) {
+            is_continuous &= end <= vma_valid_end;
+            break;
+        }
+
+        is_continuous &= vma_valid_end == next_begin;
+        vma = next;
+    }
+    result = is_continuous;
+
+out:
+    if (read_seqretry(&vma_tree_lock, seq))
+        return false;
+    *out_result = result;
+    return true;
+}
+
 bool is_in_adjacent_user_vmas(const void* addr, size_t length, int prot) {
     uintptr_t begin = (uintptr_t)addr;
     uintptr_t end = begin + length;
     assert(begin <= end);
 
+    for (size_t i = 0; i < VMA_LOCKLESS_ATTEMPTS; i++) {
+        bool result;
+        if (is_in_adjacent_user_vmas_lockless(begin, end, prot, &result))
+            return result;
+    }
+
     struct adj_visitor_ctx ctx = {
         .prot = prot,
         .is_ok = true,
     };
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_read_lock();
     bool is_continuous = _traverse_vmas_in_range(begin, end, /*use_only_valid_part=*/true,
                                                  adj_visitor, &ctx);
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
 
     return is_continuous && ctx.is_ok;
 }
@@ -1322,7 +2084,7 @@ static size_t dump_vmas_with_buf(struct libos_vma_info* infos, size_t max_count,
     size_t size = 0;
     struct libos_vma_info* vma_info = infos;
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_read_lock();
     struct libos_vma* vma;
 
     for (vma = _lookup_vma(begin); vma && vma->begin < end; vma = _get_next_vma(vma)) {
@@ -1330,12 +2092,15 @@ static size_t dump_vmas_with_buf(struct libos_vma_info* infos, size_t max_count,
             continue;
         if (size < max_count) {
             dump_vma(vma_info, vma);
+            vma_info->lazy_pages = vma->lazy_pages;
+            if (vma_info->lazy_pages)
+                get_lazy_pages(vma_info->lazy_pages);
             vma_info++;
         }
         size++;
     }
 
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
 
     return size;
 }
@@ -1364,14 +2129,14 @@ static int dump_vmas(struct libos_vma_info** out_infos, size_t* out_count,
 }
 
 static bool vma_filter_all(struct libos_vma* vma, void* arg) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     __UNUSED(arg);
 
     return !(vma->flags & VMA_INTERNAL);
 }
 
 static bool vma_filter_exclude_unmapped(struct libos_vma* vma, void* arg) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
     __UNUSED(arg);
 
     return !(vma->flags & (VMA_INTERNAL | VMA_UNMAPPED));
@@ -1394,6 +2159,9 @@ void free_vma_info_array(struct libos_vma_info* vma_infos, size_t count) {
         if (vma_infos[i].file) {
             put_handle(vma_infos[i].file);
         }
+        if (vma_infos[i].lazy_pages) {
+            put_lazy_pages(vma_infos[i].lazy_pages);
+        }
     }
 
     free(vma_infos);
@@ -1409,7 +2177,7 @@ struct madvise_dontneed_ctx {
 };
 
 static bool madvise_dontneed_visitor(struct libos_vma* vma, void* visitor_arg) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     struct madvise_dontneed_ctx* ctx = (struct madvise_dontneed_ctx*)visitor_arg;
 
@@ -1507,10 +2275,10 @@ int madvise_dontneed_range(uintptr_t begin, uintptr_t end) {
         .error = 0,
     };
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_read_lock();
     bool is_continuous = _traverse_vmas_in_range(begin, end, /*use_only_valid_part=*/false,
                                                  madvise_dontneed_visitor, &ctx);
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
 
     if (!is_continuous)
         return -ENOMEM;
@@ -1530,10 +2298,10 @@ int madvise_dontneed_range(uintptr_t begin, uintptr_t end) {
         .error = 0,
     };
 
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_read_lock();
     bool is_continuous = _traverse_vmas_in_range(begin, end, /*use_only_valid_part=*/false,
                                                  madvise_dontneed_visitor, &ctx);
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
 
     if (!is_continuous)
         ctx.error = -ENOMEM;
@@ -1542,8 +2310,92 @@ int madvise_dontneed_range(uintptr_t begin, uintptr_t end) {
 #endif
 }
 
+static bool madvise_free_visitor(struct libos_vma* vma, void* visitor_arg) {
+    assert(vma_tree_is_locked());
+
+    int* error = visitor_arg;
+    /* like on Linux, MADV_FREE is applicable only to private anonymous mappings */
+    if (vma->file || (vma->flags & (VMA_UNMAPPED | VMA_INTERNAL | MAP_SHARED))) {
+        *error = -EINVAL;
+        return false;
+    }
+    return true;
+}
+
+int madvise_free_range(uintptr_t begin, uintptr_t end) {
+    assert(IS_ALLOC_ALIGNED(begin));
+    assert(IS_ALLOC_ALIGNED(end));
+
+    int error = 0;
+    vma_tree_read_lock();
+    bool is_continuous = _traverse_vmas_in_range(begin, end, /*use_only_valid_part=*/false,
+                                                 madvise_free_visitor, &error);
+    vma_tree_read_unlock();
+
+    if (!is_continuous)
+        return -ENOMEM;
+    if (error < 0)
+        return error;
+
+    /* Gramine cannot learn whether a page was written after `madvise(MADV_FREE)` (an enclave does
+     * not see accesses to present pages), so the pages cannot be freed lazily. They cannot be handed
+     * to the PAL memory reclaimer either, for the same reason as in `madvise_dontneed_range()`.
+     * Freeing them right away would only add the cost of zeroing (or uncommitting and re-committing)
+     * the pages, without giving any memory back to the reclaim pool. Keeping the contents is allowed
+     * by MADV_FREE semantics, so this is a no-op after the above checks. */
+    return 0;
+}
+
+static int memory_reclaimer(void* arg) {
+    struct libos_thread* self = arg;
+
+    libos_tcb_init();
+    set_cur_thread(self);
+
+    log_setprefix(libos_get_tcb());
+
+    log_debug("Memory reclaimer thread started");
+
+    while (true) {
+        /* returns when the PAL reclaimed some freed memory, or when it should be called again */
+        int ret = PalVirtualMemoryReclaim();
+        if (ret < 0) {
+            log_error("Reclaiming freed memory failed: %s", pal_strerror(ret));
+            break;
+        }
+    }
+
+    log_error("Terminating the process due to a fatal error in memory reclaimer");
+    PalProcessExit(1);
+}
+
+int init_memory_reclaimer(void) {
+    struct pal_memory_reclaim_stats stats;
+    int ret = PalVirtualMemoryReclaimStatsQuery(&stats);
+    if (ret == PAL_ERROR_NOTIMPLEMENTED) {
+        /* freed memory is returned to the host immediately, nothing to do in the background */
+        return 0;
+    }
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+
+    struct libos_thread* thread = get_new_internal_thread();
+    if (!thread)
+        return -ENOMEM;
+
+    PAL_HANDLE handle = NULL;
+    ret = PalThreadCreate(memory_reclaimer, thread, &handle);
+    if (ret < 0) {
+        put_thread(thread);
+        return pal_to_unix_errno(ret);
+    }
+
+    thread->pal_handle = handle;
+    return 0;
+}
+
 static bool vma_filter_needs_reload(struct libos_vma* vma, void* arg) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     struct libos_handle* hdl = arg;
     assert(hdl && hdl->inode); /* guaranteed to have inode because invoked from `write` callback */
@@ -1565,11 +2417,32 @@ static bool vma_filter_needs_reload(struct libos_vma* vma, void* arg) {
     return true;
 }
 
+/* Drops clean populated pages of a lazily populated mapping, so that they are read again on next
+ * access. Dirty pages are kept, their contents are written back to the file on next `msync`. */
+static int reload_lazy_vma(struct libos_vma_info* vma_info) {
+    struct libos_lazy_pages* lazy = vma_info->lazy_pages;
+    uintptr_t begin = (uintptr_t)vma_info->addr;
+    uintptr_t end = begin + vma_info->valid_length;
+
+    lock(&lazy->lock);
+    for (uintptr_t page = begin; page < end; page += PAGE_SIZE) {
+        size_t idx = lazy_page_idx(lazy, page);
+        if (!lazy_page_test(lazy->dirty, idx))
+            lazy_page_clear(lazy->populated, idx);
+    }
+    int ret = lazy_pages_protect(lazy, begin, end, vma_info->prot, vma_info->flags);
+    unlock(&lazy->lock);
+    return ret;
+}
+
 static int reload_vma(struct libos_vma_info* vma_info) {
     int ret;
     struct libos_handle* file = vma_info->file;
     assert(file && file->fs && file->fs->fs_ops && file->fs->fs_ops->read);
 
+    if (vma_info->lazy_pages)
+        return reload_lazy_vma(vma_info);
+
     /* NOTE: Unfortunately there's a data race here: the memory can be unmapped, or remapped, by
      * another thread by the time we get to `read`. */
     uintptr_t read_begin = (uintptr_t)vma_info->addr;
@@ -1648,37 +2521,33 @@ out:
     return ret;
 }
 
-struct vma_update_valid_end_args {
-    struct libos_handle* hdl;
-    size_t file_size;
-};
-
-/* returns whether prot_refresh_vma() must be applied on a VMA */
-static bool vma_update_valid_end(struct libos_vma* vma, void* _args) {
-    assert(spinlock_is_locked(&vma_tree_lock));
-
-    struct vma_update_valid_end_args* args = _args;
+/* returns whether prot_refresh_vma() must be applied on a VMA, i.e. whether it maps `inode` */
+static bool vma_filter_mapped_from_inode(struct libos_vma* vma, void* arg) {
+    assert(vma_tree_is_locked());
 
-    /* guaranteed to have inode because invoked from `write` or `truncate` callback */
-    assert(args->hdl && args->hdl->inode);
+    struct libos_inode* inode = arg;
 
     if (vma->flags & (VMA_UNMAPPED | VMA_INTERNAL | MAP_ANONYMOUS))
         return false;
 
     assert(vma->file); /* check above filtered out non-file-backed mappings */
 
-    if (!vma->file->inode || vma->file->inode != args->hdl->inode)
-        return false;
+    return vma->file->inode && vma->file->inode == inode;
+}
+
+static void vma_update_valid_end(struct libos_vma* vma, size_t file_size) {
+    /* `valid_end` is read by lockless readers, so it can be changed only with the write lock */
+    assert(vma_tree_is_locked());
 
     size_t valid_length;
-    if (args->file_size >= vma->offset) {
+    if (file_size >= vma->offset) {
         size_t vma_length = vma->end - vma->begin;
-        if (args->file_size - vma->offset > vma_length) {
+        if (file_size - vma->offset > vma_length) {
             /* file size exceeds the mmapped part in VMA, the whole VMA is accessible */
             valid_length = vma_length;
         } else {
             /* file size is smaller than the mmapped part in VMA, only part of VMA is accessible */
-            valid_length = args->file_size - vma->offset;
+            valid_length = file_size - vma->offset;
         }
     } else {
         /* file got smaller than the offset from which VMA is mapped, all VMA is inaccessible */
@@ -1688,13 +2557,30 @@ static bool vma_update_valid_end(struct libos_vma* vma, void* _args) {
 
     vma->valid_end = vma->begin + valid_length;
     assert(vma->valid_end <= vma->end);
-
-    return true;
 }
 
 static int prot_refresh_vma(struct libos_vma_info* vma_info) {
     int ret;
 
+    if (vma_info->lazy_pages) {
+        struct libos_lazy_pages* lazy = vma_info->lazy_pages;
+        uintptr_t begin = (uintptr_t)vma_info->addr;
+        uintptr_t end = begin + vma_info->length;
+
+        lock(&lazy->lock);
+        /* pages beyond the end of file are not backed by the file anymore, so they must be read
+         * again if the file is extended later */
+        for (uintptr_t page = begin + vma_info->valid_length; page < end; page += PAGE_SIZE) {
+            lazy_page_clear(lazy->populated, lazy_page_idx(lazy, page));
+            lazy_page_clear(lazy->dirty, lazy_page_idx(lazy, page));
+        }
+        ret = lazy_pages_protect(lazy, begin, end, vma_info->prot, vma_info->flags);
+        unlock(&lazy->lock);
+        if (ret < 0)
+            BUG();
+        return 0;
+    }
+
     /* NOTE: Unfortunately there's a data race here: the memory can be unmapped, or remapped, by
      * another thread by the time we get to `PalVirtualMemoryProtect`. */
     if (vma_info->valid_length) {
@@ -1719,10 +2605,20 @@ static int prot_refresh_mmaped_from_file_handle(struct libos_handle* hdl, size_t
     struct libos_vma_info* vma_infos;
     size_t count;
 
-    struct vma_update_valid_end_args args = { .hdl = hdl, .file_size = file_size };
+    /* guaranteed to have inode because invoked from `write` or `truncate` callback */
+    assert(hdl->inode);
+
+    /* `dump_vmas()` below takes only the read lock, which does not exclude lockless readers, so
+     * `valid_end` is updated in a separate pass */
+    vma_tree_write_lock();
+    for (struct libos_vma* vma = _get_first_vma(); vma; vma = _get_next_vma(vma)) {
+        if (vma_filter_mapped_from_inode(vma, hdl->inode))
+            vma_update_valid_end(vma, file_size);
+    }
+    vma_tree_write_unlock();
 
     int ret = dump_vmas(&vma_infos, &count, /*begin=*/0, /*end=*/UINTPTR_MAX,
-                        vma_update_valid_end, &args);
+                        vma_filter_mapped_from_inode, hdl->inode);
     if (ret < 0)
         return ret;
 
@@ -1739,7 +2635,7 @@ out:
 }
 
 static bool vma_filter_needs_msync(struct libos_vma* vma, void* arg) {
-    assert(spinlock_is_locked(&vma_tree_lock));
+    assert(vma_tree_is_locked());
 
     struct libos_handle* hdl = arg;
 
@@ -1847,6 +2743,8 @@ BEGIN_CP_FUNC(vma) {
 
         new_vma = (struct libos_vma_info*)(base + off);
         *new_vma = *vma;
+        /* the child populates the memory itself (if remapped from file) or receives it in full */
+        new_vma->lazy_pages = NULL;
 
         if (vma->file)
             DO_CP(handle, vma->file, &new_vma->file);
@@ -1910,6 +2808,12 @@ BEGIN_CP_FUNC(vma) {
                  */
                 assert(vma->valid_length <= vma->length);
                 if (vma->valid_length > 0) {
+                    if (vma->lazy_pages) {
+                        int ret = populate_lazy_pages(vma->addr, vma->valid_length,
+                                                      /*write=*/false);
+                        if (ret < 0)
+                            return ret;
+                    }
                     struct libos_mem_entry* mem;
                     DO_CP_SIZE(memory, vma->addr, vma->valid_length, &mem);
                     mem->prot = LINUX_PROT_TO_PAL(vma->prot, /*map_flags=*/0);
@@ -2020,7 +2924,7 @@ static void debug_print_vma(struct libos_vma* vma) {
 }
 
 void debug_print_all_vmas(void) {
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_read_lock();
 
     struct libos_vma* vma = _get_first_vma();
     while (vma) {
@@ -2028,7 +2932,7 @@ void debug_print_all_vmas(void) {
         vma = _get_next_vma(vma);
     }
 
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
 }
 
 size_t get_peak_memory_usage(void) {
@@ -2036,9 +2940,9 @@ size_t get_peak_memory_usage(void) {
 }
 
 size_t get_total_memory_usage(void) {
-    spinlock_lock(&vma_tree_lock);
+    vma_tree_read_lock();
     size_t total_memory_size = g_total_memory_size;
-    spinlock_unlock(&vma_tree_lock);
+    vma_tree_read_unlock();
     /* This memory accounting is just a simple heuristic, which does not account swap, reserved
      * memory, unmapped VMAs etc. */
     return MIN(total_memory_size, g_pal_public_state->mem_total);
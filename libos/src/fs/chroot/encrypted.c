@@ -8,8 +8,9 @@
  *
  * This filesystem keeps the following data:
  *
- * - The mount (`libos_mount`) holds a `libos_encrypted_files_key` object. This is the encryption
- *   key for files. Multiple mounts can use the same key. The list of keys is managed in
+ * - The mount (`libos_mount`) holds a `libos_encrypted_mount` object with a
+ *   `libos_encrypted_files_key` object (the encryption key for files) and the size of node cache
+ *   for files. Multiple mounts can use the same key. The list of keys is managed in
  *   `libos_fs_encrypted.c`.
  *
  * - Inodes (`libos_inode`, for regular files) hold a `libos_encrypted_file` object in `inode->data`
@@ -51,6 +52,34 @@
  */
 #define HOST_PERM(perm) ((perm) | PERM_rw_______)
 
+struct libos_encrypted_mount {
+    struct libos_encrypted_files_key* key;
+    size_t cache_nodes; /* 0 for default */
+};
+
+/* Serialized mount data, used in checkpoint */
+struct libos_encrypted_mount_cp {
+    size_t cache_nodes;
+    char key_name[];
+};
+
+static int chroot_encrypted_alloc_mount(const char* key_name, size_t cache_nodes,
+                                        void** mount_data) {
+    struct libos_encrypted_files_key* key;
+    int ret = get_or_create_encrypted_files_key(key_name, &key);
+    if (ret < 0)
+        return ret;
+
+    struct libos_encrypted_mount* mount = malloc(sizeof(*mount));
+    if (!mount)
+        return -ENOMEM;
+    mount->key = key;
+    mount->cache_nodes = cache_nodes;
+
+    *mount_data = mount;
+    return 0;
+}
+
 static int chroot_encrypted_mount(struct libos_mount_params* params, void** mount_data) {
     if (!params->uri) {
         log_error("Missing file URI");
@@ -61,35 +90,40 @@ static int chroot_encrypted_mount(struct libos_mount_params* params, void** moun
         return -EINVAL;
     }
 
-    const char* key_name = params->key_name ?: "default";
+    size_t cache_nodes = params->cache_size / PF_NODE_SIZE;
+    if (params->cache_size && cache_nodes < PF_MIN_NODES_IN_CACHE) {
+        log_error("Cache size of encrypted mount '%s' is too small (minimum is %uK)", params->path,
+                  PF_MIN_NODES_IN_CACHE * PF_NODE_SIZE / 1024);
+        return -EINVAL;
+    }
 
-    struct libos_encrypted_files_key* key;
-    int ret = get_or_create_encrypted_files_key(key_name, &key);
-    if (ret < 0)
-        return ret;
+    const char* key_name = params->key_name ?: "default";
+    return chroot_encrypted_alloc_mount(key_name, cache_nodes, mount_data);
+}
 
-    *mount_data = key;
+static int chroot_encrypted_unmount(void* mount_data) {
+    free(mount_data);
     return 0;
 }
 
 static ssize_t chroot_encrypted_checkpoint(void** checkpoint, void* mount_data) {
-    struct libos_encrypted_files_key* key = mount_data;
+    struct libos_encrypted_mount* mount = mount_data;
 
-    *checkpoint = strdup(key->name);
-    if (!*checkpoint)
+    size_t name_size = strlen(mount->key->name) + 1;
+    struct libos_encrypted_mount_cp* cp = malloc(sizeof(*cp) + name_size);
+    if (!cp)
         return -ENOMEM;
-    return strlen(key->name) + 1;
+
+    cp->cache_nodes = mount->cache_nodes;
+    memcpy(cp->key_name, mount->key->name, name_size);
+
+    *checkpoint = cp;
+    return sizeof(*cp) + name_size;
 }
 
 static int chroot_encrypted_migrate(void* checkpoint, void** mount_data) {
-    const char* name = checkpoint;
-
-    struct libos_encrypted_files_key* key;
-    int ret = get_or_create_encrypted_files_key(name, &key);
-    if (ret < 0)
-        return ret;
-    *mount_data = key;
-    return 0;
+    struct libos_encrypted_mount_cp* cp = checkpoint;
+    return chroot_encrypted_alloc_mount(cp->key_name, cp->cache_nodes, mount_data);
 }
 
 static void chroot_encrypted_idrop(struct libos_inode* inode) {
@@ -153,8 +187,8 @@ static int chroot_encrypted_lookup(struct libos_dentry* dent) {
         struct libos_encrypted_file* enc;
         file_off_t size;
 
-        struct libos_encrypted_files_key* key = dent->mount->data;
-        ret = encrypted_file_open(uri, key, &enc);
+        struct libos_encrypted_mount* mount = dent->mount->data;
+        ret = encrypted_file_open(uri, mount->key, mount->cache_nodes, &enc);
         if (ret < 0) {
             if (ret == -EACCES) {
                 /* allow the inode to be created even if the underlying encrypted file is corrupted;
@@ -231,9 +265,9 @@ static int chroot_encrypted_creat(struct libos_handle* hdl, struct libos_dentry*
         goto out;
     }
 
-    struct libos_encrypted_files_key* key = dent->mount->data;
+    struct libos_encrypted_mount* mount = dent->mount->data;
     struct libos_encrypted_file* enc;
-    ret = encrypted_file_create(uri, HOST_PERM(perm), key, &enc);
+    ret = encrypted_file_create(uri, HOST_PERM(perm), mount->key, mount->cache_nodes, &enc);
     if (ret < 0)
         goto out;
 
@@ -533,6 +567,7 @@ static int chroot_encrypted_stat(struct libos_dentry* dent, struct stat* buf) {
 
 struct libos_fs_ops chroot_encrypted_fs_ops = {
     .mount      = &chroot_encrypted_mount,
+    .unmount    = &chroot_encrypted_unmount,
     .flush      = &chroot_encrypted_flush,
     .read       = &chroot_encrypted_read,
     .write      = &chroot_encrypted_write,
@@ -16,6 +16,7 @@
 
 #include "libos_flags_conv.h"
 #include "libos_fs.h"
+#include "libos_fs_cache.h"
 #include "libos_handle.h"
 #include "libos_internal.h"
 #include "libos_lock.h"
@@ -60,12 +61,31 @@ enum file_protection_kind {
     FILE_PROTECTION_KIND_TRUSTED,
 };
 
-/* this data is set up only once (at inode creation or restore), so doesn't require locking */
+/* Mount data, NULL if the mount uses default settings. */
+struct chroot_mount_data {
+    /* maximum number of pages in the page cache of each file, or 0 if the cache is disabled */
+    size_t page_cache_pages;
+};
+
+/* this data is set up only once (at inode creation or restore), so doesn't require locking; the
+ * exception are the `page_cache*` fields, which are protected by `inode->lock` (except for
+ * `page_cache_writer`, which is protected by the lock of the page cache) */
 struct chroot_inode_data {
     enum file_protection_kind prot_kind;
 
-    /* used only if `prot_kind == FILE_PROTECTION_KIND_TRUSTED`: array of hashes over file chunks */
+    /* page cache of the file (see `chroot_get_page_cache()`), the number of handles using it, and
+     * the PAL handle (of one of these handles) that last wrote to it, used to write back the dirty
+     * pages on checkpoint */
+    struct libos_page_cache* page_cache;
+    size_t page_cache_handles;
+    PAL_HANDLE page_cache_writer;
+
+    /* used only if `prot_kind == FILE_PROTECTION_KIND_TRUSTED`: array of hashes over file chunks,
+     * or Merkle tree of the file (if specified in the manifest); exactly one of them is set */
     struct trusted_chunk_hash* chunk_hashes;
+    struct trusted_file_tree* tree;
+    /* hash the file is verified against, identifies the file in the cache of verified chunks */
+    struct trusted_file_hash file_id;
 };
 
 static bool is_allowed_from_inode_data(struct libos_inode* inode) {
@@ -162,13 +182,16 @@ static int setup_inode_data(mode_t type, const char* uri, size_t file_size,
     struct trusted_file* tf = get_trusted_file(strip_prefix(uri));
     if (tf) {
         struct trusted_chunk_hash* out_chunk_hashes;
-        int ret = load_trusted_file(tf, file_size, &out_chunk_hashes);
+        struct trusted_file_tree* out_tree;
+        int ret = load_trusted_file(tf, file_size, &out_chunk_hashes, &out_tree);
         if (ret < 0) {
             free(data);
             return ret;
         }
         data->prot_kind = FILE_PROTECTION_KIND_TRUSTED;
         data->chunk_hashes = out_chunk_hashes;
+        data->tree = out_tree;
+        data->file_id = *get_trusted_file_id(tf);
         inode->data = data;
         return 0;
     }
@@ -183,7 +206,11 @@ static void chroot_idrop(struct libos_inode* inode) {
     assert(locked(&inode->lock));
     if (inode->data) {
         struct chroot_inode_data* data = inode->data;
+        /* the page cache is freed when the last handle using it is closed */
+        assert(!data->page_cache);
         free(data->chunk_hashes);
+        if (data->tree)
+            free_trusted_file_tree(data->tree);
         free(data);
     }
 }
@@ -199,21 +226,47 @@ static int chroot_icheckpoint(struct libos_inode* inode, void** out_data, size_t
 
     struct chroot_inode_data* idata = inode->data;
 
-    size_t chunk_hashes_size = 0;
-    if (idata->prot_kind == FILE_PROTECTION_KIND_TRUSTED)
-        chunk_hashes_size = get_chunk_hashes_size(inode->size);
+    /* the page cache is not migrated, so the new process has to find the data in the host file
+     * (there might be no writer if writing back the dirty pages failed before); this is the only
+     * place where the page cache does host I/O under `inode->lock` */
+    if (idata->page_cache) {
+        int ret = 0;
+        page_cache_lock(idata->page_cache);
+        if (idata->page_cache_writer && page_cache_has_dirty_pages(idata->page_cache))
+            ret = page_cache_flush(idata->page_cache, idata->page_cache_writer, inode->size);
+        page_cache_unlock(idata->page_cache);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* trusted file data: either array of chunk hashes or serialized Merkle tree */
+    void* tf_data = NULL;
+    size_t tf_data_size = 0;
+    if (idata->prot_kind == FILE_PROTECTION_KIND_TRUSTED) {
+        if (idata->tree) {
+            int ret = checkpoint_trusted_file_tree(idata->tree, &tf_data, &tf_data_size);
+            if (ret < 0)
+                return ret;
+        } else {
+            tf_data = idata->chunk_hashes;
+            tf_data_size = get_chunk_hashes_size(inode->size);
+        }
+    }
 
     struct chroot_checkpoint* cp;
-    size_t cp_size = sizeof(*cp) + sizeof(*idata) + chunk_hashes_size;
+    size_t cp_size = sizeof(*cp) + sizeof(*idata) + tf_data_size;
     cp = malloc(cp_size);
+    if (cp) {
+        cp->size = sizeof(*idata) + tf_data_size;
+        memcpy(cp->data, idata, sizeof(*idata));
+        if (tf_data_size)
+            memcpy(cp->data + sizeof(*idata), tf_data, tf_data_size);
+    }
+    if (idata->tree)
+        free(tf_data);
     if (!cp)
         return -ENOMEM;
 
-    cp->size = sizeof(*idata) + chunk_hashes_size;
-    memcpy(cp->data, idata, sizeof(*idata));
-    if (chunk_hashes_size)
-        memcpy(cp->data + sizeof(*idata), idata->chunk_hashes, chunk_hashes_size);
-
     *out_data = cp;
     *out_size = cp_size;
     return 0;
@@ -227,7 +280,20 @@ static int chroot_irestore(struct libos_inode* inode, void* data) {
         return -ENOMEM;
 
     memcpy(idata, cp->data, sizeof(*idata));
-    if (idata->prot_kind == FILE_PROTECTION_KIND_TRUSTED) {
+    idata->page_cache = NULL;
+    idata->page_cache_handles = 0;
+    idata->page_cache_writer = NULL;
+
+    if (idata->prot_kind == FILE_PROTECTION_KIND_TRUSTED && idata->tree) {
+        /* `idata->tree` is a stale pointer from the parent, it only tells that there is a tree */
+        idata->chunk_hashes = NULL;
+        int ret = restore_trusted_file_tree(cp->data + sizeof(*idata), cp->size - sizeof(*idata),
+                                            inode->size, &idata->tree);
+        if (ret < 0) {
+            free(idata);
+            return ret;
+        }
+    } else if (idata->prot_kind == FILE_PROTECTION_KIND_TRUSTED) {
         size_t chunk_hashes_size = cp->size - sizeof(*idata);
         idata->chunk_hashes = malloc(chunk_hashes_size);
         if (!idata->chunk_hashes) {
@@ -237,20 +303,64 @@ static int chroot_irestore(struct libos_inode* inode, void* data) {
         memcpy(idata->chunk_hashes, cp->data + sizeof(*idata), chunk_hashes_size);
     } else {
         idata->chunk_hashes = NULL;
+        idata->tree = NULL;
     }
 
     inode->data = idata;
     return 0;
 }
 
+static int chroot_alloc_mount(size_t page_cache_pages, void** mount_data) {
+    if (!page_cache_pages)
+        return 0;
+
+    struct chroot_mount_data* mdata = malloc(sizeof(*mdata));
+    if (!mdata)
+        return -ENOMEM;
+    mdata->page_cache_pages = page_cache_pages;
+
+    *mount_data = mdata;
+    return 0;
+}
+
 static int chroot_mount(struct libos_mount_params* params, void** mount_data) {
-    __UNUSED(mount_data);
     if (!params->uri || (!strstartswith(params->uri, URI_PREFIX_FILE) &&
                          !strstartswith(params->uri, URI_PREFIX_DEV)))
         return -EINVAL;
+
+    size_t page_cache_pages = params->cache_size / PAGE_CACHE_PAGE_SIZE;
+    if (params->cache_size && page_cache_pages < PAGE_CACHE_MIN_PAGES) {
+        log_error("Cache size of mount '%s' is too small (minimum is %dK)", params->path,
+                  PAGE_CACHE_MIN_PAGES * PAGE_CACHE_PAGE_SIZE / 1024);
+        return -EINVAL;
+    }
+
+    return chroot_alloc_mount(page_cache_pages, mount_data);
+}
+
+static int chroot_unmount(void* mount_data) {
+    free(mount_data);
     return 0;
 }
 
+static ssize_t chroot_checkpoint(void** checkpoint, void* mount_data) {
+    if (!mount_data)
+        return 0;
+
+    struct chroot_mount_data* cp = malloc(sizeof(*cp));
+    if (!cp)
+        return -ENOMEM;
+    memcpy(cp, mount_data, sizeof(*cp));
+
+    *checkpoint = cp;
+    return sizeof(*cp);
+}
+
+static int chroot_migrate(void* checkpoint, void** mount_data) {
+    struct chroot_mount_data* cp = checkpoint;
+    return chroot_alloc_mount(cp->page_cache_pages, mount_data);
+}
+
 static int chroot_dentry_uri(struct libos_dentry* dent, mode_t type, char** out_uri) {
     assert(dent->mount);
     assert(dent->mount->uri);
@@ -377,8 +487,8 @@ static int chroot_lookup(struct libos_dentry* dent) {
     dent->inode = inode;
     ret = 0;
 out:
-    if (ret < 0)
-        free(inode);
+    if (ret < 0 && inode)
+        put_inode(inode);
     free(uri);
     return ret;
 }
@@ -546,8 +656,8 @@ static int chroot_creat(struct libos_handle* hdl, struct libos_dentry* dent, int
     dent->inode = inode;
     ret = 0;
 out:
-    if (ret < 0)
-        free(inode);
+    if (ret < 0 && inode)
+        put_inode(inode);
     free(uri);
     return ret;
 }
@@ -576,15 +686,135 @@ static int chroot_mkdir(struct libos_dentry* dent, mode_t perm) {
     dent->inode = inode;
     ret = 0;
 out:
-    if (ret < 0)
-        free(inode);
+    if (ret < 0 && inode)
+        put_inode(inode);
     return ret;
 }
 
+static bool is_page_cache_enabled(struct libos_inode* inode) {
+    struct chroot_mount_data* mdata = inode->mount->data;
+    return mdata && inode->type == S_IFREG && !is_trusted_from_inode_data(inode);
+}
+
+/*
+ * Returns the page cache of the file (which is shared by all handles using it). If `hdl` does not
+ * use the page cache yet, registers it as a user (creating the page cache if necessary); it stops
+ * being a user when closed, see `chroot_close()`. Thus the page cache stays valid after releasing
+ * `inode->lock`.
+ *
+ * The host I/O is done with the lock of the page cache held, but not `inode->lock`. The lock of the
+ * page cache is taken after `inode->lock`, so the caller takes it before releasing `inode->lock`.
+ *
+ * The page cache is used only if it was enabled for the mount (with the `cache_size` parameter), see
+ * `is_page_cache_enabled()`. It is per-process: other processes see the writes after they are
+ * written back, which happens on `fsync`, on closing a handle opened for writing, on checkpoint
+ * (e.g. `fork`), and when there are too many dirty pages.
+ */
+static int chroot_get_page_cache(struct libos_handle* hdl, struct libos_page_cache** out_cache) {
+    assert(locked(&hdl->inode->lock));
+    assert(is_page_cache_enabled(hdl->inode));
+
+    struct chroot_inode_data* data = hdl->inode->data;
+    if (!hdl->info.chroot.uses_page_cache) {
+        if (!data->page_cache) {
+            struct chroot_mount_data* mdata = hdl->inode->mount->data;
+            int ret = page_cache_create(mdata->page_cache_pages, &data->page_cache);
+            if (ret < 0)
+                return ret;
+        }
+        data->page_cache_handles++;
+        hdl->info.chroot.uses_page_cache = true;
+    }
+    *out_cache = data->page_cache;
+    return 0;
+}
+
+static int chroot_close(struct libos_handle* hdl) {
+    assert(hdl->type == TYPE_CHROOT);
+
+    struct libos_inode* inode = hdl->inode;
+    struct chroot_inode_data* data = inode->data;
+    int ret = 0;
+
+    lock(&inode->lock);
+    if (!hdl->info.chroot.uses_page_cache) {
+        unlock(&inode->lock);
+        return 0;
+    }
+
+    struct libos_page_cache* cache = data->page_cache;
+    file_off_t size = inode->size;
+    page_cache_lock(cache);
+    unlock(&inode->lock);
+
+    if ((hdl->acc_mode & MAY_WRITE) && page_cache_has_dirty_pages(cache)) {
+        ret = page_cache_flush(cache, hdl->pal_handle, size);
+        if (ret < 0)
+            log_warning("Writing back cached data of '%s' failed: %s", hdl->uri,
+                        unix_strerror(ret));
+    }
+    if (!page_cache_has_dirty_pages(cache) || data->page_cache_writer == hdl->pal_handle)
+        data->page_cache_writer = NULL;
+    page_cache_unlock(cache);
+
+    lock(&inode->lock);
+    assert(data->page_cache_handles > 0);
+    if (--data->page_cache_handles == 0) {
+        /* no other handle uses the page cache, so it cannot be locked by anyone else */
+        page_cache_lock(cache);
+        bool dirty = page_cache_has_dirty_pages(cache);
+        page_cache_unlock(cache);
+        if (dirty)
+            log_warning("Discarding cached data of '%s' that could not be written back", hdl->uri);
+        page_cache_destroy(cache);
+        data->page_cache = NULL;
+        data->page_cache_writer = NULL;
+    }
+    hdl->info.chroot.uses_page_cache = false;
+    unlock(&inode->lock);
+    return ret;
+}
+
+static int chroot_checkout(struct libos_handle* hdl) {
+    /* The page cache is not migrated: the handle in the new process will create a new one. Dirty
+     * pages are written back when checkpointing the inode, see `chroot_icheckpoint()`. */
+    hdl->info.chroot.uses_page_cache = false;
+    return 0;
+}
+
 static int chroot_flush(struct libos_handle* hdl) {
     assert(hdl->type == TYPE_CHROOT);
 
-    int ret = PalStreamFlush(hdl->pal_handle);
+    int ret;
+    if (is_page_cache_enabled(hdl->inode)) {
+        struct chroot_inode_data* data = hdl->inode->data;
+        struct libos_page_cache* cache = NULL;
+        file_off_t size = 0;
+
+        lock(&hdl->inode->lock);
+        /* register as a user only if the page cache exists (otherwise there is nothing to write
+         * back), so that it is not destroyed while writing back */
+        ret = data->page_cache ? chroot_get_page_cache(hdl, &cache) : 0;
+        if (cache) {
+            size = hdl->inode->size;
+            page_cache_lock(cache);
+        }
+        unlock(&hdl->inode->lock);
+        if (ret < 0)
+            return ret;
+
+        if (cache) {
+            /* the dirty pages could have been written by another handle, so we write them back
+             * with the handle that wrote last (this handle might not be opened for writing) */
+            if (data->page_cache_writer)
+                ret = page_cache_flush(cache, data->page_cache_writer, size);
+            page_cache_unlock(cache);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    ret = PalStreamFlush(hdl->pal_handle);
     return pal_to_unix_errno(ret);
 }
 
@@ -598,10 +828,28 @@ static ssize_t chroot_read(struct libos_handle* hdl, void* buf, size_t count, fi
     if (is_trusted_from_inode_data(hdl->inode)) {
         struct chroot_inode_data* data = hdl->inode->data;
         ret = read_and_verify_trusted_file(hdl->pal_handle, offset, count, buf,
-                                           hdl->inode->size, data->chunk_hashes);
+                                           hdl->inode->size, data->chunk_hashes, data->tree,
+                                           &data->file_id);
         if (ret < 0)
             return ret;
         count = MIN(end, (uint64_t)hdl->inode->size) - offset;
+    } else if (is_page_cache_enabled(hdl->inode)) {
+        lock(&hdl->inode->lock);
+        struct libos_page_cache* cache;
+        ssize_t read = chroot_get_page_cache(hdl, &cache);
+        file_off_t size = hdl->inode->size;
+        if (read == 0)
+            page_cache_lock(cache);
+        unlock(&hdl->inode->lock);
+        if (read < 0)
+            return read;
+
+        read = page_cache_read(cache, hdl->pal_handle, size, offset, buf, count,
+                               hdl->flags & O_DIRECT ? PAGE_CACHE_DIRECT : 0);
+        page_cache_unlock(cache);
+        if (read < 0)
+            return read;
+        count = read;
     } else {
         ret = PalStreamRead(hdl->pal_handle, offset, &count, buf);
         if (ret < 0)
@@ -614,6 +862,73 @@ static ssize_t chroot_read(struct libos_handle* hdl, void* buf, size_t count, fi
     return count;
 }
 
+static file_off_t chroot_write_pos(struct libos_handle* hdl, file_off_t pos) {
+    lock(&hdl->inode->lock);
+    if (hdl->inode->type == S_IFREG && (hdl->flags & O_APPEND))
+        pos = hdl->inode->size;
+    unlock(&hdl->inode->lock);
+    return pos;
+}
+
+static void chroot_update_after_write(struct libos_handle* hdl, file_off_t actual_pos,
+                                      size_t count, file_off_t* pos) {
+    size_t new_size = 0;
+    if (hdl->inode->type == S_IFREG) {
+        *pos = actual_pos + count;
+        /* Update file size if we just wrote past the end of file */
+        lock(&hdl->inode->lock);
+        if (hdl->inode->size < *pos)
+            hdl->inode->size = *pos;
+        new_size = hdl->inode->size;
+        unlock(&hdl->inode->lock);
+    }
+
+    refresh_mappings_on_file(hdl, new_size, /*reload_file_contents=*/true);
+}
+
+static ssize_t chroot_write_cached(struct libos_handle* hdl, const void* buf, size_t count,
+                                   file_off_t* pos) {
+    struct libos_inode* inode = hdl->inode;
+    struct chroot_inode_data* data = inode->data;
+    size_t new_size = 0;
+
+    lock(&inode->lock);
+    struct libos_page_cache* cache;
+    ssize_t written = chroot_get_page_cache(hdl, &cache);
+    if (written < 0) {
+        unlock(&inode->lock);
+        return written;
+    }
+
+    file_off_t size = inode->size;
+    file_off_t actual_pos = hdl->flags & O_APPEND ? size : *pos;
+    page_cache_lock(cache);
+    unlock(&inode->lock);
+
+    /* `O_DIRECT` and `O_SYNC`/`O_DSYNC` (which includes `O_SYNC`) writes go to the host file
+     * immediately */
+    int flags = hdl->flags & (O_DIRECT | O_DSYNC) ? PAGE_CACHE_DIRECT : 0;
+    if (!(hdl->acc_mode & MAY_READ))
+        flags |= PAGE_CACHE_WRITE_ONLY;
+
+    written = page_cache_write(cache, hdl->pal_handle, size, actual_pos, buf, count, flags);
+    if (written >= 0 && page_cache_has_dirty_pages(cache))
+        data->page_cache_writer = hdl->pal_handle;
+    page_cache_unlock(cache);
+    if (written < 0)
+        return written;
+
+    lock(&inode->lock);
+    *pos = actual_pos + written;
+    if (inode->size < *pos)
+        inode->size = *pos;
+    new_size = inode->size;
+    unlock(&inode->lock);
+
+    refresh_mappings_on_file(hdl, new_size, /*reload_file_contents=*/true);
+    return written;
+}
+
 static ssize_t chroot_write(struct libos_handle* hdl, const void* buf, size_t count,
                             file_off_t* pos) {
     assert(hdl->type == TYPE_CHROOT);
@@ -623,29 +938,56 @@ static ssize_t chroot_write(struct libos_handle* hdl, const void* buf, size_t co
         return -EACCES;
     }
 
-    file_off_t actual_pos = *pos;
-    lock(&hdl->inode->lock);
-    if (hdl->inode->type == S_IFREG && (hdl->flags & O_APPEND))
-        actual_pos = hdl->inode->size;
-    unlock(&hdl->inode->lock);
+    if (is_page_cache_enabled(hdl->inode))
+        return chroot_write_cached(hdl, buf, count, pos);
+
+    file_off_t actual_pos = chroot_write_pos(hdl, *pos);
 
     int ret = PalStreamWrite(hdl->pal_handle, actual_pos, &count, (void*)buf);
     if (ret < 0) {
         return pal_to_unix_errno(ret);
     }
 
-    size_t new_size = 0;
-    if (hdl->inode->type == S_IFREG) {
-        *pos = actual_pos + count;
-        /* Update file size if we just wrote past the end of file */
-        lock(&hdl->inode->lock);
-        if (hdl->inode->size < *pos)
-            hdl->inode->size = *pos;
-        new_size = hdl->inode->size;
-        unlock(&hdl->inode->lock);
+    chroot_update_after_write(hdl, actual_pos, count, pos);
+    return (ssize_t)count;
+}
+
+static PAL_HANDLE chroot_host_read_handle(struct libos_handle* hdl) {
+    assert(hdl->type == TYPE_CHROOT);
+
+    /* trusted files must be verified while reading them, see `chroot_read()`; and with the page
+     * cache, the host file might not be up to date */
+    if (hdl->inode->type != S_IFREG || is_trusted_from_inode_data(hdl->inode)
+            || is_page_cache_enabled(hdl->inode))
+        return NULL;
+    return hdl->pal_handle;
+}
+
+static ssize_t chroot_write_from_host(struct libos_handle* hdl, PAL_HANDLE src,
+                                      file_off_t src_offset, size_t count, file_off_t* pos) {
+    assert(hdl->type == TYPE_CHROOT);
+
+    if (hdl->inode->type != S_IFREG)
+        return -EOPNOTSUPP;
+
+    if (is_trusted_from_inode_data(hdl->inode)) {
+        log_warning("Writing to a trusted file is disallowed!");
+        return -EACCES;
     }
 
-    refresh_mappings_on_file(hdl, new_size, /*reload_file_contents=*/true);
+    /* data transferred on the host would bypass the page cache */
+    if (is_page_cache_enabled(hdl->inode))
+        return -EOPNOTSUPP;
+
+    file_off_t actual_pos = chroot_write_pos(hdl, *pos);
+
+    int ret = PalStreamTransfer(src, src_offset, hdl->pal_handle, actual_pos, &count);
+    if (ret == PAL_ERROR_NOTSUPPORT)
+        return -EOPNOTSUPP;
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+
+    chroot_update_after_write(hdl, actual_pos, count, pos);
     return (ssize_t)count;
 }
 
@@ -779,6 +1121,31 @@ static int chroot_chmod(struct libos_dentry* dent, mode_t perm) {
     return 0;
 }
 
+static int chroot_truncate(struct libos_handle* hdl, file_off_t size) {
+    if (!is_page_cache_enabled(hdl->inode))
+        return generic_truncate(hdl, size);
+
+    struct chroot_inode_data* data = hdl->inode->data;
+
+    lock(&hdl->inode->lock);
+    int ret = PalStreamSetLength(hdl->pal_handle, size);
+    if (ret < 0) {
+        unlock(&hdl->inode->lock);
+        return pal_to_unix_errno(ret);
+    }
+
+    if (data->page_cache) {
+        page_cache_lock(data->page_cache);
+        page_cache_truncate(data->page_cache, size);
+        page_cache_unlock(data->page_cache);
+    }
+    hdl->inode->size = size;
+    unlock(&hdl->inode->lock);
+
+    refresh_mappings_on_file(hdl, size, /*reload_file_contents=*/false);
+    return 0;
+}
+
 static int chroot_fchmod(struct libos_handle* hdl, mode_t perm) {
     int ret;
 
@@ -792,20 +1159,27 @@ static int chroot_fchmod(struct libos_handle* hdl, mode_t perm) {
 }
 
 struct libos_fs_ops chroot_fs_ops = {
-    .mount      = &chroot_mount,
-    .flush      = &chroot_flush,
-    .read       = &chroot_read,
-    .write      = &chroot_write,
-    .mmap       = &generic_emulated_mmap,
-    .msync      = &generic_emulated_msync,
+    .mount            = &chroot_mount,
+    .unmount          = &chroot_unmount,
+    .close            = &chroot_close,
+    .flush            = &chroot_flush,
+    .read             = &chroot_read,
+    .write            = &chroot_write,
+    .host_read_handle = &chroot_host_read_handle,
+    .write_from_host  = &chroot_write_from_host,
+    .mmap             = &generic_emulated_mmap,
+    .msync            = &generic_emulated_msync,
     /* TODO: this function emulates lseek() completely inside the LibOS, but some device files may
      * report size == 0 during fstat() and may provide device-specific lseek() logic; this emulation
      * breaks for such device-specific cases */
-    .seek       = &generic_inode_seek,
-    .hstat      = &generic_inode_hstat,
-    .truncate   = &generic_truncate,
-    .poll       = &generic_inode_poll,
-    .fchmod     = &chroot_fchmod,
+    .seek             = &generic_inode_seek,
+    .hstat            = &generic_inode_hstat,
+    .truncate         = &chroot_truncate,
+    .poll             = &generic_inode_poll,
+    .checkout         = &chroot_checkout,
+    .checkpoint       = &chroot_checkpoint,
+    .migrate          = &chroot_migrate,
+    .fchmod           = &chroot_fchmod,
 };
 
 struct libos_d_ops chroot_d_ops = {
@@ -16,6 +16,29 @@
  * each chunk (of size TRUSTED_CHUNK_SIZE) in the file. The per-chunk hashes are used for partial
  * verification in future reads, to avoid re-verifying the whole file again or the need of caching
  * the whole file contents.
+ *
+ * Loading the whole file on first open is slow for large files (e.g. ML models), so the manifest
+ * may additionally specify a Merkle tree for a trusted file: `merkle_root` (hash stored in the
+ * manifest) and `merkle_tree` (URI of a host file with the tree, generated by `gramine-manifest`
+ * and `gramine-sgx-sign` with `--merkle-tree-dir`). Such files are not loaded on open; instead,
+ * each chunk is verified against the tree when it is read, and the tree itself is read from the
+ * host and verified on demand. The tree has the following format:
+ *
+ * - Level 0 consists of SHA256 hashes of file chunks (of size TRUSTED_CHUNK_SIZE).
+ * - Each level is split into nodes of TRUSTED_TREE_NODE_SIZE bytes (the last node of a level is
+ *   padded with zeros); there is always at least one node in a level.
+ * - Level N+1 consists of SHA256 hashes of the nodes of level N. The top level has a single node.
+ * - The root is the SHA256 hash of the file size (64-bit little-endian integer) followed by the top
+ *   node, so the tree also authenticates the file size.
+ * - The tree file contains all nodes of all levels, starting from the top level.
+ *
+ * Verified nodes of the tree are cached in memory (per inode) until the inode is dropped.
+ *
+ * Verified chunks of all trusted files are additionally kept in a cache shared by all trusted files
+ * (and all their handles), bounded by `sgx.trusted_files_cache_size` with LRU eviction, so that
+ * re-reads of hot chunks are served without reading the host file and re-hashing. Chunks are
+ * identified by the hash the file is verified against (SHA256 of the file or root of its Merkle
+ * tree), so files with the same contents share cache entries, and by chunk index.
  */
 
 #include <stdbool.h>
@@ -25,25 +48,75 @@
 #include "crypto.h"
 #include "hex.h"
 #include "libos_fs.h"
+#include "libos_lock.h"
+#include "libos_refcount.h"
+#include "libos_uthash.h"
 #include "list.h"
 #include "path_utils.h"
 #include "toml.h"
+#include "toml_utils.h"
 
 /* FIXME: current size is 16KB, but maybe there's a better size for perf/mem trade-off? */
 #define TRUSTED_CHUNK_SIZE (PAGE_SIZE * 4UL)
 
-/* FIXME: use hash table instead of list */
-DEFINE_LIST(trusted_file);
+#define TRUSTED_TREE_NODE_SIZE   4096UL
+#define TRUSTED_TREE_NODE_HASHES (TRUSTED_TREE_NODE_SIZE / sizeof(struct trusted_file_hash))
+/* enough for 2^64-byte files: TRUSTED_CHUNK_SIZE * TRUSTED_TREE_NODE_HASHES^8 > 2^64 */
+#define TRUSTED_TREE_MAX_LEVELS  8
+
 struct trusted_file {
-    LIST_TYPE(trusted_file) list;
+    UT_hash_handle hh; /* key is `path` */
     struct trusted_file_hash file_hash;      /* hash over file, retrieved from the manifest */
+    struct trusted_file_hash tree_root;      /* root of Merkle tree, valid if `tree_uri` is set */
+    char* tree_uri;                          /* URI of Merkle tree file, or NULL if none */
     size_t path_len;
     char path[]; /* must be NULL-terminated */
 };
 
-/* initialized once at startup and read-only afterwards, so doesn't require locking */
-DEFINE_LISTP(trusted_file);
-static LISTP_TYPE(trusted_file) g_trusted_file_list = LISTP_INIT;
+struct trusted_tree_node {
+    struct trusted_file_hash hashes[TRUSTED_TREE_NODE_HASHES];
+};
+
+struct trusted_file_tree {
+    struct libos_lock lock; /* protects `handle` and `nodes` */
+    struct trusted_file_hash root;
+    uint64_t file_size;
+    size_t levels_cnt;
+    size_t level_nodes_cnt[TRUSTED_TREE_MAX_LEVELS];
+    uint64_t level_offsets[TRUSTED_TREE_MAX_LEVELS]; /* offsets of levels in the tree file */
+    /* verified nodes of each level, NULL if not read yet; nodes are freed only with the tree */
+    struct trusted_tree_node** nodes[TRUSTED_TREE_MAX_LEVELS];
+    PAL_HANDLE handle; /* tree file, opened on first use */
+    char uri[];        /* must be NULL-terminated */
+};
+
+/* hash table of trusted files (by normalized path); initialized once at startup and read-only
+ * afterwards, so doesn't require locking */
+static struct trusted_file* g_trusted_files = NULL;
+
+DEFINE_LIST(trusted_chunk);
+struct trusted_chunk {
+    UT_hash_handle hh; /* key is `key` */
+    LIST_TYPE(trusted_chunk) lru_list;
+    refcount_t ref_count; /* one reference is held by the cache while the chunk is in it */
+    struct trusted_chunk_key {
+        struct trusted_file_hash file_id;
+        uint64_t idx;
+    } key;
+    size_t size;
+    uint8_t data[];
+};
+DEFINE_LISTP(trusted_chunk);
+
+/* cache of verified chunks, see the description at the top of this file */
+static struct libos_lock g_chunk_cache_lock;
+static struct trusted_chunk* g_chunk_cache = NULL;
+static LISTP_TYPE(trusted_chunk) g_chunk_cache_lru = LISTP_INIT; /* most recently used first */
+static size_t g_chunk_cache_cnt = 0;
+static size_t g_chunk_cache_max_cnt = 0; /* 0 if the cache is disabled; set once at startup */
+static uint64_t g_chunk_cache_hits = 0;
+static uint64_t g_chunk_cache_misses = 0;
+static uint64_t g_chunk_cache_evictions = 0;
 
 static int read_file_exact(PAL_HANDLE handle, void* buffer, uint64_t offset, size_t size) {
     size_t buffer_offset = 0;
@@ -81,29 +154,342 @@ struct trusted_file* get_trusted_file(const char* path) {
     }
 
     struct trusted_file* tf = NULL;
-    struct trusted_file* tmp;
-    LISTP_FOR_EACH_ENTRY(tmp, &g_trusted_file_list, list) {
-        if (tmp->path_len == norm_path_size - 1 && !memcmp(tmp->path, norm_path, norm_path_size)) {
-            tf = tmp;
+    HASH_FIND(hh, g_trusted_files, norm_path, norm_path_size - 1, tf);
+    free(norm_path);
+    return tf;
+}
+
+static int compute_sha256(const void* prefix, size_t prefix_size, const void* data, size_t size,
+                          struct trusted_file_hash* out_hash) {
+    LIB_SHA256_CONTEXT sha;
+    int ret = lib_SHA256Init(&sha);
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+    if (prefix_size) {
+        ret = lib_SHA256Update(&sha, prefix, prefix_size);
+        if (ret < 0)
+            return pal_to_unix_errno(ret);
+    }
+    ret = lib_SHA256Update(&sha, data, size);
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+    ret = lib_SHA256Final(&sha, out_hash->bytes);
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+    return 0;
+}
+
+static int create_trusted_file_tree(const char* uri, const struct trusted_file_hash* root,
+                                    uint64_t file_size, struct trusted_file_tree** out_tree) {
+    size_t uri_size = strlen(uri) + 1;
+    struct trusted_file_tree* tree = calloc(1, sizeof(*tree) + uri_size);
+    if (!tree)
+        return -ENOMEM;
+
+    if (!create_lock(&tree->lock)) {
+        free(tree);
+        return -ENOMEM;
+    }
+    memcpy(tree->uri, uri, uri_size);
+    memcpy(&tree->root, root, sizeof(*root));
+    tree->file_size = file_size;
+
+    uint64_t chunks_cnt = UDIV_ROUND_UP(file_size, TRUSTED_CHUNK_SIZE);
+    uint64_t nodes_cnt = MAX(UDIV_ROUND_UP(chunks_cnt, TRUSTED_TREE_NODE_HASHES), 1UL);
+    while (true) {
+        assert(tree->levels_cnt < TRUSTED_TREE_MAX_LEVELS);
+        tree->level_nodes_cnt[tree->levels_cnt++] = nodes_cnt;
+        if (nodes_cnt == 1)
             break;
+        nodes_cnt = UDIV_ROUND_UP(nodes_cnt, TRUSTED_TREE_NODE_HASHES);
+    }
+
+    /* levels are stored in the tree file starting from the top one */
+    uint64_t offset = 0;
+    for (size_t level = tree->levels_cnt; level > 0; level--) {
+        tree->level_offsets[level - 1] = offset;
+        offset += tree->level_nodes_cnt[level - 1] * TRUSTED_TREE_NODE_SIZE;
+    }
+
+    for (size_t level = 0; level < tree->levels_cnt; level++) {
+        tree->nodes[level] = calloc(tree->level_nodes_cnt[level], sizeof(*tree->nodes[level]));
+        if (!tree->nodes[level]) {
+            free_trusted_file_tree(tree);
+            return -ENOMEM;
         }
     }
-    free(norm_path);
-    return tf;
+
+    *out_tree = tree;
+    return 0;
+}
+
+void free_trusted_file_tree(struct trusted_file_tree* tree) {
+    for (size_t level = 0; level < tree->levels_cnt; level++) {
+        if (!tree->nodes[level])
+            continue;
+        for (size_t i = 0; i < tree->level_nodes_cnt[level]; i++)
+            free(tree->nodes[level][i]);
+        free(tree->nodes[level]);
+    }
+    if (tree->handle)
+        PalObjectDestroy(tree->handle);
+    destroy_lock(&tree->lock);
+    free(tree);
+}
+
+/* Returns node `idx` of `level`, reading it from the tree file and verifying it (together with all
+ * its not-yet-verified ancestors) if needed. */
+static int get_tree_node(struct trusted_file_tree* tree, size_t level, uint64_t idx,
+                         struct trusted_tree_node** out_node) {
+    assert(locked(&tree->lock));
+    assert(level < tree->levels_cnt && idx < tree->level_nodes_cnt[level]);
+
+    if (tree->nodes[level][idx]) {
+        *out_node = tree->nodes[level][idx];
+        return 0;
+    }
+
+    struct trusted_tree_node* parent = NULL;
+    if (level + 1 < tree->levels_cnt) {
+        int ret = get_tree_node(tree, level + 1, idx / TRUSTED_TREE_NODE_HASHES, &parent);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!tree->handle) {
+        int ret = PalStreamOpen(tree->uri, PAL_ACCESS_RDONLY, /*share_flags=*/0, PAL_CREATE_NEVER,
+                                /*options=*/0, &tree->handle);
+        if (ret < 0) {
+            log_warning("Cannot open Merkle tree file '%s' of trusted file", tree->uri);
+            return pal_to_unix_errno(ret);
+        }
+    }
+
+    struct trusted_tree_node* node = malloc(sizeof(*node));
+    if (!node)
+        return -ENOMEM;
+
+    int ret = read_file_exact(tree->handle, node,
+                              tree->level_offsets[level] + idx * TRUSTED_TREE_NODE_SIZE,
+                              sizeof(*node));
+    if (ret < 0)
+        goto out;
+
+    struct trusted_file_hash hash;
+    const struct trusted_file_hash* expected_hash;
+    if (parent) {
+        ret = compute_sha256(/*prefix=*/NULL, 0, node, sizeof(*node), &hash);
+        expected_hash = &parent->hashes[idx % TRUSTED_TREE_NODE_HASHES];
+    } else {
+        /* top node, the root hash also covers the file size (x86-64 is little-endian) */
+        ret = compute_sha256(&tree->file_size, sizeof(tree->file_size), node, sizeof(*node), &hash);
+        expected_hash = &tree->root;
+    }
+    if (ret < 0)
+        goto out;
+
+    if (memcmp(&hash, expected_hash, sizeof(hash))) {
+        log_warning("Merkle tree file '%s' does not match the trusted file or the root hash in "
+                    "manifest", tree->uri);
+        ret = -EPERM;
+        goto out;
+    }
+
+    tree->nodes[level][idx] = node;
+    *out_node = node;
+    ret = 0;
+out:
+    if (ret < 0)
+        free(node);
+    return ret;
+}
+
+static int verify_chunk_with_tree(struct trusted_file_tree* tree, uint64_t chunk_idx,
+                                  const struct trusted_file_hash* chunk_hash) {
+    struct trusted_tree_node* node;
+
+    lock(&tree->lock);
+    int ret = get_tree_node(tree, /*level=*/0, chunk_idx / TRUSTED_TREE_NODE_HASHES, &node);
+    unlock(&tree->lock);
+    if (ret < 0)
+        return ret;
+
+    /* verified nodes are never modified nor freed while the tree is in use */
+    if (memcmp(&node->hashes[chunk_idx % TRUSTED_TREE_NODE_HASHES], chunk_hash,
+               sizeof(*chunk_hash)))
+        return -EPERM;
+    return 0;
+}
+
+int checkpoint_trusted_file_tree(struct trusted_file_tree* tree, void** out_data,
+                                 size_t* out_size) {
+    /* verified nodes are not checkpointed, the child re-reads them on demand */
+    size_t uri_size = strlen(tree->uri) + 1;
+    size_t size = sizeof(tree->root) + uri_size;
+    char* data = malloc(size);
+    if (!data)
+        return -ENOMEM;
+
+    memcpy(data, &tree->root, sizeof(tree->root));
+    memcpy(data + sizeof(tree->root), tree->uri, uri_size);
+
+    *out_data = data;
+    *out_size = size;
+    return 0;
+}
+
+int restore_trusted_file_tree(const void* data, size_t size, size_t file_size,
+                              struct trusted_file_tree** out_tree) {
+    const struct trusted_file_hash* root = data;
+    const char* uri = (const char*)data + sizeof(*root);
+    if (size <= sizeof(*root) || uri[size - sizeof(*root) - 1] != '\0')
+        return -EINVAL;
+    return create_trusted_file_tree(uri, root, file_size, out_tree);
+}
+
+static void put_chunk(struct trusted_chunk* chunk) {
+    if (!refcount_dec(&chunk->ref_count))
+        free(chunk);
+}
+
+/* Copies `size` bytes at `offset` in chunk `idx` of file `file_id` to `buf` if the chunk is cached;
+ * returns false otherwise. The copy is done outside of the cache lock, holding a reference to the
+ * chunk (which may be evicted in the meantime). */
+static bool chunk_cache_read(const struct trusted_file_hash* file_id, uint64_t idx, uint8_t* buf,
+                             size_t offset, size_t size) {
+    if (!g_chunk_cache_max_cnt)
+        return false;
+
+    struct trusted_chunk_key key;
+    memset(&key, 0, sizeof(key));
+    memcpy(&key.file_id, file_id, sizeof(*file_id));
+    key.idx = idx;
+
+    struct trusted_chunk* chunk;
+    lock(&g_chunk_cache_lock);
+    HASH_FIND(hh, g_chunk_cache, &key, sizeof(key), chunk);
+    if (chunk && offset + size <= chunk->size) {
+        refcount_inc(&chunk->ref_count);
+        LISTP_DEL(chunk, &g_chunk_cache_lru, lru_list);
+        LISTP_ADD(chunk, &g_chunk_cache_lru, lru_list);
+        g_chunk_cache_hits++;
+    } else {
+        chunk = NULL;
+        g_chunk_cache_misses++;
+    }
+    unlock(&g_chunk_cache_lock);
+
+    if (!chunk)
+        return false;
+
+    memcpy(buf, chunk->data + offset, size);
+    put_chunk(chunk);
+    return true;
+}
+
+/* Adds a verified chunk to the cache, evicting the least recently used one if the cache is full.
+ * The cache is best-effort, so failures are ignored. */
+static void chunk_cache_add(const struct trusted_file_hash* file_id, uint64_t idx,
+                            const uint8_t* data, size_t size) {
+    if (!g_chunk_cache_max_cnt)
+        return;
+
+    struct trusted_chunk* new = malloc(sizeof(*new) + size);
+    if (!new)
+        return;
+
+    memset(&new->key, 0, sizeof(new->key));
+    memcpy(&new->key.file_id, file_id, sizeof(*file_id));
+    new->key.idx = idx;
+    new->size = size;
+    memcpy(new->data, data, size);
+    INIT_LIST_HEAD(new, lru_list);
+    refcount_set(&new->ref_count, 1);
+
+    struct trusted_chunk* to_free = NULL;
+    lock(&g_chunk_cache_lock);
+    struct trusted_chunk* old;
+    HASH_FIND(hh, g_chunk_cache, &new->key, sizeof(new->key), old);
+    if (old) {
+        /* another thread verified and added the same chunk in the meantime */
+        to_free = new;
+    } else {
+        if (g_chunk_cache_cnt == g_chunk_cache_max_cnt) {
+            to_free = LISTP_LAST_ENTRY(&g_chunk_cache_lru, struct trusted_chunk, lru_list);
+            LISTP_DEL(to_free, &g_chunk_cache_lru, lru_list);
+            HASH_DELETE(hh, g_chunk_cache, to_free);
+            g_chunk_cache_cnt--;
+            g_chunk_cache_evictions++;
+        }
+        HASH_ADD(hh, g_chunk_cache, key, sizeof(new->key), new);
+        LISTP_ADD(new, &g_chunk_cache_lru, lru_list);
+        g_chunk_cache_cnt++;
+    }
+    unlock(&g_chunk_cache_lock);
+
+    if (to_free)
+        put_chunk(to_free);
+}
+
+void get_trusted_files_cache_stats(struct trusted_files_cache_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!g_chunk_cache_max_cnt)
+        return;
+
+    lock(&g_chunk_cache_lock);
+    stats->size      = g_chunk_cache_cnt * TRUSTED_CHUNK_SIZE;
+    stats->max_size  = g_chunk_cache_max_cnt * TRUSTED_CHUNK_SIZE;
+    stats->hits      = g_chunk_cache_hits;
+    stats->misses    = g_chunk_cache_misses;
+    stats->evictions = g_chunk_cache_evictions;
+    unlock(&g_chunk_cache_lock);
+}
+
+const struct trusted_file_hash* get_trusted_file_id(struct trusted_file* tf) {
+    return tf->tree_uri ? &tf->tree_root : &tf->file_hash;
 }
 
 size_t get_chunk_hashes_size(size_t file_size) {
     return sizeof(struct trusted_chunk_hash) * UDIV_ROUND_UP(file_size, TRUSTED_CHUNK_SIZE);
 }
 
-/* calculate chunk hashes and compare with hash in manifest */
+static int load_trusted_file_tree(struct trusted_file* tf, size_t file_size,
+                                  struct trusted_file_tree** out_tree) {
+    struct trusted_file_tree* tree;
+    int ret = create_trusted_file_tree(tf->tree_uri, &tf->tree_root, file_size, &tree);
+    if (ret < 0)
+        return ret;
+
+    /* verify the top node right away, to detect mismatched file size or tree early */
+    struct trusted_tree_node* node;
+    lock(&tree->lock);
+    ret = get_tree_node(tree, tree->levels_cnt - 1, /*idx=*/0, &node);
+    unlock(&tree->lock);
+    if (ret < 0) {
+        log_warning("Merkle tree of trusted file '%s' does not match the file", tf->path);
+        free_trusted_file_tree(tree);
+        return ret;
+    }
+
+    *out_tree = tree;
+    return 0;
+}
+
+/* calculate chunk hashes and compare with hash in manifest, or (if the manifest specifies a Merkle
+ * tree for the file) only prepare the tree for lazy verification */
 int load_trusted_file(struct trusted_file* tf, size_t file_size,
-                      struct trusted_chunk_hash** out_chunk_hashes) {
+                      struct trusted_chunk_hash** out_chunk_hashes,
+                      struct trusted_file_tree** out_tree) {
     int ret;
     uint8_t* tmp_chunk = NULL;
     struct trusted_chunk_hash* chunk_hashes = NULL;
     PAL_HANDLE handle = NULL;
 
+    if (tf->tree_uri) {
+        *out_chunk_hashes = NULL;
+        return load_trusted_file_tree(tf, file_size, out_tree);
+    }
+
     char* uri = alloc_concat(URI_PREFIX_FILE, URI_PREFIX_FILE_LEN, tf->path, tf->path_len);
     if (!uri) {
         ret = -ENOMEM;
@@ -194,6 +580,7 @@ int load_trusted_file(struct trusted_file* tf, size_t file_size,
     }
 
     *out_chunk_hashes = chunk_hashes;
+    *out_tree = NULL;
     ret = 0;
 out:
     if (ret < 0)
@@ -206,7 +593,9 @@ out:
 }
 
 int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t count, uint8_t* buf,
-                                 size_t file_size, struct trusted_chunk_hash* chunk_hashes) {
+                                 size_t file_size, struct trusted_chunk_hash* chunk_hashes,
+                                 struct trusted_file_tree* tree,
+                                 const struct trusted_file_hash* file_id) {
     int ret;
 
     if (offset >= file_size)
@@ -215,18 +604,27 @@ int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t coun
     uint64_t end = MIN(offset + count, file_size);
     uint64_t aligned_offset = ALIGN_DOWN(offset, TRUSTED_CHUNK_SIZE);
 
-    /* FIXME: use pre-allocated object in common case (e.g. for the first thread) */
-    uint8_t* tmp_chunk = malloc(TRUSTED_CHUNK_SIZE);
-    if (!tmp_chunk)
-        return -ENOMEM;
+    /* scratch buffer for chunks which can't be verified in place; allocated on the first such chunk
+     * which is not cached (so reads served from the cache don't need it) */
+    uint8_t* tmp_chunk = NULL;
 
     uint8_t* buf_pos = buf;
     uint64_t chunk_offset = aligned_offset;
-    struct trusted_chunk_hash* chunk_hashes_item = chunk_hashes +
-                                                       aligned_offset / TRUSTED_CHUNK_SIZE;
     for (; chunk_offset < end; chunk_offset += TRUSTED_CHUNK_SIZE) {
         size_t chunk_size  = MIN(file_size - chunk_offset, TRUSTED_CHUNK_SIZE);
         uint64_t chunk_end = chunk_offset + chunk_size;
+        uint64_t chunk_idx = chunk_offset / TRUSTED_CHUNK_SIZE;
+
+        /* determine which part of the chunk is needed by the caller */
+        uint64_t copy_start = MAX(chunk_offset, offset);
+        uint64_t copy_end   = MIN(chunk_end, end);
+        assert(copy_end > copy_start);
+
+        if (chunk_cache_read(file_id, chunk_idx, buf_pos, copy_start - chunk_offset,
+                             copy_end - copy_start)) {
+            buf_pos += copy_end - copy_start;
+            continue;
+        }
 
         LIB_SHA256_CONTEXT chunk_sha;
         ret = lib_SHA256Init(&chunk_sha);
@@ -235,7 +633,10 @@ int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t coun
             goto out;
         }
 
-        if (chunk_offset >= offset && chunk_end <= end) {
+        /* chunks to be cached are always verified in the scratch buffer: the caller's buffer may be
+         * modified concurrently by other threads, so data hashed there can't be trusted later */
+        bool in_place = !g_chunk_cache_max_cnt && chunk_offset >= offset && chunk_end <= end;
+        if (in_place) {
             /* if current chunk-to-verify completely resides in the requested region-to-copy,
              * directly copy into buf (without a scratch buffer) and hash in-place */
             ret = read_file_exact(handle, buf_pos, chunk_offset, chunk_size);
@@ -251,6 +652,13 @@ int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t coun
             /* if current chunk-to-verify only partially overlaps with the requested region-to-copy,
              * read the file contents into a scratch buffer, verify hash and then copy only the part
              * needed by the caller */
+            if (!tmp_chunk) {
+                tmp_chunk = malloc(TRUSTED_CHUNK_SIZE);
+                if (!tmp_chunk) {
+                    ret = -ENOMEM;
+                    goto out;
+                }
+            }
             ret = read_file_exact(handle, tmp_chunk, chunk_offset, chunk_size);
             if (ret < 0)
                 goto out;
@@ -259,14 +667,6 @@ int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t coun
                 ret = pal_to_unix_errno(ret);
                 goto out;
             }
-
-            /* determine which part of the chunk is needed by the caller */
-            uint64_t copy_start = MAX(chunk_offset, offset);
-            uint64_t copy_end   = MIN(chunk_offset + chunk_size, end);
-            assert(copy_end > copy_start);
-
-            memcpy(buf_pos, tmp_chunk + copy_start - chunk_offset, copy_end - copy_start);
-            buf_pos += copy_end - copy_start;
         }
 
         struct trusted_chunk_hash chunk_hash[2]; /* each chunk_hash is 128 bits in size */
@@ -277,12 +677,21 @@ int read_and_verify_trusted_file(PAL_HANDLE handle, uint64_t offset, size_t coun
             goto out;
         }
 
-        if (memcmp(chunk_hashes_item, &chunk_hash[0], sizeof(*chunk_hashes_item))) {
+        if (tree) {
+            ret = verify_chunk_with_tree(tree, chunk_idx,
+                                         (struct trusted_file_hash*)&chunk_hash[0]);
+            if (ret < 0)
+                goto out;
+        } else if (memcmp(&chunk_hashes[chunk_idx], &chunk_hash[0], sizeof(*chunk_hashes))) {
             ret = -EPERM;
             goto out;
         }
 
-        chunk_hashes_item++;
+        if (!in_place) {
+            chunk_cache_add(file_id, chunk_idx, tmp_chunk, chunk_size);
+            memcpy(buf_pos, tmp_chunk + copy_start - chunk_offset, copy_end - copy_start);
+            buf_pos += copy_end - copy_start;
+        }
     }
 
     ret = 0;
@@ -291,50 +700,40 @@ out:
     return ret;
 }
 
-static int register_trusted_file(const char* path, const char* hash_str) {
-    if (strlen(hash_str) != sizeof(struct trusted_file_hash) * 2) {
-        log_error("Hash (%s) of a trusted file %s is not a SHA256 hash", hash_str, path);
-        return -EINVAL;
-    }
-
-    size_t path_len = strlen(path);
-    if (path_len > URI_MAX) {
-        log_error("Size of file exceeds maximum %dB: %s", URI_MAX, path);
-        return -EINVAL;
+/* Parses a SHA256 hash from a TOML value. Hashes are plain hex strings, so they are decoded directly
+ * from the raw TOML value if possible, without allocating an unescaped copy (which matters for
+ * manifests with many thousands of trusted files). */
+static int parse_toml_hash(toml_raw_t raw, struct trusted_file_hash* out_hash) {
+    size_t hex_len = sizeof(out_hash->bytes) * 2;
+    if ((raw[0] == '"' || raw[0] == '\'') && strlen(raw) == hex_len + 2
+            && raw[hex_len + 1] == raw[0]) {
+        return hex2bytes(raw + 1, hex_len, out_hash->bytes, sizeof(out_hash->bytes)) ? 0 : -EINVAL;
     }
 
-    struct trusted_file_hash file_hash;
-    char* bytes = hex2bytes(hash_str, strlen(hash_str), file_hash.bytes, sizeof(file_hash.bytes));
-    if (!bytes) {
-        log_error("Could not parse hash of trusted file: %s", path);
+    char* str = NULL;
+    int ret = toml_rtos(raw, &str);
+    if (ret < 0 || !str)
         return -EINVAL;
-    }
-
-    struct trusted_file* new = malloc(sizeof(*new) + path_len + 1);
-    if (!new)
-        return -ENOMEM;
-
-    INIT_LIST_HEAD(new, list);
-    new->path_len = path_len;
-    memcpy(new->path, path, path_len + 1);
-    memcpy(&new->file_hash, &file_hash, sizeof(file_hash));
 
-    LISTP_ADD_TAIL(new, &g_trusted_file_list, list);
-    return 0;
+    ret = 0;
+    if (strlen(str) != hex_len || !hex2bytes(str, hex_len, out_hash->bytes,
+                                             sizeof(out_hash->bytes)))
+        ret = -EINVAL;
+    free(str);
+    return ret;
 }
 
 static int init_one_trusted_file(toml_raw_t toml_trusted_uri_raw,
-                                 toml_raw_t toml_trusted_sha256_raw, size_t idx) {
+                                 toml_raw_t toml_trusted_sha256_raw,
+                                 toml_raw_t toml_trusted_merkle_root_raw,
+                                 toml_raw_t toml_trusted_merkle_tree_raw, size_t idx) {
     int ret;
 
-    /* FIXME: toml_trusted_uri_str and toml_trusted_sha256_str are temporary strings, allocating
-     *        them is redundant; however tomlc99 lib has only toml_rtos() function that returns a
-     *        newly allocated string rather than a slice into the parsed TOML structure */
+    /* FIXME: toml_trusted_uri_str is a temporary string, allocating it is redundant; however
+     *        tomlc99 lib has only toml_rtos() function that returns a newly allocated string rather
+     *        than a slice into the parsed TOML structure */
     char* toml_trusted_uri_str = NULL;
-    char* toml_trusted_sha256_str = NULL;
-
-    /* FIXME: instead of re-allocating in register_trusted_file(), could pass ownership to it */
-    char* norm_trusted_path = NULL;
+    struct trusted_file* new = NULL;
 
     ret = toml_rtos(toml_trusted_uri_raw, &toml_trusted_uri_str);
     if (ret < 0 || !toml_trusted_uri_str) {
@@ -343,13 +742,6 @@ static int init_one_trusted_file(toml_raw_t toml_trusted_uri_raw,
         goto out;
     }
 
-    ret = toml_rtos(toml_trusted_sha256_raw, &toml_trusted_sha256_str);
-    if (ret < 0 || !toml_trusted_sha256_str) {
-        log_error("Invalid trusted file in manifest at index %ld ('sha256' is not a string)", idx);
-        ret = -EINVAL;
-        goto out;
-    }
-
     if (!strstartswith(toml_trusted_uri_str, URI_PREFIX_FILE)) {
         log_error("Invalid URI [%s]: Trusted files must start with '" URI_PREFIX_FILE "'",
                   toml_trusted_uri_str);
@@ -357,39 +749,115 @@ static int init_one_trusted_file(toml_raw_t toml_trusted_uri_raw,
         goto out;
     }
 
+    /* the path is normalized directly into the new object, normalized path is never longer */
     size_t norm_trusted_path_size = strlen(toml_trusted_uri_str) - URI_PREFIX_FILE_LEN + 1;
-    norm_trusted_path = malloc(norm_trusted_path_size);
-    if (!norm_trusted_path) {
+    if (norm_trusted_path_size - 1 > URI_MAX) {
+        log_error("Size of file exceeds maximum %dB: %s", URI_MAX, toml_trusted_uri_str);
+        ret = -EINVAL;
+        goto out;
+    }
+
+    new = malloc(sizeof(*new) + norm_trusted_path_size);
+    if (!new) {
         ret = -ENOMEM;
         goto out;
     }
+    new->tree_uri = NULL;
 
-    bool normalized = get_norm_path(toml_trusted_uri_str + URI_PREFIX_FILE_LEN,
-                                    norm_trusted_path, &norm_trusted_path_size);
+    bool normalized = get_norm_path(toml_trusted_uri_str + URI_PREFIX_FILE_LEN, new->path,
+                                    &norm_trusted_path_size);
     if (!normalized) {
         log_error("Trusted file path (%s) normalization failed", toml_trusted_uri_str);
         ret = -EINVAL;
         goto out;
     }
+    new->path_len = norm_trusted_path_size - 1;
 
-    ret = register_trusted_file(norm_trusted_path, toml_trusted_sha256_str);
+    ret = parse_toml_hash(toml_trusted_sha256_raw, &new->file_hash);
     if (ret < 0) {
-        log_error("Trusted file registration (%s) failed", toml_trusted_uri_str);
+        log_error("Hash of trusted file %s is not a SHA256 hash", toml_trusted_uri_str);
+        goto out;
+    }
+
+    if (!toml_trusted_merkle_root_raw != !toml_trusted_merkle_tree_raw) {
+        log_error("Invalid trusted file in manifest at index %ld ('merkle_root' and 'merkle_tree' "
+                  "must be specified together)", idx);
+        ret = -EINVAL;
+        goto out;
+    }
+
+    if (toml_trusted_merkle_root_raw) {
+        ret = parse_toml_hash(toml_trusted_merkle_root_raw, &new->tree_root);
+        if (ret < 0) {
+            log_error("Could not parse Merkle tree root of trusted file: %s",
+                      toml_trusted_uri_str);
+            goto out;
+        }
+
+        ret = toml_rtos(toml_trusted_merkle_tree_raw, &new->tree_uri);
+        if (ret < 0 || !new->tree_uri) {
+            log_error("Invalid trusted file in manifest at index %ld ('merkle_tree' is not a "
+                      "string)", idx);
+            ret = -EINVAL;
+            goto out;
+        }
+
+        if (!strstartswith(new->tree_uri, URI_PREFIX_FILE)) {
+            log_error("Invalid URI [%s]: Merkle trees of trusted files must start with '"
+                      URI_PREFIX_FILE "'", new->tree_uri);
+            ret = -EINVAL;
+            goto out;
+        }
+    }
+
+    struct trusted_file* old;
+    HASH_FIND(hh, g_trusted_files, new->path, new->path_len, old);
+    if (old) {
+        /* duplicate entry (normally deduplicated by manifest tools), keep the first one */
+        ret = 0;
         goto out;
     }
 
+    HASH_ADD_KEYPTR(hh, g_trusted_files, new->path, new->path_len, new);
+    new = NULL;
     ret = 0;
 out:
-    free(norm_trusted_path);
+    if (new) {
+        free(new->tree_uri);
+        free(new);
+    }
     free(toml_trusted_uri_str);
-    free(toml_trusted_sha256_str);
     return ret;
 }
 
+static int init_trusted_files_cache(void) {
+    uint64_t cache_size;
+    int ret = toml_sizestring_in(g_manifest_root, "sgx.trusted_files_cache_size",
+                                 /*defaultval=*/0, &cache_size);
+    if (ret < 0) {
+        log_error("Cannot parse 'sgx.trusted_files_cache_size'");
+        return -EINVAL;
+    }
+
+    if (!cache_size)
+        return 0;
+
+    if (!create_lock(&g_chunk_cache_lock))
+        return -ENOMEM;
+
+    /* the cache holds at least one chunk */
+    g_chunk_cache_max_cnt = MAX(cache_size / TRUSTED_CHUNK_SIZE, 1UL);
+    return 0;
+}
+
 int init_trusted_files(void) {
     int ret;
 
     assert(g_manifest_root);
+
+    ret = init_trusted_files_cache();
+    if (ret < 0)
+        return ret;
     toml_table_t* manifest_sgx = toml_table_in(g_manifest_root, "sgx");
     if (!manifest_sgx)
         return 0;
@@ -421,7 +889,12 @@ int init_trusted_files(void) {
             return -EINVAL;
         }
 
-        ret = init_one_trusted_file(toml_trusted_uri_raw, toml_trusted_sha256_raw, i);
+        /* optional, for lazy verification of large files */
+        toml_raw_t toml_trusted_merkle_root_raw = toml_raw_in(toml_trusted_file, "merkle_root");
+        toml_raw_t toml_trusted_merkle_tree_raw = toml_raw_in(toml_trusted_file, "merkle_tree");
+
+        ret = init_one_trusted_file(toml_trusted_uri_raw, toml_trusted_sha256_raw,
+                                    toml_trusted_merkle_root_raw, toml_trusted_merkle_tree_raw, i);
         if (ret < 0)
             return ret;
     }
@@ -24,13 +24,41 @@ static struct libos_lock dcache_mgr_lock;
 
 #define DCACHE_MGR_ALLOC 64
 
+/* Number of children examined for garbage collection when adding a new child. Must be more than 1,
+ * so that unused children are collected faster than new ones are added. */
+#define DCACHE_GC_BATCH 2
+
+/* Initial number of buckets in the dentry hash table. The table doubles when it holds more dentries
+ * than it has buckets (see `grow_dcache_hash`). */
+#define DCACHE_HASH_INIT_BUCKETS (1 << 10)
+
 #define OBJ_TYPE struct libos_dentry
 #include "memmgr.h"
 
 struct libos_lock g_dcache_lock;
+seqlock_t g_dcache_seqlock = INIT_SEQLOCK_UNLOCKED;
 
 static MEM_MGR dentry_mgr = NULL;
 
+/*
+ * Hash table of all dentries that have a parent, indexed by parent and name (see `dentry_hash`).
+ * Each bucket is a list of dentries linked by `hash_next`. The dentries are added at the head of a
+ * bucket with a release store, so that lockless readers always see a fully initialized dentry;
+ * removal and moving dentries to a bigger table happen under `g_dcache_seqlock`. Protected by
+ * `g_dcache_lock`.
+ *
+ * Replaced tables are never freed, because lockless readers may still access them. This wastes at
+ * most as much memory as the current table takes (the tables only grow, by doubling).
+ */
+struct dcache_hash_table {
+    size_t mask; /* number of buckets - 1 */
+    struct dcache_hash_table* old; /* replaced (smaller) table */
+    struct libos_dentry* buckets[];
+};
+
+static struct dcache_hash_table* g_dcache_hash = NULL;
+static size_t g_dcache_hash_cnt = 0;
+
 struct libos_dentry* g_dentry_root = NULL;
 
 static struct libos_dentry* alloc_dentry(void) {
@@ -57,6 +85,18 @@ int init_dcache(void) {
     }
 
     dentry_mgr = create_mem_mgr(init_align_up(DCACHE_MGR_ALLOC));
+    if (!dentry_mgr)
+        return -ENOMEM;
+
+    g_dcache_hash = calloc(1, sizeof(*g_dcache_hash)
+                                  + DCACHE_HASH_INIT_BUCKETS * sizeof(g_dcache_hash->buckets[0]));
+    if (!g_dcache_hash)
+        return -ENOMEM;
+    g_dcache_hash->mask = DCACHE_HASH_INIT_BUCKETS - 1;
+
+    int ret = init_inodes();
+    if (ret < 0)
+        return ret;
 
     if (g_pal_public_state->parent_process) {
         /* In a child process, `g_dentry_root` will be restored from a checkpoint. */
@@ -144,22 +184,114 @@ void put_dentry(struct libos_dentry* dent) {
     }
 }
 
+/* FNV-1a hash of the name, seeded with the parent pointer. */
+static size_t dentry_hash(struct libos_dentry* parent, const char* name, size_t name_len) {
+    uint64_t hash = 0xcbf29ce484222325UL ^ (uintptr_t)parent;
+    for (size_t i = 0; i < name_len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 0x100000001b3UL;
+    }
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static struct libos_dentry** dentry_bucket(struct dcache_hash_table* table,
+                                           struct libos_dentry* parent, const char* name,
+                                           size_t name_len) {
+    return &table->buckets[dentry_hash(parent, name, name_len) & table->mask];
+}
+
+/* Moves all dentries to a new table with twice as many buckets. On allocation failure, the table
+ * stays as it is (so lookups only get slower). */
+static void grow_dcache_hash(void) {
+    struct dcache_hash_table* old = g_dcache_hash;
+    size_t buckets_cnt = (old->mask + 1) * 2;
+    struct dcache_hash_table* new = calloc(1, sizeof(*new) + buckets_cnt * sizeof(new->buckets[0]));
+    if (!new)
+        return;
+    new->mask = buckets_cnt - 1;
+    new->old = old;
+
+    /* lockless readers walking the old table during the move will retry */
+    write_seqbegin(&g_dcache_seqlock);
+    for (size_t i = 0; i <= old->mask; i++) {
+        struct libos_dentry* dent = old->buckets[i];
+        while (dent) {
+            struct libos_dentry* next = dent->hash_next;
+            struct libos_dentry** bucket = dentry_bucket(new, dent->parent, dent->name,
+                                                         dent->name_len);
+            __atomic_store_n(&dent->hash_next, *bucket, __ATOMIC_RELAXED);
+            *bucket = dent;
+            dent = next;
+        }
+        __atomic_store_n(&old->buckets[i], NULL, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&g_dcache_hash, new, __ATOMIC_RELEASE);
+    write_seqend(&g_dcache_seqlock);
+}
+
+static void add_child(struct libos_dentry* parent, struct libos_dentry* dent) {
+    LISTP_ADD_TAIL(dent, &parent->children, siblings);
+
+    if (g_dcache_hash_cnt > g_dcache_hash->mask)
+        grow_dcache_hash();
+
+    struct libos_dentry** bucket = dentry_bucket(g_dcache_hash, parent, dent->name,
+                                                 dent->name_len);
+    dent->hash_next = *bucket;
+    __atomic_store_n(bucket, dent, __ATOMIC_RELEASE);
+    g_dcache_hash_cnt++;
+}
+
+static void remove_from_hash(struct libos_dentry* dent) {
+    struct libos_dentry** ptr = dentry_bucket(g_dcache_hash, dent->parent, dent->name,
+                                              dent->name_len);
+    while (*ptr != dent) {
+        assert(*ptr);
+        ptr = &(*ptr)->hash_next;
+    }
+
+    write_seqbegin(&g_dcache_seqlock);
+    *ptr = dent->hash_next;
+    write_seqend(&g_dcache_seqlock);
+    g_dcache_hash_cnt--;
+}
+
+static bool dentry_unused(struct libos_dentry* dent) {
+    return refcount_get(&dent->ref_count) == 1 && !dent->inode;
+}
+
 void dentry_gc(struct libos_dentry* dent) {
     assert(locked(&g_dcache_lock));
     assert(dent->parent);
 
-    if (refcount_get(&dent->ref_count) != 1)
-        return;
-
-    if (dent->inode)
+    if (!dentry_unused(dent))
         return;
 
     LISTP_DEL_INIT(dent, &dent->parent->children, siblings);
+    remove_from_hash(dent);
     dent->parent->nchildren--;
     /* This should delete `dent` */
     put_dentry(dent);
 }
 
+/*
+ * Examines the first `DCACHE_GC_BATCH` children of `parent`: deletes the unused ones, and moves the
+ * rest to the end of the list, so that all children are eventually examined.
+ */
+static void gc_children(struct libos_dentry* parent) {
+    for (size_t i = 0; i < DCACHE_GC_BATCH && !LISTP_EMPTY(&parent->children); i++) {
+        struct libos_dentry* child = LISTP_FIRST_ENTRY(&parent->children, struct libos_dentry,
+                                                       siblings);
+        if (dentry_unused(child)) {
+            dentry_gc(child);
+        } else {
+            LISTP_DEL(child, &parent->children, siblings);
+            LISTP_ADD_TAIL(child, &parent->children, siblings);
+        }
+    }
+}
+
 struct libos_dentry* get_new_dentry(struct libos_mount* mount, struct libos_dentry* parent,
                                     const char* name, size_t name_len) {
     assert(locked(&g_dcache_lock));
@@ -192,8 +324,10 @@ struct libos_dentry* get_new_dentry(struct libos_mount* mount, struct libos_dent
         get_dentry(parent);
         dent->parent = parent;
 
+        gc_children(parent);
+
         get_dentry(dent);
-        LISTP_ADD_TAIL(dent, &parent->children, siblings);
+        add_child(parent, dent);
         parent->nchildren++;
     }
 
@@ -213,16 +347,52 @@ struct libos_dentry* lookup_dcache(struct libos_dentry* parent, const char* name
     assert(parent);
     assert(name_len > 0);
 
-    struct libos_dentry* tmp;
-    struct libos_dentry* dent;
-    LISTP_FOR_EACH_ENTRY_SAFE(dent, tmp, &parent->children, siblings) {
-        if (dent->name_len == name_len && memcmp(dent->name, name, dent->name_len) == 0) {
+    struct libos_dentry* dent = *dentry_bucket(g_dcache_hash, parent, name, name_len);
+    for (; dent; dent = dent->hash_next) {
+        if (dent->parent == parent && dent->name_len == name_len
+                && !memcmp(dent->name, name, name_len)) {
             get_dentry(dent);
             return dent;
         }
-        dentry_gc(dent);
     }
+    return NULL;
+}
 
+/*
+ * This function can read dentries that were concurrently removed and freed (or even reused), so it
+ * validates `seq` before following any pointer read from a dentry. Dentries and their names are
+ * never unmapped, so reading them is always safe, but the memory can be poisoned by ASan.
+ */
+__attribute_no_sanitize_address
+struct libos_dentry* lookup_dcache_lockless(struct libos_dentry* parent, const char* name,
+                                            size_t name_len, uint32_t seq) {
+    assert(name_len > 0);
+
+    /* tables are never freed, so the one loaded here stays accessible even if it's replaced */
+    struct dcache_hash_table* table = __atomic_load_n(&g_dcache_hash, __ATOMIC_ACQUIRE);
+    struct libos_dentry* dent = __atomic_load_n(dentry_bucket(table, parent, name, name_len),
+                                                __ATOMIC_ACQUIRE);
+    while (dent) {
+        if (read_seqretry(&g_dcache_seqlock, seq))
+            return NULL;
+
+        struct libos_dentry* dent_parent = __atomic_load_n(&dent->parent, __ATOMIC_RELAXED);
+        size_t dent_name_len = __atomic_load_n(&dent->name_len, __ATOMIC_RELAXED);
+        const char* dent_name = __atomic_load_n(&dent->name, __ATOMIC_RELAXED);
+        struct libos_dentry* next = __atomic_load_n(&dent->hash_next, __ATOMIC_ACQUIRE);
+        if (read_seqretry(&g_dcache_seqlock, seq))
+            return NULL;
+
+        if (dent_parent == parent && dent_name_len == name_len) {
+            /* not `memcmp`, which might be instrumented by ASan */
+            size_t i = 0;
+            while (i < name_len && dent_name[i] == name[i])
+                i++;
+            if (i == name_len)
+                return dent;
+        }
+        dent = next;
+    }
     return NULL;
 }
 
@@ -412,60 +582,6 @@ out:
     return ret;
 }
 
-struct libos_inode* get_new_inode(struct libos_mount* mount, mode_t type, mode_t perm) {
-    assert(mount);
-
-    struct libos_inode* inode = calloc(1, sizeof(*inode));
-    if (!inode)
-        return NULL;
-
-    if (!create_lock(&inode->lock)) {
-        free(inode);
-        return NULL;
-    }
-
-    inode->type = type;
-    inode->perm = perm;
-    inode->size = 0;
-    inode->ctime = 0;
-    inode->mtime = 0;
-    inode->atime = 0;
-
-    struct libos_thread* current = get_cur_thread();
-    lock(&current->lock);
-    inode->uid = current->euid;
-    inode->gid = current->egid;
-    unlock(&current->lock);
-
-    inode->mount = mount;
-    get_mount(mount);
-    inode->fs = mount->fs;
-
-    inode->data = NULL;
-
-    refcount_set(&inode->ref_count, 1);
-    return inode;
-}
-
-void get_inode(struct libos_inode* inode) {
-    refcount_inc(&inode->ref_count);
-}
-
-void put_inode(struct libos_inode* inode) {
-    if (refcount_dec(&inode->ref_count) == 0) {
-        if (inode->fs->d_ops && inode->fs->d_ops->idrop) {
-            lock(&inode->lock);
-            inode->fs->d_ops->idrop(inode);
-            unlock(&inode->lock);
-        }
-
-        put_mount(inode->mount);
-
-        destroy_lock(&inode->lock);
-        free(inode);
-    }
-}
-
 static int dump_dentry_write_all(const char* str, size_t size, void* arg) {
     __UNUSED(arg);
     log_always("%.*s", (int)size, str);
@@ -600,9 +716,11 @@ BEGIN_CP_FUNC(dentry) {
         *new_dent = *dent;
         INIT_LISTP(&new_dent->children);
         INIT_LIST_HEAD(new_dent, siblings);
+        new_dent->hash_next = NULL;
         refcount_set(&new_dent->ref_count, 0);
 
-        /* `file_locks` is used only by process leader. */
+        /* The lock state in `file_locks` (including leases) belongs to this process and is never
+         * inherited by the child. */
         new_dent->file_locks = NULL;
 
         DO_CP_MEMBER(str, dent, new_dent, name);
@@ -651,7 +769,7 @@ BEGIN_RS_FUNC(dentry) {
     if (dent->parent) {
         get_dentry(dent->parent);
         get_dentry(dent);
-        LISTP_ADD_TAIL(dent, &dent->parent->children, siblings);
+        add_child(dent->parent, dent);
     }
 
     if (dent->attached_mount) {
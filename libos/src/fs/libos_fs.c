@@ -9,6 +9,7 @@
 #include "libos_checkpoint.h"
 #include "libos_fs.h"
 #include "libos_fs_encrypted.h"
+#include "libos_fs_mem.h"
 #include "libos_fs_pseudo.h"
 #include "libos_internal.h"
 #include "libos_lock.h"
@@ -70,6 +71,9 @@ int init_fs(void) {
     if ((ret = init_encrypted_files()) < 0)
         goto err;
 
+    if ((ret = init_emulated_mmap()) < 0)
+        goto err;
+
     if ((ret = init_procfs()) < 0)
         goto err;
     if ((ret = init_devfs()) < 0)
@@ -145,9 +149,19 @@ static int mount_root(void) {
         goto out;
     }
 
+    uint64_t fs_root_cache_size;
+    ret = toml_sizestring_in(g_manifest_root, "fs.root.cache_size", /*defaultval=*/0,
+                             &fs_root_cache_size);
+    if (ret < 0) {
+        log_error("Cannot parse 'fs.root.cache_size'");
+        ret = -EINVAL;
+        goto out;
+    }
+
     struct libos_mount_params params = {
         .path = "/",
         .key_name = fs_root_key_name,
+        .cache_size = fs_root_cache_size,
     };
 
     if (!fs_root_type && !fs_root_uri) {
@@ -212,6 +226,7 @@ static int mount_one_nonroot(toml_table_t* mount, const char* prefix) {
     char* mount_path     = NULL;
     char* mount_uri      = NULL;
     char* mount_key_name = NULL;
+    uint64_t mount_cache_size = 0;
 
     ret = toml_string_in(mount, "type", &mount_type);
     if (ret < 0) {
@@ -241,6 +256,13 @@ static int mount_one_nonroot(toml_table_t* mount, const char* prefix) {
         goto out;
     }
 
+    ret = toml_sizestring_in(mount, "cache_size", /*defaultval=*/0, &mount_cache_size);
+    if (ret < 0) {
+        log_error("Cannot parse '%s.cache_size'", prefix);
+        ret = -EINVAL;
+        goto out;
+    }
+
     if (!mount_path) {
         log_error("No value provided for '%s.path'", prefix);
         ret = -EINVAL;
@@ -286,6 +308,7 @@ static int mount_one_nonroot(toml_table_t* mount, const char* prefix) {
         .path = mount_path,
         .uri = mount_uri,
         .key_name = mount_key_name,
+        .cache_size = mount_cache_size,
     };
     ret = mount_fs(&params);
 
@@ -463,7 +486,9 @@ static int mount_fs_at_dentry(struct libos_mount_params* params, struct libos_de
 
     mount->mount_point = mount_point;
     get_dentry(mount_point);
+    write_seqbegin(&g_dcache_seqlock);
     mount_point->attached_mount = mount;
+    write_seqend(&g_dcache_seqlock);
     get_mount(mount);
 
     /* Initialize root dentry of the new filesystem */
@@ -501,8 +526,11 @@ static int mount_fs_at_dentry(struct libos_mount_params* params, struct libos_de
     return 0;
 
 err:
-    if (mount_point->attached_mount)
+    if (mount_point->attached_mount) {
+        write_seqbegin(&g_dcache_seqlock);
         mount_point->attached_mount = NULL;
+        write_seqend(&g_dcache_seqlock);
+    }
 
     if (mount) {
         if (mount->mount_point)
@@ -0,0 +1,620 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Implementation of the page cache for host files (see `libos_fs_cache.h`).
+ *
+ * The cached pages of a file are kept in an AVL tree ordered by their index in the file (so that
+ * runs of adjacent pages can be found for read-ahead and write-back), and in an LRU list.
+ *
+ * Dirty pages are never evicted. Instead, at most half of the cache can be dirty: when a write
+ * would exceed this limit, all dirty pages are written back first. Thus there is always a clean
+ * page to evict, eviction never needs host I/O, and write-back only happens in `page_cache_write`
+ * and `page_cache_flush`, i.e. with a handle that is opened for writing.
+ *
+ * The bytes of a cached page past the end of file are always zero, so that the page can be used
+ * as-is when the file is extended.
+ *
+ * Large reads and writes (at least `PAGE_CACHE_MAX_RUN_PAGES` pages) bypass the cache, as they
+ * gain nothing from it. They are still kept coherent with the cached pages: direct reads copy
+ * the cached pages over the data read from the host, and direct writes update the cached pages.
+ */
+
+#include "api.h"
+#include "avl_tree.h"
+#include "libos_fs_cache.h"
+#include "libos_internal.h"
+#include "libos_lock.h"
+#include "list.h"
+
+/* Maximum number of pages read or written with one host operation. Also the size of the buffer
+ * used for such operations. */
+#define PAGE_CACHE_MAX_RUN_PAGES 32
+
+/* initial read-ahead window, doubled on each further sequential read that misses the cache */
+#define PAGE_CACHE_MIN_READAHEAD_PAGES 4
+
+DEFINE_LIST(cache_page);
+DEFINE_LISTP(cache_page);
+struct cache_page {
+    struct avl_tree_node tree_node;
+    LIST_TYPE(cache_page) lru_list;
+    uint64_t idx;
+    bool dirty;
+    char data[PAGE_CACHE_PAGE_SIZE];
+};
+
+struct libos_page_cache {
+    struct libos_lock lock;
+
+    struct avl_tree pages;
+    LISTP_TYPE(cache_page) lru; /* most recently used first */
+    size_t pages_cnt;
+    size_t dirty_cnt;
+    size_t max_pages;
+
+    /* size of the file including the data written through the cache; the callers update their file
+     * size only after a write returns, so the size they pass might be smaller */
+    file_off_t file_size;
+
+    /* buffer for host reads and writes of several pages, allocated on first use */
+    char* run_buf;
+
+    /* index of the last page read (for detecting sequential reads), and the read-ahead window */
+    uint64_t last_read_idx;
+    size_t readahead_pages;
+};
+
+static struct cache_page* node2page(struct avl_tree_node* node) {
+    return container_of(node, struct cache_page, tree_node);
+}
+
+static bool page_cmp(struct avl_tree_node* node_a, struct avl_tree_node* node_b) {
+    return node2page(node_a)->idx <= node2page(node_b)->idx;
+}
+
+static bool page_idx_cmp(void* idx, struct avl_tree_node* node) {
+    return *(uint64_t*)idx <= node2page(node)->idx;
+}
+
+/* Returns the cached page with the smallest index greater or equal to `idx`, or NULL. */
+static struct cache_page* first_page_from(struct libos_page_cache* cache, uint64_t idx) {
+    struct avl_tree_node* node = avl_tree_lower_bound_fn(&cache->pages, &idx, page_idx_cmp);
+    return node ? node2page(node) : NULL;
+}
+
+static struct cache_page* next_page(struct cache_page* page) {
+    struct avl_tree_node* node = avl_tree_next(&page->tree_node);
+    return node ? node2page(node) : NULL;
+}
+
+static struct cache_page* lookup_page(struct libos_page_cache* cache, uint64_t idx) {
+    struct cache_page* page = first_page_from(cache, idx);
+    return page && page->idx == idx ? page : NULL;
+}
+
+static void touch_page(struct libos_page_cache* cache, struct cache_page* page) {
+    if (LISTP_FIRST_ENTRY(&cache->lru, struct cache_page, lru_list) != page) {
+        LISTP_DEL(page, &cache->lru, lru_list);
+        LISTP_ADD(page, &cache->lru, lru_list);
+    }
+}
+
+static void insert_page(struct libos_page_cache* cache, struct cache_page* page, uint64_t idx) {
+    page->idx = idx;
+    page->dirty = false;
+    avl_tree_insert(&cache->pages, &page->tree_node);
+    LISTP_ADD(page, &cache->lru, lru_list);
+    cache->pages_cnt++;
+}
+
+static void remove_page(struct libos_page_cache* cache, struct cache_page* page) {
+    avl_tree_delete(&cache->pages, &page->tree_node);
+    LISTP_DEL(page, &cache->lru, lru_list);
+    if (page->dirty)
+        cache->dirty_cnt--;
+    cache->pages_cnt--;
+}
+
+static void drop_page(struct libos_page_cache* cache, struct cache_page* page) {
+    remove_page(cache, page);
+    free(page);
+}
+
+/*
+ * Returns a page that is not in the cache: a newly allocated one, or the least recently used clean
+ * page (removed from the cache). Returns NULL if neither is possible.
+ */
+static struct cache_page* get_free_page(struct libos_page_cache* cache) {
+    if (cache->pages_cnt < cache->max_pages) {
+        struct cache_page* page = malloc(sizeof(*page));
+        if (page)
+            return page;
+    }
+
+    struct cache_page* page;
+    LISTP_FOR_EACH_ENTRY_REVERSE(page, &cache->lru, lru_list) {
+        if (!page->dirty) {
+            remove_page(cache, page);
+            return page;
+        }
+    }
+    return NULL;
+}
+
+static size_t max_run_pages(struct libos_page_cache* cache) {
+    /* a run must not evict a large part of the cache */
+    return MIN((size_t)PAGE_CACHE_MAX_RUN_PAGES, cache->max_pages / 4);
+}
+
+static int alloc_run_buf(struct libos_page_cache* cache) {
+    if (!cache->run_buf) {
+        cache->run_buf = malloc(PAGE_CACHE_MAX_RUN_PAGES * PAGE_CACHE_PAGE_SIZE);
+        if (!cache->run_buf)
+            return -ENOMEM;
+    }
+    return 0;
+}
+
+/* Reads `size` bytes from the host file. The part past the end of the host file is zeroed. */
+static int host_read(PAL_HANDLE handle, uint64_t offset, char* buf, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        size_t count = size - done;
+        int ret = PalStreamRead(handle, offset + done, &count, buf + done);
+        if (ret < 0)
+            return pal_to_unix_errno(ret);
+        if (count == 0)
+            break;
+        done += count;
+    }
+    memset(buf + done, 0, size - done);
+    return 0;
+}
+
+static int host_write(PAL_HANDLE handle, uint64_t offset, const char* buf, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        size_t count = size - done;
+        int ret = PalStreamWrite(handle, offset + done, &count, (void*)(buf + done));
+        if (ret < 0)
+            return pal_to_unix_errno(ret);
+        if (count == 0)
+            return -EIO;
+        done += count;
+    }
+    return 0;
+}
+
+/* Fills `data` with the contents of page `idx` of the file (which has size `file_size`). */
+static int read_page(PAL_HANDLE handle, file_off_t file_size, uint64_t idx, char* data) {
+    uint64_t offset = idx * PAGE_CACHE_PAGE_SIZE;
+    size_t size = (uint64_t)file_size > offset
+                  ? MIN((uint64_t)PAGE_CACHE_PAGE_SIZE, (uint64_t)file_size - offset)
+                  : 0;
+
+    int ret = host_read(handle, offset, data, size);
+    if (ret < 0)
+        return ret;
+    memset(data + size, 0, PAGE_CACHE_PAGE_SIZE - size);
+    return 0;
+}
+
+/*
+ * Reads pages [`idx`, `idx` + `cnt`) from the host file with a single host read, and adds them to
+ * the cache. None of the pages may be cached already, and all of them must begin before the end of
+ * file. Might add only some of the pages if there is not enough memory.
+ */
+static int read_pages(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size,
+                      uint64_t idx, size_t cnt) {
+    int ret;
+
+    if (cnt > 1 && alloc_run_buf(cache) < 0)
+        cnt = 1;
+
+    if (cnt == 1) {
+        struct cache_page* page = get_free_page(cache);
+        if (!page)
+            return 0;
+        ret = read_page(handle, file_size, idx, page->data);
+        if (ret < 0) {
+            free(page);
+            return ret;
+        }
+        insert_page(cache, page, idx);
+        return 0;
+    }
+
+    uint64_t offset = idx * PAGE_CACHE_PAGE_SIZE;
+    assert((uint64_t)file_size > offset);
+    size_t size = MIN(cnt * PAGE_CACHE_PAGE_SIZE, (uint64_t)file_size - offset);
+    ret = host_read(handle, offset, cache->run_buf, size);
+    if (ret < 0)
+        return ret;
+    memset(cache->run_buf + size, 0, cnt * PAGE_CACHE_PAGE_SIZE - size);
+
+    for (size_t i = 0; i < cnt; i++) {
+        struct cache_page* page = get_free_page(cache);
+        if (!page)
+            break;
+        memcpy(page->data, cache->run_buf + i * PAGE_CACHE_PAGE_SIZE, PAGE_CACHE_PAGE_SIZE);
+        insert_page(cache, page, idx + i);
+    }
+    return 0;
+}
+
+/*
+ * Writes back `cnt` adjacent dirty pages, starting with `first`, with a single host write. Pages
+ * past the end of file are not written, but are still marked as clean.
+ */
+static int write_pages(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size,
+                       struct cache_page* first, size_t cnt) {
+    assert(cnt == 1 || cache->run_buf);
+
+    uint64_t offset = first->idx * PAGE_CACHE_PAGE_SIZE;
+    size_t size = (uint64_t)file_size > offset
+                  ? MIN(cnt * PAGE_CACHE_PAGE_SIZE, (uint64_t)file_size - offset)
+                  : 0;
+
+    if (size > 0) {
+        const char* data = first->data;
+        if (cnt > 1) {
+            struct cache_page* page = first;
+            for (size_t i = 0; i < cnt && i * PAGE_CACHE_PAGE_SIZE < size; i++) {
+                assert(page && page->idx == first->idx + i);
+                memcpy(cache->run_buf + i * PAGE_CACHE_PAGE_SIZE, page->data,
+                       MIN((size_t)PAGE_CACHE_PAGE_SIZE, size - i * PAGE_CACHE_PAGE_SIZE));
+                page = next_page(page);
+            }
+            data = cache->run_buf;
+        }
+
+        int ret = host_write(handle, offset, data, size);
+        if (ret < 0)
+            return ret;
+    }
+
+    struct cache_page* page = first;
+    for (size_t i = 0; i < cnt; i++) {
+        assert(page->dirty);
+        page->dirty = false;
+        cache->dirty_cnt--;
+        page = next_page(page);
+    }
+    return 0;
+}
+
+/* Copies the cached parts of the range [`pos`, `pos` + `count`) to `buf`. */
+static void copy_from_cached_pages(struct libos_page_cache* cache, uint64_t pos, char* buf,
+                                   size_t count) {
+    uint64_t end = pos + count;
+    for (struct cache_page* page = first_page_from(cache, pos / PAGE_CACHE_PAGE_SIZE);
+            page && page->idx * PAGE_CACHE_PAGE_SIZE < end; page = next_page(page)) {
+        uint64_t page_start = page->idx * PAGE_CACHE_PAGE_SIZE;
+        uint64_t copy_start = MAX(page_start, pos);
+        uint64_t copy_end = MIN(page_start + PAGE_CACHE_PAGE_SIZE, end);
+        memcpy(buf + (copy_start - pos), page->data + (copy_start - page_start),
+               copy_end - copy_start);
+    }
+}
+
+/*
+ * Updates the cached parts of the range [`pos`, `pos` + `count`) after the range was written
+ * directly to the host file. Pages covered by the range are dropped, pages covered only partially
+ * are updated with the new data (and keep their dirty state).
+ */
+static void update_cached_pages(struct libos_page_cache* cache, uint64_t pos, const char* buf,
+                                size_t count) {
+    uint64_t end = pos + count;
+    struct cache_page* page = first_page_from(cache, pos / PAGE_CACHE_PAGE_SIZE);
+    while (page && page->idx * PAGE_CACHE_PAGE_SIZE < end) {
+        struct cache_page* next = next_page(page);
+
+        uint64_t page_start = page->idx * PAGE_CACHE_PAGE_SIZE;
+        uint64_t copy_start = MAX(page_start, pos);
+        uint64_t copy_end = MIN(page_start + PAGE_CACHE_PAGE_SIZE, end);
+        if (copy_end - copy_start == PAGE_CACHE_PAGE_SIZE) {
+            drop_page(cache, page);
+        } else {
+            memcpy(page->data + (copy_start - page_start), buf + (copy_start - pos),
+                   copy_end - copy_start);
+        }
+        page = next;
+    }
+}
+
+/* Drops the clean pages overlapping with the range [`pos`, `pos` + `count`). */
+static void drop_clean_pages(struct libos_page_cache* cache, uint64_t pos, size_t count) {
+    uint64_t end = pos + count;
+    struct cache_page* page = first_page_from(cache, pos / PAGE_CACHE_PAGE_SIZE);
+    while (page && page->idx * PAGE_CACHE_PAGE_SIZE < end) {
+        struct cache_page* next = next_page(page);
+        if (!page->dirty)
+            drop_page(cache, page);
+        page = next;
+    }
+}
+
+static ssize_t write_direct(struct libos_page_cache* cache, PAL_HANDLE handle, uint64_t pos,
+                            const char* buf, size_t count) {
+    int ret = host_write(handle, pos, buf, count);
+    if (ret < 0) {
+        /* we don't know which part of the range was written, so make sure it will be re-read */
+        drop_clean_pages(cache, pos, count);
+        return ret;
+    }
+    update_cached_pages(cache, pos, buf, count);
+    return count;
+}
+
+int page_cache_create(size_t max_pages, struct libos_page_cache** out_cache) {
+    assert(max_pages >= PAGE_CACHE_MIN_PAGES);
+
+    struct libos_page_cache* cache = calloc(1, sizeof(*cache));
+    if (!cache)
+        return -ENOMEM;
+
+    if (!create_lock(&cache->lock)) {
+        free(cache);
+        return -ENOMEM;
+    }
+
+    cache->pages.cmp = page_cmp;
+    INIT_LISTP(&cache->lru);
+    cache->max_pages = max_pages;
+    /* the first read (presumably from the beginning of file) is treated as sequential */
+    cache->last_read_idx = UINT64_MAX;
+
+    *out_cache = cache;
+    return 0;
+}
+
+void page_cache_destroy(struct libos_page_cache* cache) {
+    struct avl_tree_node* node;
+    while ((node = avl_tree_first(&cache->pages)))
+        drop_page(cache, node2page(node));
+
+    assert(cache->pages_cnt == 0 && cache->dirty_cnt == 0);
+    destroy_lock(&cache->lock);
+    free(cache->run_buf);
+    free(cache);
+}
+
+void page_cache_lock(struct libos_page_cache* cache) {
+    lock(&cache->lock);
+}
+
+void page_cache_unlock(struct libos_page_cache* cache) {
+    unlock(&cache->lock);
+}
+
+bool page_cache_has_dirty_pages(struct libos_page_cache* cache) {
+    assert(locked(&cache->lock));
+    return cache->dirty_cnt > 0;
+}
+
+ssize_t page_cache_read(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size,
+                        file_off_t pos, void* buf, size_t count, int flags) {
+    assert(locked(&cache->lock));
+    assert(pos >= 0);
+
+    file_size = MAX(file_size, cache->file_size);
+    if (pos >= file_size)
+        return 0;
+    count = MIN(count, (uint64_t)(file_size - pos));
+    if (count == 0)
+        return 0;
+
+    int ret;
+    if ((flags & PAGE_CACHE_DIRECT) || count >= PAGE_CACHE_MAX_RUN_PAGES * PAGE_CACHE_PAGE_SIZE) {
+        ret = host_read(handle, pos, buf, count);
+        if (ret < 0)
+            return ret;
+        /* cached pages might be newer than the host file */
+        copy_from_cached_pages(cache, pos, buf, count);
+        return count;
+    }
+
+    uint64_t first_idx = pos / PAGE_CACHE_PAGE_SIZE;
+    uint64_t last_idx = (pos + count - 1) / PAGE_CACHE_PAGE_SIZE;
+    uint64_t end_idx = UDIV_ROUND_UP((uint64_t)file_size, PAGE_CACHE_PAGE_SIZE);
+
+    /* `last_read_idx + 1` overflows to 0 before the first read */
+    bool sequential = first_idx == cache->last_read_idx || first_idx == cache->last_read_idx + 1;
+    bool readahead_updated = false;
+    cache->last_read_idx = last_idx;
+
+    size_t done = 0;
+    while (done < count) {
+        uint64_t cur = pos + done;
+        uint64_t idx = cur / PAGE_CACHE_PAGE_SIZE;
+        size_t page_off = cur % PAGE_CACHE_PAGE_SIZE;
+        size_t copy_size = MIN(count - done, PAGE_CACHE_PAGE_SIZE - page_off);
+
+        struct cache_page* page = lookup_page(cache, idx);
+        if (!page) {
+            if (!readahead_updated) {
+                if (sequential) {
+                    cache->readahead_pages = MIN(MAX(cache->readahead_pages * 2,
+                                                     (size_t)PAGE_CACHE_MIN_READAHEAD_PAGES),
+                                                 max_run_pages(cache));
+                } else {
+                    cache->readahead_pages = 0;
+                }
+                readahead_updated = true;
+            }
+
+            /* read the missing pages up to the next cached one, and the read-ahead window */
+            uint64_t run_end_idx = MIN(last_idx + 1 + cache->readahead_pages, end_idx);
+            run_end_idx = MIN(run_end_idx, idx + max_run_pages(cache));
+            struct cache_page* next = first_page_from(cache, idx);
+            if (next && next->idx < run_end_idx)
+                run_end_idx = next->idx;
+
+            ret = read_pages(cache, handle, file_size, idx, run_end_idx - idx);
+            if (ret < 0)
+                return done ? (ssize_t)done : ret;
+
+            page = lookup_page(cache, idx);
+        }
+
+        if (page) {
+            memcpy((char*)buf + done, page->data + page_off, copy_size);
+            touch_page(cache, page);
+        } else {
+            /* no memory for caching the page, but it is not cached so the host file is up to date */
+            ret = host_read(handle, cur, (char*)buf + done, copy_size);
+            if (ret < 0)
+                return done ? (ssize_t)done : ret;
+        }
+        done += copy_size;
+    }
+    return count;
+}
+
+ssize_t page_cache_write(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size,
+                         file_off_t pos, const void* buf, size_t count, int flags) {
+    assert(locked(&cache->lock));
+    assert(pos >= 0);
+
+    file_off_t pos_end;
+    if (__builtin_add_overflow(pos, count, &pos_end))
+        return -EFBIG;
+    if (count == 0)
+        return 0;
+
+    int ret;
+    size_t done = 0;
+
+    /* file size including the data written so far, used for writing back the pages */
+    file_off_t cur_size = MAX(file_size, cache->file_size);
+
+    if ((flags & PAGE_CACHE_DIRECT) || count >= PAGE_CACHE_MAX_RUN_PAGES * PAGE_CACHE_PAGE_SIZE) {
+        ssize_t written = write_direct(cache, handle, pos, buf, count);
+        if (written < 0)
+            return written;
+        done = written;
+        goto out;
+    }
+
+    while (done < count) {
+        uint64_t cur = pos + done;
+        uint64_t idx = cur / PAGE_CACHE_PAGE_SIZE;
+        size_t page_off = cur % PAGE_CACHE_PAGE_SIZE;
+        size_t copy_size = MIN(count - done, PAGE_CACHE_PAGE_SIZE - page_off);
+
+        struct cache_page* page = lookup_page(cache, idx);
+        if (!page) {
+            /* the rest of the page has to be read from the host file, unless it is past EOF */
+            bool partial = copy_size < PAGE_CACHE_PAGE_SIZE
+                           && idx * PAGE_CACHE_PAGE_SIZE < (uint64_t)cur_size;
+            if (partial && (flags & PAGE_CACHE_WRITE_ONLY)) {
+                /* we cannot read the rest of the page, so write this part directly */
+                ssize_t written = write_direct(cache, handle, cur, (const char*)buf + done,
+                                               copy_size);
+                if (written < 0) {
+                    ret = written;
+                    goto out;
+                }
+                done += copy_size;
+                cur_size = MAX(cur_size, (file_off_t)(cur + copy_size));
+                continue;
+            }
+
+            page = get_free_page(cache);
+            if (!page) {
+                ret = -ENOMEM;
+                goto out;
+            }
+            if (copy_size < PAGE_CACHE_PAGE_SIZE) {
+                ret = read_page(handle, cur_size, idx, page->data);
+                if (ret < 0) {
+                    free(page);
+                    goto out;
+                }
+            }
+            insert_page(cache, page, idx);
+        }
+
+        if (!page->dirty) {
+            if (cache->dirty_cnt >= cache->max_pages / 2) {
+                ret = page_cache_flush(cache, handle, cur_size);
+                if (ret < 0)
+                    goto out;
+            }
+            page->dirty = true;
+            cache->dirty_cnt++;
+        }
+
+        memcpy(page->data + page_off, (const char*)buf + done, copy_size);
+        touch_page(cache, page);
+        done += copy_size;
+        cur_size = MAX(cur_size, (file_off_t)(cur + copy_size));
+    }
+    ret = 0;
+
+out:
+    if (done)
+        cache->file_size = MAX(cache->file_size, (file_off_t)(pos + done));
+    return done ? (ssize_t)done : ret;
+}
+
+int page_cache_flush(struct libos_page_cache* cache, PAL_HANDLE handle, file_off_t file_size) {
+    assert(locked(&cache->lock));
+
+    if (cache->dirty_cnt == 0)
+        return 0;
+
+    file_size = MAX(file_size, cache->file_size);
+
+    size_t max_cnt = alloc_run_buf(cache) < 0 ? 1 : PAGE_CACHE_MAX_RUN_PAGES;
+
+    struct cache_page* page = first_page_from(cache, 0);
+    while (page) {
+        if (!page->dirty) {
+            page = next_page(page);
+            continue;
+        }
+
+        /* find a run of adjacent dirty pages */
+        struct cache_page* last = page;
+        size_t cnt = 1;
+        while (cnt < max_cnt) {
+            struct cache_page* next = next_page(last);
+            if (!next || !next->dirty || next->idx != last->idx + 1)
+                break;
+            last = next;
+            cnt++;
+        }
+
+        int ret = write_pages(cache, handle, file_size, page, cnt);
+        if (ret < 0)
+            return ret;
+        page = next_page(last);
+    }
+    assert(cache->dirty_cnt == 0);
+    return 0;
+}
+
+void page_cache_truncate(struct libos_page_cache* cache, file_off_t size) {
+    assert(locked(&cache->lock));
+    assert(size >= 0);
+
+    cache->file_size = size;
+
+    struct cache_page* page =
+        first_page_from(cache, UDIV_ROUND_UP((uint64_t)size, PAGE_CACHE_PAGE_SIZE));
+    while (page) {
+        struct cache_page* next = next_page(page);
+        drop_page(cache, page);
+        page = next;
+    }
+
+    /* the rest of the last page must read as zeros if the file is extended later */
+    size_t page_off = size % PAGE_CACHE_PAGE_SIZE;
+    if (page_off) {
+        page = lookup_page(cache, size / PAGE_CACHE_PAGE_SIZE);
+        if (page)
+            memset(page->data + page_off, 0, PAGE_CACHE_PAGE_SIZE - page_off);
+    }
+}
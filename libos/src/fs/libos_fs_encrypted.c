@@ -79,6 +79,47 @@ static pf_status_t cb_write(pf_handle_t handle, const void* buffer, uint64_t off
     return PF_STATUS_SUCCESS;
 }
 
+/* Maximum number of writes submitted to PAL at once by `cb_write_batch` */
+#define WRITE_BATCH_MAX_OPS 32
+
+static pf_status_t cb_write_batch(pf_handle_t handle, const void* const* buffers,
+                                  const uint64_t* offsets, const size_t* sizes, size_t count) {
+    PAL_HANDLE pal_handle = (PAL_HANDLE)handle;
+    struct pal_batch_op ops[WRITE_BATCH_MAX_OPS];
+
+    for (size_t done = 0; done < count; done += WRITE_BATCH_MAX_OPS) {
+        size_t ops_cnt = MIN(count - done, (size_t)WRITE_BATCH_MAX_OPS);
+        for (size_t i = 0; i < ops_cnt; i++) {
+            ops[i] = (struct pal_batch_op){
+                .handle = pal_handle,
+                .type   = PAL_BATCH_OP_WRITE,
+                .offset = offsets[done + i],
+                .count  = sizes[done + i],
+                .buffer = (void*)buffers[done + i],
+            };
+        }
+
+        int ret = PalStreamBatch(ops, ops_cnt);
+        if (ret < 0) {
+            log_warning("PalStreamBatch failed: %s", pal_strerror(ret));
+            return PF_STATUS_CALLBACK_FAILED;
+        }
+
+        for (size_t i = 0; i < ops_cnt; i++) {
+            size_t written = ops[i].result < 0 ? 0 : ops[i].count;
+            if (written == sizes[done + i])
+                continue;
+
+            /* interrupted or short write, finish it the slow way (which also reports errors) */
+            pf_status_t status = cb_write(handle, buffers[done + i] + written,
+                                          offsets[done + i] + written, sizes[done + i] - written);
+            if (PF_FAILURE(status))
+                return status;
+        }
+    }
+    return PF_STATUS_SUCCESS;
+}
+
 static pf_status_t cb_truncate(pf_handle_t handle, uint64_t size) {
     PAL_HANDLE pal_handle = (PAL_HANDLE)handle;
 
@@ -217,6 +258,16 @@ static int encrypted_file_internal_open(struct libos_encrypted_file* enc, PAL_HA
         goto out;
     }
 
+    if (enc->cache_nodes) {
+        pfs = pf_set_cache_size(pf, enc->cache_nodes);
+        if (PF_FAILURE(pfs)) {
+            log_warning("pf_set_cache_size failed: %s", pf_strerror(pfs));
+            pf_close(pf);
+            ret = -EINVAL;
+            goto out;
+        }
+    }
+
     enc->pf = pf;
     enc->pal_handle = pal_handle;
     ret = 0;
@@ -287,6 +338,7 @@ int init_encrypted_files(void) {
     pf_set_callbacks(&cb_read, &cb_write, &cb_fsync, &cb_truncate,
                      &cb_aes_cmac, &cb_aes_gcm_encrypt, &cb_aes_gcm_decrypt,
                      &cb_random, cb_debug_ptr);
+    pf_set_write_batch_callback(&cb_write_batch);
 
     int ret;
 
@@ -446,7 +498,7 @@ void update_encrypted_files_key(struct libos_encrypted_files_key* key, const pf_
 }
 
 static int encrypted_file_alloc(const char* uri, struct libos_encrypted_files_key* key,
-                                struct libos_encrypted_file** out_enc) {
+                                size_t cache_nodes, struct libos_encrypted_file** out_enc) {
     assert(strstartswith(uri, URI_PREFIX_FILE));
 
     if (!key) {
@@ -464,6 +516,7 @@ static int encrypted_file_alloc(const char* uri, struct libos_encrypted_files_ke
         return -ENOMEM;
     }
     enc->key = key;
+    enc->cache_nodes = cache_nodes;
     enc->use_count = 0;
     enc->pf = NULL;
     enc->pal_handle = NULL;
@@ -471,10 +524,10 @@ static int encrypted_file_alloc(const char* uri, struct libos_encrypted_files_ke
     return 0;
 }
 
-int encrypted_file_open(const char* uri, struct libos_encrypted_files_key* key,
+int encrypted_file_open(const char* uri, struct libos_encrypted_files_key* key, size_t cache_nodes,
                         struct libos_encrypted_file** out_enc) {
     struct libos_encrypted_file* enc;
-    int ret = encrypted_file_alloc(uri, key, &enc);
+    int ret = encrypted_file_alloc(uri, key, cache_nodes, &enc);
     if (ret < 0)
         return ret;
 
@@ -490,9 +543,9 @@ int encrypted_file_open(const char* uri, struct libos_encrypted_files_key* key,
 }
 
 int encrypted_file_create(const char* uri, mode_t perm, struct libos_encrypted_files_key* key,
-                          struct libos_encrypted_file** out_enc) {
+                          size_t cache_nodes, struct libos_encrypted_file** out_enc) {
     struct libos_encrypted_file* enc;
-    int ret = encrypted_file_alloc(uri, key, &enc);
+    int ret = encrypted_file_alloc(uri, key, cache_nodes, &enc);
     if (ret < 0)
         return ret;
 
@@ -762,6 +815,7 @@ BEGIN_CP_FUNC(encrypted_file) {
     new_enc = (struct libos_encrypted_file*)(base + off);
 
     new_enc->use_count = enc->use_count;
+    new_enc->cache_nodes = enc->cache_nodes;
     DO_CP_MEMBER(str, enc, new_enc, uri);
 
     lock(&g_keys_lock);
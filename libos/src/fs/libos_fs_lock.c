@@ -7,10 +7,11 @@
 #include "libos_fs_lock.h"
 #include "libos_ipc.h"
 #include "libos_lock.h"
+#include "libos_uthash.h"
 #include "linux_abi/fs.h"
 
 /*
- * Global lock for the whole subsystem. Protects access to `g_dent_file_locks_list`, and also to
+ * Global lock for the whole subsystem. Protects access to `g_dent_file_locks_hash`, and also to
  * dentry fields (`file_locks` and `maybe_has_file_locks`).
  */
 static struct libos_lock g_fs_lock_lock;
@@ -24,21 +25,32 @@ static struct libos_lock g_fs_lock_lock;
  *
  * If the request is initiated by process leader, `notify.vmid` should be set to 0, and
  * `notify.event` should be set to an event handle. After processing the request, the event will be
- * triggered, and `*notify.result` will be set to the result.
+ * triggered, and `*notify.result` (and, for `get` requests, `*notify.out_file_lock`) will be set to
+ * the result.
+ *
+ * Besides requests waiting for conflicting locks to be released, all requests for a file leased to
+ * another process are queued here until the lease is returned (see `lease` below).
  */
 DEFINE_LISTP(file_lock_request);
 DEFINE_LIST(file_lock_request);
 struct file_lock_request {
     struct libos_file_lock file_lock;
 
+    /* True for `file_lock_get` requests, false for `file_lock_set` requests. */
+    bool get;
+    /* For `file_lock_set` requests: whether to wait until conflicting locks are released, or fail
+     * with -EAGAIN. */
+    bool wait;
+
     struct {
         IDTYPE vmid;
         unsigned int seq;
 
-        /* Note that `event` and `result` are owned by the side making the request, and outlive this
-         * object (we delete it as soon as the request is processed). */
+        /* Note that `event`, `result` and `out_file_lock` are owned by the side making the request,
+         * and outlive this object (we delete it as soon as the request is processed). */
         PAL_HANDLE event;
         int* result;
+        struct libos_file_lock* out_file_lock;
     } notify;
 
     LIST_TYPE(file_lock_request) list;
@@ -46,11 +58,15 @@ struct file_lock_request {
 
 /* Describes file locks' details for a given dentry. Holds both POSIX (fcntl) and BSD (flock)
  * locks. */
-DEFINE_LISTP(dent_file_locks);
-DEFINE_LIST(dent_file_locks);
 struct dent_file_locks {
+    /* The file's dentry. Can be NULL only in a lease holder which got the lease revoked before
+     * processing the response granting it (see `lease` below). */
     struct libos_dentry* dent;
 
+    /* Absolute path of the file, and the hash table node for `g_dent_file_locks_hash`. */
+    char* path;
+    UT_hash_handle hh;
+
     /* Used to disallow mixing of POSIX and BSD locks on the same file (dentry). Note that all file
      * locking requests are processed by the leader process, so even if POSIX and BSD locks are
      * created in different processes, they will end up in the leader and it will update these
@@ -59,49 +75,215 @@ struct dent_file_locks {
     bool flock_used;
 
     /*
-     * POSIX (fcntl) and BSD (flock) locks for a given dentry.
-     *
-     * For POSIX locks:
-     *   - sorted by PID and then by start position (so that we are able to merge and split locks),
+     * POSIX (fcntl) locks for a given dentry:
+     *   - sorted by start position and then by PID,
+     *   - augmented with `subtree_max_end`, so that we are able to quickly find all locks
+     *     overlapping with a given range (see `posix_lock_first_overlap`),
      *   - the ranges do not overlap within a given PID.
-     *
-     * BSD locks do not have ranges, thus the above properties do not apply.
      */
-    LISTP_TYPE(libos_file_lock) file_locks;
+    struct avl_tree posix_locks;
+
+    /* BSD (flock) locks for a given dentry. */
+    LISTP_TYPE(libos_file_lock) flock_locks;
 
     /* Pending requests. */
     LISTP_TYPE(file_lock_request) file_lock_requests;
 
-    /* List node, for `g_dent_file_locks_list`. */
-    LIST_TYPE(dent_file_locks) list;
+    /*
+     * Lease on the file (see `libos_fs_lock.h`).
+     *
+     * In the leader process: `vmid` and `pid` describe the lease holder (`vmid` is 0 if the file
+     * is not leased), and `grants` is the number of IPC responses granting the lease sent to the
+     * holder. As long as the file is leased, all POSIX locks on it are stored in the holder, and
+     * `posix_locks` above is empty. `revoking` is set after asking the holder to return the lease:
+     * from then on, all requests for the file are queued until the lease is returned.
+     *
+     * In the lease holder: `grants` is the number of IPC responses granting the lease received so
+     * far (the lease is valid if it's non-zero), and `revoke_grants` is the number of such
+     * responses that the leader sent before revoking the lease (0 if the lease is not revoked).
+     * The lease is returned once `grants` reaches `revoke_grants`, so that no response granting it
+     * is processed after the lease is returned.
+     */
+    struct {
+        IDTYPE vmid;
+        IDTYPE pid;
+        unsigned int grants;
+        unsigned int revoke_grants;
+        bool revoking;
+    } lease;
 };
 
-/* Global list of `dent_file_locks` objects. Used for cleanup. */
-static LISTP_TYPE(dent_file_locks) g_dent_file_locks_list = LISTP_INIT;
+/*
+ * Global hash table of `dent_file_locks` objects, keyed by absolute path. In the leader process,
+ * it's used to find the objects for IPC requests without looking up the file in the dentry cache,
+ * and for cleanup. In other processes, it contains only leased files (and is used to find them when
+ * handling lease revocation).
+ */
+static struct dent_file_locks* g_dent_file_locks_hash = NULL;
 
 int init_fs_lock(void) {
-    if (g_process_ipc_ids.leader_vmid)
-        return 0;
+    /* Processes other than the leader need the lock too, for leased files. */
+    if (!create_lock(&g_fs_lock_lock))
+        return -ENOMEM;
+    return 0;
+}
 
-    return create_lock(&g_fs_lock_lock);
+static struct libos_file_lock* node2lock(struct avl_tree_node* node) {
+    return container_of(node, struct libos_file_lock, tree_node);
 }
 
-static int find_dent_file_locks(struct libos_dentry* dent, bool create,
-                                struct dent_file_locks** out_dent_file_locks) {
+static bool posix_lock_cmp(struct avl_tree_node* node_a, struct avl_tree_node* node_b) {
+    struct libos_file_lock* a = node2lock(node_a);
+    struct libos_file_lock* b = node2lock(node_b);
+    if (a->start != b->start)
+        return a->start < b->start;
+    return a->pid <= b->pid;
+}
+
+static void posix_lock_update(struct avl_tree_node* node) {
+    struct libos_file_lock* file_lock = node2lock(node);
+    uint64_t max_end = file_lock->end;
+    if (node->left)
+        max_end = MAX(max_end, node2lock(node->left)->subtree_max_end);
+    if (node->right)
+        max_end = MAX(max_end, node2lock(node->right)->subtree_max_end);
+    file_lock->subtree_max_end = max_end;
+}
+
+/* Returns the first (in tree order) lock in the subtree of `node` that overlaps with the range
+ * [`start`, `end`], or NULL if there is none. */
+static struct libos_file_lock* posix_lock_first_overlap(struct avl_tree_node* node, uint64_t start,
+                                                        uint64_t end) {
+    if (!node || node2lock(node)->subtree_max_end < start)
+        return NULL;
+
+    struct libos_file_lock* found = posix_lock_first_overlap(node->left, start, end);
+    if (found)
+        return found;
+
+    struct libos_file_lock* cur = node2lock(node);
+    if (end < cur->start) {
+        /* `cur` and all locks in the right subtree begin after the range ends */
+        return NULL;
+    }
+    if (start <= cur->end)
+        return cur;
+
+    return posix_lock_first_overlap(node->right, start, end);
+}
+
+/* Returns the next (in tree order) lock after `file_lock` that overlaps with the range [`start`,
+ * `end`], or NULL if there is none. */
+static struct libos_file_lock* posix_lock_next_overlap(struct libos_file_lock* file_lock,
+                                                       uint64_t start, uint64_t end) {
+    struct avl_tree_node* node = &file_lock->tree_node;
+
+    struct libos_file_lock* found = posix_lock_first_overlap(node->right, start, end);
+    if (found)
+        return found;
+
+    /* Go up until we find an ancestor that comes after `node` in tree order (i.e. `node` is in its
+     * left subtree), then check that ancestor and its right subtree. */
+    while (node->parent) {
+        struct avl_tree_node* parent = node->parent;
+        if (parent->left == node) {
+            struct libos_file_lock* cur = node2lock(parent);
+            if (end < cur->start)
+                return NULL;
+            if (start <= cur->end)
+                return cur;
+
+            found = posix_lock_first_overlap(parent->right, start, end);
+            if (found)
+                return found;
+        }
+        node = parent;
+    }
+    return NULL;
+}
+
+#define POSIX_LOCK_FOR_EACH_OVERLAP(cur, tree, start, end)                            \
+    for ((cur) = posix_lock_first_overlap((tree)->root, (start), (end)); (cur);       \
+         (cur) = posix_lock_next_overlap((cur), (start), (end)))
+
+/* Allocates `dent_file_locks` for `path`, without adding it to `g_dent_file_locks_hash`. */
+static int alloc_dent_file_locks(const char* path, struct dent_file_locks** out_dent_file_locks) {
+    struct dent_file_locks* dent_file_locks = calloc(1, sizeof(*dent_file_locks));
+    if (!dent_file_locks)
+        return -ENOMEM;
+
+    dent_file_locks->path = strdup(path);
+    if (!dent_file_locks->path) {
+        free(dent_file_locks);
+        return -ENOMEM;
+    }
+
+    dent_file_locks->posix_locks.cmp = posix_lock_cmp;
+    dent_file_locks->posix_locks.update = posix_lock_update;
+    INIT_LISTP(&dent_file_locks->flock_locks);
+    INIT_LISTP(&dent_file_locks->file_lock_requests);
+
+    *out_dent_file_locks = dent_file_locks;
+    return 0;
+}
+
+static void free_dent_file_locks(struct dent_file_locks* dent_file_locks) {
+    free(dent_file_locks->path);
+    free(dent_file_locks);
+}
+
+/* Adds `dent_file_locks` allocated by `alloc_dent_file_locks` to `g_dent_file_locks_hash`, and
+ * attaches it to `dent` (if not NULL). */
+static void add_dent_file_locks(struct libos_dentry* dent, struct dent_file_locks* dent_file_locks) {
     assert(locked(&g_fs_lock_lock));
-    if (!dent->file_locks && create) {
-        struct dent_file_locks* dent_file_locks = malloc(sizeof(*dent_file_locks));
-        if (!dent_file_locks)
-            return -ENOMEM;
-        dent_file_locks->posix_used = false;
-        dent_file_locks->flock_used = false;
+
+    if (dent) {
+        assert(!dent->file_locks);
         dent_file_locks->dent = dent;
         get_dentry(dent);
-        INIT_LISTP(&dent_file_locks->file_locks);
-        INIT_LISTP(&dent_file_locks->file_lock_requests);
         dent->file_locks = dent_file_locks;
+    }
+
+    HASH_ADD_KEYPTR(hh, g_dent_file_locks_hash, dent_file_locks->path,
+                    strlen(dent_file_locks->path), dent_file_locks);
+}
+
+static int create_dent_file_locks(struct libos_dentry* dent, const char* path,
+                                  struct dent_file_locks** out_dent_file_locks) {
+    assert(locked(&g_fs_lock_lock));
 
-        LISTP_ADD(dent_file_locks, &g_dent_file_locks_list, list);
+    struct dent_file_locks* dent_file_locks;
+    int ret = alloc_dent_file_locks(path, &dent_file_locks);
+    if (ret < 0)
+        return ret;
+
+    add_dent_file_locks(dent, dent_file_locks);
+    *out_dent_file_locks = dent_file_locks;
+    return 0;
+}
+
+static struct dent_file_locks* find_dent_file_locks_by_path(const char* path) {
+    assert(locked(&g_fs_lock_lock));
+
+    struct dent_file_locks* dent_file_locks;
+    HASH_FIND(hh, g_dent_file_locks_hash, path, strlen(path), dent_file_locks);
+    return dent_file_locks;
+}
+
+static int find_dent_file_locks(struct libos_dentry* dent, bool create,
+                                struct dent_file_locks** out_dent_file_locks) {
+    assert(locked(&g_fs_lock_lock));
+    if (!dent->file_locks && create) {
+        char* path;
+        int ret = dentry_abs_path(dent, &path, /*size=*/NULL);
+        if (ret < 0)
+            return ret;
+
+        struct dent_file_locks* dent_file_locks;
+        ret = create_dent_file_locks(dent, path, &dent_file_locks);
+        free(path);
+        if (ret < 0)
+            return ret;
     }
     *out_dent_file_locks = dent->file_locks;
     return 0;
@@ -113,64 +295,78 @@ static int file_lock_dump_write_all(const char* str, size_t size, void* arg) {
     return 0;
 }
 
+static char file_lock_type_char(struct libos_file_lock* file_lock) {
+    switch (file_lock->type) {
+        case F_RDLCK: return 'r';
+        case F_WRLCK: return 'w';
+        default: return '?';
+    }
+}
+
 /* Log current locks for a file, for debugging purposes. */
 static void file_locks_dump(struct dent_file_locks* dent_file_locks) {
     assert(locked(&g_fs_lock_lock));
     struct print_buf buf = INIT_PRINT_BUF(&file_lock_dump_write_all);
-    IDTYPE pid = 0;
-    bool force_flush = false;
-
-    struct libos_file_lock* file_lock;
-    LISTP_FOR_EACH_ENTRY(file_lock, &dent_file_locks->file_locks, list) {
-        char c;
-        switch (file_lock->type) {
-            case F_RDLCK: c = 'r'; break;
-            case F_WRLCK: c = 'w'; break;
-            default: c = '?'; break;
-        }
 
-        if (file_lock->family == FILE_LOCK_POSIX) {
-            if (file_lock->pid != pid) {
-                if (force_flush)
-                    buf_flush(&buf);
-                pid = file_lock->pid;
-                force_flush = true;
-                buf_printf(&buf, "fcntl (POSIX): pid=%d:", pid);
-            }
-            if (file_lock->end == FS_LOCK_EOF) {
-                buf_printf(&buf, " %c[%lu..end]", c, file_lock->start);
-            } else {
-                buf_printf(&buf, " %c[%lu..%lu]", c, file_lock->start, file_lock->end);
-            }
+    if (dent_file_locks->posix_locks.root)
+        buf_printf(&buf, "fcntl (POSIX):");
+    struct avl_tree_node* node = avl_tree_first(&dent_file_locks->posix_locks);
+    for (; node; node = avl_tree_next(node)) {
+        struct libos_file_lock* file_lock = node2lock(node);
+        char c = file_lock_type_char(file_lock);
+        if (file_lock->end == FS_LOCK_EOF) {
+            buf_printf(&buf, " pid=%d:%c[%lu..end]", file_lock->pid, c, file_lock->start);
         } else {
-            assert(file_lock->family == FILE_LOCK_FLOCK);
-            if (force_flush)
-                buf_flush(&buf);
-            force_flush = true;
-            buf_printf(&buf, " flock (BSD): handle id=%lu: %c", file_lock->handle_id, c);
+            buf_printf(&buf, " pid=%d:%c[%lu..%lu]", file_lock->pid, c, file_lock->start,
+                       file_lock->end);
         }
     }
+    if (dent_file_locks->posix_locks.root)
+        buf_flush(&buf);
+
+    struct libos_file_lock* file_lock;
+    LISTP_FOR_EACH_ENTRY(file_lock, &dent_file_locks->flock_locks, list) {
+        assert(file_lock->family == FILE_LOCK_FLOCK);
+        buf_printf(&buf, " flock (BSD): handle id=%lu: %c", file_lock->handle_id,
+                   file_lock_type_char(file_lock));
+        buf_flush(&buf);
+    }
+
+    if (dent_file_locks->lease.vmid) {
+        buf_printf(&buf, "leased to process %u (pid=%d)%s", dent_file_locks->lease.vmid,
+                   dent_file_locks->lease.pid, dent_file_locks->lease.revoking ? ", revoking" : "");
+        buf_flush(&buf);
+    } else if (dent_file_locks->lease.grants) {
+        buf_printf(&buf, "leased");
+        buf_flush(&buf);
+    }
 
-    if (LISTP_EMPTY(&dent_file_locks->file_locks)) {
+    if (!dent_file_locks->posix_locks.root && LISTP_EMPTY(&dent_file_locks->flock_locks)) {
         buf_printf(&buf, "no locks");
     }
     buf_flush(&buf);
 }
 
-/* Removes `dent_file_locks` if it's not necessary (no locks are held or requested for a file). */
+/* Removes `dent_file_locks` if it's not necessary (no locks are held or requested for a file, and
+ * the file is not leased). */
 static void dent_file_locks_gc(struct dent_file_locks* dent_file_locks) {
     assert(locked(&g_fs_lock_lock));
     if (g_log_level >= LOG_LEVEL_TRACE)
         file_locks_dump(dent_file_locks);
-    if (LISTP_EMPTY(&dent_file_locks->file_locks)
-            && LISTP_EMPTY(&dent_file_locks->file_lock_requests)) {
+    if (!dent_file_locks->posix_locks.root
+            && LISTP_EMPTY(&dent_file_locks->flock_locks)
+            && LISTP_EMPTY(&dent_file_locks->file_lock_requests)
+            && !dent_file_locks->lease.vmid
+            && !dent_file_locks->lease.grants
+            && !dent_file_locks->lease.revoke_grants) {
         struct libos_dentry* dent = dent_file_locks->dent;
-        dent->file_locks = NULL;
-
-        LISTP_DEL(dent_file_locks, &g_dent_file_locks_list, list);
+        if (dent) {
+            dent->file_locks = NULL;
+            put_dentry(dent);
+        }
 
-        put_dentry(dent);
-        free(dent_file_locks);
+        HASH_DELETE(hh, g_dent_file_locks_hash, dent_file_locks);
+        free_dent_file_locks(dent_file_locks);
     }
 }
 
@@ -188,15 +384,15 @@ static struct libos_file_lock* file_lock_find_conflict(struct dent_file_locks* d
     struct libos_file_lock* cur;
     /* Gramine doesn't support mixing POSIX and flock types of locks: it fails loudly. */
     if (file_lock->family == FILE_LOCK_POSIX) {
-        LISTP_FOR_EACH_ENTRY(cur, &dent_file_locks->file_locks, list) {
-            if (cur->pid != file_lock->pid && file_lock->start <= cur->end
-                    && cur->start <= file_lock->end
+        POSIX_LOCK_FOR_EACH_OVERLAP(cur, &dent_file_locks->posix_locks, file_lock->start,
+                                    file_lock->end) {
+            if (cur->pid != file_lock->pid
                     && (cur->type == F_WRLCK || file_lock->type == F_WRLCK))
                 return cur;
         }
     } else {
         assert(file_lock->family == FILE_LOCK_FLOCK);
-        LISTP_FOR_EACH_ENTRY(cur, &dent_file_locks->file_locks, list) {
+        LISTP_FOR_EACH_ENTRY(cur, &dent_file_locks->flock_locks, list) {
             if (cur->handle_id != file_lock->handle_id
                     && (cur->type == F_WRLCK || file_lock->type == F_WRLCK))
                 return cur;
@@ -205,21 +401,38 @@ static struct libos_file_lock* file_lock_find_conflict(struct dent_file_locks* d
     return NULL;
 }
 
+/* Sets `out_file_lock` to the result of `file_lock_get`: details of `conflict`, or `F_UNLCK` if
+ * there is no conflicting lock. */
+static void file_lock_get_result(struct libos_file_lock* conflict,
+                                 struct libos_file_lock* out_file_lock) {
+    if (conflict) {
+        out_file_lock->family = conflict->family;
+        out_file_lock->type = conflict->type;
+        out_file_lock->start = conflict->start;
+        out_file_lock->end = conflict->end;
+        out_file_lock->pid = conflict->pid;
+        out_file_lock->handle_id = conflict->handle_id;
+    } else {
+        out_file_lock->type = F_UNLCK;
+    }
+}
+
 /*
  * Add a new lock request. Before releasing `g_fs_lock_lock`, the caller has to initialize the
  * `notify` part of the request (see `struct file_lock_request` above).
  */
 static int file_lock_add_request(struct dent_file_locks* dent_file_locks,
-                                 struct libos_file_lock* file_lock,
+                                 struct libos_file_lock* file_lock, bool get, bool wait,
                                  struct file_lock_request** out_req) {
     assert(locked(&g_fs_lock_lock));
-    assert(file_lock->type != F_UNLCK);
 
     struct file_lock_request* req = malloc(sizeof(*req));
     if (!req)
         return -ENOMEM;
     req->file_lock = *file_lock;
-    LISTP_ADD(req, &dent_file_locks->file_lock_requests, list);
+    req->get = get;
+    req->wait = wait;
+    LISTP_ADD_TAIL(req, &dent_file_locks->file_lock_requests, list);
     *out_req = req;
     return 0;
 }
@@ -236,6 +449,8 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
     assert(locked(&g_fs_lock_lock));
     assert(file_lock->family == FILE_LOCK_POSIX);
 
+    struct avl_tree* tree = &dent_file_locks->posix_locks;
+
     /* Preallocate new locks first, so that we don't fail after modifying something. */
 
     /* Lock to be added. Not necessary for F_UNLCK, because we're only removing existing locks. */
@@ -257,30 +472,26 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
     uint64_t start = file_lock->start;
     uint64_t end   = file_lock->end;
 
-    /* `prev` will be set to the last lock before target range, so that we add the new lock just
-     * after `prev`. */
-    struct libos_file_lock* prev = NULL;
+    /* Collect the existing locks for a given PID that overlap with the target range, or are
+     * adjacent to it (so that we can merge them). They are sorted by start position. */
+    LISTP_TYPE(libos_file_lock) pid_locks = LISTP_INIT;
+    uint64_t search_start = start > 0 ? start - 1 : 0;
+    uint64_t search_end = end < FS_LOCK_EOF ? end + 1 : FS_LOCK_EOF;
 
     struct libos_file_lock* cur;
     struct libos_file_lock* tmp;
-    LISTP_FOR_EACH_ENTRY_SAFE(cur, tmp, &dent_file_locks->file_locks, list) {
-        if (cur->family != FILE_LOCK_POSIX)
-            continue;
-
-        if (cur->pid < file_lock->pid) {
-            prev = cur;
-            continue;
-        }
-        if (file_lock->pid < cur->pid) {
-            break;
-        }
+    POSIX_LOCK_FOR_EACH_OVERLAP(cur, tree, search_start, search_end) {
+        if (cur->pid == file_lock->pid)
+            LISTP_ADD_TAIL(cur, &pid_locks, list);
+    }
 
+    LISTP_FOR_EACH_ENTRY_SAFE(cur, tmp, &pid_locks, list) {
         if (cur->type == file_lock->type) {
             /* Same lock type: we can possibly merge the locks. */
 
             if (start > 0 && cur->end < start - 1) {
                 /* `cur` ends before target range begins, and is not even adjacent */
-                prev = cur;
+                continue;
             } else if (end < FS_LOCK_EOF && end + 1 < cur->start) {
                 /* `cur` begins after target range ends, and is not even adjacent - we're
                  * done */
@@ -290,7 +501,8 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
                  * expand the target range. */
                 start = MIN(start, cur->start);
                 end = MAX(end, cur->end);
-                LISTP_DEL(cur, &dent_file_locks->file_locks, list);
+                LISTP_DEL(cur, &pid_locks, list);
+                avl_tree_delete(tree, &cur->tree_node);
                 free(cur);
             }
         } else {
@@ -298,7 +510,7 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
 
             if (cur->end < start) {
                 /* `cur` ends before target range begins */
-                prev = cur;
+                continue;
             } else if (end < cur->start) {
                 /* `cur` begins after target range ends - we're done */
                 break;
@@ -313,7 +525,7 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
                  */
                 assert(start > 0);
                 cur->end = start - 1;
-                prev = cur;
+                avl_tree_update(tree, &cur->tree_node);
             } else if (cur->start < start && cur->end > end) {
                 /*
                  * The target range is inside `cur`. Split `cur` and finish.
@@ -336,10 +548,9 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
                 extra->pid = cur->pid;
                 extra->handle_id = 0; /* unused in POSIX (fcntl) locks, unset for sanity */
                 cur->end = start - 1;
-                LISTP_ADD_AFTER(extra, cur, &dent_file_locks->file_locks, list);
+                avl_tree_update(tree, &cur->tree_node);
+                avl_tree_insert(tree, &extra->tree_node);
                 extra = NULL;
-                /* We're done: the new lock, if any, will be added after `cur`. */
-                prev = cur;
                 break;
             } else if (start <= cur->start && cur->end <= end) {
                 /*
@@ -348,11 +559,13 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
                  * cur:    ====
                  * tgt:  --------
                  */
-                LISTP_DEL(cur, &dent_file_locks->file_locks, list);
+                LISTP_DEL(cur, &pid_locks, list);
+                avl_tree_delete(tree, &cur->tree_node);
                 free(cur);
             } else {
                 /*
-                 * `cur` overlaps with end of target range. Shorten `cur` and finish.
+                 * `cur` overlaps with end of target range. Shorten `cur` and finish. This changes
+                 * the position of `cur` in the tree, so we need to reinsert it.
                  *
                  * cur:    ====
                  * tgt: -----
@@ -361,7 +574,9 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
                  */
                 assert(start <= cur->start && end < cur->end);
                 assert(end < FS_LOCK_EOF);
+                avl_tree_delete(tree, &cur->tree_node);
                 cur->start = end + 1;
+                avl_tree_insert(tree, &cur->tree_node);
                 break;
             }
         }
@@ -378,22 +593,13 @@ static int _posix_lock_set(struct dent_file_locks* dent_file_locks,
         new->handle_id = 0; /* unused in POSIX (fcntl) locks, unset for sanity */
 
 #ifdef DEBUG
-        /* Assert that list order is preserved */
-        struct libos_file_lock* next = prev
-            ? LISTP_NEXT_ENTRY(prev, &dent_file_locks->file_locks, list)
-            : LISTP_FIRST_ENTRY(&dent_file_locks->file_locks, struct libos_file_lock, list);
-        if (prev)
-            assert(prev->pid < file_lock->pid
-                    || (prev->pid == file_lock->pid && prev->end < start));
-        if (next)
-            assert(file_lock->pid < next->pid || (file_lock->pid == next->pid && end < next->start));
+        /* Assert that the new lock doesn't overlap with other locks for a given PID */
+        POSIX_LOCK_FOR_EACH_OVERLAP(cur, tree, start, end) {
+            assert(cur->pid != file_lock->pid);
+        }
 #endif
 
-        if (prev) {
-            LISTP_ADD_AFTER(new, prev, &dent_file_locks->file_locks, list);
-        } else {
-            LISTP_ADD(new, &dent_file_locks->file_locks, list);
-        }
+        avl_tree_insert(tree, &new->tree_node);
     }
 
     if (extra)
@@ -420,12 +626,9 @@ static int _flock_lock_set(struct dent_file_locks* dent_file_locks,
 
     struct libos_file_lock* cur;
     struct libos_file_lock* tmp;
-    LISTP_FOR_EACH_ENTRY_SAFE(cur, tmp, &dent_file_locks->file_locks, list) {
-        if (cur->family != FILE_LOCK_FLOCK)
-            continue;
-
+    LISTP_FOR_EACH_ENTRY_SAFE(cur, tmp, &dent_file_locks->flock_locks, list) {
         if (cur->handle_id == file_lock->handle_id) {
-            LISTP_DEL(cur, &dent_file_locks->file_locks, list);
+            LISTP_DEL(cur, &dent_file_locks->flock_locks, list);
             free(cur);
             break;
         }
@@ -438,21 +641,109 @@ static int _flock_lock_set(struct dent_file_locks* dent_file_locks,
         new->handle_id = file_lock->handle_id;
         new->start = new->end = new->pid = 0; /* unused in BSD (flock) locks, unset for sanity */
 
-        LISTP_ADD(new, &dent_file_locks->file_locks, list);
+        LISTP_ADD(new, &dent_file_locks->flock_locks, list);
+    }
+
+    return 0;
+}
+
+/*
+ * Check if a lock can be added/removed: returns -EPERM if it would mix POSIX and BSD locks on the
+ * same file, -EAGAIN if it conflicts with an existing lock, and 0 otherwise.
+ */
+static int file_lock_check(struct dent_file_locks* dent_file_locks,
+                           struct libos_file_lock* file_lock) {
+    assert(locked(&g_fs_lock_lock));
+
+    if (file_lock->type == F_UNLCK)
+        return 0;
+
+    if ((file_lock->family == FILE_LOCK_FLOCK && dent_file_locks->posix_used)
+            || (file_lock->family == FILE_LOCK_POSIX && dent_file_locks->flock_used)) {
+        log_error("Application wants to use both POSIX (fcntl) and BSD (flock) file locks on "
+                  "the same file. This is not supported.");
+        return -EPERM;
     }
 
+    if (file_lock_find_conflict(dent_file_locks, file_lock))
+        return -EAGAIN;
+    return 0;
+}
+
+/* Add/remove a lock, assumes we already verified that it's possible (see `file_lock_check`). */
+static int file_lock_apply(struct dent_file_locks* dent_file_locks,
+                           struct libos_file_lock* file_lock) {
+    assert(locked(&g_fs_lock_lock));
+
+    int ret = file_lock->family == FILE_LOCK_POSIX ? _posix_lock_set(dent_file_locks, file_lock)
+                                                   : _flock_lock_set(dent_file_locks, file_lock);
+    if (ret < 0)
+        return ret;
+
+    if (file_lock->type != F_UNLCK) {
+        if (file_lock->family == FILE_LOCK_POSIX)
+            dent_file_locks->posix_used = true;
+        if (file_lock->family == FILE_LOCK_FLOCK)
+            dent_file_locks->flock_used = true;
+    }
     return 0;
 }
 
+/* Remove a processed request, and notify the waiter. For `get` requests, `conflict` is the result
+ * (see `file_lock_get_result`). */
+static void file_lock_finish_request(struct dent_file_locks* dent_file_locks,
+                                     struct file_lock_request* req, int result,
+                                     struct libos_file_lock* conflict) {
+    assert(locked(&g_fs_lock_lock));
+
+    LISTP_DEL(req, &dent_file_locks->file_lock_requests, list);
+
+    /* Notify the waiter that we processed their request. Note that the result might still be
+     * a failure (-ENOMEM). */
+    if (req->notify.vmid == 0) {
+        assert(req->notify.event);
+        assert(req->notify.result);
+        *req->notify.result = result;
+        if (req->get) {
+            assert(req->notify.out_file_lock);
+            file_lock_get_result(conflict, req->notify.out_file_lock);
+        }
+        PalEventSet(req->notify.event);
+    } else {
+        assert(!req->notify.event);
+        assert(!req->notify.result);
+
+        int ret;
+        if (req->get) {
+            struct libos_file_lock out_file_lock = {0};
+            file_lock_get_result(conflict, &out_file_lock);
+            ret = ipc_file_lock_get_send_response(req->notify.vmid, req->notify.seq, result,
+                                                  &out_file_lock);
+        } else {
+            ret = ipc_file_lock_set_send_response(req->notify.vmid, req->notify.seq, result,
+                                                  /*lease=*/false);
+        }
+        if (ret < 0) {
+            log_warning("file lock: error sending result over IPC: %s", unix_strerror(ret));
+        }
+    }
+    free(req);
+}
+
 /*
  * Process pending requests. This function should be called after any modification to the list of
- * locks, since we might have unblocked a request.
+ * locks, since we might have unblocked a request, and after a lease is returned.
  *
  * TODO: This is pretty inefficient, but perhaps good enough for now...
  */
 static void file_lock_process_requests(struct dent_file_locks* dent_file_locks) {
     assert(locked(&g_fs_lock_lock));
 
+    if (dent_file_locks->lease.vmid) {
+        /* The locks are held by the lease holder, wait until it returns them. */
+        return;
+    }
+
     bool changed;
     do {
         changed = false;
@@ -460,100 +751,267 @@ static void file_lock_process_requests(struct dent_file_locks* dent_file_locks)
         struct file_lock_request* req;
         struct file_lock_request* tmp;
         LISTP_FOR_EACH_ENTRY_SAFE(req, tmp, &dent_file_locks->file_lock_requests, list) {
-            struct libos_file_lock* conflict = file_lock_find_conflict(dent_file_locks,
-                                                                       &req->file_lock);
-            if (!conflict) {
-                int result = req->file_lock.family == FILE_LOCK_POSIX
-                                 ? _posix_lock_set(dent_file_locks, &req->file_lock)
-                                 : _flock_lock_set(dent_file_locks, &req->file_lock);
-                LISTP_DEL(req, &dent_file_locks->file_lock_requests, list);
-
-                /* Notify the waiter that we processed their request. Note that the result might
-                 * still be a failure (-ENOMEM). */
-                if (req->notify.vmid == 0) {
-                    assert(req->notify.event);
-                    assert(req->notify.result);
-                    *req->notify.result = result;
-                    PalEventSet(req->notify.event);
-                } else {
-                    assert(!req->notify.event);
-                    assert(!req->notify.result);
-
-                    int ret = ipc_file_lock_set_send_response(req->notify.vmid, req->notify.seq,
-                                                              result);
-                    if (ret < 0) {
-                        log_warning("file lock: error sending result over IPC: %s",
-                                    unix_strerror(ret));
-                    }
-                }
-                free(req);
-                changed = true;
+            if (req->get) {
+                /* Requests for `file_lock_get` were queued only because the file was leased. */
+                struct libos_file_lock* conflict = file_lock_find_conflict(dent_file_locks,
+                                                                           &req->file_lock);
+                file_lock_finish_request(dent_file_locks, req, /*result=*/0, conflict);
+                continue;
             }
+
+            int result = file_lock_check(dent_file_locks, &req->file_lock);
+            if (result == -EAGAIN && req->wait)
+                continue;
+
+            if (result == 0) {
+                result = file_lock_apply(dent_file_locks, &req->file_lock);
+                if (result == 0)
+                    changed = true;
+            }
+            file_lock_finish_request(dent_file_locks, req, result, /*conflict=*/NULL);
         }
     } while (changed);
 }
 
-/* Add/remove a lock if possible. On conflict, returns -EAGAIN (if `wait` is false) or adds a new
- * request (if `wait` is true). */
-static int file_lock_set_or_add_request(struct libos_dentry* dent,
-                                        struct libos_file_lock* file_lock,
-                                        bool wait, struct file_lock_request** out_req) {
+/* Ask the lease holder to return the lease on a file. */
+static int file_lock_revoke_lease(struct dent_file_locks* dent_file_locks) {
     assert(locked(&g_fs_lock_lock));
+    assert(dent_file_locks->lease.vmid);
 
-    struct dent_file_locks* dent_file_locks = NULL;
-    int ret = find_dent_file_locks(dent, /*create=*/file_lock->type != F_UNLCK, &dent_file_locks);
-    if (ret < 0)
-        goto out;
-    if (!dent_file_locks) {
-        assert(file_lock->type == F_UNLCK);
-        /* Nothing to unlock. */
+    if (dent_file_locks->lease.revoking)
         return 0;
+
+    int ret = ipc_file_lock_revoke_lease(dent_file_locks->lease.vmid, dent_file_locks->path,
+                                         dent_file_locks->lease.grants);
+    if (ret < 0) {
+        log_warning("file lock: error revoking lease on %s from process %u: %s",
+                    dent_file_locks->path, dent_file_locks->lease.vmid, unix_strerror(ret));
+        return ret;
     }
+    dent_file_locks->lease.revoking = true;
+    return 0;
+}
 
-    if (file_lock->type != F_UNLCK) {
-        if ((file_lock->family == FILE_LOCK_FLOCK && dent_file_locks->posix_used)
-                || (file_lock->family == FILE_LOCK_POSIX && dent_file_locks->flock_used)) {
-            log_error("Application wants to use both POSIX (fcntl) and BSD (flock) file locks on "
-                      "the same file. This is not supported.");
-            ret = -EPERM;
-            goto out;
+/*
+ * Add/remove a lock if possible. On conflict, returns -EAGAIN (if `wait` is false) or adds a new
+ * request (if `wait` is true).
+ *
+ * `vmid` is the requesting process (0 for the leader process itself). If the request can be
+ * granted immediately and the file is not locked by anyone, the requesting process might get
+ * a lease on the file instead (`*out_lease` is set to true). A request for a file leased to another
+ * process is always queued (and the lease is revoked), unless it's a no-op.
+ */
+static int file_lock_set_or_add_request(struct dent_file_locks* dent_file_locks,
+                                        struct libos_file_lock* file_lock, bool wait, IDTYPE vmid,
+                                        struct file_lock_request** out_req, bool* out_lease) {
+    assert(locked(&g_fs_lock_lock));
+
+    *out_req = NULL;
+    *out_lease = false;
+
+    int ret;
+    if (dent_file_locks->lease.vmid) {
+        /* The file is leased: all locks on it are POSIX locks held by the lease holder. */
+        if (file_lock->type == F_UNLCK && (file_lock->family == FILE_LOCK_FLOCK
+                                           || file_lock->pid != dent_file_locks->lease.pid)) {
+            /* Nothing to unlock. */
+            return 0;
         }
-    }
 
-    struct libos_file_lock* conflict = NULL;
-    if (file_lock->type != F_UNLCK)
-        conflict = file_lock_find_conflict(dent_file_locks, file_lock);
-    if (conflict) {
-        if (!wait) {
-            ret = -EAGAIN;
-            goto out;
+        if (file_lock->family == FILE_LOCK_POSIX && vmid == dent_file_locks->lease.vmid
+                && !dent_file_locks->lease.revoking) {
+            /* The holder sent this request before it processed the response granting the lease:
+             * let it apply the lock locally. */
+            dent_file_locks->lease.grants++;
+            *out_lease = true;
+            return 0;
         }
 
-        struct file_lock_request* req;
-        ret = file_lock_add_request(dent_file_locks, file_lock, &req);
+        ret = file_lock_revoke_lease(dent_file_locks);
         if (ret < 0)
-            goto out;
+            return ret;
+        return file_lock_add_request(dent_file_locks, file_lock, /*get=*/false, wait, out_req);
+    }
 
-        *out_req = req;
-    } else {
-        ret = file_lock->family == FILE_LOCK_POSIX ? _posix_lock_set(dent_file_locks, file_lock)
-                                                   : _flock_lock_set(dent_file_locks, file_lock);
-        if (ret < 0)
-            goto out;
-        file_lock_process_requests(dent_file_locks);
-        *out_req = NULL;
+    ret = file_lock_check(dent_file_locks, file_lock);
+    if (ret == -EAGAIN && wait)
+        return file_lock_add_request(dent_file_locks, file_lock, /*get=*/false, wait, out_req);
+    if (ret < 0)
+        return ret;
+
+    if (vmid && file_lock->family == FILE_LOCK_POSIX && file_lock->type != F_UNLCK
+            && !dent_file_locks->posix_locks.root
+            && LISTP_EMPTY(&dent_file_locks->flock_locks)
+            && LISTP_EMPTY(&dent_file_locks->file_lock_requests)) {
+        /* Nobody else is interested in the file: grant a lease to the requesting process. */
+        dent_file_locks->lease.vmid = vmid;
+        dent_file_locks->lease.pid = file_lock->pid;
+        dent_file_locks->lease.grants = 1;
+        dent_file_locks->lease.revoking = false;
+        dent_file_locks->posix_used = true;
+        *out_lease = true;
+        return 0;
     }
 
-    if (file_lock->type != F_UNLCK) {
-        if (file_lock->family == FILE_LOCK_POSIX)
-            dent_file_locks->posix_used = true;
-        if (file_lock->family == FILE_LOCK_FLOCK)
-            dent_file_locks->flock_used = true;
+    ret = file_lock_apply(dent_file_locks, file_lock);
+    if (ret < 0)
+        return ret;
+    file_lock_process_requests(dent_file_locks);
+    return 0;
+}
+
+/* Check for a conflicting lock. If the file is leased to another process (and the result depends
+ * on the holder's locks), adds a new request instead. */
+static int file_lock_get_or_add_request(struct dent_file_locks* dent_file_locks,
+                                        struct libos_file_lock* file_lock,
+                                        struct libos_file_lock* out_file_lock,
+                                        struct file_lock_request** out_req) {
+    assert(locked(&g_fs_lock_lock));
+    assert(file_lock->type != F_UNLCK);
+
+    *out_req = NULL;
+
+    if (dent_file_locks->lease.vmid) {
+        /* The file is leased: all locks on it are POSIX locks held by the lease holder, so they
+         * can conflict only with POSIX locks of other processes. */
+        if (file_lock->family == FILE_LOCK_FLOCK || file_lock->pid == dent_file_locks->lease.pid) {
+            file_lock_get_result(/*conflict=*/NULL, out_file_lock);
+            return 0;
+        }
+
+        int ret = file_lock_revoke_lease(dent_file_locks);
+        if (ret < 0)
+            return ret;
+        return file_lock_add_request(dent_file_locks, file_lock, /*get=*/true, /*wait=*/false,
+                                     out_req);
     }
-    ret = 0;
-out:
-    if (dent_file_locks)
+
+    struct libos_file_lock* conflict = file_lock_find_conflict(dent_file_locks, file_lock);
+    file_lock_get_result(conflict, out_file_lock);
+    return 0;
+}
+
+/*
+ * Wait for a request added by the leader process. Expects `g_fs_lock_lock` to be held, and releases
+ * it for the time of waiting. The request is removed (and `dent_file_locks` possibly freed) after
+ * it's processed.
+ */
+static int file_lock_wait_for_request(struct dent_file_locks* dent_file_locks,
+                                      struct file_lock_request* req,
+                                      struct libos_file_lock* out_file_lock) {
+    assert(locked(&g_fs_lock_lock));
+
+    PAL_HANDLE event;
+    int ret = PalEventCreate(&event, /*init_signaled=*/false, /*auto_clear=*/false);
+    if (ret < 0) {
+        LISTP_DEL(req, &dent_file_locks->file_lock_requests, list);
+        free(req);
         dent_file_locks_gc(dent_file_locks);
+        return pal_to_unix_errno(ret);
+    }
+
+    int result;
+    req->notify.vmid = 0;
+    req->notify.seq = 0;
+    req->notify.event = event;
+    req->notify.result = &result;
+    req->notify.out_file_lock = out_file_lock;
+
+    unlock(&g_fs_lock_lock);
+    ret = event_wait_with_retry(event);
+    lock(&g_fs_lock_lock);
+    PalObjectDestroy(event);
+    if (ret < 0)
+        return ret;
+
+    return result;
+}
+
+/* Send all POSIX locks on a leased file back to the leader process, and forget the lease. */
+static int file_lock_return_lease(struct dent_file_locks* dent_file_locks) {
+    assert(locked(&g_fs_lock_lock));
+    assert(g_process_ipc_ids.leader_vmid);
+    assert(dent_file_locks->lease.grants > 0);
+    assert(dent_file_locks->lease.grants == dent_file_locks->lease.revoke_grants);
+
+    struct avl_tree* tree = &dent_file_locks->posix_locks;
+
+    size_t locks_count = 0;
+    for (struct avl_tree_node* node = avl_tree_first(tree); node; node = avl_tree_next(node))
+        locks_count++;
+
+    struct libos_file_lock* file_locks = NULL;
+    if (locks_count > 0) {
+        file_locks = malloc(locks_count * sizeof(*file_locks));
+        if (!file_locks)
+            return -ENOMEM;
+    }
+
+    size_t i = 0;
+    struct avl_tree_node* node;
+    while ((node = avl_tree_first(tree))) {
+        struct libos_file_lock* file_lock = node2lock(node);
+        file_locks[i++] = *file_lock;
+        avl_tree_delete(tree, node);
+        free(file_lock);
+    }
+    assert(i == locks_count);
+
+    int ret = ipc_file_lock_return_lease(dent_file_locks->path, file_locks, locks_count);
+    free(file_locks);
+    if (ret < 0) {
+        log_warning("file lock: error returning lease on %s: %s", dent_file_locks->path,
+                    unix_strerror(ret));
+    }
+
+    dent_file_locks->lease.grants = 0;
+    dent_file_locks->lease.revoke_grants = 0;
+    dent_file_locks_gc(dent_file_locks);
+    return ret;
+}
+
+/*
+ * Called in a lease holder after getting a response granting the lease. Applies the lock, and
+ * returns the lease if it was already revoked.
+ *
+ * `*new_dent_file_locks` is allocated by the caller before sending the request, so that the grant
+ * is always accounted (failing here would leave the leader thinking that we hold the lease). It is
+ * used (and set to NULL) if the file has no `dent_file_locks` yet.
+ */
+static int file_lock_lease_granted(struct libos_dentry* dent, struct libos_file_lock* file_lock,
+                                   struct dent_file_locks** new_dent_file_locks) {
+    assert(g_process_ipc_ids.leader_vmid);
+    assert(file_lock->family == FILE_LOCK_POSIX);
+
+    lock(&g_fs_lock_lock);
+
+    struct dent_file_locks* dent_file_locks = dent->file_locks;
+    if (!dent_file_locks) {
+        /* The lease might have been revoked already (before we processed the response). */
+        dent_file_locks = find_dent_file_locks_by_path((*new_dent_file_locks)->path);
+        if (dent_file_locks) {
+            assert(!dent_file_locks->dent);
+            dent_file_locks->dent = dent;
+            get_dentry(dent);
+            dent->file_locks = dent_file_locks;
+        } else {
+            dent_file_locks = *new_dent_file_locks;
+            *new_dent_file_locks = NULL;
+            add_dent_file_locks(dent, dent_file_locks);
+        }
+    }
+
+    dent_file_locks->lease.grants++;
+
+    /* All POSIX locks on the file are ours, so there are no conflicts. */
+    int ret = file_lock_apply(dent_file_locks, file_lock);
+
+    if (dent_file_locks->lease.grants == dent_file_locks->lease.revoke_grants) {
+        int return_ret = file_lock_return_lease(dent_file_locks);
+        if (ret == 0)
+            ret = return_ret;
+    }
+    unlock(&g_fs_lock_lock);
     return ret;
 }
 
@@ -573,6 +1031,16 @@ int file_lock_set(struct libos_dentry* dent, struct libos_file_lock* file_lock,
             unlock(&g_fs_lock_lock);
             return 0;
         }
+
+        struct dent_file_locks* dent_file_locks = dent->file_locks;
+        if (file_lock->family == FILE_LOCK_POSIX && dent_file_locks
+                && dent_file_locks->lease.grants > 0) {
+            /* We hold a lease on the file, so we can handle the request locally: all POSIX locks on
+             * the file are ours, so there are no conflicts. */
+            ret = file_lock_apply(dent_file_locks, file_lock);
+            unlock(&g_fs_lock_lock);
+            return ret;
+        }
         unlock(&g_fs_lock_lock);
 
         char* path;
@@ -580,48 +1048,77 @@ int file_lock_set(struct libos_dentry* dent, struct libos_file_lock* file_lock,
         if (ret < 0)
             return ret;
 
-        ret = ipc_file_lock_set(path, file_lock, wait);
+        /* the response may grant us a lease on the file, prepare for storing it */
+        struct dent_file_locks* new_dent_file_locks = NULL;
+        if (file_lock->family == FILE_LOCK_POSIX) {
+            ret = alloc_dent_file_locks(path, &new_dent_file_locks);
+            if (ret < 0) {
+                free(path);
+                return ret;
+            }
+        }
+
+        bool lease = false;
+        ret = ipc_file_lock_set(path, file_lock, wait, &lease);
+        if (ret == 0 && lease)
+            ret = file_lock_lease_granted(dent, file_lock, &new_dent_file_locks);
+        if (new_dent_file_locks)
+            free_dent_file_locks(new_dent_file_locks);
         free(path);
         return ret;
     }
 
     lock(&g_fs_lock_lock);
 
-    PAL_HANDLE event = NULL;
-    struct file_lock_request* req = NULL;
-    ret = file_lock_set_or_add_request(dent, file_lock, wait, &req);
+    struct dent_file_locks* dent_file_locks = NULL;
+    ret = find_dent_file_locks(dent, /*create=*/file_lock->type != F_UNLCK, &dent_file_locks);
     if (ret < 0)
         goto out;
-    if (req) {
-        /* `file_lock_set_or_add_request` is allowed to add a request only if `wait` is true */
-        assert(wait);
-
-        int result;
-        ret = PalEventCreate(&event, /*init_signaled=*/false, /*auto_clear=*/false);
-        if (ret < 0)
-            goto out;
-        req->notify.vmid = 0;
-        req->notify.seq = 0;
-        req->notify.event = event;
-        req->notify.result = &result;
+    if (!dent_file_locks) {
+        assert(file_lock->type == F_UNLCK);
+        /* Nothing to unlock. */
+        goto out;
+    }
 
-        unlock(&g_fs_lock_lock);
-        ret = event_wait_with_retry(event);
-        lock(&g_fs_lock_lock);
-        if (ret < 0)
-            goto out;
+    struct file_lock_request* req;
+    bool lease;
+    ret = file_lock_set_or_add_request(dent_file_locks, file_lock, wait, /*vmid=*/0, &req, &lease);
+    assert(!lease);
+    if (req) {
+        /* `file_lock_set_or_add_request` is allowed to add a request only if `wait` is true, or if
+         * the file is leased to another process */
+        assert(ret == 0);
 
-        ret = result;
-    } else {
-        ret = 0;
+        ret = file_lock_wait_for_request(dent_file_locks, req, /*out_file_lock=*/NULL);
+        goto out;
     }
+    dent_file_locks_gc(dent_file_locks);
 out:
     unlock(&g_fs_lock_lock);
-    if (event)
-        PalObjectDestroy(event);
     return ret;
 }
 
+/* Find the dentry for `path`, for handling an IPC request. Expects `g_fs_lock_lock` *not* to be
+ * held. */
+static int file_lock_lookup_dentry(const char* path, struct libos_dentry** out_dent) {
+    struct libos_dentry* dent = NULL;
+    struct libos_inode* inode = NULL;
+
+    int ret = path_lookupat_cached(g_dentry_root, path, LOOKUP_NO_FOLLOW, &dent, &inode);
+    if (ret == 0) {
+        put_inode(inode);
+    } else if (ret == -EAGAIN) {
+        lock(&g_dcache_lock);
+        ret = path_lookupat(g_dentry_root, path, LOOKUP_NO_FOLLOW, &dent);
+        unlock(&g_dcache_lock);
+    }
+    if (ret < 0)
+        return ret;
+
+    *out_dent = dent;
+    return 0;
+}
+
 int file_lock_set_from_ipc(const char* path, struct libos_file_lock* file_lock, bool wait,
                            IDTYPE vmid, unsigned long seq) {
     assert(file_lock->family == FILE_LOCK_POSIX || file_lock->family == FILE_LOCK_FLOCK);
@@ -630,31 +1127,57 @@ int file_lock_set_from_ipc(const char* path, struct libos_file_lock* file_lock,
 
     struct libos_dentry* dent = NULL;
     struct file_lock_request* req = NULL;
-
-    lock(&g_dcache_lock);
-    int ret = path_lookupat(g_dentry_root, path, LOOKUP_NO_FOLLOW, &dent);
-    unlock(&g_dcache_lock);
-    if (ret < 0) {
-        log_warning("file_lock_set_from_ipc: error on dentry lookup for %s: %d", path, ret);
-        goto out;
-    }
+    bool lease = false;
+    int ret;
 
     lock(&g_fs_lock_lock);
-    ret = file_lock_set_or_add_request(dent, file_lock, wait, &req);
-    unlock(&g_fs_lock_lock);
-    if (ret < 0)
-        goto out;
+    struct dent_file_locks* dent_file_locks = find_dent_file_locks_by_path(path);
+    if (!dent_file_locks) {
+        if (file_lock->type == F_UNLCK) {
+            /* Nothing to unlock. */
+            unlock(&g_fs_lock_lock);
+            ret = 0;
+            goto out;
+        }
+
+        /* Make sure the file exists before creating a lock for it. */
+        unlock(&g_fs_lock_lock);
+        ret = file_lock_lookup_dentry(path, &dent);
+        if (ret < 0) {
+            log_warning("file_lock_set_from_ipc: error on dentry lookup for %s: %s", path,
+                        unix_strerror(ret));
+            goto out;
+        }
+        lock(&g_fs_lock_lock);
+
+        /* The paths in IPC requests come from `dentry_abs_path`, so we should have found the object
+         * by path if the dentry had one. Still, don't assume that. */
+        dent_file_locks = dent->file_locks;
+        if (!dent_file_locks) {
+            ret = create_dent_file_locks(dent, path, &dent_file_locks);
+            if (ret < 0) {
+                unlock(&g_fs_lock_lock);
+                goto out;
+            }
+        }
+    }
 
+    ret = file_lock_set_or_add_request(dent_file_locks, file_lock, wait, vmid, &req, &lease);
     if (req) {
-        /* `file_lock_set_or_add_request` is allowed to add a request only if `wait` is true */
-        assert(wait);
+        /* `file_lock_set_or_add_request` is allowed to add a request only if `wait` is true, or if
+         * the file is leased to another process */
+        assert(ret == 0);
 
         req->notify.vmid = vmid;
         req->notify.seq = seq;
         req->notify.event = NULL;
         req->notify.result = NULL;
+        req->notify.out_file_lock = NULL;
+    } else {
+        dent_file_locks_gc(dent_file_locks);
     }
-    ret = 0;
+    unlock(&g_fs_lock_lock);
+
 out:
     if (dent)
         put_dentry(dent);
@@ -662,7 +1185,7 @@ out:
         /* We added a request, so response will be sent later. */
         return 0;
     }
-    return ipc_file_lock_set_send_response(vmid, seq, ret);
+    return ipc_file_lock_set_send_response(vmid, seq, ret, lease);
 }
 
 int file_lock_get(struct libos_dentry* dent, struct libos_file_lock* file_lock,
@@ -673,6 +1196,18 @@ int file_lock_get(struct libos_dentry* dent, struct libos_file_lock* file_lock,
 
     int ret;
     if (g_process_ipc_ids.leader_vmid) {
+        if (file_lock->family == FILE_LOCK_POSIX) {
+            lock(&g_fs_lock_lock);
+            if (dent->file_locks && dent->file_locks->lease.grants > 0) {
+                /* We hold a lease on the file: all POSIX locks on the file are ours, so there are
+                 * no conflicts. */
+                unlock(&g_fs_lock_lock);
+                file_lock_get_result(/*conflict=*/NULL, out_file_lock);
+                return 0;
+            }
+            unlock(&g_fs_lock_lock);
+        }
+
         char* path;
         ret = dentry_abs_path(dent, &path, /*size=*/NULL);
         if (ret < 0)
@@ -689,71 +1224,158 @@ int file_lock_get(struct libos_dentry* dent, struct libos_file_lock* file_lock,
     ret = find_dent_file_locks(dent, /*create=*/false, &dent_file_locks);
     if (ret < 0)
         goto out;
+    if (!dent_file_locks) {
+        file_lock_get_result(/*conflict=*/NULL, out_file_lock);
+        goto out;
+    }
 
-    struct libos_file_lock* conflict = NULL;
-    if (dent_file_locks)
-        conflict = file_lock_find_conflict(dent_file_locks, file_lock);
-    if (conflict) {
-        out_file_lock->family = conflict->family;
-        out_file_lock->type = conflict->type;
-        out_file_lock->start = conflict->start;
-        out_file_lock->end = conflict->end;
-        out_file_lock->pid = conflict->pid;
-        out_file_lock->handle_id = conflict->handle_id;
-    } else {
-        out_file_lock->type = F_UNLCK;
+    struct file_lock_request* req;
+    ret = file_lock_get_or_add_request(dent_file_locks, file_lock, out_file_lock, &req);
+    if (req) {
+        assert(ret == 0);
+        ret = file_lock_wait_for_request(dent_file_locks, req, out_file_lock);
+        goto out;
     }
-    ret = 0;
+    dent_file_locks_gc(dent_file_locks);
 
 out:
-    if (dent_file_locks)
-        dent_file_locks_gc(dent_file_locks);
-
     unlock(&g_fs_lock_lock);
     return ret;
 }
 
-int file_lock_get_from_ipc(const char* path, struct libos_file_lock* file_lock,
-                           struct libos_file_lock* out_file_lock) {
+int file_lock_get_from_ipc(const char* path, struct libos_file_lock* file_lock, IDTYPE vmid,
+                           unsigned long seq) {
     assert(file_lock->family == FILE_LOCK_POSIX || file_lock->family == FILE_LOCK_FLOCK);
     assert(file_lock->family == FILE_LOCK_POSIX ? file_lock->pid : file_lock->handle_id);
     assert(!g_process_ipc_ids.leader_vmid);
 
-    struct libos_dentry* dent = NULL;
-    lock(&g_dcache_lock);
-    int ret = path_lookupat(g_dentry_root, path, LOOKUP_NO_FOLLOW, &dent);
-    unlock(&g_dcache_lock);
-    if (ret < 0) {
-        log_warning("file_lock_get_from_ipc: error on dentry lookup for %s: %s", path,
-                    unix_strerror(ret));
-        return ret;
+    struct libos_file_lock out_file_lock = {0};
+    struct file_lock_request* req = NULL;
+    int ret;
+
+    lock(&g_fs_lock_lock);
+    struct dent_file_locks* dent_file_locks = find_dent_file_locks_by_path(path);
+    if (dent_file_locks) {
+        ret = file_lock_get_or_add_request(dent_file_locks, file_lock, &out_file_lock, &req);
+        if (req) {
+            assert(ret == 0);
+            req->notify.vmid = vmid;
+            req->notify.seq = seq;
+            req->notify.event = NULL;
+            req->notify.result = NULL;
+            req->notify.out_file_lock = NULL;
+        } else {
+            dent_file_locks_gc(dent_file_locks);
+        }
+    } else {
+        /* Nobody holds locks on the file. */
+        file_lock_get_result(/*conflict=*/NULL, &out_file_lock);
+        ret = 0;
     }
+    unlock(&g_fs_lock_lock);
 
-    ret = file_lock_get(dent, file_lock, out_file_lock);
-    put_dentry(dent);
-    return ret;
+    if (req) {
+        /* We added a request, so response will be sent later. */
+        return 0;
+    }
+    return ipc_file_lock_get_send_response(vmid, seq, ret, &out_file_lock);
 }
 
-/* Removes all POSIX locks and lock requests for a given PID and dentry. */
-static int file_lock_clear_pid_from_dentry(struct libos_dentry* dent, IDTYPE pid) {
-    assert(locked(&g_fs_lock_lock));
+int file_lock_revoke_lease_from_ipc(const char* path, unsigned int grants) {
+    assert(g_process_ipc_ids.leader_vmid);
+    assert(grants > 0);
 
-    struct dent_file_locks* dent_file_locks;
-    int ret = find_dent_file_locks(dent, /*create=*/false, &dent_file_locks);
-    if (ret < 0)
-        return ret;
+    int ret = 0;
+    lock(&g_fs_lock_lock);
+    struct dent_file_locks* dent_file_locks = find_dent_file_locks_by_path(path);
     if (!dent_file_locks) {
-        /* Nothing to process. */
-        return 0;
+        /* We haven't processed any of the responses granting the lease yet. Remember the
+         * revocation, the lease will be returned in `file_lock_lease_granted`. */
+        ret = create_dent_file_locks(/*dent=*/NULL, path, &dent_file_locks);
+        if (ret < 0)
+            goto out;
     }
 
+    assert(!dent_file_locks->lease.revoke_grants);
+    dent_file_locks->lease.revoke_grants = grants;
+    if (dent_file_locks->lease.grants == grants)
+        ret = file_lock_return_lease(dent_file_locks);
+out:
+    unlock(&g_fs_lock_lock);
+    return ret;
+}
+
+int file_lock_return_lease_from_ipc(const char* path, struct libos_file_lock* file_locks,
+                                    size_t locks_count, IDTYPE vmid) {
+    assert(!g_process_ipc_ids.leader_vmid);
+
+    int ret;
+    lock(&g_fs_lock_lock);
+    struct dent_file_locks* dent_file_locks = find_dent_file_locks_by_path(path);
+    if (!dent_file_locks || dent_file_locks->lease.vmid != vmid) {
+        /* The lease was dropped in the meantime (the holder cleared its locks before exiting). */
+        log_debug("file lock: ignoring returned lease on %s from process %u", path, vmid);
+        ret = 0;
+        goto out;
+    }
+
+    /* Preallocate the locks first, so that we don't fail after modifying something. */
+    struct libos_file_lock** new_locks = NULL;
+    if (locks_count > 0) {
+        new_locks = calloc(locks_count, sizeof(*new_locks));
+        if (!new_locks) {
+            ret = -ENOMEM;
+            goto out;
+        }
+    }
+    for (size_t i = 0; i < locks_count; i++) {
+        new_locks[i] = malloc(sizeof(*new_locks[i]));
+        if (!new_locks[i]) {
+            for (size_t j = 0; j < i; j++)
+                free(new_locks[j]);
+            free(new_locks);
+            ret = -ENOMEM;
+            goto out;
+        }
+    }
+
+    /* All POSIX locks on a leased file are stored in the holder. */
+    assert(!dent_file_locks->posix_locks.root);
+    for (size_t i = 0; i < locks_count; i++) {
+        assert(file_locks[i].pid == dent_file_locks->lease.pid);
+        new_locks[i]->family = FILE_LOCK_POSIX;
+        new_locks[i]->type = file_locks[i].type;
+        new_locks[i]->start = file_locks[i].start;
+        new_locks[i]->end = file_locks[i].end;
+        new_locks[i]->pid = file_locks[i].pid;
+        new_locks[i]->handle_id = 0; /* unused in POSIX (fcntl) locks, unset for sanity */
+        avl_tree_insert(&dent_file_locks->posix_locks, &new_locks[i]->tree_node);
+    }
+    free(new_locks);
+
+    memset(&dent_file_locks->lease, 0, sizeof(dent_file_locks->lease));
+    file_lock_process_requests(dent_file_locks);
+    dent_file_locks_gc(dent_file_locks);
+    ret = 0;
+out:
+    unlock(&g_fs_lock_lock);
+    return ret;
+}
+
+/* Removes all POSIX locks and lock requests (and a lease) for a given PID and file. */
+static void file_lock_clear_pid_from_dent_file_locks(struct dent_file_locks* dent_file_locks,
+                                                     IDTYPE pid) {
+    assert(locked(&g_fs_lock_lock));
+
     bool changed = false;
 
-    struct libos_file_lock* file_lock;
-    struct libos_file_lock* file_lock_tmp;
-    LISTP_FOR_EACH_ENTRY_SAFE(file_lock, file_lock_tmp, &dent_file_locks->file_locks, list) {
-        if (file_lock->family == FILE_LOCK_POSIX && file_lock->pid == pid) {
-            LISTP_DEL(file_lock, &dent_file_locks->file_locks, list);
+    struct avl_tree* tree = &dent_file_locks->posix_locks;
+    struct avl_tree_node* node = avl_tree_first(tree);
+    while (node) {
+        struct libos_file_lock* file_lock = node2lock(node);
+        node = avl_tree_next(node);
+        if (file_lock->pid == pid) {
+            avl_tree_delete(tree, &file_lock->tree_node);
             free(file_lock);
             changed = true;
         }
@@ -769,36 +1391,46 @@ static int file_lock_clear_pid_from_dentry(struct libos_dentry* dent, IDTYPE pid
         }
     }
 
-    if (changed) {
-        file_lock_process_requests(dent_file_locks);
-        dent_file_locks_gc(dent_file_locks);
+    if (dent_file_locks->lease.vmid && dent_file_locks->lease.pid == pid) {
+        /* Drop the lease together with the locks held under it. If the holder still returns the
+         * lease, it will be ignored. */
+        memset(&dent_file_locks->lease, 0, sizeof(dent_file_locks->lease));
+        changed = true;
     }
 
-    return 0;
+    if (changed)
+        file_lock_process_requests(dent_file_locks);
+    dent_file_locks_gc(dent_file_locks);
 }
 
 int file_lock_clear_pid(IDTYPE pid) {
+    struct dent_file_locks* dent_file_locks;
+    struct dent_file_locks* dent_file_locks_tmp;
+
     if (g_process_ipc_ids.leader_vmid) {
+        /* Forget our leases: the leader drops them together with our locks. */
+        lock(&g_fs_lock_lock);
+        HASH_ITER(hh, g_dent_file_locks_hash, dent_file_locks, dent_file_locks_tmp) {
+            struct avl_tree_node* node;
+            while ((node = avl_tree_first(&dent_file_locks->posix_locks))) {
+                avl_tree_delete(&dent_file_locks->posix_locks, node);
+                free(node2lock(node));
+            }
+            memset(&dent_file_locks->lease, 0, sizeof(dent_file_locks->lease));
+            dent_file_locks_gc(dent_file_locks);
+        }
+        unlock(&g_fs_lock_lock);
+
         return ipc_file_lock_clear_pid(pid);
     }
 
     log_debug("clearing file (POSIX) locks for pid %d", pid);
 
-    int ret;
-
-    struct dent_file_locks* dent_file_locks;
-    struct dent_file_locks* dent_file_locks_tmp;
-
     lock(&g_fs_lock_lock);
-    LISTP_FOR_EACH_ENTRY_SAFE(dent_file_locks, dent_file_locks_tmp, &g_dent_file_locks_list, list) {
+    HASH_ITER(hh, g_dent_file_locks_hash, dent_file_locks, dent_file_locks_tmp) {
         /* Note that the below call might end up deleting `dent_file_locks` */
-        ret = file_lock_clear_pid_from_dentry(dent_file_locks->dent, pid);
-        if (ret < 0)
-            goto out;
+        file_lock_clear_pid_from_dent_file_locks(dent_file_locks, pid);
     }
-
-    ret = 0;
-out:
     unlock(&g_fs_lock_lock);
-    return ret;
+    return 0;
 }
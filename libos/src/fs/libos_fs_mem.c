@@ -3,43 +3,207 @@
  *                    Paweł Marczewski <pawel@invisiblethingslab.com>
  */
 
+/*
+ * The file data is stored in fixed-size pages, indexed by a radix tree (similar to x86 page
+ * tables): a tree of height 0 is a single page (at offset 0), and each level above it is a node
+ * with `MEM_FILE_NODE_SLOTS` pointers to subtrees. Missing pages (and subtrees) are holes that read
+ * as zeros, so writes cost only the pages written to, and truncation frees the pages beyond the new
+ * size.
+ *
+ * Both pages and nodes are allocated with malloc() and freed as soon as they are not needed (e.g.
+ * on truncation), so memory of deleted or shrunk files is given back.
+ *
+ * Checkpoints of files contain only the pages which are present (see `mem_file_checkpoint()`).
+ */
+
 #include "api.h"
 #include "libos_fs.h"
 #include "libos_fs_mem.h"
+#include "libos_internal.h"
 
-/* Minimum allocation size in `slabmgr.h` */
-#define MIN_RESIZE ((size_t)16)
+#define MEM_FILE_PAGE_SIZE  4096
+#define MEM_FILE_NODE_SHIFT 9
+#define MEM_FILE_NODE_SLOTS (1UL << MEM_FILE_NODE_SHIFT)
+/* enough for any `file_off_t` offset: 2^63 bytes are 2^51 pages, a tree of height 6 has 2^54 */
+#define MEM_FILE_MAX_HEIGHT 6
 
-static int mem_file_resize(struct libos_mem_file* mem, size_t buf_size) {
-    assert(buf_size > 0);
+struct mem_file_page {
+    union {
+        char data[MEM_FILE_PAGE_SIZE];
+        void* slots[MEM_FILE_NODE_SLOTS];
+    };
+};
 
-    char* buf = malloc(buf_size);
-    if (!buf)
-        return -ENOMEM;
+static_assert(sizeof(struct mem_file_page) == MEM_FILE_PAGE_SIZE, "wrong size of mem file page");
+static_assert(MEM_FILE_NODE_SHIFT * MEM_FILE_MAX_HEIGHT + 12 > 63, "mem file tree is too low");
+
+/* checkpoint of a file, see `mem_file_checkpoint()` */
+struct mem_file_checkpoint {
+    file_off_t size;
+    size_t pages_cnt;
+    struct mem_file_checkpoint_page {
+        uint64_t idx;
+        char data[MEM_FILE_PAGE_SIZE];
+    } pages[];
+};
 
-    size_t min_size = MIN(buf_size, (size_t)mem->size);
-    memcpy(buf, mem->buf, min_size);
+static struct mem_file_page* alloc_page(void) {
+    return calloc(1, sizeof(struct mem_file_page));
+}
+
+static void free_page(struct mem_file_page* page) {
+    free(page);
+}
 
-    /* if the new buffer is larger, zero out the new portion */
-    if (buf_size > min_size)
-        memset(buf + min_size, 0, buf_size - min_size);
+/* Frees the subtree of height `height`, rooted at `node`. */
+static void free_tree(void* node, unsigned int height) {
+    if (!node)
+        return;
 
-    free(mem->buf);
-    mem->buf = buf;
-    mem->buf_size = buf_size;
-    return 0;
+    if (height > 0) {
+        struct mem_file_page* page = node;
+        for (size_t i = 0; i < MEM_FILE_NODE_SLOTS; i++)
+            free_tree(page->slots[i], height - 1);
+    }
+    free_page(node);
+}
+
+/*
+ * Frees all pages of the subtree of height `height` at `*node_ptr` (covering pages starting at
+ * `first_idx`) with indices greater or equal to `idx`. Frees the subtree root if it becomes empty.
+ */
+static void free_tree_from(void** node_ptr, unsigned int height, uint64_t first_idx,
+                           uint64_t idx) {
+    if (!*node_ptr)
+        return;
+
+    if (idx <= first_idx) {
+        free_tree(*node_ptr, height);
+        *node_ptr = NULL;
+        return;
+    }
+    if (height == 0)
+        return;
+
+    struct mem_file_page* node = *node_ptr;
+    uint64_t slot_pages = 1UL << (MEM_FILE_NODE_SHIFT * (height - 1));
+    bool empty = true;
+    for (size_t i = 0; i < MEM_FILE_NODE_SLOTS; i++) {
+        uint64_t slot_first_idx = first_idx + i * slot_pages;
+        if (idx < slot_first_idx + slot_pages)
+            free_tree_from(&node->slots[i], height - 1, slot_first_idx, idx);
+        if (node->slots[i])
+            empty = false;
+    }
+    if (empty) {
+        free_page(node);
+        *node_ptr = NULL;
+    }
+}
+
+static uint64_t tree_capacity(unsigned int height) {
+    return 1UL << (MEM_FILE_NODE_SHIFT * height);
+}
+
+/* Returns the page with index `idx`, or NULL if it is a hole. */
+static char* lookup_page(struct libos_mem_file* mem, uint64_t idx) {
+    if (idx >= tree_capacity(mem->height))
+        return NULL;
+
+    void* node = mem->root;
+    for (unsigned int height = mem->height; height > 0 && node; height--) {
+        size_t slot = (idx >> (MEM_FILE_NODE_SHIFT * (height - 1))) & (MEM_FILE_NODE_SLOTS - 1);
+        node = ((struct mem_file_page*)node)->slots[slot];
+    }
+    return node;
+}
+
+/* Returns the page with index `idx`, allocating it (and the tree nodes on the way) if needed. */
+static char* get_page(struct libos_mem_file* mem, uint64_t idx) {
+    while (idx >= tree_capacity(mem->height)) {
+        assert(mem->height < MEM_FILE_MAX_HEIGHT);
+        if (mem->root) {
+            struct mem_file_page* node = alloc_page();
+            if (!node)
+                return NULL;
+            node->slots[0] = mem->root;
+            mem->root = node;
+        }
+        mem->height++;
+    }
+
+    void** node_ptr = &mem->root;
+    for (unsigned int height = mem->height; ; height--) {
+        if (!*node_ptr) {
+            *node_ptr = alloc_page();
+            if (!*node_ptr)
+                return NULL;
+        }
+        if (height == 0)
+            break;
+        size_t slot = (idx >> (MEM_FILE_NODE_SHIFT * (height - 1))) & (MEM_FILE_NODE_SLOTS - 1);
+        node_ptr = &((struct mem_file_page*)*node_ptr)->slots[slot];
+    }
+    return *node_ptr;
+}
+
+/* Returns the number of pages in the subtree of height `height`, rooted at `node`. */
+static size_t count_pages(void* node, unsigned int height) {
+    if (!node)
+        return 0;
+    if (height == 0)
+        return 1;
+
+    struct mem_file_page* page = node;
+    size_t cnt = 0;
+    for (size_t i = 0; i < MEM_FILE_NODE_SLOTS; i++)
+        cnt += count_pages(page->slots[i], height - 1);
+    return cnt;
+}
+
+/* Copies the pages of the subtree of height `height` at `node` (covering pages starting at
+ * `first_idx`) to `*pos`, advancing it. */
+static void save_pages(void* node, unsigned int height, uint64_t first_idx,
+                       struct mem_file_checkpoint_page** pos) {
+    if (!node)
+        return;
+
+    if (height == 0) {
+        (*pos)->idx = first_idx;
+        memcpy((*pos)->data, node, MEM_FILE_PAGE_SIZE);
+        (*pos)++;
+        return;
+    }
+
+    struct mem_file_page* page = node;
+    uint64_t slot_pages = tree_capacity(height - 1);
+    for (size_t i = 0; i < MEM_FILE_NODE_SLOTS; i++)
+        save_pages(page->slots[i], height - 1, first_idx + i * slot_pages, pos);
 }
 
 void mem_file_init(struct libos_mem_file* mem, char* data, size_t size) {
     assert(!OVERFLOWS(file_off_t, size));
 
-    mem->buf = data;
-    mem->buf_size = size;
-    mem->size = size;
+    mem->root = NULL;
+    mem->height = 0;
+    mem->size = 0;
+
+    if (size > 0) {
+        /* there is no way to report failure, which happens only when out of memory (and then LibOS
+         * terminates anyway) */
+        ssize_t ret = mem_file_write(mem, /*pos_start=*/0, data, size);
+        if (ret < 0 || (size_t)ret != size) {
+            log_error("Out-of-memory when creating in-memory file");
+            BUG();
+        }
+    }
+    free(data);
 }
 
 void mem_file_destroy(struct libos_mem_file* mem) {
-    free(mem->buf);
+    free_tree(mem->root, mem->height);
+    mem->root = NULL;
+    mem->height = 0;
 }
 
 ssize_t mem_file_read(struct libos_mem_file* mem, file_off_t pos_start, void* buf, size_t size) {
@@ -50,8 +214,21 @@ ssize_t mem_file_read(struct libos_mem_file* mem, file_off_t pos_start, void* bu
         pos_end = mem->size;
 
     size = pos_end >= pos_start ? pos_end - pos_start : 0;
-    if (size > 0)
-        memcpy(buf, mem->buf + pos_start, size);
+
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = pos_start + done;
+        size_t page_off = pos % MEM_FILE_PAGE_SIZE;
+        size_t copy_size = MIN(size - done, MEM_FILE_PAGE_SIZE - page_off);
+
+        char* page = lookup_page(mem, pos / MEM_FILE_PAGE_SIZE);
+        if (page) {
+            memcpy((char*)buf + done, page + page_off, copy_size);
+        } else {
+            memset((char*)buf + done, 0, copy_size);
+        }
+        done += copy_size;
+    }
     return size;
 }
 
@@ -63,57 +240,82 @@ ssize_t mem_file_write(struct libos_mem_file* mem, file_off_t pos_start, const v
     if (__builtin_add_overflow(pos_start, size, &pos_end))
         return -EFBIG;
 
-    if (OVERFLOWS(size_t, pos_end))
-        return -EFBIG;
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = pos_start + done;
+        size_t page_off = pos % MEM_FILE_PAGE_SIZE;
+        size_t copy_size = MIN(size - done, MEM_FILE_PAGE_SIZE - page_off);
 
-    if (size > 0) {
-        if (mem->buf_size < (size_t)pos_end) {
-            size_t buf_size = MAX(mem->buf_size, MIN_RESIZE);
-            while (buf_size < (size_t)pos_end)
-                if (__builtin_mul_overflow(buf_size, 2, &buf_size))
-                    return -EFBIG;
-
-            int ret = mem_file_resize(mem, buf_size);
-            if (ret < 0)
-                return ret;
+        char* page = get_page(mem, pos / MEM_FILE_PAGE_SIZE);
+        if (!page) {
+            if (!done)
+                return -ENOMEM;
+            break;
         }
-        assert((size_t)pos_end <= mem->buf_size);
-        if (pos_end > mem->size)
-            mem->size = pos_end;
-        memcpy(mem->buf + pos_start, buf, size);
+        memcpy(page + page_off, (const char*)buf + done, copy_size);
+        done += copy_size;
     }
 
-    return size;
+    if (done > 0 && pos_start + (file_off_t)done > mem->size)
+        mem->size = pos_start + done;
+    return done;
 }
 
 int mem_file_truncate(struct libos_mem_file* mem, file_off_t size) {
     assert(size >= 0);
 
-    if (OVERFLOWS(size_t, size))
-        return -EFBIG;
+    if (size < mem->size) {
+        uint64_t first_free_idx = UDIV_ROUND_UP((uint64_t)size, MEM_FILE_PAGE_SIZE);
+        free_tree_from(&mem->root, mem->height, /*first_idx=*/0, first_free_idx);
+        if (!mem->root)
+            mem->height = 0;
 
-    size_t buf_size = mem->buf_size;
-    if (buf_size < (size_t)size) {
-        buf_size = MAX(buf_size, MIN_RESIZE);
-        while (buf_size < (size_t)size) {
-            if (__builtin_mul_overflow(buf_size, 2, &buf_size))
-                return -EFBIG;
+        /* the rest of the last page must read as zeros if the file is extended later */
+        size_t page_off = size % MEM_FILE_PAGE_SIZE;
+        if (page_off) {
+            char* page = lookup_page(mem, size / MEM_FILE_PAGE_SIZE);
+            if (page)
+                memset(page + page_off, 0, MEM_FILE_PAGE_SIZE - page_off);
         }
-    } else if (size > 0) {
-        while (buf_size / 2 >= (size_t)size)
-            buf_size /= 2;
-        buf_size = MAX(buf_size, MIN_RESIZE);
-    } else {
-        buf_size = MIN_RESIZE;
     }
+    /* extending the file only creates a hole at the end */
+    mem->size = size;
+    return 0;
+}
+
+int mem_file_checkpoint(struct libos_mem_file* mem, void** out_data, size_t* out_size) {
+    size_t pages_cnt = count_pages(mem->root, mem->height);
+
+    struct mem_file_checkpoint* cp;
+    size_t cp_size = sizeof(*cp) + pages_cnt * sizeof(cp->pages[0]);
+    cp = malloc(cp_size);
+    if (!cp)
+        return -ENOMEM;
+
+    cp->size = mem->size;
+    cp->pages_cnt = pages_cnt;
+    struct mem_file_checkpoint_page* pos = cp->pages;
+    save_pages(mem->root, mem->height, /*first_idx=*/0, &pos);
+    assert(pos == cp->pages + pages_cnt);
+
+    *out_data = cp;
+    *out_size = cp_size;
+    return 0;
+}
+
+int mem_file_restore(struct libos_mem_file* mem, const void* data) {
+    const struct mem_file_checkpoint* cp = data;
 
-    assert((size_t)size <= buf_size);
-    if (buf_size != mem->buf_size) {
-        int ret = mem_file_resize(mem, buf_size);
-        if (ret < 0)
-            return ret;
+    mem_file_init(mem, /*data=*/NULL, /*size=*/0);
+    for (size_t i = 0; i < cp->pages_cnt; i++) {
+        char* page = get_page(mem, cp->pages[i].idx);
+        if (!page) {
+            mem_file_destroy(mem);
+            return -ENOMEM;
+        }
+        memcpy(page, cp->pages[i].data, MEM_FILE_PAGE_SIZE);
     }
-    mem->size = size;
+    mem->size = cp->size;
     return 0;
 }
 
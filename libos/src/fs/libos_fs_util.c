@@ -9,6 +9,11 @@
 #include "libos_lock.h"
 #include "libos_vma.h"
 #include "stat.h"
+#include "toml_utils.h"
+
+/* whether file mappings are populated on first access instead of read in full on `mmap`, see
+ * `fs.experimental__enable_lazy_mmap` */
+static bool g_lazy_mmap_enabled = false;
 
 int generic_seek(file_off_t pos, file_off_t size, file_off_t offset, int origin,
                  file_off_t* out_pos) {
@@ -57,7 +62,7 @@ int generic_readdir(struct libos_dentry* dent, readdir_callback_t callback, void
     return 0;
 }
 
-static int generic_istat(struct libos_inode* inode, struct stat* buf) {
+int generic_istat(struct libos_inode* inode, struct stat* buf) {
     memset(buf, 0, sizeof(*buf));
 
     lock(&inode->lock);
@@ -136,6 +141,67 @@ int generic_inode_poll(struct libos_handle* hdl, int in_events, int* out_events)
     return ret;
 }
 
+int init_emulated_mmap(void) {
+    bool enabled;
+    int ret = toml_bool_in(g_manifest_root, "fs.experimental__enable_lazy_mmap",
+                           /*defaultval=*/false, &enabled);
+    if (ret < 0) {
+        log_error("Cannot parse 'fs.experimental__enable_lazy_mmap' (the value must be `true` or "
+                  "`false`)");
+        return -EINVAL;
+    }
+    if (!enabled)
+        return 0;
+
+    if (!g_pal_public_state->memory_protection_enforced) {
+        log_warning("fs.experimental__enable_lazy_mmap is ignored because memory protections are "
+                    "not enforced on this platform (e.g. SGX without EDMM)");
+        return 0;
+    }
+
+    bool check_invalid_ptrs;
+    ret = toml_bool_in(g_manifest_root, "libos.check_invalid_pointers", /*defaultval=*/true,
+                       &check_invalid_ptrs);
+    if (ret < 0)
+        return -EINVAL;
+    if (!check_invalid_ptrs) {
+        /* syscall buffers in lazily mapped memory are populated when checking the pointers */
+        log_warning("fs.experimental__enable_lazy_mmap is ignored because "
+                    "libos.check_invalid_pointers is disabled");
+        return 0;
+    }
+
+    g_lazy_mmap_enabled = true;
+    return 0;
+}
+
+/* Allocates inaccessible memory for the mapping, pages are read from the file on first access (see
+ * `bkeep_vma_set_lazy()`). */
+static int lazy_emulated_mmap(struct libos_handle* hdl, void* addr, size_t size, uint64_t offset,
+                              size_t* out_valid_size) {
+    int ret = PalVirtualMemoryAlloc(addr, size, /*prot=*/0);
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+
+    ret = bkeep_vma_set_lazy(addr, size);
+    if (ret < 0) {
+        int free_ret = PalVirtualMemoryFree(addr, size);
+        if (free_ret < 0) {
+            log_debug("PalVirtualMemoryFree failed on cleanup: %s", pal_strerror(free_ret));
+            BUG();
+        }
+        return ret;
+    }
+
+    lock(&hdl->inode->lock);
+    file_off_t file_size = hdl->inode->size;
+    unlock(&hdl->inode->lock);
+
+    size_t valid_size = offset > (uint64_t)file_size ? 0 : MIN(size, (uint64_t)file_size - offset);
+    *out_valid_size = ALLOC_ALIGN_UP(valid_size);
+    return 0;
+}
+
 int generic_emulated_mmap(struct libos_handle* hdl, void* addr, size_t size, int prot, int flags,
                           uint64_t offset, size_t* out_valid_size) {
     assert(addr && IS_ALLOC_ALIGNED_PTR(addr));
@@ -143,6 +209,10 @@ int generic_emulated_mmap(struct libos_handle* hdl, void* addr, size_t size, int
 
     int ret;
 
+    /* MAP_POPULATE asks for reading the whole mapping right away, also used by the ELF loader */
+    if (g_lazy_mmap_enabled && !(flags & MAP_POPULATE))
+        return lazy_emulated_mmap(hdl, addr, size, offset, out_valid_size);
+
     pal_prot_flags_t pal_prot = LINUX_PROT_TO_PAL(prot, flags);
     pal_prot_flags_t pal_prot_writable = pal_prot | PAL_PROT_WRITE;
 
@@ -205,24 +275,13 @@ err:;
     return ret;
 }
 
-int generic_emulated_msync(struct libos_handle* hdl, void* addr, size_t size, int prot, int flags,
-                           uint64_t offset) {
-    assert(!(flags & MAP_PRIVATE));
-
+/* Writes back `size` bytes of mapping memory at `addr` to the file at `offset`, not beyond the end
+ * of file. */
+static int write_back_mapping(struct libos_handle* hdl, void* addr, size_t size, uint64_t offset) {
     lock(&hdl->inode->lock);
     file_off_t file_size = hdl->inode->size;
     unlock(&hdl->inode->lock);
 
-    pal_prot_flags_t pal_prot = LINUX_PROT_TO_PAL(prot, flags);
-    pal_prot_flags_t pal_prot_readable = pal_prot | PAL_PROT_READ;
-
-    int ret;
-    if (pal_prot != pal_prot_readable) {
-        ret = PalVirtualMemoryProtect(addr, size, pal_prot_readable);
-        if (ret < 0)
-            return pal_to_unix_errno(ret);
-    }
-
     size_t write_size = offset > (uint64_t)file_size ? 0 : MIN(size, (uint64_t)file_size - offset);
     char* write_addr = addr;
     file_off_t pos = offset;
@@ -231,24 +290,54 @@ int generic_emulated_msync(struct libos_handle* hdl, void* addr, size_t size, in
         if (count < 0) {
             if (count == -EINTR)
                 continue;
-            ret = count;
-            goto out;
+            return count;
         }
 
         if (count == 0) {
             log_debug("Failed to write back the whole mapping");
-            ret = -EIO;
-            goto out;
+            return -EIO;
         }
 
         assert((size_t)count <= write_size);
         write_size -= count;
         write_addr += count;
     }
+    return 0;
+}
+
+struct lazy_msync_args {
+    struct libos_handle* hdl;
+    void* addr;
+    uint64_t offset;
+};
+
+static int lazy_msync_write_back(void* addr, size_t size, void* _args) {
+    struct lazy_msync_args* args = _args;
+    return write_back_mapping(args->hdl, addr, size,
+                              args->offset + ((uintptr_t)addr - (uintptr_t)args->addr));
+}
+
+int generic_emulated_msync(struct libos_handle* hdl, void* addr, size_t size, int prot, int flags,
+                           uint64_t offset) {
+    assert(!(flags & MAP_PRIVATE));
+
+    /* only the pages written to since the last `msync` are written back in lazy mappings */
+    struct lazy_msync_args args = { .hdl = hdl, .addr = addr, .offset = offset };
+    int ret = msync_lazy_pages(addr, size, lazy_msync_write_back, &args);
+    if (ret != -ENOENT)
+        return ret;
+
+    pal_prot_flags_t pal_prot = LINUX_PROT_TO_PAL(prot, flags);
+    pal_prot_flags_t pal_prot_readable = pal_prot | PAL_PROT_READ;
+
+    if (pal_prot != pal_prot_readable) {
+        ret = PalVirtualMemoryProtect(addr, size, pal_prot_readable);
+        if (ret < 0)
+            return pal_to_unix_errno(ret);
+    }
 
-    ret = 0;
+    ret = write_back_mapping(hdl, addr, size, offset);
 
-out:
     if (pal_prot != pal_prot_readable) {
         int protect_ret = PalVirtualMemoryProtect(addr, size, pal_prot);
         if (protect_ret < 0) {
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * This file contains code for allocating inodes.
+ *
+ * Inodes are allocated from a dedicated memory manager, which never returns memory to the system,
+ * and reuses freed objects only as other inodes. This makes it safe for lockless lookups in the
+ * dentry cache (see `path_lookupat_cached`) to read an inode that might have been concurrently
+ * freed, and to take a reference to it with `refcount_inc_not_zero`.
+ */
+
+#include "libos_fs.h"
+#include "libos_internal.h"
+#include "libos_lock.h"
+#include "libos_thread.h"
+
+static struct libos_lock inode_mgr_lock;
+
+#define SYSTEM_LOCK()   lock(&inode_mgr_lock)
+#define SYSTEM_UNLOCK() unlock(&inode_mgr_lock)
+#define SYSTEM_LOCKED() locked(&inode_mgr_lock)
+
+#define INODE_MGR_ALLOC 64
+
+#define OBJ_TYPE struct libos_inode
+#include "memmgr.h"
+
+static MEM_MGR inode_mgr = NULL;
+
+int init_inodes(void) {
+    if (!create_lock(&inode_mgr_lock))
+        return -ENOMEM;
+
+    inode_mgr = create_mem_mgr(init_align_up(INODE_MGR_ALLOC));
+    if (!inode_mgr) {
+        destroy_lock(&inode_mgr_lock);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+struct libos_inode* get_new_inode(struct libos_mount* mount, mode_t type, mode_t perm) {
+    assert(mount);
+
+    struct libos_inode* inode =
+        get_mem_obj_from_mgr_enlarge(inode_mgr, size_align_up(INODE_MGR_ALLOC));
+    if (!inode)
+        return NULL;
+
+    memset(inode, 0, sizeof(*inode));
+
+    if (!create_lock(&inode->lock)) {
+        free_mem_obj_to_mgr(inode_mgr, inode);
+        return NULL;
+    }
+
+    inode->type = type;
+    inode->perm = perm;
+    inode->size = 0;
+    inode->ctime = 0;
+    inode->mtime = 0;
+    inode->atime = 0;
+
+    struct libos_thread* current = get_cur_thread();
+    lock(&current->lock);
+    inode->uid = current->euid;
+    inode->gid = current->egid;
+    unlock(&current->lock);
+
+    inode->mount = mount;
+    get_mount(mount);
+    inode->fs = mount->fs;
+
+    inode->data = NULL;
+
+    refcount_set(&inode->ref_count, 1);
+    return inode;
+}
+
+void get_inode(struct libos_inode* inode) {
+    refcount_inc(&inode->ref_count);
+}
+
+void put_inode(struct libos_inode* inode) {
+    if (refcount_dec(&inode->ref_count) == 0) {
+        if (inode->fs->d_ops && inode->fs->d_ops->idrop) {
+            lock(&inode->lock);
+            inode->fs->d_ops->idrop(inode);
+            unlock(&inode->lock);
+        }
+
+        put_mount(inode->mount);
+
+        destroy_lock(&inode->lock);
+        free_mem_obj_to_mgr(inode_mgr, inode);
+    }
+}
@@ -11,6 +11,7 @@
 #include "libos_handle.h"
 #include "libos_lock.h"
 #include "libos_process.h"
+#include "libos_uthash.h"
 #include "linux_abi/fs.h"
 #include "perm.h"
 #include "stat.h"
@@ -258,20 +259,9 @@ static int lookup_advance(struct lookup* lookup) {
     return 0;
 }
 
-/*
- * This implementation is mostly iterative, but uses recursion to follow symlinks (which is why the
- * link depth is limited to MAX_LINK_DEPTH).
- */
-static int do_path_lookupat(struct libos_dentry* start, const char* path, int flags,
-                            struct libos_dentry** found, unsigned int link_depth) {
-    assert(locked(&g_dcache_lock));
-
-    struct libos_dentry* dent = NULL;
-    int ret = 0;
-
-    /* Empty path is invalid in POSIX */
-    if (*path == '\0')
-        return -ENOENT;
+/* Returns the dentry that the lookup of `path` starts from, with its reference count increased. */
+static struct libos_dentry* get_start_dentry(struct libos_dentry* start, const char* path) {
+    struct libos_dentry* dent;
 
     if (*path == '/') {
         /* Absolute path, use process root even if `start` was provided (can happen for *at() system
@@ -293,6 +283,24 @@ static int do_path_lookupat(struct libos_dentry* start, const char* path, int fl
         dent = start;
         get_dentry(dent);
     }
+    return dent;
+}
+
+/*
+ * This implementation is mostly iterative, but uses recursion to follow symlinks (which is why the
+ * link depth is limited to MAX_LINK_DEPTH).
+ */
+static int do_path_lookupat(struct libos_dentry* start, const char* path, int flags,
+                            struct libos_dentry** found, unsigned int link_depth) {
+    assert(locked(&g_dcache_lock));
+
+    int ret = 0;
+
+    /* Empty path is invalid in POSIX */
+    if (*path == '\0')
+        return -ENOENT;
+
+    struct libos_dentry* dent = get_start_dentry(start, path);
 
     size_t path_len = strlen(path);
     bool has_slash = (path_len > 0 && path[path_len - 1] == '/');
@@ -338,6 +346,149 @@ int path_lookupat(struct libos_dentry* start, const char* path, int flags,
     return do_path_lookupat(start, path, flags, found, /*link_depth=*/0);
 }
 
+/*
+ * The functions below implement `path_lookupat_cached`. They can read dentries, inodes and mounts
+ * that are concurrently modified or freed (see `g_dcache_seqlock`), so they validate the sequence
+ * number before following any pointer they read, and give up (return false or -EAGAIN) if the
+ * dentry cache was modified. This is safe because none of these objects is ever unmapped.
+ */
+
+/* Lockless version of the `..` handling in `lookup_advance`. */
+__attribute_no_sanitize_address
+static bool dentry_up_lockless(struct libos_dentry** dent, uint32_t seq) {
+    struct libos_dentry* cur = *dent;
+    while (true) {
+        struct libos_dentry* parent = __atomic_load_n(&cur->parent, __ATOMIC_RELAXED);
+        struct libos_mount* mount = __atomic_load_n(&cur->mount, __ATOMIC_RELAXED);
+        if (read_seqretry(&g_dcache_seqlock, seq))
+            return false;
+
+        if (parent) {
+            *dent = parent;
+            return true;
+        }
+        if (!mount) {
+            /* `cur` is `g_dentry_root`, the lookup stays at `*dent` */
+            return true;
+        }
+
+        cur = __atomic_load_n(&mount->mount_point, __ATOMIC_RELAXED);
+        if (read_seqretry(&g_dcache_seqlock, seq))
+            return false;
+    }
+}
+
+/* Lockless version of `do_path_lookupat`, without symlink traversal and without lookups in the
+ * underlying filesystem. On success, the reference counts of `*found` and `*found_inode` are
+ * increased. */
+__attribute_no_sanitize_address
+static int do_path_lookupat_cached(struct libos_dentry* dent, const char* path, int flags,
+                                   uint32_t seq, struct libos_dentry** found,
+                                   struct libos_inode** found_inode) {
+    size_t path_len = strlen(path);
+    bool has_slash = (path_len > 0 && path[path_len - 1] == '/');
+
+    const char* name = path;
+    while (*name == '/')
+        name++;
+
+    struct libos_inode* inode;
+    while (true) {
+        /* Same as `lookup_enter_dentry`, but give up instead of following a symlink, or failing */
+        while (true) {
+            struct libos_mount* mount = __atomic_load_n(&dent->attached_mount, __ATOMIC_ACQUIRE);
+            if (read_seqretry(&g_dcache_seqlock, seq))
+                return -EAGAIN;
+            if (!mount)
+                break;
+
+            dent = __atomic_load_n(&mount->root, __ATOMIC_ACQUIRE);
+            if (read_seqretry(&g_dcache_seqlock, seq) || !dent)
+                return -EAGAIN;
+        }
+
+        inode = __atomic_load_n(&dent->inode, __ATOMIC_ACQUIRE);
+        if (read_seqretry(&g_dcache_seqlock, seq) || !inode)
+            return -EAGAIN;
+        mode_t type = __atomic_load_n(&inode->type, __ATOMIC_RELAXED);
+        if (read_seqretry(&g_dcache_seqlock, seq))
+            return -EAGAIN;
+
+        bool is_final = (*name == '\0');
+        if (type == S_IFLNK && (!is_final || has_slash || (flags & LOOKUP_FOLLOW)))
+            return -EAGAIN;
+        if (type != S_IFDIR && (!is_final || has_slash || (flags & LOOKUP_DIRECTORY)))
+            return -EAGAIN;
+
+        if (is_final)
+            break;
+
+        /* Same as `lookup_advance`, but give up if the next dentry is not in the cache */
+        const char* name_end = name;
+        while (*name_end != '\0' && *name_end != '/')
+            name_end++;
+        size_t name_len = name_end - name;
+
+        if (name_len > NAME_MAX)
+            return -EAGAIN;
+
+        if (name_len == 1 && name[0] == '.') {
+            /* stay at `dent` */
+        } else if (name_len == 2 && name[0] == '.' && name[1] == '.') {
+            if (!dentry_up_lockless(&dent, seq))
+                return -EAGAIN;
+        } else {
+            dent = lookup_dcache_lockless(dent, name, name_len, seq);
+            if (!dent)
+                return -EAGAIN;
+        }
+
+        name = name_end;
+        while (*name == '/')
+            name++;
+    }
+
+    /* The dentry and inode might have been freed after the last check, in which case their
+     * reference counts are 0 (and we cannot use them). Otherwise, we take the references, and then
+     * check that nothing changed in the meantime. */
+    if (!refcount_inc_not_zero(&dent->ref_count))
+        return -EAGAIN;
+    if (!refcount_inc_not_zero(&inode->ref_count)) {
+        put_dentry(dent);
+        return -EAGAIN;
+    }
+    if (read_seqretry(&g_dcache_seqlock, seq)) {
+        put_inode(inode);
+        put_dentry(dent);
+        return -EAGAIN;
+    }
+
+    *found = dent;
+    *found_inode = inode;
+    return 0;
+}
+
+int path_lookupat_cached(struct libos_dentry* start, const char* path, int flags,
+                         struct libos_dentry** found, struct libos_inode** found_inode) {
+    *found = NULL;
+    *found_inode = NULL;
+
+    if (flags & ~(LOOKUP_FOLLOW | LOOKUP_DIRECTORY))
+        return -EAGAIN;
+
+    /* Empty path is invalid, let `path_lookupat` report the error */
+    if (*path == '\0')
+        return -EAGAIN;
+
+    struct libos_dentry* dent = get_start_dentry(start, path);
+
+    uint32_t seq = read_seqbegin(&g_dcache_seqlock);
+    int ret = do_path_lookupat_cached(dent, path, flags, seq, found, found_inode);
+
+    put_dentry(dent);
+    return ret;
+}
+
 static inline int open_flags_to_lookup_flags(int flags) {
     int retval = LOOKUP_FOLLOW;
 
@@ -556,6 +707,7 @@ DEFINE_LIST(temp_dirent);
 DEFINE_LISTP(temp_dirent);
 struct temp_dirent {
     LIST_TYPE(temp_dirent) list;
+    UT_hash_handle hh;
 
     size_t name_len;
     char name[];
@@ -598,29 +750,30 @@ static int populate_directory(struct libos_dentry* dent) {
     if (ret < 0)
         log_error("readdir error: %s", unix_strerror(ret));
 
+    /* index the names, so that checking all children below takes linear time */
+    struct temp_dirent* ents_by_name = NULL;
+    struct temp_dirent* ent;
+    LISTP_FOR_EACH_ENTRY(ent, &ents, list) {
+        HASH_ADD_KEYPTR(hh, ents_by_name, ent->name, ent->name_len, ent);
+    }
+
     struct libos_dentry* child;
     LISTP_FOR_EACH_ENTRY(child, &dent->children, siblings) {
         struct libos_inode* inode = child->inode;
         /* Check `inode->fs` so that we don't remove files added by Gramine (named pipes, sockets,
          * synthetic mountpoints) */
         if (inode && inode->fs == inode->mount->fs) {
-            struct temp_dirent* ent;
-            bool removed = true;
-            LISTP_FOR_EACH_ENTRY(ent, &ents, list) {
-                if (strcmp(ent->name, child->name) == 0) {
-                    removed = false;
-                    break;
-                }
-            }
-            if (removed) {
+            HASH_FIND(hh, ents_by_name, child->name, child->name_len, ent);
+            if (!ent) {
                 log_debug("File no longer present, detaching inode: %s", child->name);
+                write_seqbegin(&g_dcache_seqlock);
                 child->inode = NULL;
+                write_seqend(&g_dcache_seqlock);
                 put_inode(inode);
             }
         }
     }
 
-    struct temp_dirent* ent;
     struct temp_dirent* tmp;
 
     LISTP_FOR_EACH_ENTRY(ent, &ents, list) {
@@ -643,6 +796,7 @@ static int populate_directory(struct libos_dentry* dent) {
 
     ret = 0;
 out:
+    HASH_CLEAR(hh, ents_by_name);
     LISTP_FOR_EACH_ENTRY_SAFE(ent, tmp, &ents, list) {
         LISTP_DEL(ent, &ents, list);
         free(ent);
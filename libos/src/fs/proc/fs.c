@@ -77,6 +77,18 @@ int init_procfs(void) {
     pseudo_add_str(root, "cpuinfo", &proc_cpuinfo_load);
     pseudo_add_str(root, "stat", &proc_stat_load);
 
+    /* Gramine-specific statistics, useful for performance analysis; host call and memory reclaim
+     * statistics are collected only by some PALs */
+    struct pseudo_node* gramine = pseudo_add_dir(root, "gramine");
+    pseudo_add_str(gramine, "trusted_files_cache", &proc_gramine_trusted_files_cache_load);
+    pseudo_add_str(gramine, "malloc", &proc_gramine_malloc_load);
+    size_t host_call_stats_cnt = 0;
+    if (PalHostCallStatsQuery(/*stats=*/NULL, &host_call_stats_cnt) != PAL_ERROR_NOTIMPLEMENTED)
+        pseudo_add_str(gramine, "ocalls", &proc_gramine_ocalls_load);
+    struct pal_memory_reclaim_stats reclaim_stats;
+    if (PalVirtualMemoryReclaimStatsQuery(&reclaim_stats) != PAL_ERROR_NOTIMPLEMENTED)
+        pseudo_add_str(gramine, "memory_reclaim", &proc_gramine_memory_reclaim_load);
+
     pseudo_add_link(root, "self", &proc_self_follow_link);
 
     struct pseudo_node* thread_pid = pseudo_add_dir(root, /*name=*/NULL);
@@ -4,9 +4,11 @@
 /*!
  * \file
  *
- * This file contains the implementation of `/proc/meminfo` and `/proc/cpuinfo`.
+ * This file contains the implementation of `/proc/meminfo`, `/proc/cpuinfo`, `/proc/stat`,
+ * `/proc/gramine/ocalls`, `/proc/gramine/trusted_files_cache` and `/proc/gramine/malloc`.
  */
 
+#include "libos_fs.h"
 #include "libos_fs_proc.h"
 #include "libos_fs_pseudo.h"
 #include "libos_vma.h"
@@ -223,4 +225,150 @@ int proc_stat_load(struct libos_dentry* dent, char** out_data, size_t* out_size)
     return 0;
 }
 
+int proc_gramine_ocalls_load(struct libos_dentry* dent, char** out_data, size_t* out_size) {
+    __UNUSED(dent);
+
+    /* first query the number of host call types */
+    size_t stats_cnt = 0;
+    int ret = PalHostCallStatsQuery(/*stats=*/NULL, &stats_cnt);
+    if (ret != PAL_ERROR_INVAL)
+        return ret < 0 ? pal_to_unix_errno(ret) : -EINVAL;
+
+    struct pal_host_call_stats* stats = malloc(stats_cnt * sizeof(*stats));
+    if (!stats)
+        return -ENOMEM;
+
+    size_t size = 0;
+    size_t max = 128;
+    char* str = malloc(max);
+    if (!str) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    ret = PalHostCallStatsQuery(stats, &stats_cnt);
+    if (ret < 0) {
+        ret = pal_to_unix_errno(ret);
+        goto out;
+    }
+
+    ret = print_to_str(&str, size, &max, "%-28s %12s %12s %16s %12s %16s\n", "name", "calls",
+                       "exitless", "cycles", "max_cycles", "bytes");
+    if (ret < 0)
+        goto out;
+    size += ret;
+
+    for (size_t i = 0; i < stats_cnt; i++) {
+        /* skip host calls which were never used, to keep the output short */
+        if (!stats[i].calls)
+            continue;
+        ret = print_to_str(&str, size, &max, "%-28s %12lu %12lu %16lu %12lu %16lu\n",
+                           stats[i].name, stats[i].calls, stats[i].exitless_calls,
+                           stats[i].cycles, stats[i].max_cycles, stats[i].bytes);
+        if (ret < 0)
+            goto out;
+        size += ret;
+    }
+
+    *out_data = str;
+    *out_size = size;
+    str = NULL;
+    ret = 0;
+out:
+    free(str);
+    free(stats);
+    return ret;
+}
+
+int proc_gramine_trusted_files_cache_load(struct libos_dentry* dent, char** out_data,
+                                          size_t* out_size) {
+    __UNUSED(dent);
+
+    struct trusted_files_cache_stats stats;
+    get_trusted_files_cache_stats(&stats);
+
+    size_t size = 0;
+    size_t max = 128;
+    char* str = malloc(max);
+    if (!str)
+        return -ENOMEM;
+
+    int ret = print_to_str(&str, size, &max,
+                           "size: %lu\nmax_size: %lu\nhits: %lu\nmisses: %lu\nevictions: %lu\n",
+                           stats.size, stats.max_size, stats.hits, stats.misses, stats.evictions);
+    if (ret < 0) {
+        free(str);
+        return ret;
+    }
+    size += ret;
+
+    *out_data = str;
+    *out_size = size;
+    return 0;
+}
+
+int proc_gramine_memory_reclaim_load(struct libos_dentry* dent, char** out_data,
+                                     size_t* out_size) {
+    __UNUSED(dent);
+
+    struct pal_memory_reclaim_stats stats;
+    int ret = PalVirtualMemoryReclaimStatsQuery(&stats);
+    if (ret < 0)
+        return pal_to_unix_errno(ret);
+
+    size_t size = 0;
+    size_t max = 128;
+    char* str = malloc(max);
+    if (!str)
+        return -ENOMEM;
+
+    ret = print_to_str(&str, size, &max,
+                       "reclaimable: %lu kB\nrecycled: %lu kB\nreclaimed: %lu kB\n",
+                       stats.reclaimable / 1024, stats.recycled / 1024, stats.reclaimed / 1024);
+    if (ret < 0) {
+        free(str);
+        return ret;
+    }
+    size += ret;
+
+    *out_data = str;
+    *out_size = size;
+    return 0;
+}
+
+int proc_gramine_malloc_load(struct libos_dentry* dent, char** out_data, size_t* out_size) {
+    __UNUSED(dent);
+
+    struct malloc_stats stats[MALLOC_STATS_MAX_CNT];
+    size_t stats_cnt = get_malloc_stats(stats, ARRAY_SIZE(stats));
+
+    size_t size = 0;
+    size_t max = 128;
+    char* str = malloc(max);
+    if (!str)
+        return -ENOMEM;
+
+    int ret = print_to_str(&str, size, &max, "%8s %16s %16s %12s %12s\n", "obj_size", "allocs",
+                           "frees", "refills", "flushes");
+    if (ret < 0)
+        goto out;
+    size += ret;
+
+    for (size_t i = 0; i < stats_cnt; i++) {
+        ret = print_to_str(&str, size, &max, "%8lu %16lu %16lu %12lu %12lu\n", stats[i].obj_size,
+                           stats[i].allocs, stats[i].frees, stats[i].refills, stats[i].flushes);
+        if (ret < 0)
+            goto out;
+        size += ret;
+    }
+
+    *out_data = str;
+    *out_size = size;
+    str = NULL;
+    ret = 0;
+out:
+    free(str);
+    return ret;
+}
+
 #undef ADD_INFO
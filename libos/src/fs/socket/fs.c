@@ -66,6 +66,12 @@ static ssize_t writev(struct libos_handle* handle, struct iovec* iov, size_t iov
                       /*addr=*/NULL, /*addrlen=*/0, /*flags=*/0);
 }
 
+static ssize_t write_from_host(struct libos_handle* handle, PAL_HANDLE src, file_off_t src_offset,
+                               size_t count, file_off_t* pos) {
+    __UNUSED(pos);
+    return do_sendfile(handle, src, src_offset, count);
+}
+
 static int hstat(struct libos_handle* handle, struct stat* stat) {
     __UNUSED(handle);
     assert(stat);
@@ -239,6 +245,7 @@ static struct libos_fs_ops socket_fs_ops = {
     .write    = write,
     .readv    = readv,
     .writev   = writev,
+    .write_from_host = write_from_host,
     .hstat    = hstat,
     .setflags = setflags,
     .ioctl    = ioctl,
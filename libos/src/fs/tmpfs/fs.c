@@ -63,44 +63,22 @@ static void tmpfs_idrop(struct libos_inode* inode) {
     }
 }
 
-struct tmpfs_checkpoint {
-    size_t size;
-    char data[];
-};
-
 static int tmpfs_icheckpoint(struct libos_inode* inode, void** out_data, size_t* out_size) {
     assert(locked(&inode->lock));
 
-    struct libos_mem_file* mem = inode->data;
-    assert(mem->size >= 0);
-
-    struct tmpfs_checkpoint* cp;
-    size_t cp_size = sizeof(*cp) + mem->size;
-    cp = malloc(cp_size);
-    if (!cp)
-        return -ENOMEM;
-    cp->size = mem->size;
-    memcpy(cp->data, mem->buf, mem->size);
-
-    *out_data = cp;
-    *out_size = cp_size;
-    return 0;
+    return mem_file_checkpoint(inode->data, out_data, out_size);
 }
 
 static int tmpfs_irestore(struct libos_inode* inode, void* data) {
-    struct tmpfs_checkpoint* cp = data;
-
     struct libos_mem_file* mem = malloc(sizeof(*mem));
     if (!mem)
         return -ENOMEM;
-    mem->buf = malloc(cp->size);
-    if (!mem->buf) {
+
+    int ret = mem_file_restore(mem, data);
+    if (ret < 0) {
         free(mem);
-        return -ENOMEM;
+        return ret;
     }
-    memcpy(mem->buf, cp->data, cp->size);
-    mem->size = cp->size;
-    mem->buf_size = cp->size;
 
     inode->data = mem;
     return 0;
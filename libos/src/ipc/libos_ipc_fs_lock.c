@@ -10,7 +10,8 @@
 #include "libos_fs_lock.h"
 #include "libos_ipc.h"
 
-int ipc_file_lock_set(const char* path, struct libos_file_lock* file_lock, bool wait) {
+int ipc_file_lock_set(const char* path, struct libos_file_lock* file_lock, bool wait,
+                      bool* out_lease) {
     assert(file_lock->family == FILE_LOCK_POSIX || file_lock->family == FILE_LOCK_FLOCK);
     assert(file_lock->family == FILE_LOCK_POSIX ? file_lock->pid : file_lock->handle_id);
     assert(g_process_ipc_ids.leader_vmid);
@@ -41,18 +42,25 @@ int ipc_file_lock_set(const char* path, struct libos_file_lock* file_lock, bool
     int ret = ipc_send_msg_and_get_response(g_process_ipc_ids.leader_vmid, msg, &data);
     if (ret < 0)
         return ret;
-    int result = *(int*)data;
+    struct libos_ipc_file_lock_set_resp* resp = data;
+    int result = resp->result;
+    *out_lease = resp->lease;
     free(data);
     return result;
 }
 
-int ipc_file_lock_set_send_response(IDTYPE vmid, unsigned long seq, int result) {
+int ipc_file_lock_set_send_response(IDTYPE vmid, unsigned long seq, int result, bool lease) {
     assert(!g_process_ipc_ids.leader_vmid);
 
-    size_t total_msg_size = get_ipc_msg_size(sizeof(result));
+    struct libos_ipc_file_lock_set_resp msgout = {
+        .result = result,
+        .lease = lease,
+    };
+
+    size_t total_msg_size = get_ipc_msg_size(sizeof(msgout));
     struct libos_ipc_msg* msg = __alloca(total_msg_size);
     init_ipc_response(msg, seq, total_msg_size);
-    memcpy(msg->data, &result, sizeof(result));
+    memcpy(msg->data, &msgout, sizeof(msgout));
     return ipc_send_message(vmid, msg);
 }
 
@@ -101,6 +109,27 @@ int ipc_file_lock_get(const char* path, struct libos_file_lock* file_lock,
     return result;
 }
 
+int ipc_file_lock_get_send_response(IDTYPE vmid, unsigned long seq, int result,
+                                    struct libos_file_lock* file_lock) {
+    assert(!g_process_ipc_ids.leader_vmid);
+
+    struct libos_ipc_file_lock_resp msgout = {
+        .result = result,
+        .family = file_lock->family,
+        .type = file_lock->type,
+        .start = file_lock->start,
+        .end = file_lock->end,
+        .pid = file_lock->pid,
+        .handle_id = file_lock->handle_id,
+    };
+
+    size_t total_msg_size = get_ipc_msg_size(sizeof(msgout));
+    struct libos_ipc_msg* msg = __alloca(total_msg_size);
+    init_ipc_response(msg, seq, total_msg_size);
+    memcpy(msg->data, &msgout, sizeof(msgout));
+    return ipc_send_message(vmid, msg);
+}
+
 int ipc_file_lock_clear_pid(IDTYPE pid) {
     assert(g_process_ipc_ids.leader_vmid);
 
@@ -118,6 +147,66 @@ int ipc_file_lock_clear_pid(IDTYPE pid) {
     return result;
 }
 
+int ipc_file_lock_revoke_lease(IDTYPE vmid, const char* path, unsigned int grants) {
+    assert(!g_process_ipc_ids.leader_vmid);
+
+    struct libos_ipc_file_lock_revoke_lease msgin = {
+        .grants = grants,
+    };
+
+    size_t path_len = strlen(path);
+    size_t total_msg_size = get_ipc_msg_size(sizeof(msgin) + path_len + 1);
+    struct libos_ipc_msg* msg = __alloca(total_msg_size);
+    init_ipc_msg(msg, IPC_MSG_FILE_LOCK_REVOKE_LEASE, total_msg_size);
+    memcpy(msg->data, &msgin, sizeof(msgin));
+
+    /* Copy path after message (`msg->data` is unaligned, so we have to compute the offset
+     * manually) */
+    char* path_ptr = (char*)&msg->data + offsetof(struct libos_ipc_file_lock_revoke_lease, path);
+    memcpy(path_ptr, path, path_len + 1);
+
+    return ipc_send_message(vmid, msg);
+}
+
+int ipc_file_lock_return_lease(const char* path, struct libos_file_lock* file_locks,
+                               size_t locks_count) {
+    assert(g_process_ipc_ids.leader_vmid);
+
+    size_t locks_size = locks_count * sizeof(struct libos_ipc_file_lock_range);
+    size_t path_size = strlen(path) + 1;
+    size_t total_msg_size = get_ipc_msg_size(sizeof(struct libos_ipc_file_lock_return_lease)
+                                             + locks_size + path_size);
+    /* The number of locks is not bounded, so don't put the message on stack */
+    struct libos_ipc_msg* msg = malloc(total_msg_size);
+    if (!msg)
+        return -ENOMEM;
+    init_ipc_msg(msg, IPC_MSG_FILE_LOCK_RETURN_LEASE, total_msg_size);
+
+    struct libos_ipc_file_lock_return_lease msgin = {
+        .locks_count = locks_count,
+    };
+    memcpy(msg->data, &msgin, sizeof(msgin));
+
+    /* Copy locks and path after message (`msg->data` is unaligned, so we have to compute the
+     * offsets manually) */
+    char* ptr = (char*)&msg->data + offsetof(struct libos_ipc_file_lock_return_lease, locks);
+    for (size_t i = 0; i < locks_count; i++) {
+        struct libos_ipc_file_lock_range range = {
+            .type = file_locks[i].type,
+            .start = file_locks[i].start,
+            .end = file_locks[i].end,
+            .pid = file_locks[i].pid,
+        };
+        memcpy(ptr, &range, sizeof(range));
+        ptr += sizeof(range);
+    }
+    memcpy(ptr, path, path_size);
+
+    int ret = ipc_send_message(g_process_ipc_ids.leader_vmid, msg);
+    free(msg);
+    return ret;
+}
+
 int ipc_file_lock_set_callback(IDTYPE src, void* data, unsigned long seq) {
     struct libos_ipc_file_lock* msgin = data;
     struct libos_file_lock file_lock = {
@@ -143,23 +232,7 @@ int ipc_file_lock_get_callback(IDTYPE src, void* data, unsigned long seq) {
         .handle_id = msgin->handle_id,
     };
 
-    struct libos_file_lock file_lock2 = {0};
-    int result = file_lock_get_from_ipc(msgin->path, &file_lock, &file_lock2);
-    struct libos_ipc_file_lock_resp msgout = {
-        .result = result,
-        .family = file_lock2.family,
-        .type = file_lock2.type,
-        .start = file_lock2.start,
-        .end = file_lock2.end,
-        .pid = file_lock2.pid,
-        .handle_id = file_lock2.handle_id,
-    };
-
-    size_t total_msg_size = get_ipc_msg_size(sizeof(msgout));
-    struct libos_ipc_msg* msg = __alloca(total_msg_size);
-    init_ipc_response(msg, seq, total_msg_size);
-    memcpy(msg->data, &msgout, sizeof(msgout));
-    return ipc_send_message(src, msg);
+    return file_lock_get_from_ipc(msgin->path, &file_lock, src, seq);
 }
 
 int ipc_file_lock_clear_pid_callback(IDTYPE src, void* data, unsigned long seq) {
@@ -172,3 +245,35 @@ int ipc_file_lock_clear_pid_callback(IDTYPE src, void* data, unsigned long seq)
     memcpy(msg->data, &result, sizeof(result));
     return ipc_send_message(src, msg);
 }
+
+int ipc_file_lock_revoke_lease_callback(IDTYPE src, void* data, unsigned long seq) {
+    __UNUSED(src);
+    __UNUSED(seq);
+    struct libos_ipc_file_lock_revoke_lease* msgin = data;
+
+    return file_lock_revoke_lease_from_ipc(msgin->path, msgin->grants);
+}
+
+int ipc_file_lock_return_lease_callback(IDTYPE src, void* data, unsigned long seq) {
+    __UNUSED(seq);
+    struct libos_ipc_file_lock_return_lease* msgin = data;
+
+    struct libos_file_lock* file_locks = NULL;
+    if (msgin->locks_count > 0) {
+        file_locks = calloc(msgin->locks_count, sizeof(*file_locks));
+        if (!file_locks)
+            return -ENOMEM;
+    }
+    for (size_t i = 0; i < msgin->locks_count; i++) {
+        file_locks[i].family = FILE_LOCK_POSIX;
+        file_locks[i].type = msgin->locks[i].type;
+        file_locks[i].start = msgin->locks[i].start;
+        file_locks[i].end = msgin->locks[i].end;
+        file_locks[i].pid = msgin->locks[i].pid;
+    }
+    const char* path = (const char*)&msgin->locks[msgin->locks_count];
+
+    int ret = file_lock_return_lease_from_ipc(path, file_locks, msgin->locks_count, src);
+    free(file_locks);
+    return ret;
+}
@@ -60,9 +60,11 @@ static ipc_callback ipc_callbacks[] = {
     [IPC_MSG_SYNC_CONFIRM_DOWNGRADE] = ipc_sync_confirm_downgrade_callback,
     [IPC_MSG_SYNC_CONFIRM_CLOSE]     = ipc_sync_confirm_close_callback,
 
-    [IPC_MSG_FILE_LOCK_SET]       = ipc_file_lock_set_callback,
-    [IPC_MSG_FILE_LOCK_GET]       = ipc_file_lock_get_callback,
-    [IPC_MSG_FILE_LOCK_CLEAR_PID] = ipc_file_lock_clear_pid_callback,
+    [IPC_MSG_FILE_LOCK_SET]          = ipc_file_lock_set_callback,
+    [IPC_MSG_FILE_LOCK_GET]          = ipc_file_lock_get_callback,
+    [IPC_MSG_FILE_LOCK_CLEAR_PID]    = ipc_file_lock_clear_pid_callback,
+    [IPC_MSG_FILE_LOCK_REVOKE_LEASE] = ipc_file_lock_revoke_lease_callback,
+    [IPC_MSG_FILE_LOCK_RETURN_LEASE] = ipc_file_lock_return_lease_callback,
 };
 
 static void ipc_leader_died_callback(void) {
@@ -295,6 +297,7 @@ static noreturn void ipc_worker_main(void) {
             cur_thread->libos_tcb->tp = NULL;
             put_thread(cur_thread);
 
+            flush_thread_malloc_cache();
             PalThreadExit(&g_clear_on_worker_exit);
             /* Unreachable. */
         }
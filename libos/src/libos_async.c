@@ -295,6 +295,7 @@ static int libos_async_worker(void* arg) {
     free(pals);
     free(pal_events);
 
+    flush_thread_malloc_cache();
     PalThreadExit(&async_worker_running);
     /* UNREACHABLE */
 
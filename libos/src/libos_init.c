@@ -460,6 +460,7 @@ noreturn void libos_init(const char* const* argv, const char* const* envp) {
     log_setprefix(libos_get_tcb());
 
     RUN_INIT(init_async_worker);
+    RUN_INIT(init_memory_reclaimer);
 
     char** new_argv;
     elf_auxv_t* new_auxv;
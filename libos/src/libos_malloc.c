@@ -7,11 +7,14 @@
  *
  * When existing slabs are not sufficient, or a large (4k or greater) allocation is requested, it
  * ends up here (__system_alloc and __system_free).
+ *
+ * Small allocations are served from per-thread caches of free slab objects, see below.
  */
 
 #include "asan.h"
 #include "libos_internal.h"
 #include "libos_lock.h"
+#include "libos_tcb.h"
 #include "libos_utils.h"
 #include "libos_vma.h"
 #include "linux_abi/memory.h"
@@ -30,6 +33,161 @@ static struct libos_lock slab_mgr_lock;
 
 static SLAB_MGR slab_mgr = NULL;
 
+/*
+ * Per-thread caches of free slab objects. Without them, each malloc() and free() of a small object
+ * takes `slab_mgr_lock`, which all threads contend on. Instead, each thread keeps for each slab
+ * level a bounded list of free objects (linked through their first bytes), which serves malloc()
+ * and free() without any locking. An empty list is refilled with a batch of objects from the slab
+ * manager, and a full list returns a batch of objects back to it, so the lock is taken only once
+ * per batch. Objects freed by another thread than the one which allocated them simply end up in the
+ * cache of the freeing thread.
+ *
+ * Each list holds at most `THREAD_CACHE_LEVEL_SIZE` bytes (but no less than `THREAD_CACHE_MIN_CNT`
+ * and no more than `THREAD_CACHE_MAX_CNT` objects), which limits each thread's cache to ~64KB. The
+ * cache is allocated on first use and flushed when the thread exits.
+ *
+ * With ASan, the caches are not used: the slab manager then prefers fresh memory to recycling
+ * freed objects, so that use-after-free bugs are more likely to be detected.
+ */
+#define THREAD_CACHE_LEVEL_SIZE (8 * 1024)
+#define THREAD_CACHE_MIN_CNT    2
+#define THREAD_CACHE_MAX_CNT    32
+
+/* Stored in the TCB of an exited thread: objects freed afterwards go directly to the slab manager,
+ * as nobody would flush the cache again. */
+#define THREAD_CACHE_DISABLED ((void*)1)
+
+struct thread_cache_level {
+    void* head;
+    size_t cnt;
+    /* statistics not yet added to `g_malloc_stats` */
+    uint64_t allocs;
+    uint64_t frees;
+};
+
+struct thread_cache {
+    struct thread_cache_level levels[SLAB_LEVEL];
+};
+
+static size_t g_thread_cache_max_cnt[SLAB_LEVEL];
+
+/* Statistics per slab level (size class); the allocations and frees served by thread caches are
+ * added here only on refills and flushes of the caches, to avoid contention on these counters. */
+static struct malloc_stats g_malloc_stats[SLAB_LEVEL];
+
+static_assert(SLAB_LEVEL <= MALLOC_STATS_MAX_CNT, "MALLOC_STATS_MAX_CNT is too small");
+
+static void publish_thread_cache_stats(struct thread_cache_level* cache_level, size_t level) {
+    __atomic_add_fetch(&g_malloc_stats[level].allocs, cache_level->allocs, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_malloc_stats[level].frees, cache_level->frees, __ATOMIC_RELAXED);
+    cache_level->allocs = 0;
+    cache_level->frees = 0;
+}
+
+static struct thread_cache* get_thread_cache(void) {
+#ifdef ASAN
+    return NULL;
+#else
+    struct thread_cache* cache = LIBOS_TCB_GET(malloc_cache);
+    if (cache == THREAD_CACHE_DISABLED)
+        return NULL;
+
+    if (!cache) {
+        cache = slab_alloc(slab_mgr, sizeof(*cache));
+        if (!cache)
+            return NULL;
+        memset(cache, 0, sizeof(*cache));
+        LIBOS_TCB_SET(malloc_cache, cache);
+    }
+    return cache;
+#endif
+}
+
+static void* thread_cache_alloc(struct thread_cache* cache, size_t level) {
+    struct thread_cache_level* cache_level = &cache->levels[level];
+
+    if (!cache_level->head) {
+        assert(cache_level->cnt == 0);
+
+        void* objs[THREAD_CACHE_MAX_CNT];
+        size_t cnt = slab_alloc_batch(slab_mgr, level, objs,
+                                      (g_thread_cache_max_cnt[level] + 1) / 2);
+        if (!cnt)
+            return NULL;
+
+        for (size_t i = 0; i < cnt; i++) {
+            *(void**)objs[i] = cache_level->head;
+            cache_level->head = objs[i];
+        }
+        cache_level->cnt = cnt;
+
+        __atomic_add_fetch(&g_malloc_stats[level].refills, 1, __ATOMIC_RELAXED);
+        publish_thread_cache_stats(cache_level, level);
+    }
+
+    void* obj = cache_level->head;
+    cache_level->head = *(void**)obj;
+    cache_level->cnt--;
+    cache_level->allocs++;
+    return obj;
+}
+
+/* Returns `cnt` objects from the head of the list to the slab manager. */
+static void thread_cache_flush_level(struct thread_cache* cache, size_t level, size_t cnt) {
+    struct thread_cache_level* cache_level = &cache->levels[level];
+    assert(cnt <= cache_level->cnt);
+
+    void* objs[THREAD_CACHE_MAX_CNT];
+    for (size_t i = 0; i < cnt; i++) {
+        objs[i] = cache_level->head;
+        cache_level->head = *(void**)objs[i];
+    }
+    cache_level->cnt -= cnt;
+
+    slab_free_batch(slab_mgr, level, objs, cnt);
+
+    __atomic_add_fetch(&g_malloc_stats[level].flushes, 1, __ATOMIC_RELAXED);
+    publish_thread_cache_stats(cache_level, level);
+}
+
+static void thread_cache_free(struct thread_cache* cache, size_t level, void* obj) {
+    struct thread_cache_level* cache_level = &cache->levels[level];
+
+    if (cache_level->cnt == g_thread_cache_max_cnt[level])
+        thread_cache_flush_level(cache, level, (cache_level->cnt + 1) / 2);
+
+#ifdef DEBUG
+    _real_memset(obj, 0xCC, slab_levels[level]);
+#endif
+    *(void**)obj = cache_level->head;
+    cache_level->head = obj;
+    cache_level->cnt++;
+    cache_level->frees++;
+}
+
+void flush_thread_malloc_cache(void) {
+    struct thread_cache* cache = LIBOS_TCB_GET(malloc_cache);
+    LIBOS_TCB_SET(malloc_cache, THREAD_CACHE_DISABLED);
+    if (!cache || cache == THREAD_CACHE_DISABLED)
+        return;
+
+    for (size_t level = 0; level < SLAB_LEVEL; level++)
+        thread_cache_flush_level(cache, level, cache->levels[level].cnt);
+    slab_free(slab_mgr, cache);
+}
+
+size_t get_malloc_stats(struct malloc_stats* stats, size_t stats_cnt) {
+    size_t cnt = MIN(stats_cnt, (size_t)SLAB_LEVEL);
+    for (size_t level = 0; level < cnt; level++) {
+        stats[level].obj_size = slab_levels[level];
+        stats[level].allocs   = __atomic_load_n(&g_malloc_stats[level].allocs, __ATOMIC_RELAXED);
+        stats[level].frees    = __atomic_load_n(&g_malloc_stats[level].frees, __ATOMIC_RELAXED);
+        stats[level].refills  = __atomic_load_n(&g_malloc_stats[level].refills, __ATOMIC_RELAXED);
+        stats[level].flushes  = __atomic_load_n(&g_malloc_stats[level].flushes, __ATOMIC_RELAXED);
+    }
+    return cnt;
+}
+
 /* Returns NULL on failure */
 void* __system_malloc(size_t size) {
     size_t alloc_size = ALLOC_ALIGN_UP(size);
@@ -80,11 +238,26 @@ int init_slab(void) {
     if (!slab_mgr) {
         return -ENOMEM;
     }
+    for (size_t level = 0; level < SLAB_LEVEL; level++) {
+        size_t cnt = THREAD_CACHE_LEVEL_SIZE / slab_levels[level];
+        g_thread_cache_max_cnt[level] = MIN(MAX(cnt, (size_t)THREAD_CACHE_MIN_CNT),
+                                            (size_t)THREAD_CACHE_MAX_CNT);
+    }
     return 0;
 }
 
 void* malloc(size_t size) {
-    void* mem = slab_alloc(slab_mgr, size);
+    void* mem = NULL;
+
+    size_t level = slab_size_to_level(size);
+    struct thread_cache* cache = level < SLAB_LEVEL ? get_thread_cache() : NULL;
+    if (cache) {
+        mem = thread_cache_alloc(cache, level);
+    } else {
+        mem = slab_alloc(slab_mgr, size);
+        if (mem && level < SLAB_LEVEL)
+            __atomic_add_fetch(&g_malloc_stats[level].allocs, 1, __ATOMIC_RELAXED);
+    }
 
     if (!mem) {
         /*
@@ -140,5 +313,17 @@ void free(void* mem) {
         return;
     }
 
+    if (!mem)
+        return;
+
+    unsigned char level = slab_get_obj_level(mem);
+    struct thread_cache* cache = level < SLAB_LEVEL ? get_thread_cache() : NULL;
+    if (cache) {
+        thread_cache_free(cache, level, mem);
+        return;
+    }
+
+    if (level < SLAB_LEVEL)
+        __atomic_add_fetch(&g_malloc_stats[level].frees, 1, __ATOMIC_RELAXED);
     slab_free(slab_mgr, mem);
 }
@@ -512,7 +512,9 @@ struct parser_table {
                               parse_pointer_arg, parse_pointer_arg}},
     [__NR_get_robust_list] = {.slow = false, .name = "get_robust_list", .parser = {parse_long_arg,
                               parse_integer_arg, parse_pointer_arg, parse_pointer_arg}},
-    [__NR_splice] = {.slow = false, .name = "splice", .parser = {NULL}},
+    [__NR_splice] = {.slow = true, .name = "splice", .parser = {parse_long_arg, parse_integer_arg,
+                     parse_pointer_arg, parse_integer_arg, parse_pointer_arg, parse_pointer_arg,
+                     parse_integer_arg}},
     [__NR_tee] = {.slow = false, .name = "tee", .parser = {NULL}},
     [__NR_sync_file_range] = {.slow = false, .name = "sync_file_range", .parser = {NULL}},
     [__NR_vmsplice] = {.slow = false, .name = "vmsplice", .parser = {NULL}},
@@ -574,7 +576,9 @@ struct parser_table {
     [__NR_membarrier] = {.slow = false, .name = "membarrier", .parser = {NULL}},
     [__NR_mlock2] = {.slow = false, .name = "mlock2", .parser = {parse_long_arg,
                      parse_pointer_arg, parse_pointer_arg, parse_integer_arg}},
-    [__NR_copy_file_range] = {.slow = false, .name = "copy_file_range", .parser = {NULL}},
+    [__NR_copy_file_range] = {.slow = false, .name = "copy_file_range", .parser = {parse_long_arg,
+                              parse_integer_arg, parse_pointer_arg, parse_integer_arg,
+                              parse_pointer_arg, parse_pointer_arg, parse_integer_arg}},
     [__NR_preadv2] = {.slow = false, .name = "preadv2", .parser = {NULL}},
     [__NR_pwritev2] = {.slow = false, .name = "pwritev2", .parser = {NULL}},
     [__NR_pkey_mprotect] = {.slow = false, .name = "pkey_mprotect", .parser = {NULL}},
@@ -264,9 +264,11 @@ static int execute_loadcmd(const struct loadcmd* c, elf_addr_t base_diff,
             return ret;
         }
 
+        /* MAP_POPULATE: the tail of the last page is zeroed below, so the segment must not be
+         * populated lazily from the file */
         size_t valid_size;
-        ret = file->fs->fs_ops->mmap(file, map_start, map_size, c->prot, map_flags, c->map_off,
-                                     &valid_size);
+        ret = file->fs->fs_ops->mmap(file, map_start, map_size, c->prot, map_flags | MAP_POPULATE,
+                                     c->map_off, &valid_size);
         if (ret < 0) {
             log_debug("failed to map segment: %s", unix_strerror(ret));
             return ret;
@@ -753,6 +753,19 @@ static int send(struct libos_handle* handle, struct iovec* iov, size_t iov_len,
     return ret;
 }
 
+static int sendfile(struct libos_handle* handle, PAL_HANDLE src, uint64_t src_offset,
+                    size_t* size) {
+    assert(handle->type == TYPE_SOCK);
+
+    /* UDP would need to split the data into datagrams the same way as Linux does */
+    if (handle->info.sock.type != SOCK_STREAM)
+        return -EOPNOTSUPP;
+
+    int ret = PalStreamTransfer(src, src_offset, handle->info.sock.pal_handle, /*dst_offset=*/0,
+                                size);
+    return ret == PAL_ERROR_NOTSUPPORT ? -EOPNOTSUPP : pal_to_unix_errno(ret);
+}
+
 static int recv(struct libos_handle* handle, struct iovec* iov, size_t iov_len, void* msg_control,
                 size_t* msg_controllen_ptr, size_t* out_total_size, void* addr, size_t* addrlen_ptr,
                 bool force_nonblocking) {
@@ -813,5 +826,6 @@ struct libos_sock_ops sock_ip_ops = {
     .getsockopt = getsockopt,
     .setsockopt = setsockopt,
     .send = send,
+    .sendfile = sendfile,
     .recv = recv,
 };
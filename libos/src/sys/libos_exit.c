@@ -116,10 +116,12 @@ noreturn void thread_exit(int error_code, int term_signal) {
             /* `cleanup_thread` did not get this reference, clean it. We have to be careful, as
              * this is most likely the last reference and will free this `cur_thread`. */
             put_thread(cur_thread);
+            flush_thread_malloc_cache();
             PalThreadExit(NULL);
             /* UNREACHABLE */
         }
 
+        flush_thread_malloc_cache();
         PalThreadExit(&cur_thread->clear_child_tid_pal);
         /* UNREACHABLE */
     }
@@ -3,7 +3,8 @@
 
 /*
  * Implementation of system calls "unlink", "unlinkat", "mkdir", "mkdirat", "rmdir", "umask",
- * "chmod", "fchmod", "fchmodat", "rename", "renameat" and "sendfile".
+ * "chmod", "fchmod", "fchmodat", "rename", "renameat", "sendfile", "splice" and
+ * "copy_file_range".
  */
 
 #include "libos_fs.h"
@@ -12,22 +13,21 @@
 #include "libos_lock.h"
 #include "libos_process.h"
 #include "libos_table.h"
+#include "libos_thread.h"
 #include "linux_abi/errors.h"
 #include "linux_abi/fs.h"
 #include "perm.h"
 #include "stat.h"
 
 /*
- * Read/write in 64KB chunks in the sendfile() syscall. This syscall also has an optimization of
- * using a statically allocated buffer instead of allocating on the heap (as our internal malloc()
- * has subpar performance). To prevent data races of multiple threads executing sendfile() at the
- * same time and thus potentially corrupting a single static buffer, we optimize for a common case:
- * only the first thread uses the static buffer whereas other threads fall back to a slower heap
- * allocation.
+ * When data cannot be transferred directly on the host (see `copy_data()` below), the "sendfile",
+ * "splice" and "copy_file_range" syscalls read and write it in chunks, using a per-thread buffer
+ * which is kept for subsequent calls (our internal malloc() has subpar performance). Chunks start at
+ * 64KB and double after each full chunk up to 1MB, so that small transfers do not allocate a big
+ * buffer, and big transfers need fewer reads and writes.
  */
-#define BUF_SIZE (64 * 1024)
-static char g_sendfile_buf[BUF_SIZE];
-static bool g_sendfile_buf_in_use = false;
+#define COPY_CHUNK_MIN_SIZE (64 * 1024)
+#define COPY_CHUNK_MAX_SIZE (1024 * 1024)
 
 /* The kernel would look up the parent directory, and remove the child from the inode. But we are
  * working with the PAL, so we open the file, truncate and close it. */
@@ -79,8 +79,11 @@ long libos_syscall_unlinkat(int dfd, const char* pathname, int flag) {
         }
     }
 
-    put_inode(dent->inode);
+    struct libos_inode* inode = dent->inode;
+    write_seqbegin(&g_dcache_seqlock);
     dent->inode = NULL;
+    write_seqend(&g_dcache_seqlock);
+    put_inode(inode);
     ret = 0;
 out:
     unlock(&g_dcache_lock);
@@ -154,8 +157,11 @@ long libos_syscall_rmdir(const char* pathname) {
     if (ret < 0)
         goto out;
 
-    put_inode(dent->inode);
+    struct libos_inode* inode = dent->inode;
+    write_seqbegin(&g_dcache_seqlock);
     dent->inode = NULL;
+    write_seqend(&g_dcache_seqlock);
+    put_inode(inode);
     ret = 0;
 out:
     unlock(&g_dcache_lock);
@@ -345,10 +351,13 @@ static int do_rename(struct libos_dentry* old_dent, struct libos_dentry* new_den
     if (ret < 0)
         return ret;
 
-    if (new_dent->inode)
-        put_inode(new_dent->inode);
+    struct libos_inode* replaced_inode = new_dent->inode;
+    write_seqbegin(&g_dcache_seqlock);
     new_dent->inode = old_dent->inode;
     old_dent->inode = NULL;
+    write_seqend(&g_dcache_seqlock);
+    if (replaced_inode)
+        put_inode(replaced_inode);
     return 0;
 }
 
@@ -414,15 +423,133 @@ out:
     return ret;
 }
 
-long libos_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
-    long ret;
-    char* buf = NULL;
+/* Returns the per-thread copy buffer, with at least `*size` bytes. If such buffer cannot be
+ * allocated, returns the current (smaller) buffer and updates `*size` to its size. */
+static char* get_copy_buf(size_t* size) {
+    struct libos_thread* cur_thread = get_cur_thread();
+    if (cur_thread->copy_buf_size < *size) {
+        char* buf = malloc(*size);
+        if (buf) {
+            free(cur_thread->copy_buf);
+            cur_thread->copy_buf = buf;
+            cur_thread->copy_buf_size = *size;
+        } else if (cur_thread->copy_buf) {
+            *size = cur_thread->copy_buf_size;
+        } else {
+            return NULL;
+        }
+    }
+    return cur_thread->copy_buf;
+}
 
-    /* "unused" to silence newer Clang; we keep this variable as it may be helpful once we improve
-     * the `sendfile()` implementation, see one of the TODOs below */
-    __attribute__((unused)) size_t read_from_in = 0;
+/*
+ * Copies up to `count` bytes from `in_hdl` (starting at `*pos_in`) to `out_hdl` (starting at
+ * `*pos_out`, or at the position of `out_hdl` if `pos_out` is NULL). The positions are updated only
+ * if the respective handle is seekable.
+ *
+ * If the input is a host file whose data does not need any processing in LibOS (e.g. it is not
+ * a trusted file), and the output supports it (host files, TCP sockets), the data is transferred
+ * directly on the host and never copied into LibOS. Otherwise, it is read and written in chunks.
+ *
+ * Returns the number of copied bytes, or negative error code if nothing was copied.
+ */
+static ssize_t copy_data(struct libos_handle* in_hdl, file_off_t* pos_in,
+                         struct libos_handle* out_hdl, file_off_t* pos_out, size_t count) {
+    ssize_t ret = 0;
+    size_t copied = 0;
+
+    PAL_HANDLE host_src = NULL;
+    if (in_hdl->fs->fs_ops->host_read_handle && out_hdl->fs->fs_ops->write_from_host)
+        host_src = in_hdl->fs->fs_ops->host_read_handle(in_hdl);
+
+    size_t chunk_size = COPY_CHUNK_MIN_SIZE;
+    while (copied < count) {
+        size_t to_copy = count - copied;
+
+        if (host_src) {
+            ssize_t x;
+            if (pos_out) {
+                x = out_hdl->fs->fs_ops->write_from_host(out_hdl, host_src, *pos_in, to_copy,
+                                                         pos_out);
+            } else {
+                maybe_lock_pos_handle(out_hdl);
+                x = out_hdl->fs->fs_ops->write_from_host(out_hdl, host_src, *pos_in, to_copy,
+                                                         &out_hdl->pos);
+                maybe_unlock_pos_handle(out_hdl);
+            }
+            if (x == -EOPNOTSUPP) {
+                /* cannot be done on the host, fall back to reading and writing */
+                host_src = NULL;
+                continue;
+            }
+            if (x < 0) {
+                ret = x;
+                break;
+            }
+            assert((size_t)x <= to_copy);
 
-    size_t copied_to_out = 0;
+            *pos_in += x;
+            copied += x;
+            if ((size_t)x < to_copy) {
+                /* end of input file, or output cannot take more data without blocking */
+                break;
+            }
+            continue;
+        }
+
+        to_copy = MIN(to_copy, chunk_size);
+        char* buf = get_copy_buf(&to_copy);
+        if (!buf) {
+            ret = -ENOMEM;
+            break;
+        }
+
+        file_off_t old_pos_in = *pos_in;
+        ssize_t x = in_hdl->fs->fs_ops->read(in_hdl, buf, to_copy, pos_in);
+        if (x < 0) {
+            ret = x;
+            break;
+        }
+        assert((size_t)x <= to_copy);
+
+        if (x == 0) {
+            /* no more data in input handle */
+            break;
+        }
+
+        ssize_t y;
+        if (pos_out) {
+            y = out_hdl->fs->fs_ops->write(out_hdl, buf, x, pos_out);
+        } else {
+            maybe_lock_pos_handle(out_hdl);
+            y = out_hdl->fs->fs_ops->write(out_hdl, buf, x, &out_hdl->pos);
+            maybe_unlock_pos_handle(out_hdl);
+        }
+        if (y < 0) {
+            /* if the input is seekable, don't skip the data that was not written (for other inputs
+             * the data is lost, there is no way to put it back) */
+            *pos_in = old_pos_in;
+            ret = y;
+            break;
+        }
+        assert(y <= x);
+
+        copied += y;
+        if (y < x) {
+            if (*pos_in != old_pos_in)
+                *pos_in = old_pos_in + y;
+            break;
+        }
+
+        if ((size_t)x == to_copy && chunk_size < COPY_CHUNK_MAX_SIZE)
+            chunk_size *= 2;
+    }
+
+    return copied ? (ssize_t)copied : ret;
+}
+
+long libos_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+    long ret;
 
     if (offset && !is_user_memory_writable(offset, sizeof(*offset)))
         return -EFAULT;
@@ -454,22 +581,6 @@ long libos_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
         goto out;
     }
 
-    /* FIXME: This sendfile() emulation is very simple and not particularly efficient: it reads from
-     *        input FD in BUF_SIZE chunks and writes into output FD. Mmap-based emulation may be
-     *        more efficient but adds complexity (not all handle types provide mmap callback). */
-
-    bool buf_in_use = __atomic_exchange_n(&g_sendfile_buf_in_use, true, __ATOMIC_ACQUIRE);
-    if (!buf_in_use) {
-        /* no other thread was using the static buffer */
-        buf = g_sendfile_buf;
-    } else {
-        buf = malloc(BUF_SIZE);
-        if (!buf) {
-            ret = -ENOMEM;
-            goto out;
-        }
-    }
-
     if (!count) {
         ret = 0;
         goto out;
@@ -499,64 +610,237 @@ long libos_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
         maybe_unlock_pos_handle(in_hdl);
     }
 
-    while (copied_to_out < count) {
-        size_t to_copy = count - copied_to_out > BUF_SIZE ? BUF_SIZE : count - copied_to_out;
+    ret = copy_data(in_hdl, &pos_in, out_hdl, /*pos_out=*/NULL, count);
 
-        ssize_t x = in_hdl->fs->fs_ops->read(in_hdl, buf, to_copy, &pos_in);
-        if (x < 0) {
-            ret = x;
-            goto out_update;
-        }
-        assert(x <= (ssize_t)to_copy);
+    /* Update either `*offset` or the offset in input file (see the comment above `pos_in`
+     * declaration). Note that we do it even if copying failed. */
+    if (offset) {
+        *offset = pos_in;
+    } else if (in_hdl->seekable) {
+        maybe_lock_pos_handle(in_hdl);
+        in_hdl->pos = pos_in;
+        maybe_unlock_pos_handle(in_hdl);
+    }
+
+out:
+    put_handle(in_hdl);
+    put_handle(out_hdl);
+    return ret;
+}
 
-        read_from_in += x;
+long libos_syscall_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                          unsigned int flags) {
+    long ret;
 
-        if (x == 0) {
-            /* no more data in input FD, let's return however many bytes copied_to_out up until now */
-            break;
+    if (!WITHIN_MASK(flags, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE | SPLICE_F_GIFT))
+        return -EINVAL;
+
+    if (off_in && !is_user_memory_writable(off_in, sizeof(*off_in)))
+        return -EFAULT;
+    if (off_out && !is_user_memory_writable(off_out, sizeof(*off_out)))
+        return -EFAULT;
+
+    struct libos_handle* in_hdl = get_fd_handle(fd_in, NULL, NULL);
+    if (!in_hdl)
+        return -EBADF;
+
+    struct libos_handle* out_hdl = get_fd_handle(fd_out, NULL, NULL);
+    if (!out_hdl) {
+        put_handle(in_hdl);
+        return -EBADF;
+    }
+
+    if (!(in_hdl->acc_mode & MAY_READ) || !(out_hdl->acc_mode & MAY_WRITE)) {
+        ret = -EBADF;
+        goto out;
+    }
+
+    /* Linux requires one of the handles to be a pipe; the data is never actually moved to/from the
+     * pipe buffer without copying, so SPLICE_F_MOVE and SPLICE_F_GIFT are ignored (as they are only
+     * hints) */
+    bool in_is_pipe = in_hdl->type == TYPE_PIPE;
+    bool out_is_pipe = out_hdl->type == TYPE_PIPE;
+    if (!in_is_pipe && !out_is_pipe) {
+        ret = -EINVAL;
+        goto out;
+    }
+    if ((in_is_pipe && off_in) || (out_is_pipe && off_out)) {
+        ret = -ESPIPE;
+        goto out;
+    }
+
+    if (!in_hdl->fs || !in_hdl->fs->fs_ops || !in_hdl->fs->fs_ops->read || !out_hdl->fs
+            || !out_hdl->fs->fs_ops || !out_hdl->fs->fs_ops->write) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    if (out_hdl->flags & O_APPEND) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    if (flags & SPLICE_F_NONBLOCK) {
+        if (FIRST_TIME())
+            log_debug("SPLICE_F_NONBLOCK is ignored, only nonblocking mode of handles is used");
+    }
+
+    if (!len) {
+        ret = 0;
+        goto out;
+    }
+
+    file_off_t pos_in = 0;
+    if (off_in) {
+        if (!in_hdl->fs->fs_ops->seek) {
+            ret = -ESPIPE;
+            goto out;
+        }
+        pos_in = *off_in;
+        if (pos_in < 0) {
+            ret = -EINVAL;
+            goto out;
+        }
+    } else {
+        maybe_lock_pos_handle(in_hdl);
+        pos_in = in_hdl->pos;
+        maybe_unlock_pos_handle(in_hdl);
+    }
+
+    file_off_t pos_out = 0;
+    if (off_out) {
+        if (!out_hdl->fs->fs_ops->seek) {
+            ret = -ESPIPE;
+            goto out;
+        }
+        pos_out = *off_out;
+        if (pos_out < 0) {
+            ret = -EINVAL;
+            goto out;
         }
+    }
+
+    ret = copy_data(in_hdl, &pos_in, out_hdl, off_out ? &pos_out : NULL, len);
+
+    if (off_in) {
+        *off_in = pos_in;
+    } else if (in_hdl->seekable) {
+        maybe_lock_pos_handle(in_hdl);
+        in_hdl->pos = pos_in;
+        maybe_unlock_pos_handle(in_hdl);
+    }
+    if (off_out)
+        *off_out = pos_out;
+
+out:
+    put_handle(in_hdl);
+    put_handle(out_hdl);
+    return ret;
+}
+
+long libos_syscall_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out,
+                                   size_t len, unsigned int flags) {
+    long ret;
+
+    if (flags)
+        return -EINVAL;
+
+    if (off_in && !is_user_memory_writable(off_in, sizeof(*off_in)))
+        return -EFAULT;
+    if (off_out && !is_user_memory_writable(off_out, sizeof(*off_out)))
+        return -EFAULT;
+
+    struct libos_handle* in_hdl = get_fd_handle(fd_in, NULL, NULL);
+    if (!in_hdl)
+        return -EBADF;
+
+    struct libos_handle* out_hdl = get_fd_handle(fd_out, NULL, NULL);
+    if (!out_hdl) {
+        put_handle(in_hdl);
+        return -EBADF;
+    }
+
+    if (!(in_hdl->acc_mode & MAY_READ) || !(out_hdl->acc_mode & MAY_WRITE)
+            || (out_hdl->flags & O_APPEND)) {
+        ret = -EBADF;
+        goto out;
+    }
+
+    if (!in_hdl->inode || !out_hdl->inode) {
+        ret = -EINVAL;
+        goto out;
+    }
+    if (in_hdl->inode->type == S_IFDIR || out_hdl->inode->type == S_IFDIR) {
+        ret = -EISDIR;
+        goto out;
+    }
+    if (in_hdl->inode->type != S_IFREG || out_hdl->inode->type != S_IFREG
+            || !in_hdl->fs || !in_hdl->fs->fs_ops || !in_hdl->fs->fs_ops->read
+            || !out_hdl->fs || !out_hdl->fs->fs_ops || !out_hdl->fs->fs_ops->write) {
+        ret = -EINVAL;
+        goto out;
+    }
 
+    /* the offsets in handles are used (and updated) only if the respective pointer is NULL */
+    file_off_t pos_in;
+    if (off_in) {
+        pos_in = *off_in;
+    } else {
+        maybe_lock_pos_handle(in_hdl);
+        pos_in = in_hdl->pos;
+        maybe_unlock_pos_handle(in_hdl);
+    }
+
+    file_off_t pos_out;
+    if (off_out) {
+        pos_out = *off_out;
+    } else {
         maybe_lock_pos_handle(out_hdl);
-        ssize_t y = out_hdl->fs->fs_ops->write(out_hdl, buf, x, &out_hdl->pos);
+        pos_out = out_hdl->pos;
         maybe_unlock_pos_handle(out_hdl);
-        if (y < 0) {
-            ret = y;
-            goto out_update;
-        }
-        assert(y <= x);
+    }
 
-        copied_to_out += y;
+    if (pos_in < 0 || pos_out < 0) {
+        ret = -EINVAL;
+        goto out;
+    }
+    if (len > (size_t)(FILE_OFF_MAX - pos_in) || len > (size_t)(FILE_OFF_MAX - pos_out)) {
+        ret = -EOVERFLOW;
+        goto out;
+    }
+    if (in_hdl->inode == out_hdl->inode && pos_in < pos_out + (file_off_t)len
+            && pos_out < pos_in + (file_off_t)len) {
+        /* Linux doesn't allow overlapping ranges in the same file */
+        ret = -EINVAL;
+        goto out;
+    }
 
-        if (y < x) {
-            /* written less bytes to output fd than read from input fd -> out of sync now; don't try
-             * to be smart and simply return however many bytes we copied_to_out up until now */
-            /* TODO: need to revert in_fd's file position to (read_from_in - x + y) from original
-             *       offset and maybe continue this loop */
-            break;
-        }
+    if (!len) {
+        ret = 0;
+        goto out;
     }
 
-    ret = 0;
+    ret = copy_data(in_hdl, &pos_in, out_hdl, &pos_out, len);
 
-out_update:
-    /* Update either `*offset` or the offset in input file (see the comment above `pos_in`
-     * declaration). Note that we do it even if one of the read/write operations failed. */
-    if (offset) {
-        *offset = pos_in;
-    } else if (in_hdl->seekable) {
+    if (off_in) {
+        *off_in = pos_in;
+    } else {
         maybe_lock_pos_handle(in_hdl);
         in_hdl->pos = pos_in;
         maybe_unlock_pos_handle(in_hdl);
     }
+    if (off_out) {
+        *off_out = pos_out;
+    } else {
+        maybe_lock_pos_handle(out_hdl);
+        out_hdl->pos = pos_out;
+        maybe_unlock_pos_handle(out_hdl);
+    }
 
 out:
-    if (buf == g_sendfile_buf)
-        __atomic_store_n(&g_sendfile_buf_in_use, 0, __ATOMIC_RELEASE);
-    else
-        free(buf);
     put_handle(in_hdl);
     put_handle(out_hdl);
-    return copied_to_out ? (long)copied_to_out : ret;
+    return ret;
 }
 
 long libos_syscall_chroot(const char* filename) {
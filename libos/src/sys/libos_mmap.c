@@ -339,12 +339,7 @@ long libos_syscall_mprotect(void* addr, size_t length, int prot) {
         }
     }
 
-    ret = PalVirtualMemoryProtect(addr, length, LINUX_PROT_TO_PAL(prot, /*map_flags=*/0));
-    if (ret < 0) {
-        return pal_to_unix_errno(ret);
-    }
-
-    return 0;
+    return protect_user_memory(addr, length, prot);
 }
 
 long libos_syscall_munmap(void* _addr, size_t length) {
@@ -494,7 +489,6 @@ long libos_syscall_madvise(unsigned long start, size_t len_in, int behavior) {
         case MADV_RANDOM:
         case MADV_SEQUENTIAL:
         case MADV_WILLNEED:
-        case MADV_FREE:
         case MADV_SOFT_OFFLINE:
         case MADV_MERGEABLE:
         case MADV_UNMERGEABLE:
@@ -515,6 +509,10 @@ long libos_syscall_madvise(unsigned long start, size_t len_in, int behavior) {
         case MADV_DONTNEED: {
             return madvise_dontneed_range(start, start + len);
         }
+
+        case MADV_FREE: {
+            return madvise_free_range(start, start + len);
+        }
     }
     return -EINVAL;
 }
@@ -664,6 +664,51 @@ static int check_msghdr(struct msghdr* user_msg, bool is_recv) {
     return 0;
 }
 
+/* Checks whether data can be sent on the socket, and consumes the pending error (if any). */
+static ssize_t check_send_state(struct libos_sock_handle* sock, bool* out_has_sendtimeout_set) {
+    lock(&sock->lock);
+    *out_has_sendtimeout_set = !!sock->sendtimeout_us;
+
+    if (sock->state == SOCK_CONNECTING) {
+        unlock(&sock->lock);
+        return -EAGAIN;
+    }
+
+    ssize_t ret = -((ssize_t)sock->last_error);
+    sock->last_error = 0;
+
+    if (!ret && !sock->can_be_written) {
+        ret = -EPIPE;
+    }
+
+    unlock(&sock->lock);
+    return ret;
+}
+
+/* Delivers SIGPIPE and converts EINTR to restart codes, as appropriate for the result of a send. */
+static ssize_t finish_send(ssize_t ret, unsigned int flags, bool has_sendtimeout_set) {
+    if (ret == -EPIPE && !(flags & MSG_NOSIGNAL)) {
+        siginfo_t info = {
+            .si_signo = SIGPIPE,
+            .si_pid = g_process.pid,
+            .si_code = SI_USER,
+        };
+        if (kill_current_proc(&info) < 0) {
+            log_error("failed to deliver a signal");
+        }
+    }
+    if (ret == -EINTR) {
+        /* Timeout could have been changed in the meantime, but it should not matter - this is
+         * a peculiar corner case that nothing should really care about. */
+        if (has_sendtimeout_set) {
+            ret = -ERESTARTNOHAND;
+        } else {
+            ret = -ERESTARTSYS;
+        }
+    }
+    return ret;
+}
+
 /* We return the size directly (contrary to the usual out argument) for simplicity - this function
  * is called directly from syscall handlers, which return values in such a way. */
 ssize_t do_sendmsg(struct libos_handle* handle, struct iovec* iov, size_t iov_len,
@@ -691,25 +736,10 @@ ssize_t do_sendmsg(struct libos_handle* handle, struct iovec* iov, size_t iov_le
             log_debug("MSG_MORE on TCP sockets is ignored");
     }
 
-    lock(&sock->lock);
-    if (sock->state == SOCK_CONNECTING) {
-        unlock(&sock->lock);
-        return -EAGAIN;
-    }
-
-    bool has_sendtimeout_set = !!sock->sendtimeout_us;
-
-    ret = -((ssize_t)sock->last_error);
-    sock->last_error = 0;
-
-    if (!ret && !sock->can_be_written) {
-        ret = -EPIPE;
-    }
-
-    unlock(&sock->lock);
-
+    bool has_sendtimeout_set;
+    ret = check_send_state(sock, &has_sendtimeout_set);
     if (ret < 0) {
-        goto out;
+        return finish_send(ret, flags, has_sendtimeout_set);
     }
 
     size_t total_size = 0;
@@ -725,27 +755,37 @@ ssize_t do_sendmsg(struct libos_handle* handle, struct iovec* iov, size_t iov_le
         ret = size;
     }
 
-out:
-    if (ret == -EPIPE && !(flags & MSG_NOSIGNAL)) {
-        siginfo_t info = {
-            .si_signo = SIGPIPE,
-            .si_pid = g_process.pid,
-            .si_code = SI_USER,
-        };
-        if (kill_current_proc(&info) < 0) {
-            log_error("failed to deliver a signal");
-        }
+    return finish_send(ret, flags, has_sendtimeout_set);
+}
+
+ssize_t do_sendfile(struct libos_handle* handle, PAL_HANDLE src, uint64_t src_offset,
+                    size_t count) {
+    if (handle->type != TYPE_SOCK) {
+        return -ENOTSOCK;
     }
-    if (ret == -EINTR) {
-        /* Timeout could have been changed in the meantime, but it should not matter - this is
-         * a peculiar corner case that nothing should really care about. */
-        if (has_sendtimeout_set) {
-            ret = -ERESTARTNOHAND;
-        } else {
-            ret = -ERESTARTSYS;
-        }
+
+    struct libos_sock_handle* sock = &handle->info.sock;
+    if (!sock->ops->sendfile) {
+        return -EOPNOTSUPP;
     }
-    return ret;
+
+    bool has_sendtimeout_set;
+    ssize_t ret = check_send_state(sock, &has_sendtimeout_set);
+    if (ret < 0) {
+        return finish_send(ret, /*flags=*/0, has_sendtimeout_set);
+    }
+
+    size_t size = count;
+    ret = sock->ops->sendfile(handle, src, src_offset, &size);
+    if (ret == -EOPNOTSUPP) {
+        return ret;
+    }
+    maybe_epoll_et_trigger(handle, ret, /*in=*/false, !ret ? size < count : false);
+    if (!ret) {
+        ret = size;
+    }
+
+    return finish_send(ret, /*flags=*/0, has_sendtimeout_set);
 }
 
 long libos_syscall_sendto(int fd, void* buf, size_t len, unsigned int flags, void* addr,
@@ -33,6 +33,55 @@ static int do_stat(struct libos_dentry* dent, struct stat* stat) {
     return 0;
 }
 
+/*
+ * Fast path for paths that are already in the dentry cache: looks them up without taking
+ * `g_dcache_lock` (see `path_lookupat_cached`) and, if the filesystem uses `generic_inode_stat`,
+ * retrieves the attributes directly from the inode. Returns -EAGAIN if the slow path has to be
+ * used.
+ */
+static int do_stat_cached(struct libos_dentry* start, const char* path, int lookup_flags,
+                          struct stat* stat) {
+    struct libos_dentry* dent;
+    struct libos_inode* inode;
+    int ret = path_lookupat_cached(start, path, lookup_flags, &dent, &inode);
+    if (ret < 0)
+        return ret;
+
+    struct libos_fs* fs = inode->fs;
+    if (fs && fs->d_ops && fs->d_ops->stat == &generic_inode_stat) {
+        ret = generic_istat(inode, stat);
+        if (ret == 0)
+            stat->st_ino = dentry_ino(dent);
+    } else {
+        ret = -EAGAIN;
+    }
+
+    put_inode(inode);
+    put_dentry(dent);
+    return ret;
+}
+
+static int do_stat_path(struct libos_dentry* start, const char* path, int lookup_flags,
+                        struct stat* stat) {
+    int ret = do_stat_cached(start, path, lookup_flags, stat);
+    if (ret != -EAGAIN)
+        return ret;
+
+    struct libos_dentry* dent = NULL;
+
+    lock(&g_dcache_lock);
+    ret = path_lookupat(start, path, lookup_flags, &dent);
+    if (ret < 0)
+        goto out;
+
+    ret = do_stat(dent, stat);
+out:
+    unlock(&g_dcache_lock);
+    if (dent)
+        put_dentry(dent);
+    return ret;
+}
+
 static int do_hstat(struct libos_handle* hdl, struct stat* stat) {
     struct libos_fs* fs = hdl->fs;
 
@@ -57,20 +106,7 @@ long libos_syscall_stat(const char* file, struct stat* stat) {
     if (!is_user_memory_writable(stat, sizeof(*stat)))
         return -EFAULT;
 
-    int ret;
-    struct libos_dentry* dent = NULL;
-
-    lock(&g_dcache_lock);
-    ret = path_lookupat(/*start=*/NULL, file, LOOKUP_FOLLOW, &dent);
-    if (ret < 0)
-        goto out;
-
-    ret = do_stat(dent, stat);
-out:
-    unlock(&g_dcache_lock);
-    if (dent)
-        put_dentry(dent);
-    return ret;
+    return do_stat_path(/*start=*/NULL, file, LOOKUP_FOLLOW, stat);
 }
 
 long libos_syscall_lstat(const char* file, struct stat* stat) {
@@ -80,20 +116,7 @@ long libos_syscall_lstat(const char* file, struct stat* stat) {
     if (!is_user_memory_writable(stat, sizeof(*stat)))
         return -EFAULT;
 
-    int ret;
-    struct libos_dentry* dent = NULL;
-
-    lock(&g_dcache_lock);
-    ret = path_lookupat(/*start=*/NULL, file, LOOKUP_NO_FOLLOW, &dent);
-    if (ret < 0)
-        goto out;
-
-    ret = do_stat(dent, stat);
-out:
-    unlock(&g_dcache_lock);
-    if (dent)
-        put_dentry(dent);
-    return ret;
+    return do_stat_path(/*start=*/NULL, file, LOOKUP_NO_FOLLOW, stat);
 }
 
 long libos_syscall_fstat(int fd, struct stat* stat) {
@@ -276,18 +299,7 @@ long libos_syscall_newfstatat(int dirfd, const char* pathname, struct stat* stat
             return ret;
     }
 
-    lock(&g_dcache_lock);
-
-    struct libos_dentry* dent = NULL;
-    ret = path_lookupat(dir, pathname, lookup_flags, &dent);
-    if (ret < 0)
-        goto out;
-
-    ret = do_stat(dent, statbuf);
-out:
-    unlock(&g_dcache_lock);
-    if (dent)
-        put_dentry(dent);
+    ret = do_stat_path(dir, pathname, lookup_flags, statbuf);
     if (dir)
         put_dentry(dir);
     return ret;
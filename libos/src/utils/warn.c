@@ -47,6 +47,7 @@ int print_warnings_on_insecure_configs(bool is_initial_process) {
     bool disable_aslr         = false;
     bool allow_eventfd        = false;
     bool experimental_flock   = false;
+    bool experimental_lazy_mmap = false;
     bool allow_all_files      = false;
     bool use_allowed_files    = warn_about_allowed_files_usage();
     bool encrypted_files_keys = warn_about_fs_insecure_keys();
@@ -91,6 +92,11 @@ int print_warnings_on_insecure_configs(bool is_initial_process) {
     if (ret < 0)
         goto out;
 
+    ret = toml_bool_in(g_pal_public_state->manifest_root, "fs.experimental__enable_lazy_mmap",
+                       /*defaultval=*/false, &experimental_lazy_mmap);
+    if (ret < 0)
+        goto out;
+
     ret = toml_string_in(g_pal_public_state->manifest_root, "sgx.file_check_policy",
                          &file_check_policy_str);
     if (ret < 0)
@@ -105,8 +111,8 @@ int print_warnings_on_insecure_configs(bool is_initial_process) {
         goto out;
 
     if (!verbose_log_level && !sgx_debug && !use_cmdline_argv && !use_host_env && !disable_aslr &&
-            !allow_eventfd && !experimental_flock && !allow_all_files && !use_allowed_files &&
-            !encrypted_files_keys && !memfaults_without_exinfo_allowed) {
+            !allow_eventfd && !experimental_flock && !experimental_lazy_mmap && !allow_all_files &&
+            !use_allowed_files && !encrypted_files_keys && !memfaults_without_exinfo_allowed) {
         /* there are no insecure configurations, skip printing */
         ret = 0;
         goto out;
@@ -144,6 +150,11 @@ int print_warnings_on_insecure_configs(bool is_initial_process) {
         log_always("  - sys.experimental__enable_flock = true      "
                    "(flock syscall is enabled; still under development and may contain bugs)");
 
+    if (experimental_lazy_mmap)
+        log_always("  - fs.experimental__enable_lazy_mmap = true   "
+                   "(lazy file mappings are enabled; still under development and may contain "
+                   "bugs)");
+
     if (memfaults_without_exinfo_allowed)
         log_always("  - sgx.insecure__allow_memfaults_without_exinfo "
                    "(allow memory faults even when SGX EXINFO is not supported by CPU)");
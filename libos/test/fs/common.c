@@ -99,6 +99,57 @@ void sendfile_fd(const char* input_path, const char* output_path, int fi, int fo
     }
 }
 
+void copy_file_range_fd(const char* input_path, const char* output_path, int fi, int fo,
+                        size_t size) {
+    while (size > 0) {
+        ssize_t ret = copy_file_range(fi, /*off_in=*/NULL, fo, /*off_out=*/NULL, size,
+                                      /*flags=*/0);
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            fatal_error("Failed to copy_file_range from %s to %s: %s\n", input_path, output_path,
+                        strerror(errno));
+        }
+        if (ret == 0)
+            fatal_error("Unexpected end of file %s\n", input_path);
+        size -= ret;
+    }
+}
+
+/* Copies the data through a pipe, in chunks which fit into the pipe buffer. */
+void splice_fd(const char* input_path, const char* output_path, int fi, int fo, size_t size) {
+    int pipefds[2];
+    if (pipe(pipefds) < 0)
+        fatal_error("Failed to create pipe: %s\n", strerror(errno));
+
+    while (size > 0) {
+        ssize_t in_pipe = splice(fi, /*off_in=*/NULL, pipefds[1], /*off_out=*/NULL,
+                                 size < 4096 ? size : 4096, /*flags=*/0);
+        if (in_pipe < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            fatal_error("Failed to splice from %s: %s\n", input_path, strerror(errno));
+        }
+        if (in_pipe == 0)
+            fatal_error("Unexpected end of file %s\n", input_path);
+        size -= in_pipe;
+
+        while (in_pipe > 0) {
+            ssize_t ret = splice(pipefds[0], /*off_in=*/NULL, fo, /*off_out=*/NULL, in_pipe,
+                                 /*flags=*/0);
+            if (ret < 0) {
+                if (errno == EAGAIN || errno == EINTR)
+                    continue;
+                fatal_error("Failed to splice to %s: %s\n", output_path, strerror(errno));
+            }
+            in_pipe -= ret;
+        }
+    }
+
+    close_fd("pipe", pipefds[0]);
+    close_fd("pipe", pipefds[1]);
+}
+
 void close_fd(const char* path, int fd) {
     if (fd >= 0 && close(fd) != 0)
         fatal_error("Failed to close file %s: %s\n", path, strerror(errno));
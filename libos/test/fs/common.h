@@ -41,6 +41,9 @@ int open_output_fd(const char* path, bool rdwr);
 int open_output_fd_append(const char* path);
 void write_fd(const char* path, int fd, const void* buffer, size_t size);
 void sendfile_fd(const char* input_path, const char* output_path, int fi, int fo, size_t size);
+void copy_file_range_fd(const char* input_path, const char* output_path, int fi, int fo,
+                        size_t size);
+void splice_fd(const char* input_path, const char* output_path, int fi, int fo, size_t size);
 void close_fd(const char* path, int fd);
 void* mmap_fd(const char* path, int fd, int protection, size_t offset, size_t size);
 void munmap_fd(const char* path, void* address, size_t size);
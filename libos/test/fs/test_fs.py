@@ -290,6 +290,10 @@ class TC_00_FileSystem(RegressionTestCase):
                 self.assertIn('write_fd(' + size + ') output OK', stdout)
             if executable == 'copy_sendfile':
                 self.assertIn('sendfile_fd(' + size + ') OK', stdout)
+            if executable == 'copy_file_range':
+                self.assertIn('copy_file_range_fd(' + size + ') OK', stdout)
+            if executable == 'copy_splice':
+                self.assertIn('splice_fd(' + size + ') OK', stdout)
             if size != '0':
                 if 'copy_mmap' in executable:
                     self.assertIn('mmap_fd(' + size + ') input OK', stdout)
@@ -331,6 +335,12 @@ class TC_00_FileSystem(RegressionTestCase):
     def test_206_copy_dir_mmap_rev(self):
         self.do_copy_test('copy_mmap_rev', 60)
 
+    def test_207_copy_dir_file_range(self):
+        self.do_copy_test('copy_file_range', 60)
+
+    def test_208_copy_dir_splice(self):
+        self.do_copy_test('copy_splice', 60)
+
     def test_210_copy_dir_mounted(self):
         executable = 'copy_whole'
         stdout, stderr = self.run_binary([executable, '/mounted/input', '/mounted/output'],
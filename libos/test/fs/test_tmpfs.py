@@ -98,6 +98,15 @@ class TC_10_Tmpfs(test_fs.TC_00_FileSystem):
     def test_140_file_truncate(self):
         test_fs.TC_00_FileSystem.test_140_file_truncate(self)
 
+    def test_150_write_bench(self):
+        append_path = os.path.join(self.OUTPUT_DIR, 'test_150a') # new files to be created
+        sparse_path = os.path.join(self.OUTPUT_DIR, 'test_150b')
+        stdout, stderr = self.run_binary(['write_bench', append_path, sparse_path])
+        self.assertNotIn('ERROR: ', stderr)
+        self.assertIn('append(' + append_path + ') OK', stdout)
+        self.assertIn('random_writes(' + sparse_path + ') OK', stdout)
+        self.assertIn('truncate(' + sparse_path + ') OK', stdout)
+
     # overrides TC_00_FileSystem to skip verification by python
     def verify_copy_content(self, input_path, output_path):
         pass
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of small appends and of random writes to a large sparse file. The file contents
+ * (including the holes, which must read as zeros) are verified after writing and after truncating
+ * the file and extending it again. The test only prints the measured times, it never fails because
+ * of them.
+ */
+
+#include "common.h"
+
+#define BLOCK_SIZE    4096
+#define APPEND_SIZE   1000
+#define APPEND_COUNT  8192
+#define SPARSE_BLOCKS 16384 /* 64MB */
+#define RANDOM_WRITES 1024
+#define READ_SIZE     (1024 * 1024)
+
+static bool g_written[SPARSE_BLOCKS];
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+        fatal_error("clock_gettime failed: %s\n", strerror(errno));
+    return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static char block_byte(size_t block) {
+    return (char)(block % 255 + 1);
+}
+
+static void pwrite_fd(const char* path, int fd, const void* buffer, size_t size, off_t offset) {
+    ssize_t ret = pwrite(fd, buffer, size, offset);
+    if (ret < 0)
+        fatal_error("Failed to write file %s: %s\n", path, strerror(errno));
+    if ((size_t)ret != size)
+        fatal_error("Short write to file %s\n", path);
+}
+
+static void check_size(const char* path, int fd, off_t expected) {
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+        fatal_error("Failed to fstat file %s: %s\n", path, strerror(errno));
+    if (st.st_size != expected)
+        fatal_error("File size is wrong (expected %jd got %jd)\n", (intmax_t)expected,
+                    (intmax_t)st.st_size);
+}
+
+static void append(const char* path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+    if (fd < 0)
+        fatal_error("Failed to open file %s: %s\n", path, strerror(errno));
+
+    char buf[APPEND_SIZE];
+    uint64_t start = now_us();
+    for (size_t i = 0; i < APPEND_COUNT; i++) {
+        memset(buf, (char)i, sizeof(buf));
+        write_fd(path, fd, buf, sizeof(buf));
+    }
+    printf("append(%s): %d x %d bytes: %lu us\n", path, APPEND_COUNT, APPEND_SIZE,
+           now_us() - start);
+    check_size(path, fd, (off_t)APPEND_COUNT * APPEND_SIZE);
+    close_fd(path, fd);
+
+    fd = open_input_fd(path);
+    for (size_t i = 0; i < APPEND_COUNT; i++) {
+        read_fd(path, fd, buf, sizeof(buf));
+        for (size_t j = 0; j < sizeof(buf); j++)
+            if (buf[j] != (char)i)
+                fatal_error("Wrong contents of append %zu\n", i);
+    }
+    close_fd(path, fd);
+    printf("append(%s) OK\n", path);
+}
+
+/* Checks that the first `blocks` blocks of the file contain the written blocks and zeros. */
+static void verify_sparse(const char* path, int fd, size_t blocks, char* buf) {
+    for (size_t offset = 0; offset < blocks * BLOCK_SIZE; offset += READ_SIZE) {
+        seek_fd(path, fd, offset, SEEK_SET);
+        read_fd(path, fd, buf, READ_SIZE);
+        for (size_t i = 0; i < READ_SIZE; i++) {
+            size_t block = (offset + i) / BLOCK_SIZE;
+            char expected = g_written[block] ? block_byte(block) : 0;
+            if (buf[i] != expected)
+                fatal_error("Wrong contents at offset %zu\n", offset + i);
+        }
+    }
+}
+
+static void random_writes(const char* path) {
+    int fd = open_output_fd(path, /*rdwr=*/true);
+    char* buf = alloc_buffer(READ_SIZE);
+
+    /* the last block is always written, so that the file size is known */
+    uint64_t start = now_us();
+    for (size_t i = 0; i < RANDOM_WRITES; i++) {
+        size_t block = i == 0 ? SPARSE_BLOCKS - 1 : (size_t)rand() % SPARSE_BLOCKS;
+        memset(buf, block_byte(block), BLOCK_SIZE);
+        pwrite_fd(path, fd, buf, BLOCK_SIZE, (off_t)block * BLOCK_SIZE);
+        g_written[block] = true;
+    }
+    printf("random_writes(%s): %d x %d bytes: %lu us\n", path, RANDOM_WRITES, BLOCK_SIZE,
+           now_us() - start);
+    check_size(path, fd, (off_t)SPARSE_BLOCKS * BLOCK_SIZE);
+    verify_sparse(path, fd, SPARSE_BLOCKS, buf);
+    printf("random_writes(%s) OK\n", path);
+
+    /* truncate in the middle of a block, then extend the file: the rest must read as zeros */
+    size_t half = SPARSE_BLOCKS / 2;
+    memset(buf, block_byte(half), BLOCK_SIZE);
+    pwrite_fd(path, fd, buf, BLOCK_SIZE, (off_t)half * BLOCK_SIZE);
+    g_written[half] = true;
+    if (ftruncate(fd, (off_t)half * BLOCK_SIZE + BLOCK_SIZE / 2) < 0)
+        fatal_error("Failed to ftruncate file %s: %s\n", path, strerror(errno));
+    if (ftruncate(fd, (off_t)SPARSE_BLOCKS * BLOCK_SIZE) < 0)
+        fatal_error("Failed to ftruncate file %s: %s\n", path, strerror(errno));
+
+    for (size_t block = half + 1; block < SPARSE_BLOCKS; block++)
+        g_written[block] = false;
+    verify_sparse(path, fd, half, buf);
+    seek_fd(path, fd, (off_t)half * BLOCK_SIZE, SEEK_SET);
+    read_fd(path, fd, buf, READ_SIZE);
+    for (size_t i = 0; i < READ_SIZE; i++) {
+        char expected = i < BLOCK_SIZE / 2 ? block_byte(half) : 0;
+        if (buf[i] != expected)
+            fatal_error("Wrong contents at offset %zu after truncate\n", half * BLOCK_SIZE + i);
+    }
+    printf("truncate(%s) OK\n", path);
+
+    free(buf);
+    close_fd(path, fd);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3)
+        fatal_error("Usage: %s <append_path> <sparse_path>\n", argv[0]);
+
+    setup();
+    append(argv[1]);
+    random_writes(argv[2]);
+    return 0;
+}
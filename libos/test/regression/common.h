@@ -8,6 +8,8 @@
 
 #include <assert.h>
 #include <err.h>
+#include <stdint.h>
+#include <time.h>
 
 #define OVERFLOWS(type, val)                        \
     ({                                              \
@@ -39,3 +41,14 @@
 #define WRITE_ONCE(x, y) do { *(volatile __typeof__(x)*)&(x) = (y); } while (0)
 
 #define COMPILER_BARRIER() ({ __asm__ __volatile__("" ::: "memory"); })
+
+/* Monotonic time for benchmarks, in nanoseconds and in microseconds */
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    CHECK(clock_gettime(CLOCK_MONOTONIC, &ts));
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static inline uint64_t now_us(void) {
+    return now_ns() / 1000;
+}
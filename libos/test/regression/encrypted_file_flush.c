@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of flush (`fsync()`) latency of an encrypted file vs. the number of dirty 4KB blocks,
+ * both for contiguous dirty blocks (coalesced into large writes) and for scattered ones. The file
+ * contents are verified after all flushes, after reopening the file.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE   "tmp_enc/encrypted_file_flush"
+#define BLOCK_SIZE  4096
+#define FILE_BLOCKS 1024
+#define ITERATIONS  20
+
+/* the dirty set is bounded by the cache of protected files (48 nodes, including MHT nodes) */
+static const size_t g_dirty_blocks[] = {1, 4, 16, 32};
+
+static char g_expected[FILE_BLOCKS * BLOCK_SIZE];
+
+static void write_block(int fd, size_t block, char c) {
+    memset(&g_expected[block * BLOCK_SIZE], c, BLOCK_SIZE);
+    ssize_t n = CHECK(pwrite(fd, &g_expected[block * BLOCK_SIZE], BLOCK_SIZE, block * BLOCK_SIZE));
+    if (n != BLOCK_SIZE)
+        errx(1, "short write");
+}
+
+static void run(int fd, size_t dirty_blocks, bool scattered) {
+    uint64_t total_ns = 0;
+    for (size_t iter = 0; iter < ITERATIONS; iter++) {
+        for (size_t i = 0; i < dirty_blocks; i++) {
+            /* scattered blocks are spread over the whole file, each in a separate run of nodes */
+            size_t block = scattered ? (i * FILE_BLOCKS / dirty_blocks + iter) % FILE_BLOCKS
+                                     : (iter * dirty_blocks + i) % FILE_BLOCKS;
+            write_block(fd, block, 'a' + (iter + i) % 26);
+        }
+
+        uint64_t start = now_ns();
+        CHECK(fsync(fd));
+        total_ns += now_ns() - start;
+    }
+    printf("dirty blocks: %2zu (%s), avg flush latency: %lu us\n", dirty_blocks,
+           scattered ? "scattered" : "contiguous", total_ns / ITERATIONS / 1000);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int fd = CHECK(open(TEST_FILE, O_CREAT | O_TRUNC | O_RDWR, 0600));
+    for (size_t block = 0; block < FILE_BLOCKS; block++)
+        write_block(fd, block, 'x');
+    CHECK(fsync(fd));
+
+    for (size_t i = 0; i < sizeof(g_dirty_blocks) / sizeof(g_dirty_blocks[0]); i++) {
+        run(fd, g_dirty_blocks[i], /*scattered=*/false);
+        run(fd, g_dirty_blocks[i], /*scattered=*/true);
+    }
+    CHECK(close(fd));
+
+    /* reopen to read the file from the host, not from the cache of protected files */
+    static char buf[FILE_BLOCKS * BLOCK_SIZE];
+    fd = CHECK(open(TEST_FILE, O_RDONLY));
+    size_t offset = 0;
+    while (offset < sizeof(buf)) {
+        ssize_t n = CHECK(read(fd, buf + offset, sizeof(buf) - offset));
+        if (n == 0)
+            errx(1, "unexpected EOF at offset %zu", offset);
+        offset += n;
+    }
+    if (memcmp(buf, g_expected, sizeof(buf)))
+        errx(1, "file contents differ after flushes");
+    CHECK(close(fd));
+
+    CHECK(unlink(TEST_FILE));
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of sequential and random reads of an encrypted file (mounted with a non-default node
+ * cache size, so that sequential reads use large read-ahead windows). The file contents are verified
+ * for all reads; reads at and across the end of file must not return data read ahead past it.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE   "tmp_enc/encrypted_file_read"
+#define BLOCK_SIZE  4096
+#define FILE_BLOCKS 4096 /* 16MB */
+#define ITERATIONS  4
+
+static char g_data[FILE_BLOCKS * BLOCK_SIZE];
+
+static void read_block(int fd, size_t block, size_t size) {
+    static char buf[BLOCK_SIZE * 16];
+    size_t offset = block * BLOCK_SIZE;
+    if (size > sizeof(g_data) - offset)
+        size = sizeof(g_data) - offset;
+
+    ssize_t n = CHECK(pread(fd, buf, size, offset));
+    if ((size_t)n != size)
+        errx(1, "short read at offset %zu", offset);
+    if (memcmp(buf, &g_data[offset], size))
+        errx(1, "wrong data read at offset %zu", offset);
+}
+
+static void run(int fd, size_t read_size, bool random) {
+    uint64_t start = now_ns();
+    for (size_t iter = 0; iter < ITERATIONS; iter++) {
+        for (size_t i = 0; i < FILE_BLOCKS; i += read_size / BLOCK_SIZE) {
+            /* Knuth's multiplicative hash permutes the blocks (FILE_BLOCKS is a power of two) */
+            size_t block = random ? (i * 2654435761UL) % FILE_BLOCKS : i;
+            read_block(fd, block, read_size);
+        }
+    }
+    uint64_t elapsed_us = (now_ns() - start) / 1000 ?: 1;
+    printf("%s reads of %5zu bytes: %lu MB/s\n", random ? "random" : "sequential", read_size,
+           sizeof(g_data) * ITERATIONS / elapsed_us);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    for (size_t i = 0; i < sizeof(g_data); i++)
+        g_data[i] = (char)(i * 13 + i / BLOCK_SIZE);
+
+    int fd = CHECK(open(TEST_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0600));
+    size_t offset = 0;
+    while (offset < sizeof(g_data)) {
+        ssize_t n = CHECK(write(fd, g_data + offset, sizeof(g_data) - offset));
+        offset += n;
+    }
+    CHECK(close(fd));
+
+    /* reopen to read the file from the host, not from the cache of protected files */
+    fd = CHECK(open(TEST_FILE, O_RDONLY));
+    run(fd, BLOCK_SIZE, /*random=*/false);
+    run(fd, BLOCK_SIZE, /*random=*/true);
+    run(fd, BLOCK_SIZE * 16, /*random=*/false);
+    run(fd, BLOCK_SIZE * 16, /*random=*/true);
+
+    char c;
+    if (CHECK(pread(fd, &c, sizeof(c), sizeof(g_data))) != 0)
+        errx(1, "read at the end of file returned data");
+    read_block(fd, FILE_BLOCKS - 1, BLOCK_SIZE * 16);
+    CHECK(close(fd));
+
+    CHECK(unlink(TEST_FILE));
+    puts("TEST OK");
+    return 0;
+}
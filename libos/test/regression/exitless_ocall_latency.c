@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Microbenchmark of OCALL round-trip latency vs. number of concurrent threads. Each thread issues
+ * many 1-byte `pread()`s on a host file, each of which results in one OCALL (serviced by RPC
+ * threads if Exitless is enabled). Every thread reads a different sequence of offsets of a file
+ * with distinct bytes and checks each byte, so a reply delivered to the wrong thread (or a request
+ * executed twice or not at all) fails the test.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE   "tmp/exitless_ocall_latency"
+#define FILE_SIZE   256
+#define ITERATIONS  10000
+#define MAX_THREADS 16
+
+struct thread_arg {
+    size_t idx;
+    uint64_t elapsed_ns;
+};
+
+static int g_fd;
+static pthread_barrier_t g_barrier;
+
+static void* thread_func(void* arg) {
+    struct thread_arg* thread_arg = arg;
+
+    int ret = pthread_barrier_wait(&g_barrier);
+    if (ret != 0 && ret != PTHREAD_BARRIER_SERIAL_THREAD)
+        errx(1, "pthread_barrier_wait failed");
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        /* the file contains bytes 0..255, so the byte read is equal to its offset */
+        size_t offset = (thread_arg->idx * 37 + i) % FILE_SIZE;
+        unsigned char c;
+        ssize_t n = CHECK(pread(g_fd, &c, sizeof(c), offset));
+        if (n != 1 || c != offset)
+            errx(1, "thread %zu: pread at offset %zu returned %zd bytes (byte %u)",
+                 thread_arg->idx, offset, n, c);
+    }
+    thread_arg->elapsed_ns = now_ns() - start;
+    return NULL;
+}
+
+static void run(size_t threads_cnt) {
+    pthread_t threads[MAX_THREADS];
+    struct thread_arg args[MAX_THREADS];
+
+    if (pthread_barrier_init(&g_barrier, NULL, threads_cnt) != 0)
+        errx(1, "pthread_barrier_init failed");
+
+    for (size_t i = 0; i < threads_cnt; i++) {
+        args[i].idx = i;
+        if (pthread_create(&threads[i], NULL, thread_func, &args[i]) != 0)
+            errx(1, "pthread_create failed");
+    }
+
+    uint64_t total_ns = 0;
+    for (size_t i = 0; i < threads_cnt; i++) {
+        if (pthread_join(threads[i], NULL) != 0)
+            errx(1, "pthread_join failed");
+        total_ns += args[i].elapsed_ns;
+    }
+
+    if (pthread_barrier_destroy(&g_barrier) != 0)
+        errx(1, "pthread_barrier_destroy failed");
+
+    printf("threads: %2zu, avg OCALL round-trip: %lu ns\n", threads_cnt,
+           total_ns / (threads_cnt * ITERATIONS));
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    unsigned char data[FILE_SIZE];
+    for (size_t i = 0; i < FILE_SIZE; i++)
+        data[i] = i;
+
+    g_fd = CHECK(open(TEST_FILE, O_CREAT | O_TRUNC | O_RDWR, 0600));
+    if (CHECK(write(g_fd, data, sizeof(data))) != sizeof(data))
+        errx(1, "short write");
+
+    for (size_t threads_cnt = 1; threads_cnt <= MAX_THREADS; threads_cnt *= 2)
+        run(threads_cnt);
+
+    CHECK(close(g_fd));
+    CHECK(unlink(TEST_FILE));
+    puts("TEST OK");
+    return 0;
+}
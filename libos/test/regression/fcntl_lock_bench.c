@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Throughput benchmark for POSIX locks (`fcntl(F_SETLK/F_SETLKW)`). All work is done in child
+ * processes, because only their lock requests go through IPC (the main process handles its locks
+ * locally). Two scenarios are run, first with one child process and then with many:
+ *
+ * - "private": each process repeatedly locks and unlocks its own file (uncontended),
+ * - "shared": all processes increment a counter stored in a single file, under a write lock
+ *   (contended). The final value of the counter is checked.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_DIR "tmp"
+#define SHARED_FILE TEST_DIR "/lock_bench_shared"
+
+static unsigned int g_iterations = 10000;
+static unsigned int g_procs_cnt = 4;
+
+static void lock_range(int fd, int cmd, short type, off_t start, off_t len) {
+    struct flock fl = {
+        .l_type = type,
+        .l_whence = SEEK_SET,
+        .l_start = start,
+        .l_len = len,
+    };
+    CHECK(fcntl(fd, cmd, &fl));
+}
+
+static void private_worker(unsigned int idx) {
+    char path[64];
+    snprintf(path, sizeof(path), TEST_DIR "/lock_bench_%u", idx);
+
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    for (unsigned int i = 0; i < g_iterations; i++) {
+        /* Nobody else uses the file, so `F_SETLK` should never fail with EAGAIN */
+        lock_range(fd, F_SETLK, F_WRLCK, 0, 0);
+        lock_range(fd, F_SETLK, F_UNLCK, 0, 0);
+    }
+    CHECK(close(fd));
+    CHECK(unlink(path));
+}
+
+static void shared_worker(unsigned int idx) {
+    (void)idx;
+
+    int fd = CHECK(open(SHARED_FILE, O_RDWR));
+    for (unsigned int i = 0; i < g_iterations; i++) {
+        lock_range(fd, F_SETLKW, F_WRLCK, 0, sizeof(uint32_t));
+
+        uint32_t counter;
+        if (CHECK(pread(fd, &counter, sizeof(counter), 0)) != sizeof(counter))
+            errx(1, "short read from " SHARED_FILE);
+        counter++;
+        if (CHECK(pwrite(fd, &counter, sizeof(counter), 0)) != sizeof(counter))
+            errx(1, "short write to " SHARED_FILE);
+
+        lock_range(fd, F_SETLK, F_UNLCK, 0, sizeof(uint32_t));
+    }
+    CHECK(close(fd));
+}
+
+static void run_workers(const char* name, unsigned int procs_cnt,
+                        void (*worker)(unsigned int idx)) {
+    uint64_t start = now_us();
+    for (unsigned int i = 0; i < procs_cnt; i++) {
+        pid_t pid = CHECK(fork());
+        if (pid == 0) {
+            worker(i);
+            exit(0);
+        }
+    }
+
+    for (unsigned int i = 0; i < procs_cnt; i++) {
+        int status = 0;
+        CHECK(wait(&status));
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            errx(1, "child died with status: %#x", status);
+    }
+    printf("%s, %u process(es): %u lock/unlock pairs per process: %lu us\n", name, procs_cnt,
+           g_iterations, now_us() - start);
+}
+
+static void run_shared(unsigned int procs_cnt) {
+    int fd = CHECK(open(SHARED_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    uint32_t counter = 0;
+    if (CHECK(pwrite(fd, &counter, sizeof(counter), 0)) != sizeof(counter))
+        errx(1, "short write to " SHARED_FILE);
+
+    run_workers("shared", procs_cnt, shared_worker);
+
+    if (CHECK(pread(fd, &counter, sizeof(counter), 0)) != sizeof(counter))
+        errx(1, "short read from " SHARED_FILE);
+    if (counter != procs_cnt * g_iterations)
+        errx(1, "wrong counter value: expected %u, got %u", procs_cnt * g_iterations, counter);
+
+    CHECK(close(fd));
+    CHECK(unlink(SHARED_FILE));
+}
+
+int main(int argc, char* argv[]) {
+    setbuf(stdout, NULL);
+
+    if (argc > 1)
+        g_iterations = atoi(argv[1]);
+    if (argc > 2)
+        g_procs_cnt = atoi(argv[2]);
+
+    run_workers("private", 1, private_worker);
+    run_workers("private", g_procs_cnt, private_worker);
+
+    run_shared(1);
+    run_shared(g_procs_cnt);
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,225 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Test and benchmark of the page cache of chroot files. The manifest mounts the `tmp` directory
+ * twice: as `/cached` with the page cache enabled (`cache_size` mount parameter), and as the
+ * default `tmp` directory without it. Small sequential and random reads and writes are timed on
+ * both mounts; the data is checked against an in-memory copy, and after the file is closed it must
+ * also be visible through the uncached mount. Also checks that the data is written back for
+ * `fsync()`, `O_DSYNC` and `fork()`, and that `ftruncate()` drops the cached data.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define CACHED_DIR   "/cached"
+#define UNCACHED_DIR "tmp"
+
+#define FILE_SIZE  (1024 * 1024)
+#define RANDOM_OPS 20000
+
+static const size_t g_io_sizes[] = {64, 512, 4096};
+
+static char g_expected[FILE_SIZE];
+static char g_buf[FILE_SIZE];
+static unsigned int g_file_cnt;
+
+/* returns a new file name, so that each test starts without any cached state */
+static void new_file_name(char* name, size_t size) {
+    snprintf(name, size, "file_page_cache_%u", g_file_cnt++);
+}
+
+static void fill_random(char* buf, size_t size) {
+    for (size_t i = 0; i < size; i++)
+        buf[i] = rand();
+}
+
+static void check_contents(int fd, const char* expected, size_t size) {
+    ssize_t n = CHECK(pread(fd, g_buf, sizeof(g_buf), 0));
+    if ((size_t)n != size)
+        errx(1, "wrong file size: expected %zu, got %zd", size, n);
+    if (memcmp(g_buf, expected, size))
+        errx(1, "wrong file contents");
+}
+
+static void check_file(const char* dir, const char* name, const char* expected, size_t size) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = CHECK(open(path, O_RDONLY));
+    check_contents(fd, expected, size);
+    CHECK(close(fd));
+}
+
+static void remove_file(const char* name) {
+    char path[128];
+    snprintf(path, sizeof(path), UNCACHED_DIR "/%s", name);
+    CHECK(unlink(path));
+}
+
+static void bench(const char* dir, size_t io_size) {
+    char name[64];
+    new_file_name(name, sizeof(name));
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    fill_random(g_expected, sizeof(g_expected));
+
+    uint64_t start = now_us();
+    for (size_t off = 0; off < FILE_SIZE; off += io_size)
+        if (CHECK(write(fd, &g_expected[off], io_size)) != (ssize_t)io_size)
+            errx(1, "short write");
+    uint64_t seq_write_us = now_us() - start;
+
+    CHECK(lseek(fd, 0, SEEK_SET));
+    start = now_us();
+    for (size_t off = 0; off < FILE_SIZE; off += io_size) {
+        if (CHECK(read(fd, &g_buf[off], io_size)) != (ssize_t)io_size)
+            errx(1, "short read");
+    }
+    uint64_t seq_read_us = now_us() - start;
+    if (memcmp(g_buf, g_expected, FILE_SIZE))
+        errx(1, "sequentially read data differs");
+
+    start = now_us();
+    for (size_t i = 0; i < RANDOM_OPS; i++) {
+        size_t off = (size_t)rand() % (FILE_SIZE - io_size + 1);
+        if (i % 2) {
+            fill_random(&g_expected[off], io_size);
+            if (CHECK(pwrite(fd, &g_expected[off], io_size, off)) != (ssize_t)io_size)
+                errx(1, "short write");
+        } else {
+            char buf[4096];
+            if (CHECK(pread(fd, buf, io_size, off)) != (ssize_t)io_size)
+                errx(1, "short read");
+            if (memcmp(buf, &g_expected[off], io_size))
+                errx(1, "randomly read data differs at offset %zu", off);
+        }
+    }
+    uint64_t random_us = now_us() - start;
+
+    CHECK(close(fd));
+    check_file(UNCACHED_DIR, name, g_expected, FILE_SIZE);
+    remove_file(name);
+
+    printf("%s, I/O size %zu: seq write %lu us, seq read %lu us, %u random r/w %lu us\n", dir,
+           io_size, seq_write_us, seq_read_us, RANDOM_OPS, random_us);
+}
+
+static void test_fsync(void) {
+    char name[64];
+    new_file_name(name, sizeof(name));
+    char path[128];
+    snprintf(path, sizeof(path), CACHED_DIR "/%s", name);
+
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    fill_random(g_expected, 10000);
+    for (size_t off = 0; off < 10000; off += 100)
+        if (CHECK(write(fd, &g_expected[off], 100)) != 100)
+            errx(1, "short write");
+    CHECK(fsync(fd));
+
+    /* the file is still open, but the data must already be in the host file */
+    check_file(UNCACHED_DIR, name, g_expected, 10000);
+    CHECK(close(fd));
+    remove_file(name);
+}
+
+static void test_dsync(void) {
+    char name[64];
+    new_file_name(name, sizeof(name));
+    char path[128];
+    snprintf(path, sizeof(path), CACHED_DIR "/%s", name);
+
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC | O_DSYNC, 0600));
+    fill_random(g_expected, 5000);
+    for (size_t off = 0; off < 5000; off += 50)
+        if (CHECK(write(fd, &g_expected[off], 50)) != 50)
+            errx(1, "short write");
+
+    /* no `fsync()` needed with `O_DSYNC` */
+    check_file(UNCACHED_DIR, name, g_expected, 5000);
+    check_contents(fd, g_expected, 5000);
+    CHECK(close(fd));
+    remove_file(name);
+}
+
+static void test_fork(void) {
+    char name[64];
+    new_file_name(name, sizeof(name));
+    char path[128];
+    snprintf(path, sizeof(path), CACHED_DIR "/%s", name);
+
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    fill_random(g_expected, 20000);
+    for (size_t off = 0; off < 20000; off += 200)
+        if (CHECK(write(fd, &g_expected[off], 200)) != 200)
+            errx(1, "short write");
+
+    pid_t pid = CHECK(fork());
+    if (pid == 0) {
+        /* the inherited file descriptor, and a new one, must see the parent's writes */
+        check_contents(fd, g_expected, 20000);
+        check_file(CACHED_DIR, name, g_expected, 20000);
+        exit(0);
+    }
+
+    int status = 0;
+    CHECK(waitpid(pid, &status, 0));
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        errx(1, "child died with status: %#x", status);
+
+    CHECK(close(fd));
+    remove_file(name);
+}
+
+static void test_truncate(void) {
+    char name[64];
+    new_file_name(name, sizeof(name));
+    char path[128];
+    snprintf(path, sizeof(path), CACHED_DIR "/%s", name);
+
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    fill_random(g_expected, 10000);
+    if (CHECK(write(fd, g_expected, 10000)) != 10000)
+        errx(1, "short write");
+
+    CHECK(ftruncate(fd, 5000));
+    CHECK(ftruncate(fd, 9000));
+    memset(&g_expected[5000], 0, 4000);
+    check_contents(fd, g_expected, 9000);
+
+    CHECK(close(fd));
+    check_file(UNCACHED_DIR, name, g_expected, 9000);
+    remove_file(name);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+    srand(42);
+
+    for (size_t i = 0; i < ARRAY_LEN(g_io_sizes); i++) {
+        bench(UNCACHED_DIR, g_io_sizes[i]);
+        bench(CACHED_DIR, g_io_sizes[i]);
+    }
+
+    test_fsync();
+    test_dsync();
+    test_fork();
+    test_truncate();
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of large sequential file reads, with different read sizes. The manifest enables
+ * `sgx.zero_copy_file_reads`, so on SGX the file is read through its mapping in untrusted memory.
+ * The read data is verified, including reads crossing the boundaries of mapped windows, the
+ * short read at the end of file and random reads (which are not served from the mapping).
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE  "tmp/file_read_throughput"
+/* not a multiple of page size, to test the partial page at the end of file */
+#define FILE_SIZE  (64 * 1024 * 1024 + 123)
+#define ITERATIONS 4
+#define RANDOM_READS 1000
+
+static const size_t g_read_sizes[] = {4096, 16 * 1024, 256 * 1024, 1024 * 1024, 3 * 1000 * 1000};
+
+static char g_expected[FILE_SIZE];
+
+static void run(size_t read_size, char* buf) {
+    int fd = CHECK(open(TEST_FILE, O_RDONLY));
+
+    uint64_t start = now_ns();
+    for (size_t iter = 0; iter < ITERATIONS; iter++) {
+        size_t offset = 0;
+        while (true) {
+            ssize_t n = CHECK(pread(fd, buf, read_size, offset));
+            if (n == 0)
+                break;
+            size_t expected_n = FILE_SIZE - offset < read_size ? FILE_SIZE - offset : read_size;
+            if ((size_t)n != expected_n)
+                errx(1, "unexpected short read at offset %zu: %zd", offset, n);
+            if (memcmp(buf, &g_expected[offset], n))
+                errx(1, "read data differs at offset %zu (read size %zu)", offset, read_size);
+            offset += n;
+        }
+        if (offset != FILE_SIZE)
+            errx(1, "read %zu bytes instead of %d", offset, FILE_SIZE);
+    }
+    uint64_t elapsed_ns = now_ns() - start;
+
+    CHECK(close(fd));
+
+    printf("read size: %7zu, throughput: %lu MB/s\n", read_size,
+           (uint64_t)FILE_SIZE * ITERATIONS * 1000 / elapsed_ns);
+}
+
+static void run_random(char* buf) {
+    int fd = CHECK(open(TEST_FILE, O_RDONLY));
+
+    for (size_t i = 0; i < RANDOM_READS; i++) {
+        size_t read_size = g_read_sizes[i % ARRAY_LEN(g_read_sizes)];
+        size_t offset = (size_t)rand() % FILE_SIZE;
+        size_t expected_n = FILE_SIZE - offset < read_size ? FILE_SIZE - offset : read_size;
+        ssize_t n = CHECK(pread(fd, buf, read_size, offset));
+        if ((size_t)n != expected_n)
+            errx(1, "unexpected short random read at offset %zu: %zd", offset, n);
+        if (memcmp(buf, &g_expected[offset], n))
+            errx(1, "randomly read data differs at offset %zu (read size %zu)", offset, read_size);
+    }
+
+    CHECK(close(fd));
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    for (size_t i = 0; i < FILE_SIZE; i++)
+        g_expected[i] = (char)(i * 7 + i / 4096);
+
+    int fd = CHECK(open(TEST_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0600));
+    size_t written = 0;
+    while (written < FILE_SIZE) {
+        ssize_t n = CHECK(write(fd, &g_expected[written], FILE_SIZE - written));
+        written += n;
+    }
+    CHECK(close(fd));
+
+    size_t max_read_size = g_read_sizes[ARRAY_LEN(g_read_sizes) - 1];
+    char* buf = malloc(max_read_size);
+    if (!buf)
+        errx(1, "malloc failed");
+
+    for (size_t i = 0; i < ARRAY_LEN(g_read_sizes); i++)
+        run(g_read_sizes[i], buf);
+    run_random(buf);
+
+    free(buf);
+    CHECK(unlink(TEST_FILE));
+    puts("TEST OK");
+    return 0;
+}
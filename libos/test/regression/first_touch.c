@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of the first touch of lazily allocated (`MAP_NORESERVE`) memory, which on SGX with EDMM
+ * commits the pages to the enclave on page faults. The pages of a new mapping are touched in
+ * ascending order, in descending order (like a growing stack) and in random order. The manifest
+ * `first_touch_no_fault_around` disables the EDMM fault-around (`sgx.edmm_fault_around_size`), to
+ * compare against committing a single page per fault.
+ *
+ * The test checks that the touched memory reads as zeros and keeps the written values.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define MAPPING_SIZE (64 * 1024 * 1024)
+
+static size_t g_page_size;
+static size_t g_order[MAPPING_SIZE / 4096];
+
+static void run(const char* name, size_t pages_cnt) {
+    char* addr = mmap(NULL, pages_cnt * g_page_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+
+    uint64_t start = now_us();
+    for (size_t i = 0; i < pages_cnt; i++) {
+        char* page = addr + g_order[i] * g_page_size;
+        if (page[0] != 0 || page[g_page_size - 1] != 0)
+            errx(1, "lazily allocated page at %p is not zeroed", page);
+        page[0] = 1;
+    }
+    uint64_t time_us = now_us() - start;
+
+    for (size_t i = 0; i < pages_cnt; i++)
+        if (addr[i * g_page_size] != 1)
+            errx(1, "write to page at %p was lost", addr + i * g_page_size);
+    CHECK(munmap(addr, pages_cnt * g_page_size));
+
+    printf("%s touch of %zu pages: %lu us (%lu MB/s)\n", name, pages_cnt, time_us,
+           time_us ? pages_cnt * g_page_size / time_us : 0);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+    srand(42);
+
+    g_page_size = getpagesize();
+    size_t pages_cnt = MAPPING_SIZE / g_page_size;
+    if (pages_cnt > ARRAY_LEN(g_order))
+        errx(1, "unexpected page size %zu", g_page_size);
+
+    for (size_t i = 0; i < pages_cnt; i++)
+        g_order[i] = i;
+    run("ascending", pages_cnt);
+
+    for (size_t i = 0; i < pages_cnt; i++)
+        g_order[i] = pages_cnt - 1 - i;
+    run("descending", pages_cnt);
+
+    for (size_t i = pages_cnt - 1; i > 0; i--) {
+        size_t j = (size_t)rand() % (i + 1);
+        size_t tmp = g_order[i];
+        g_order[i] = g_order[j];
+        g_order[j] = tmp;
+    }
+    run("random", pages_cnt);
+
+    puts("TEST OK");
+    return 0;
+}
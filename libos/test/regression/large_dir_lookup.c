@@ -0,0 +1,136 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Path walk benchmark for large directories: creates many files in a single directory (on the host
+ * and on tmpfs), then times lookups of existing and non-existing files in it. Checks the results
+ * of all lookups, and that `readdir` lists exactly the created files after the failed lookups.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define LOOKUP_ROUNDS 3
+
+static const char* g_dirs[] = {
+    "tmp/large_dir_lookup",
+    "/mnt/tmpfs/large_dir_lookup",
+};
+
+static unsigned int g_files_cnt = 20000;
+static unsigned char* g_seen;
+
+static void file_path(char* buf, size_t size, const char* dir, const char* prefix,
+                      unsigned int i) {
+    int n = snprintf(buf, size, "%s/%s%08u", dir, prefix, i);
+    if (n < 0 || (size_t)n >= size)
+        errx(1, "path too long");
+}
+
+static void check_readdir(const char* dir_path) {
+    memset(g_seen, 0, g_files_cnt);
+
+    DIR* dir = opendir(dir_path);
+    if (!dir)
+        err(1, "opendir %s", dir_path);
+
+    unsigned int count = 0;
+    while (1) {
+        errno = 0;
+        struct dirent* dent = readdir(dir);
+        if (!dent) {
+            if (errno)
+                err(1, "readdir %s", dir_path);
+            break;
+        }
+        if (!strcmp(dent->d_name, ".") || !strcmp(dent->d_name, ".."))
+            continue;
+
+        unsigned int i;
+        if (sscanf(dent->d_name, "file%08u", &i) != 1 || i >= g_files_cnt)
+            errx(1, "unexpected file in %s: %s", dir_path, dent->d_name);
+        if (g_seen[i])
+            errx(1, "file listed twice in %s: %s", dir_path, dent->d_name);
+        g_seen[i] = 1;
+        count++;
+    }
+    CHECK(closedir(dir));
+
+    if (count != g_files_cnt)
+        errx(1, "readdir %s: expected %u files, got %u", dir_path, g_files_cnt, count);
+}
+
+static void run_test(const char* dir) {
+    char path[256];
+    struct stat st;
+
+    CHECK(mkdir(dir, 0700));
+
+    uint64_t start = now_us();
+    for (unsigned int i = 0; i < g_files_cnt; i++) {
+        file_path(path, sizeof(path), dir, "file", i);
+        int fd = CHECK(open(path, O_CREAT | O_EXCL | O_WRONLY, 0600));
+        CHECK(close(fd));
+    }
+    printf("%s: create %u files: %lu us\n", dir, g_files_cnt, now_us() - start);
+
+    start = now_us();
+    for (unsigned int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (unsigned int i = 0; i < g_files_cnt; i++) {
+            /* visit the files in a different order than they were created */
+            file_path(path, sizeof(path), dir, "file", (i * 7919 + round) % g_files_cnt);
+            CHECK(stat(path, &st));
+        }
+    }
+    printf("%s: %u lookups of existing files: %lu us\n", dir, LOOKUP_ROUNDS * g_files_cnt,
+           now_us() - start);
+
+    start = now_us();
+    for (unsigned int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (unsigned int i = 0; i < g_files_cnt; i++) {
+            file_path(path, sizeof(path), dir, "missing", round * g_files_cnt + i);
+            if (stat(path, &st) == 0 || errno != ENOENT)
+                errx(1, "stat of missing file %s did not fail with ENOENT", path);
+        }
+    }
+    printf("%s: %u lookups of missing files: %lu us\n", dir, LOOKUP_ROUNDS * g_files_cnt,
+           now_us() - start);
+
+    check_readdir(dir);
+
+    for (unsigned int i = 0; i < g_files_cnt; i++) {
+        file_path(path, sizeof(path), dir, "file", i);
+        CHECK(unlink(path));
+    }
+    CHECK(rmdir(dir));
+}
+
+int main(int argc, char* argv[]) {
+    setbuf(stdout, NULL);
+
+    if (argc > 1)
+        g_files_cnt = atoi(argv[1]);
+
+    g_seen = malloc(g_files_cnt);
+    if (!g_seen)
+        err(1, "malloc");
+
+    for (size_t i = 0; i < sizeof(g_dirs) / sizeof(g_dirs[0]); i++)
+        run_test(g_dirs[i]);
+
+    free(g_seen);
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Sparse accesses to large file mappings, with lazy population of file mappings enabled in the
+ * manifest (each test is run on a host file and on a tmpfs file). Checks the contents of populated
+ * pages, that `msync` of a shared mapping writes back modified pages (and does not overwrite file
+ * contents written with `pwrite` in the meantime), that writes to a private mapping are not visible
+ * in the file, that lazily mapped memory can be used as a syscall buffer, and that two threads
+ * touching the same pages for the first time at once both see the file contents. Sparse accesses
+ * are timed with and without MAP_POPULATE.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define PAGE_SIZE     4096
+#define FILE_PAGES    8192 /* 32MB */
+#define SPARSE_STRIDE 512  /* pages between sparse accesses */
+#define RACE_PAGES    1024 /* pages touched concurrently by two threads */
+
+static const char* g_paths[] = {
+    "tmp/lazy_mmap_testfile",
+    "/mnt/tmpfs/lazy_mmap_testfile",
+};
+
+static char g_page[PAGE_SIZE];
+
+static char page_byte(size_t page) {
+    return (char)(page * 7 + 1);
+}
+
+static void check_page(const char* page_addr, char expected, const char* what, size_t page) {
+    for (size_t i = 0; i < PAGE_SIZE; i++)
+        if (page_addr[i] != expected)
+            errx(1, "%s: wrong contents of page %zu", what, page);
+}
+
+static void pread_page(int fd, size_t page) {
+    ssize_t n = CHECK(pread(fd, g_page, PAGE_SIZE, page * PAGE_SIZE));
+    if (n != PAGE_SIZE)
+        errx(1, "short read of page %zu", page);
+}
+
+static void pwrite_page(int fd, size_t page, char c) {
+    memset(g_page, c, PAGE_SIZE);
+    ssize_t n = CHECK(pwrite(fd, g_page, PAGE_SIZE, page * PAGE_SIZE));
+    if (n != PAGE_SIZE)
+        errx(1, "short write of page %zu", page);
+}
+
+static void sparse_access(int fd, int extra_flags, const char* name) {
+    uint64_t start = now_ns();
+    char* addr = mmap(NULL, FILE_PAGES * PAGE_SIZE, PROT_READ, MAP_PRIVATE | extra_flags, fd, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+    for (size_t page = 0; page < FILE_PAGES; page += SPARSE_STRIDE)
+        check_page(addr + page * PAGE_SIZE, page_byte(page), name, page);
+    CHECK(munmap(addr, FILE_PAGES * PAGE_SIZE));
+    printf("%s: sparse access to %d pages: %lu us\n", name, FILE_PAGES / SPARSE_STRIDE,
+           (now_ns() - start) / 1000);
+}
+
+static void test_shared(int fd) {
+    char* addr = mmap(NULL, FILE_PAGES * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+
+    /* read (populate) a page, then change it in the file: the mapping must see the new contents */
+    check_page(addr + 60 * PAGE_SIZE, page_byte(60), "shared read", 60);
+    pwrite_page(fd, 60, 'p');
+    check_page(addr + 60 * PAGE_SIZE, 'p', "shared read after pwrite", 60);
+
+    /* write through the mapping to a non-populated page, a populated page and a run of pages */
+    check_page(addr + 100 * PAGE_SIZE, page_byte(100), "shared read", 100);
+    memset(addr + 3 * PAGE_SIZE, 'a', PAGE_SIZE);
+    memset(addr + 100 * PAGE_SIZE, 'b', 3 * PAGE_SIZE);
+    CHECK(msync(addr, FILE_PAGES * PAGE_SIZE, MS_SYNC));
+
+    pread_page(fd, 3);
+    check_page(g_page, 'a', "file after msync", 3);
+    for (size_t page = 100; page < 103; page++) {
+        pread_page(fd, page);
+        check_page(g_page, 'b', "file after msync", page);
+    }
+    pread_page(fd, 60);
+    check_page(g_page, 'p', "file after msync", 60);
+    pread_page(fd, 4);
+    check_page(g_page, page_byte(4), "file after msync", 4);
+
+    /* a page written back before must be written back again after it is modified */
+    memset(addr + 3 * PAGE_SIZE, 'c', PAGE_SIZE);
+    CHECK(munmap(addr, FILE_PAGES * PAGE_SIZE));
+    pread_page(fd, 3);
+    check_page(g_page, 'c', "file after munmap", 3);
+}
+
+static void test_private(int fd) {
+    char* addr = mmap(NULL, FILE_PAGES * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+
+    memset(addr + 5 * PAGE_SIZE, 'x', PAGE_SIZE);
+    check_page(addr + 5 * PAGE_SIZE, 'x', "private write", 5);
+    pread_page(fd, 5);
+    check_page(g_page, page_byte(5), "file after private write", 5);
+
+    /* lazily mapped memory as a syscall buffer, both for reading and for writing */
+    ssize_t n = CHECK(pread(fd, addr + 1000 * PAGE_SIZE, 2 * PAGE_SIZE, 7 * PAGE_SIZE));
+    if (n != 2 * PAGE_SIZE)
+        errx(1, "short read into mapping");
+    check_page(addr + 1000 * PAGE_SIZE, page_byte(7), "read into mapping", 1000);
+    check_page(addr + 1001 * PAGE_SIZE, page_byte(8), "read into mapping", 1001);
+
+    n = CHECK(pwrite(fd, addr + 2000 * PAGE_SIZE, PAGE_SIZE, 9 * PAGE_SIZE));
+    if (n != PAGE_SIZE)
+        errx(1, "short write from mapping");
+    pread_page(fd, 9);
+    check_page(g_page, page_byte(2000), "file after write from mapping", 9);
+
+    CHECK(munmap(addr, FILE_PAGES * PAGE_SIZE));
+}
+
+static pthread_barrier_t g_barrier;
+static char* g_race_addr;
+
+static void* race_thread(void* arg) {
+    int ret = pthread_barrier_wait(&g_barrier);
+    if (ret != 0 && ret != PTHREAD_BARRIER_SERIAL_THREAD)
+        errx(1, "pthread_barrier_wait: %d", ret);
+
+    /* the first thread checks each page from its first byte, the second from its last byte, to
+     * catch a page that is seen before it is filled completely */
+    bool backwards = (uintptr_t)arg;
+    for (size_t page = 0; page < RACE_PAGES; page++) {
+        const char* page_addr = g_race_addr + page * PAGE_SIZE;
+        for (size_t i = 0; i < PAGE_SIZE; i++) {
+            size_t off = backwards ? PAGE_SIZE - 1 - i : i;
+            if (page_addr[off] != page_byte(page))
+                errx(1, "concurrent first touch: wrong contents of page %zu", page);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_first_touch(int fd) {
+    g_race_addr = mmap(NULL, RACE_PAGES * PAGE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (g_race_addr == MAP_FAILED)
+        err(1, "mmap");
+
+    if ((errno = pthread_barrier_init(&g_barrier, NULL, 2)))
+        err(1, "pthread_barrier_init");
+    pthread_t threads[2];
+    for (size_t i = 0; i < 2; i++)
+        if ((errno = pthread_create(&threads[i], NULL, race_thread, (void*)i)))
+            err(1, "pthread_create");
+    for (size_t i = 0; i < 2; i++)
+        if ((errno = pthread_join(threads[i], NULL)))
+            err(1, "pthread_join");
+    CHECK(pthread_barrier_destroy(&g_barrier));
+
+    CHECK(munmap(g_race_addr, RACE_PAGES * PAGE_SIZE));
+}
+
+static void run_tests(const char* path) {
+    int fd = CHECK(open(path, O_RDWR | O_CREAT | O_TRUNC, 0600));
+    for (size_t page = 0; page < FILE_PAGES; page++)
+        pwrite_page(fd, page, page_byte(page));
+
+    sparse_access(fd, MAP_POPULATE, "MAP_POPULATE");
+    sparse_access(fd, /*extra_flags=*/0, "lazy");
+    test_concurrent_first_touch(fd);
+    test_private(fd);
+    test_shared(fd);
+
+    CHECK(close(fd));
+    CHECK(unlink(path));
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    for (size_t i = 0; i < sizeof(g_paths) / sizeof(g_paths[0]); i++)
+        run_tests(g_paths[i]);
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Scaling benchmark for the LibOS-internal memory allocator: runs syscalls which allocate and free
+ * LibOS objects (`eventfd` + `close` allocate a handle, `epoll_ctl` adds and removes an epoll item)
+ * from 1, 2, 4, ..., 64 threads concurrently. Each thread checks that its eventfd counters and
+ * epoll events are not mixed up with other threads' objects, and no file descriptors may leak.
+ * When run in Gramine, also prints and parses `/proc/gramine/malloc`.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define MAX_THREADS 64
+#define ITERATIONS_PER_THREAD 10000
+
+static pthread_barrier_t g_barrier;
+
+static void barrier_wait(void) {
+    int ret = pthread_barrier_wait(&g_barrier);
+    if (ret != 0 && ret != PTHREAD_BARRIER_SERIAL_THREAD)
+        errx(1, "pthread_barrier_wait: %d", ret);
+}
+
+static void* thread_func(void* arg) {
+    uint64_t thread_idx = (uintptr_t)arg;
+
+    int epfd = CHECK(epoll_create1(0));
+    /* always readable, so that each epoll_wait() below reports it */
+    int watched_fd = CHECK(eventfd(1, 0));
+
+    barrier_wait();
+
+    for (uint64_t i = 0; i < ITERATIONS_PER_THREAD; i++) {
+        int fd = CHECK(eventfd(0, 0));
+        uint64_t val = thread_idx * ITERATIONS_PER_THREAD + i + 1;
+        if (CHECK(write(fd, &val, sizeof(val))) != sizeof(val))
+            errx(1, "short write to eventfd");
+        uint64_t read_val;
+        if (CHECK(read(fd, &read_val, sizeof(read_val))) != sizeof(read_val))
+            errx(1, "short read from eventfd");
+        if (read_val != val)
+            errx(1, "eventfd returned %lu instead of %lu", read_val, val);
+        CHECK(close(fd));
+
+        struct epoll_event event = { .events = EPOLLIN, .data.u64 = val };
+        CHECK(epoll_ctl(epfd, EPOLL_CTL_ADD, watched_fd, &event));
+        struct epoll_event ready_event;
+        if (CHECK(epoll_wait(epfd, &ready_event, 1, /*timeout=*/0)) != 1)
+            errx(1, "epoll_wait did not report the watched eventfd");
+        if (ready_event.data.u64 != val)
+            errx(1, "epoll_wait returned data %lu instead of %lu", ready_event.data.u64, val);
+        CHECK(epoll_ctl(epfd, EPOLL_CTL_DEL, watched_fd, NULL));
+    }
+
+    CHECK(close(watched_fd));
+    CHECK(close(epfd));
+    return NULL;
+}
+
+static void run_threads(unsigned int threads_cnt) {
+    pthread_t threads[MAX_THREADS];
+
+    if ((errno = pthread_barrier_init(&g_barrier, NULL, threads_cnt + 1)))
+        err(1, "pthread_barrier_init");
+
+    for (unsigned int i = 0; i < threads_cnt; i++)
+        if ((errno = pthread_create(&threads[i], NULL, thread_func, (void*)(uintptr_t)i)))
+            err(1, "pthread_create");
+
+    barrier_wait();
+
+    uint64_t start = now_us();
+    for (unsigned int i = 0; i < threads_cnt; i++)
+        if ((errno = pthread_join(threads[i], NULL)))
+            err(1, "pthread_join");
+    uint64_t time_us = now_us() - start;
+
+    CHECK(pthread_barrier_destroy(&g_barrier));
+
+    uint64_t iterations = (uint64_t)threads_cnt * ITERATIONS_PER_THREAD;
+    printf("%2u threads: %lu iterations: %lu us (%lu iterations/s)\n", threads_cnt, iterations,
+           time_us, time_us ? iterations * 1000000 / time_us : 0);
+}
+
+static void print_malloc_stats(void) {
+    int fd = open("/proc/gramine/malloc", O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT)
+            return; /* not running in Gramine */
+        err(1, "open");
+    }
+
+    char buf[4096];
+    ssize_t n = CHECK(read(fd, buf, sizeof(buf) - 1));
+    buf[n] = '\0';
+    CHECK(close(fd));
+    printf("%s", buf);
+
+    /* skip the header line, then each line is "obj_size allocs frees refills flushes" */
+    char* line = strchr(buf, '\n');
+    uint64_t total_allocs = 0;
+    while (line && *++line) {
+        unsigned long obj_size, allocs, frees, refills, flushes;
+        if (sscanf(line, "%lu %lu %lu %lu %lu", &obj_size, &allocs, &frees, &refills,
+                   &flushes) != 5)
+            errx(1, "cannot parse /proc/gramine/malloc line: %s", line);
+        total_allocs += allocs;
+        line = strchr(line, '\n');
+    }
+    if (!total_allocs)
+        errx(1, "/proc/gramine/malloc reports no allocations");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    /* the lowest free file descriptor must be the same after all runs */
+    int first_free_fd = CHECK(open("/dev/null", O_RDONLY));
+    CHECK(close(first_free_fd));
+
+    for (unsigned int threads_cnt = 1; threads_cnt <= MAX_THREADS; threads_cnt *= 2)
+        run_threads(threads_cnt);
+
+    int fd = CHECK(open("/dev/null", O_RDONLY));
+    CHECK(close(fd));
+    if (fd != first_free_fd)
+        errx(1, "file descriptors leaked (lowest free fd %d instead of %d)", fd, first_free_fd);
+
+    print_malloc_stats();
+
+    puts("TEST OK");
+    return 0;
+}
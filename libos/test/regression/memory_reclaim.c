@@ -0,0 +1,146 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Test of reclaiming freed memory. The manifest enables EDMM memory reclaim (if EDMM is enabled),
+ * so unmapped pages are kept committed and reused by new mappings. Checks that the reused pages
+ * are always zeroed and get the requested permissions (also in read-only, executable and
+ * `MAP_NORESERVE` mappings), that freed memory is eventually returned to the host (by reading
+ * `/proc/gramine/memory_reclaim`, which exists only when the reclaim is enabled) and that
+ * `madvise(MADV_FREE)` keeps the mapping usable.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define MAPPING_SIZE   (4 * 1024 * 1024)
+#define BIG_SIZE       (64 * 1024 * 1024)
+#define ITERATIONS     200
+#define RECLAIM_WAIT_S 10
+
+#define STATS_FILE "/proc/gramine/memory_reclaim"
+
+static size_t g_page_size;
+
+static void check_zeroed(const char* addr, size_t size) {
+    for (size_t off = 0; off < size; off += sizeof(uint64_t))
+        if (*(const uint64_t*)(addr + off))
+            errx(1, "reused memory at %p is not zeroed", addr + off);
+}
+
+/* returns false if the stats file does not exist (memory reclaim is not enabled) */
+static bool read_reclaimable_kb(unsigned long* out_kb) {
+    FILE* f = fopen(STATS_FILE, "r");
+    if (!f)
+        return false;
+
+    unsigned long reclaimable, recycled, reclaimed;
+    if (fscanf(f, "reclaimable: %lu kB recycled: %lu kB reclaimed: %lu kB", &reclaimable,
+               &recycled, &reclaimed) != 3)
+        errx(1, "cannot parse " STATS_FILE);
+    CHECK(fclose(f));
+
+    printf("reclaimable: %lu kB, recycled: %lu kB, reclaimed: %lu kB\n", reclaimable, recycled,
+           reclaimed);
+    *out_kb = reclaimable;
+    return true;
+}
+
+static void test_reuse(int prot, int extra_flags, const char* name) {
+    uint64_t start = now_us();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        char* addr = mmap(NULL, MAPPING_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+        if (addr == MAP_FAILED)
+            err(1, "mmap");
+        memset(addr, 0xab, MAPPING_SIZE);
+        CHECK(munmap(addr, MAPPING_SIZE));
+
+        addr = mmap(NULL, MAPPING_SIZE, prot, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+        if (addr == MAP_FAILED)
+            err(1, "mmap");
+        check_zeroed(addr, MAPPING_SIZE);
+        if (prot & PROT_EXEC) {
+            /* x86 `ret` instruction */
+            addr[0] = (char)0xc3;
+            ((void (*)(void))addr)();
+        }
+        CHECK(munmap(addr, MAPPING_SIZE));
+    }
+    uint64_t time_us = now_us() - start;
+
+    printf("%s: %u mmap/munmap pairs of %u kB: %lu us\n", name, 2 * ITERATIONS,
+           MAPPING_SIZE / 1024, time_us);
+}
+
+static void test_reclaim(void) {
+    char* addr = mmap(NULL, BIG_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+    memset(addr, 0xab, BIG_SIZE);
+    CHECK(munmap(addr, BIG_SIZE));
+
+    unsigned long reclaimable_kb;
+    if (!read_reclaimable_kb(&reclaimable_kb)) {
+        puts(STATS_FILE " does not exist, skipping the reclaim check");
+        return;
+    }
+
+    /* the reclaimer removes all freed pages after the application was idle for a while */
+    for (size_t i = 0; i < RECLAIM_WAIT_S; i++) {
+        if (!reclaimable_kb)
+            return;
+        sleep(1);
+        read_reclaimable_kb(&reclaimable_kb);
+    }
+    errx(1, "freed memory was not reclaimed in %d seconds", RECLAIM_WAIT_S);
+}
+
+static void test_madv_free(void) {
+    char* addr = mmap(NULL, MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+    memset(addr, 0xab, MAPPING_SIZE);
+
+    CHECK(madvise(addr, MAPPING_SIZE, MADV_FREE));
+
+    /* each page keeps its contents or is zeroed, and can be written again */
+    for (size_t off = 0; off < MAPPING_SIZE; off += g_page_size) {
+        if (addr[off] != (char)0xab && addr[off] != 0)
+            errx(1, "unexpected contents after MADV_FREE at %p", addr + off);
+        addr[off] = (char)(off / g_page_size);
+    }
+    for (size_t off = 0; off < MAPPING_SIZE; off += g_page_size)
+        if (addr[off] != (char)(off / g_page_size))
+            errx(1, "write after MADV_FREE was lost at %p", addr + off);
+
+    CHECK(munmap(addr, MAPPING_SIZE));
+    puts("MADV_FREE OK");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    g_page_size = getpagesize();
+
+    test_reuse(PROT_READ | PROT_WRITE, 0, "read-write");
+    test_reuse(PROT_READ, 0, "read-only");
+    test_reuse(PROT_READ | PROT_WRITE | PROT_EXEC, 0, "read-write-exec");
+    test_reuse(PROT_READ | PROT_WRITE, MAP_NORESERVE, "noreserve");
+    test_madv_free();
+    test_reclaim();
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of non-fixed `mmap` with many live mappings. The address space is fragmented into
+ * single-page mappings separated by single-page holes (by mapping a large region and unmapping
+ * every other page), so that none of the holes fits the mappings created afterwards. Then the
+ * time of `mmap`/`munmap` pairs is measured for 10k, 25k and 50k live mappings (the maximum can be
+ * changed with the first argument; note that with the Linux PAL each mapping is also a host
+ * mapping, limited by the host's `vm.max_map_count`).
+ *
+ * The test checks that the new mappings do not overlap the existing ones, are zero-filled, and that
+ * the existing mappings keep their contents.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define ITERATIONS 2000
+#define NEW_MAPPING_PAGES 16
+
+static size_t g_page_size;
+
+static void run(unsigned int mappings_cnt) {
+    size_t region_size = 2 * mappings_cnt * g_page_size;
+    char* region = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1, 0);
+    if (region == MAP_FAILED)
+        err(1, "mmap");
+
+    for (unsigned int i = 0; i < mappings_cnt; i++) {
+        char* page = region + 2 * i * g_page_size;
+        page[0] = (char)i;
+        CHECK(munmap(page + g_page_size, g_page_size));
+    }
+
+    size_t new_size = NEW_MAPPING_PAGES * g_page_size;
+    uint64_t start = now_us();
+    for (unsigned int i = 0; i < ITERATIONS; i++) {
+        char* addr = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1, 0);
+        if (addr == MAP_FAILED)
+            err(1, "mmap");
+        if (addr < region + region_size && region < addr + new_size)
+            errx(1, "new mapping %p overlaps the fragmented region %p-%p", addr, region,
+                 region + region_size);
+        for (size_t off = 0; off < new_size; off += g_page_size)
+            if (addr[off])
+                errx(1, "new mapping at %p is not zero-filled", addr + off);
+        memset(addr, 0xff, new_size);
+        CHECK(munmap(addr, new_size));
+    }
+    uint64_t time_us = now_us() - start;
+
+    for (unsigned int i = 0; i < mappings_cnt; i++) {
+        char* page = region + 2 * i * g_page_size;
+        if (page[0] != (char)i)
+            errx(1, "mapping at %p was corrupted", page);
+    }
+    CHECK(munmap(region, region_size));
+
+    printf("%u live mappings: %u mmap/munmap pairs: %lu us\n", mappings_cnt, ITERATIONS, time_us);
+}
+
+int main(int argc, char* argv[]) {
+    setbuf(stdout, NULL);
+
+    g_page_size = getpagesize();
+
+    unsigned int max_mappings = 50000;
+    if (argc > 1)
+        max_mappings = atoi(argv[1]);
+
+    for (unsigned int cnt = 10000; cnt <= max_mappings; cnt = cnt < 25000 ? cnt + 15000 : cnt * 2)
+        run(cnt);
+
+    puts("TEST OK");
+    return 0;
+}
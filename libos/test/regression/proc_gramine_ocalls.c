@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Checks that `/proc/gramine/ocalls` (only available on Linux-SGX) reports the OCALLs made by this
+ * process: pread() on a host file is expected to result in one PREAD OCALL per call.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE  "tmp/proc_gramine_ocalls"
+#define STATS_FILE "/proc/gramine/ocalls"
+#define READ_SIZE  4096
+#define ITERATIONS 100
+
+static char g_buf[READ_SIZE];
+
+int main(void) {
+    int fd = CHECK(open(TEST_FILE, O_CREAT | O_TRUNC | O_RDWR, 0600));
+    if (CHECK(pwrite(fd, g_buf, sizeof(g_buf), /*offset=*/0)) != sizeof(g_buf))
+        errx(1, "short write");
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+        if (CHECK(pread(fd, g_buf, sizeof(g_buf), /*offset=*/0)) != sizeof(g_buf))
+            errx(1, "short read");
+
+    CHECK(close(fd));
+    CHECK(unlink(TEST_FILE));
+
+    FILE* f = fopen(STATS_FILE, "r");
+    if (!f)
+        err(1, "fopen " STATS_FILE);
+
+    bool found = false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        fputs(line, stdout);
+
+        char name[32];
+        uint64_t calls, exitless_calls, cycles, max_cycles, bytes;
+        if (sscanf(line, "%31s %lu %lu %lu %lu %lu", name, &calls, &exitless_calls, &cycles,
+                   &max_cycles, &bytes) != 6 || strcmp(name, "pread"))
+            continue;
+
+        if (calls < ITERATIONS || bytes < ITERATIONS * READ_SIZE || exitless_calls > calls
+                || max_cycles > cycles)
+            errx(1, "unexpected pread stats");
+        found = true;
+    }
+    if (ferror(f))
+        errx(1, "reading " STATS_FILE " failed");
+    CHECK(fclose(f));
+
+    if (!found)
+        errx(1, "no pread stats in " STATS_FILE);
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Scaling benchmark for path lookups: runs `stat` (and `lstat`, `fstatat`) on already cached paths
+ * from 1, 2, 4, ..., 64 threads concurrently, and checks the results (file type and size of each
+ * path, and that a removed file is not found anymore).
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define MAX_THREADS 64
+#define LOOKUPS_PER_THREAD 20000
+
+#define TEST_DIR  "/mnt/tmpfs/stat_scaling"
+#define TEST_FILE TEST_DIR "/a/b/c/file"
+#define FILE_SIZE 1234
+
+/* mounted from the host, see the manifest */
+#define EXE_PATH "/stat_scaling"
+
+static pthread_barrier_t g_barrier;
+
+static void check_stat(const char* path, const struct stat* st, mode_t type, off_t size) {
+    if ((st->st_mode & S_IFMT) != type)
+        errx(1, "%s: wrong file type: 0%o", path, st->st_mode & S_IFMT);
+    if (size >= 0 && st->st_size != size)
+        errx(1, "%s: wrong size: %ld", path, (long)st->st_size);
+}
+
+static void* thread_func(void* arg) {
+    (void)arg;
+    struct stat st;
+
+    int ret = pthread_barrier_wait(&g_barrier);
+    if (ret != 0 && ret != PTHREAD_BARRIER_SERIAL_THREAD)
+        errx(1, "pthread_barrier_wait: %d", ret);
+
+    for (size_t i = 0; i < LOOKUPS_PER_THREAD; i++) {
+        switch (i % 4) {
+            case 0:
+                CHECK(stat(TEST_FILE, &st));
+                check_stat(TEST_FILE, &st, S_IFREG, FILE_SIZE);
+                break;
+            case 1:
+                CHECK(lstat(TEST_DIR "/a/b/../b/./c", &st));
+                check_stat(TEST_DIR "/a/b/c", &st, S_IFDIR, -1);
+                break;
+            case 2:
+                CHECK(fstatat(AT_FDCWD, TEST_DIR "/a/b/c/file", &st, AT_SYMLINK_NOFOLLOW));
+                check_stat(TEST_FILE, &st, S_IFREG, FILE_SIZE);
+                break;
+            case 3:
+                CHECK(stat(EXE_PATH, &st));
+                check_stat(EXE_PATH, &st, S_IFREG, -1);
+                break;
+        }
+    }
+    return NULL;
+}
+
+static void run_threads(unsigned int threads_cnt) {
+    pthread_t threads[MAX_THREADS];
+
+    if ((errno = pthread_barrier_init(&g_barrier, NULL, threads_cnt + 1)))
+        err(1, "pthread_barrier_init");
+
+    for (unsigned int i = 0; i < threads_cnt; i++)
+        if ((errno = pthread_create(&threads[i], NULL, thread_func, NULL)))
+            err(1, "pthread_create");
+
+    int ret = pthread_barrier_wait(&g_barrier);
+    if (ret != 0 && ret != PTHREAD_BARRIER_SERIAL_THREAD)
+        errx(1, "pthread_barrier_wait: %d", ret);
+
+    uint64_t start = now_us();
+    for (unsigned int i = 0; i < threads_cnt; i++)
+        if ((errno = pthread_join(threads[i], NULL)))
+            err(1, "pthread_join");
+    uint64_t time_us = now_us() - start;
+
+    CHECK(pthread_barrier_destroy(&g_barrier));
+
+    uint64_t lookups = (uint64_t)threads_cnt * LOOKUPS_PER_THREAD;
+    printf("%2u threads: %lu lookups: %lu us (%lu lookups/s)\n", threads_cnt, lookups, time_us,
+           time_us ? lookups * 1000000 / time_us : 0);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    CHECK(mkdir(TEST_DIR, 0700));
+    CHECK(mkdir(TEST_DIR "/a", 0700));
+    CHECK(mkdir(TEST_DIR "/a/b", 0700));
+    CHECK(mkdir(TEST_DIR "/a/b/c", 0700));
+    int fd = CHECK(open(TEST_FILE, O_CREAT | O_EXCL | O_WRONLY, 0600));
+    CHECK(ftruncate(fd, FILE_SIZE));
+    CHECK(close(fd));
+
+    for (unsigned int threads_cnt = 1; threads_cnt <= MAX_THREADS; threads_cnt *= 2)
+        run_threads(threads_cnt);
+
+    /* the cached paths must not outlive the files */
+    CHECK(unlink(TEST_FILE));
+    struct stat st;
+    if (stat(TEST_FILE, &st) == 0 || errno != ENOENT)
+        errx(1, "stat of removed file %s did not fail with ENOENT", TEST_FILE);
+
+    CHECK(rmdir(TEST_DIR "/a/b/c"));
+    CHECK(rmdir(TEST_DIR "/a/b"));
+    CHECK(rmdir(TEST_DIR "/a"));
+    CHECK(rmdir(TEST_DIR));
+
+    puts("TEST OK");
+    return 0;
+}
@@ -1,14 +1,18 @@
+import hashlib
 import os
 import re
 import shutil
 import signal
 import socket
 import subprocess
+import time
 import unittest
 
 import json
 import tomli
 
+from graminelibos.manifest import TRUSTED_CHUNK_SIZE, gen_merkle_tree
+
 from graminelibos.regression import (
     GDB_VERSION,
     HAS_AVX,
@@ -430,6 +434,29 @@ class TC_01_Bootstrap(RegressionTestCase):
         self.assertIn('FE_TOWARDZERO  child: 42.5 = 42.0, -42.5 = -42.0', stdout)
         self.assertIn('FE_TOWARDZERO parent: 42.5 = 42.0, -42.5 = -42.0', stdout)
 
+    @unittest.skipUnless(HAS_SGX, 'This test is only meaningful on SGX PAL')
+    def test_603_exitless_ocall_latency(self):
+        stdout, _ = self.run_binary(['exitless_ocall_latency'], timeout=60)
+        self.assertIn('threads: 16, avg OCALL round-trip:', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_604_file_read_throughput(self):
+        stdout, _ = self.run_binary(['file_read_throughput'], timeout=120)
+        self.assertIn('read size: 3000000, throughput:', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    @unittest.skipUnless(HAS_SGX, '/proc/gramine/ocalls is only available on SGX PAL')
+    def test_605_proc_gramine_ocalls(self):
+        stdout, _ = self.run_binary(['proc_gramine_ocalls'])
+        self.assertIn('pread', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_606_file_page_cache(self):
+        stdout, _ = self.run_binary(['file_page_cache'], timeout=120)
+        self.assertIn('/cached, I/O size 64: seq write', stdout)
+        self.assertIn('tmp, I/O size 4096: seq write', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_700_debug_log_inline(self):
         _, stderr = self.run_binary(['debug_log_inline'])
         self._verify_debug_log(stderr)
@@ -932,6 +959,44 @@ class TC_30_Syscall(RegressionTestCase):
         if not HAS_SGX or HAS_EDMM:
             self.assertIn('write to R mem got SIGSEGV', stdout)
 
+    def test_05C_vma_lookup_scaling(self):
+        stdout, _ = self.run_binary(['vma_lookup_scaling'], timeout=180)
+        self.assertIn('32 threads: ', stdout)
+        self.assertIn('32 threads with mmap churn: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_05D_mmap_throughput(self):
+        stdout, _ = self.run_binary(['mmap_throughput'], timeout=180)
+        self.assertIn('50000 live mappings: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_05E_malloc_scaling(self):
+        stdout, _ = self.run_binary(['malloc_scaling'], timeout=180)
+        self.assertIn('64 threads: ', stdout)
+        self.assertRegex(stdout, r'obj_size +allocs +frees +refills +flushes')
+        self.assertIn('TEST OK', stdout)
+
+    def test_05F_first_touch(self):
+        stdout, _ = self.run_binary(['first_touch'], timeout=180)
+        self.assertIn('ascending touch of ', stdout)
+        self.assertIn('random touch of ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_05F_first_touch_no_fault_around(self):
+        stdout, _ = self.run_binary(['first_touch_no_fault_around'], timeout=180)
+        self.assertIn('ascending touch of ', stdout)
+        self.assertIn('random touch of ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_05G_memory_reclaim(self):
+        stdout, _ = self.run_binary(['memory_reclaim'], timeout=180)
+        self.assertIn('read-write: ', stdout)
+        self.assertIn('read-only: ', stdout)
+        self.assertIn('read-write-exec: ', stdout)
+        self.assertIn('noreserve: ', stdout)
+        self.assertIn('MADV_FREE OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_060_sigaltstack(self):
         stdout, _ = self.run_binary(['sigaltstack'])
 
@@ -1053,6 +1118,12 @@ class TC_30_Syscall(RegressionTestCase):
                 os.remove('tmp_enc/lock_file')
         self.assertIn('TEST OK', stdout)
 
+    def test_112_fcntl_lock_bench(self):
+        stdout, _ = self.run_binary(['fcntl_lock_bench'], timeout=120)
+        self.assertIn('private, 1 process(es)', stdout)
+        self.assertIn('shared, 4 process(es)', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_120_gethostname_default(self):
         # The generic manifest (manifest.template) doesn't use extra runtime conf.
         stdout, _ = self.run_binary(['hostname', 'localhost'])
@@ -1389,6 +1460,84 @@ class TC_40_FileSystem(RegressionTestCase):
         stdout, _ = self.run_binary(['sealed_file_mod', pf_path, 'unlink'])
         self.assertIn('UNLINK OK', stdout)
 
+    def test_054_encrypted_file_flush(self):
+        os.makedirs('tmp_enc', exist_ok=True)
+        stdout, _ = self.run_binary(['encrypted_file_flush'], timeout=60)
+        self.assertIn('dirty blocks: 32 (scattered), avg flush latency: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_055_encrypted_file_read(self):
+        os.makedirs('tmp_enc', exist_ok=True)
+        stdout, _ = self.run_binary(['encrypted_file_read'], timeout=120)
+        self.assertIn('sequential reads of 65536 bytes: ', stdout)
+        self.assertIn('random reads of 65536 bytes: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_056_trusted_file_lazy(self):
+        # contents and hashes of the files are hard-coded in trusted_file_lazy.manifest.template
+        size = 32 * 1024 * 1024 + 1000
+        data = bytes(range(256)) * (size // 256) + bytes(range(size % 256))
+        chunk_hashes = [hashlib.sha256(data[i:i + TRUSTED_CHUNK_SIZE]).digest()
+                        for i in range(0, size, TRUSTED_CHUNK_SIZE)]
+        _, tree = gen_merkle_tree(chunk_hashes, size)
+
+        tampered = bytearray(data)
+        tampered[16 * 1024 * 1024 + 5] ^= 0xff
+
+        files = {
+            'trusted_file_lazy_flat': data,
+            'trusted_file_lazy_merkle': data,
+            'trusted_file_lazy_tampered': tampered,
+            'trusted_file_lazy.merkle': tree,
+        }
+        try:
+            for name, contents in files.items():
+                with open(name, 'wb') as f:
+                    f.write(contents)
+            stdout, _ = self.run_binary(['trusted_file_lazy'], timeout=120)
+        finally:
+            for name in files:
+                if os.path.exists(name):
+                    os.remove(name)
+        self.assertIn('trusted_file_lazy_merkle: time to first byte: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_057_trusted_files_index(self):
+        # contents of the file are hard-coded in trusted_files_index.manifest.template
+        with open('trusted_files_index_testfile', 'w') as f:
+            f.write('trusted_files_index_testfile')
+        # not listed in the manifest, opening it must fail
+        with open('trusted_files_index_untrusted', 'w') as f:
+            f.write('trusted_files_index_untrusted')
+        try:
+            for count in ('1k', '10k', '100k'):
+                start = time.monotonic()
+                stdout, _ = self.run_binary([f'trusted_files_index_{count}'], timeout=120)
+                elapsed = time.monotonic() - start
+                print(f'startup with {count} trusted files: {elapsed:.3f} s')
+                self.assertIn('first open of trusted file: ', stdout)
+                self.assertIn('TEST OK', stdout)
+        finally:
+            os.remove('trusted_files_index_testfile')
+            os.remove('trusted_files_index_untrusted')
+
+    def test_058_trusted_file_cache(self):
+        # contents of the file are hard-coded in trusted_file_cache.manifest.template
+        with open('trusted_file_cache_testfile', 'wb') as f:
+            f.write(bytes(range(256)) * 4096)
+        try:
+            stdout, _ = self.run_binary(['trusted_file_cache'], timeout=120)
+        finally:
+            os.remove('trusted_file_cache_testfile')
+        self.assertIn('hot region re-reads: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_059_lazy_mmap(self):
+        os.makedirs('tmp', exist_ok=True)
+        stdout, _ = self.run_binary(['lazy_mmap'], timeout=120)
+        self.assertIn('lazy: sparse access to 16 pages: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_060_synthetic(self):
         stdout, _ = self.run_binary(['synthetic'])
         self.assertIn("TEST OK", stdout)
@@ -1403,6 +1552,19 @@ class TC_40_FileSystem(RegressionTestCase):
         stdout, _ = self.run_binary(['close_range'])
         self.assertIn('TEST OK', stdout)
 
+    def test_090_large_dir_lookup(self):
+        os.makedirs('tmp', exist_ok=True)
+        if os.path.exists('tmp/large_dir_lookup'):
+            shutil.rmtree('tmp/large_dir_lookup')
+        stdout, _ = self.run_binary(['large_dir_lookup'], timeout=120)
+        self.assertIn('lookups of existing files: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_091_stat_scaling(self):
+        stdout, _ = self.run_binary(['stat_scaling'], timeout=120)
+        self.assertIn('64 threads: ', stdout)
+        self.assertIn('TEST OK', stdout)
+
 class TC_50_GDB(RegressionTestCase):
     def setUp(self):
         if not self.has_debug():
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Re-reads a hot region of a trusted file from several threads (each with its own handle), with
+ * the cache of verified chunks enabled in the manifest, then reads the whole file (larger than the
+ * cache). Verifies the contents of all reads and checks the cache statistics from
+ * `/proc/gramine/trusted_files_cache`: the hot region must be served from the cache, and the whole
+ * file read must evict chunks without exceeding the maximum cache size.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE    "trusted_file_cache_testfile"
+#define FILE_SIZE    (1024 * 1024) /* contents: bytes 0, 1, ..., 255 repeated */
+#define HOT_SIZE     (256 * 1024)  /* fits in the cache, see the manifest */
+#define READ_SIZE    5000          /* not a multiple of chunk size, to test partial chunks */
+#define THREADS_CNT  4
+#define ITERATIONS   50
+
+static char g_file_buf[FILE_SIZE];
+
+static void read_and_check(int fd, size_t offset, size_t size, char* buf) {
+    ssize_t n = CHECK(pread(fd, buf, size, offset));
+    if ((size_t)n != size)
+        errx(1, "short read at offset %zu", offset);
+    for (size_t i = 0; i < size; i++)
+        if ((unsigned char)buf[i] != (unsigned char)(offset + i))
+            errx(1, "wrong contents at offset %zu", offset + i);
+}
+
+static void* thread_func(void* arg) {
+    char buf[READ_SIZE];
+    int fd = CHECK(open(TEST_FILE, O_RDONLY));
+    for (size_t iter = 0; iter < ITERATIONS; iter++)
+        for (size_t offset = 0; offset + READ_SIZE <= HOT_SIZE; offset += READ_SIZE)
+            read_and_check(fd, offset, READ_SIZE, buf);
+    CHECK(close(fd));
+    return arg;
+}
+
+static void get_cache_stat(const char* name, uint64_t* out_val) {
+    char buf[256] = {0};
+    int fd = CHECK(open("/proc/gramine/trusted_files_cache", O_RDONLY));
+    CHECK(read(fd, buf, sizeof(buf) - 1));
+    CHECK(close(fd));
+
+    /* each line has the form "<name>: <value>" */
+    size_t name_len = strlen(name);
+    char* line = buf;
+    while (line) {
+        if (!strncmp(line, name, name_len) && line[name_len] == ':'
+                && sscanf(line + name_len + 1, "%lu", out_val) == 1)
+            return;
+        line = strchr(line, '\n');
+        if (line)
+            line++;
+    }
+    errx(1, "no '%s' in /proc/gramine/trusted_files_cache", name);
+}
+
+int main(void) {
+    pthread_t threads[THREADS_CNT];
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < THREADS_CNT; i++)
+        if ((errno = pthread_create(&threads[i], NULL, thread_func, NULL)))
+            err(1, "pthread_create");
+    for (size_t i = 0; i < THREADS_CNT; i++)
+        if ((errno = pthread_join(threads[i], NULL)))
+            err(1, "pthread_join");
+    printf("hot region re-reads: %lu us\n", (now_ns() - start) / 1000);
+
+    uint64_t hits;
+    get_cache_stat("hits", &hits);
+    if (!hits)
+        errx(1, "no hits in the cache of trusted files");
+
+    int fd = CHECK(open(TEST_FILE, O_RDONLY));
+    read_and_check(fd, 0, FILE_SIZE, g_file_buf);
+    CHECK(close(fd));
+
+    uint64_t evictions, size, max_size;
+    get_cache_stat("evictions", &evictions);
+    get_cache_stat("size", &size);
+    get_cache_stat("max_size", &max_size);
+    if (!evictions)
+        errx(1, "no evictions from the cache of trusted files");
+    if (size > max_size)
+        errx(1, "cache of trusted files exceeds its maximum size");
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Benchmark of opening a large trusted file and reading its first bytes, for a file verified as a
+ * whole on open (`_flat`) vs. a file with Merkle tree, verified lazily on reads (`_merkle`). Also
+ * checks that a tampered chunk of a file with Merkle tree is detected (only when it is read) and
+ * that the tree works in a forked child. The files are generated by the test runner (byte at
+ * offset `i` is `i % 256`).
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define FILE_SIZE       (32 * 1024 * 1024 + 1000)
+#define TAMPERED_OFFSET (16 * 1024 * 1024 + 5)
+#define BUF_SIZE        (64 * 1024)
+
+static uint8_t g_buf[BUF_SIZE];
+
+static void check_contents(const uint8_t* buf, size_t size, size_t offset) {
+    for (size_t i = 0; i < size; i++)
+        if (buf[i] != (uint8_t)(offset + i))
+            errx(1, "wrong data at offset %zu", offset + i);
+}
+
+static void read_and_check(int fd, size_t offset, size_t size) {
+    ssize_t n = CHECK(pread(fd, g_buf, size, offset));
+    if ((size_t)n != size)
+        errx(1, "short read at offset %zu", offset);
+    check_contents(g_buf, size, offset);
+}
+
+static void bench(const char* path) {
+    uint64_t start = now_us();
+    int fd = CHECK(open(path, O_RDONLY));
+    read_and_check(fd, /*offset=*/0, /*size=*/4096);
+    uint64_t first_byte_us = now_us() - start;
+
+    for (size_t offset = 0; offset < FILE_SIZE; offset += BUF_SIZE) {
+        size_t size = FILE_SIZE - offset < BUF_SIZE ? FILE_SIZE - offset : BUF_SIZE;
+        read_and_check(fd, offset, size);
+    }
+    uint64_t total_us = now_us() - start;
+
+    CHECK(close(fd));
+    printf("%s: time to first byte: %lu us, time to read whole file: %lu us\n", path,
+           first_byte_us, total_us);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    bench("trusted_file_lazy_flat");
+    bench("trusted_file_lazy_merkle");
+
+    /* tampered file can be opened, only reading the tampered chunk fails */
+    int fd = CHECK(open("trusted_file_lazy_tampered", O_RDONLY));
+    read_and_check(fd, /*offset=*/0, /*size=*/4096);
+    read_and_check(fd, /*offset=*/FILE_SIZE - 1000, /*size=*/1000);
+    ssize_t n = pread(fd, g_buf, 1, TAMPERED_OFFSET);
+    if (n != -1 || errno != EPERM)
+        errx(1, "reading tampered chunk did not fail with EPERM (returned %zd)", n);
+    CHECK(close(fd));
+
+    /* child verifies chunks that the parent hasn't read yet */
+    fd = CHECK(open("trusted_file_lazy_merkle", O_RDONLY));
+    read_and_check(fd, /*offset=*/0, /*size=*/4096);
+    pid_t pid = CHECK(fork());
+    if (pid == 0) {
+        read_and_check(fd, /*offset=*/20 * 1024 * 1024 + 3, /*size=*/BUF_SIZE);
+        exit(0);
+    }
+    int status;
+    CHECK(waitpid(pid, &status, 0));
+    if (!WIFEXITED(status) || WEXITSTATUS(status))
+        errx(1, "child failed (status %d)", status);
+    CHECK(close(fd));
+
+    puts("TEST OK");
+    return 0;
+}
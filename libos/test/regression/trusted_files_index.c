@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Used with manifests listing many trusted files (see `trusted_files_index_*.manifest.template`):
+ * reads the trusted file listed last in the manifest and measures the time of its first open,
+ * which includes the lookup of the file among trusted files. Startup time of Gramine is measured
+ * by the test runner. Also checks that the lookup rejects files which are not listed (created by
+ * the test runner), and does not confuse files listed with different names.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define TEST_FILE      "trusted_files_index_testfile"
+#define UNTRUSTED_FILE "trusted_files_index_untrusted"
+
+int main(void) {
+    char buf[sizeof(TEST_FILE)] = {0};
+
+    uint64_t start = now_ns();
+    int fd = CHECK(open(TEST_FILE, O_RDONLY));
+    uint64_t open_ns = now_ns() - start;
+
+    ssize_t n = CHECK(read(fd, buf, sizeof(buf) - 1));
+    if (n != sizeof(buf) - 1 || strcmp(buf, TEST_FILE))
+        errx(1, "wrong contents of " TEST_FILE);
+    CHECK(close(fd));
+
+    /* exists on the host, but is not listed in the manifest */
+    if (open(UNTRUSTED_FILE, O_RDONLY) != -1 || errno != EACCES)
+        errx(1, "opening a file which is not trusted did not fail with EACCES");
+
+    /* listed in the manifest, but does not exist on the host */
+    if (open("trusted_files_index/0", O_RDONLY) != -1 || errno != ENOENT)
+        errx(1, "opening a non-existing trusted file did not fail with ENOENT");
+
+    printf("first open of trusted file: %lu us\n", open_ns / 1000);
+    puts("TEST OK");
+    return 0;
+}
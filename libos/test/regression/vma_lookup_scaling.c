@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Scaling benchmark for VMA lookups: runs syscalls whose buffers are validated against the VMAs
+ * (`write` to /dev/null, `clock_gettime`) from 1, 2, 4, ..., 32 threads concurrently, first alone
+ * and then while another thread repeatedly maps and unmaps memory. The churning thread checks that
+ * each new mapping is zero-filled, and the syscalls must still reject unmapped buffers afterwards.
+ */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define MAX_THREADS 32
+#define SYSCALLS_PER_THREAD 20000
+#define CHURN_MAPPING_SIZE (64 * 1024)
+
+static pthread_barrier_t g_barrier;
+static int g_devnull_fd;
+static bool g_stop_churn;
+static uint64_t g_churn_cnt;
+
+static void barrier_wait(void) {
+    int ret = pthread_barrier_wait(&g_barrier);
+    if (ret != 0 && ret != PTHREAD_BARRIER_SERIAL_THREAD)
+        errx(1, "pthread_barrier_wait: %d", ret);
+}
+
+static void* reader_func(void* arg) {
+    (void)arg;
+    char buf[256];
+    memset(buf, 'a', sizeof(buf));
+
+    barrier_wait();
+
+    for (size_t i = 0; i < SYSCALLS_PER_THREAD; i++) {
+        if (i % 2) {
+            if (CHECK(write(g_devnull_fd, buf, sizeof(buf))) != sizeof(buf))
+                errx(1, "short write to /dev/null");
+        } else {
+            struct timespec ts;
+            CHECK(clock_gettime(CLOCK_MONOTONIC, &ts));
+        }
+    }
+    return NULL;
+}
+
+static void* churn_func(void* arg) {
+    (void)arg;
+
+    while (!__atomic_load_n(&g_stop_churn, __ATOMIC_RELAXED)) {
+        char* addr = mmap(NULL, CHURN_MAPPING_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+            err(1, "mmap");
+        if (addr[0] || addr[CHURN_MAPPING_SIZE - 1])
+            errx(1, "new mapping at %p is not zero-filled", addr);
+        addr[0] = 1;
+        CHECK(munmap(addr, CHURN_MAPPING_SIZE));
+        __atomic_add_fetch(&g_churn_cnt, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static void run_threads(unsigned int threads_cnt, bool churn) {
+    pthread_t threads[MAX_THREADS];
+    pthread_t churn_thread;
+
+    if ((errno = pthread_barrier_init(&g_barrier, NULL, threads_cnt + 1)))
+        err(1, "pthread_barrier_init");
+
+    __atomic_store_n(&g_stop_churn, false, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_churn_cnt, 0, __ATOMIC_RELAXED);
+    if (churn && (errno = pthread_create(&churn_thread, NULL, churn_func, NULL)))
+        err(1, "pthread_create");
+
+    for (unsigned int i = 0; i < threads_cnt; i++)
+        if ((errno = pthread_create(&threads[i], NULL, reader_func, NULL)))
+            err(1, "pthread_create");
+
+    barrier_wait();
+
+    uint64_t start = now_us();
+    for (unsigned int i = 0; i < threads_cnt; i++)
+        if ((errno = pthread_join(threads[i], NULL)))
+            err(1, "pthread_join");
+    uint64_t time_us = now_us() - start;
+
+    if (churn) {
+        __atomic_store_n(&g_stop_churn, true, __ATOMIC_RELAXED);
+        if ((errno = pthread_join(churn_thread, NULL)))
+            err(1, "pthread_join");
+    }
+
+    CHECK(pthread_barrier_destroy(&g_barrier));
+
+    uint64_t syscalls = (uint64_t)threads_cnt * SYSCALLS_PER_THREAD;
+    printf("%2u threads%s: %lu syscalls: %lu us (%lu syscalls/s)", threads_cnt,
+           churn ? " with mmap churn" : "", syscalls, time_us,
+           time_us ? syscalls * 1000000 / time_us : 0);
+    if (churn)
+        printf(", %lu mmap/munmap pairs", __atomic_load_n(&g_churn_cnt, __ATOMIC_RELAXED));
+    printf("\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    g_devnull_fd = CHECK(open("/dev/null", O_WRONLY));
+
+    for (unsigned int threads_cnt = 1; threads_cnt <= MAX_THREADS; threads_cnt *= 2)
+        run_threads(threads_cnt, /*churn=*/false);
+    for (unsigned int threads_cnt = 1; threads_cnt <= MAX_THREADS; threads_cnt *= 2)
+        run_threads(threads_cnt, /*churn=*/true);
+
+    /* invalid buffers must still be rejected */
+    char* addr = mmap(NULL, CHURN_MAPPING_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        err(1, "mmap");
+    CHECK(munmap(addr, CHURN_MAPPING_SIZE));
+    if (write(g_devnull_fd, addr, 16) != -1 || errno != EFAULT)
+        errx(1, "write from unmapped buffer did not fail with EFAULT");
+
+    CHECK(close(g_devnull_fd));
+    puts("TEST OK");
+    return 0;
+}
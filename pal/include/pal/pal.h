@@ -173,6 +173,15 @@ struct pal_public_state {
      */
     size_t alloc_align;
 
+    /*!
+     * \brief Whether memory protections are enforced.
+     *
+     * If true, accesses violating protections set with `PalVirtualMemoryAlloc()` and
+     * `PalVirtualMemoryProtect()` (in particular, any access to memory allocated with no
+     * permissions) raise `PAL_EVENT_MEMFAULT`. This is not the case e.g. on SGX without EDMM.
+     */
+    bool memory_protection_enforced;
+
     size_t mem_total;
 
     struct pal_cpu_info cpu_info;
@@ -247,19 +256,53 @@ int PalVirtualMemoryFree(void* addr, size_t size);
  */
 int PalVirtualMemoryProtect(void* addr, size_t size, pal_prot_flags_t prot);
 
+/*!
+ * \brief Wait for freed memory to reclaim and return it to the host.
+ *
+ * Some PALs do not return freed memory to the host immediately, but keep it for reuse by later
+ * allocations (currently Linux-SGX PAL with EDMM, if `sgx.edmm_reclaim_watermark` is set). This
+ * function blocks until such memory should be returned to the host (there is too much of it or it
+ * was not reused for some time), and returns it. It is meant to be called in a loop by a dedicated
+ * thread, which must not be an application thread.
+ *
+ * Other PALs return PAL_ERROR_NOTIMPLEMENTED.
+ */
+int PalVirtualMemoryReclaim(void);
+
+/*! Statistics of freed memory kept for reuse (see #PalVirtualMemoryReclaim) */
+struct pal_memory_reclaim_stats {
+    uint64_t reclaimable; /*!< size of freed memory currently kept */
+    uint64_t recycled;    /*!< total size of kept memory reused by later allocations */
+    uint64_t reclaimed;   /*!< total size of kept memory returned to the host */
+};
+
+/*!
+ * \brief Get statistics of freed memory kept for reuse.
+ *
+ * \param[out] stats  On success, filled with the statistics.
+ *
+ * Returns PAL_ERROR_NOTIMPLEMENTED if the PAL does not keep freed memory (see
+ * #PalVirtualMemoryReclaim).
+ */
+int PalVirtualMemoryReclaimStatsQuery(struct pal_memory_reclaim_stats* stats);
+
 /*!
  * \brief Set upcalls for memory bookkeeping
  *
  * \param alloc         Function to call to get a memory range.
  * \param free          Function to call to release the memory range.
- * \param get_vma_info  Function to call to get the VMA info (currently only PAL prot flags).
+ * \param get_vma_info  Function to call to get the VMA info: PAL prot flags of the address and the
+ *                      range `[*out_begin; *out_end)` around it in which all pages have the same
+ *                      prot flags (may be just the page of the address).
  *
  * Both \p alloc and \p free must be thread-safe.
  */
 void PalSetMemoryBookkeepingUpcalls(int (*alloc)(size_t size, uintptr_t* out_addr),
                                     int (*free)(uintptr_t addr, size_t size),
                                     int (*get_vma_info)(uintptr_t addr,
-                                                        pal_prot_flags_t* out_prot_flags));
+                                                        pal_prot_flags_t* out_prot_flags,
+                                                        uintptr_t* out_begin,
+                                                        uintptr_t* out_end));
 
 /*
  * PROCESS CREATION
@@ -403,6 +446,59 @@ int PalStreamRead(PAL_HANDLE handle, uint64_t offset, size_t* count, void* buffe
  */
 int PalStreamWrite(PAL_HANDLE handle, uint64_t offset, size_t* count, void* buffer);
 
+enum pal_batch_op_type {
+    PAL_BATCH_OP_READ,  /*!< same as #PalStreamRead */
+    PAL_BATCH_OP_WRITE, /*!< same as #PalStreamWrite */
+};
+
+struct pal_batch_op {
+    PAL_HANDLE handle;
+    enum pal_batch_op_type type;
+    uint64_t offset;
+    size_t count;  /*!< size of `buffer`; on success set to the number of bytes read/written */
+    void* buffer;
+    int result;    /*!< set to 0 on success, negative error code on failure */
+};
+
+/*!
+ * \brief Perform several independent reads/writes on open streams.
+ *
+ * \param[in,out] ops      Operations to perform.
+ * \param         ops_cnt  Number of operations in \p ops.
+ *
+ * \returns 0 if all operations were attempted (each operation reports its own result), negative
+ *          error code if \p ops is invalid.
+ *
+ * The semantics of each operation is the same as of the corresponding #PalStreamRead or
+ * #PalStreamWrite call, but the PAL is free to execute them in any order and to submit them to the
+ * host together (e.g. with a single enclave exit on Linux-SGX). Thus the operations must not
+ * depend on each other, in particular must not touch overlapping file ranges.
+ */
+int PalStreamBatch(struct pal_batch_op* ops, size_t ops_cnt);
+
+/*!
+ * \brief Transfer data from a file to another stream directly on the host.
+ *
+ * \param         src_handle  Handle to the file to read from.
+ * \param         src_offset  Offset in \p src_handle to read at.
+ * \param         dst_handle  Handle to the stream to write to.
+ * \param         dst_offset  Offset in \p dst_handle to write at (ignored if \p dst_handle is not a
+ *                            file).
+ * \param[in,out] count       Number of bytes to transfer. On success, will be set to the number of
+ *                            bytes transferred (0 if \p src_offset is at or past the end of file).
+ *
+ * \returns 0 on success, negative error code on failure. Returns PAL_ERROR_NOTSUPPORT (without any
+ *          side effects) if the data cannot be transferred between these handles; the caller should
+ *          then use #PalStreamRead and #PalStreamWrite.
+ *
+ * The data is never copied into PAL (e.g. it is moved by `sendfile` or `copy_file_range` on Linux),
+ * so this must be used only for data that needs no processing (encryption, integrity checks) in
+ * LibOS. Currently, transfers from seekable files to seekable files and to TCP sockets are
+ * supported (if supported by the host).
+ */
+int PalStreamTransfer(PAL_HANDLE src_handle, uint64_t src_offset, PAL_HANDLE dst_handle,
+                      uint64_t dst_offset, size_t* count);
+
 enum pal_delete_mode {
     PAL_DELETE_ALL,  /*!< delete the whole resource / shut down both directions */
     PAL_DELETE_READ,  /*!< shut down the read side only */
@@ -990,6 +1086,30 @@ int PalGetSpecialKey(const char* name, void* key, size_t* key_size);
 #define PAL_KEY_NAME_SGX_MRENCLAVE "_sgx_mrenclave"
 #define PAL_KEY_NAME_SGX_MRSIGNER  "_sgx_mrsigner"
 
+/*! Statistics of one type of calls to the host (e.g. one OCALL type in case of SGX PAL) */
+struct pal_host_call_stats {
+    char name[32];           /*!< name of the host call */
+    uint64_t calls;          /*!< number of calls */
+    uint64_t exitless_calls; /*!< number of calls serviced without leaving the TEE (if supported) */
+    uint64_t cycles;         /*!< total time spent on the host side, in TSC cycles */
+    uint64_t max_cycles;     /*!< time of the longest call, in TSC cycles */
+    uint64_t bytes;          /*!< number of bytes read or written by I/O calls */
+};
+
+/*!
+ * \brief Get statistics of calls to the host, summed up over all threads of the current process.
+ *
+ * \param[out]    stats      On success, filled with statistics of each type of host calls.
+ * \param[in,out] stats_cnt  Caller specifies the number of entries in `stats`. On success, will
+ *                           contain the number of filled entries.
+ *
+ * Currently implemented only for Linux-SGX PAL, where the statistics of OCALLs are collected by
+ * the untrusted runtime (so they cannot be trusted and are meant only for performance analysis).
+ * Other PALs return PAL_ERROR_NOTIMPLEMENTED. If `stats` is too small, PAL_ERROR_INVAL is returned
+ * and `stats_cnt` is set to the required number of entries.
+ */
+int PalHostCallStatsQuery(struct pal_host_call_stats* stats, size_t* stats_cnt);
+
 #ifdef __GNUC__
 #define symbol_version_default(real, name, version) \
     __asm__(".symver " #real "," #name "@@" #version "\n")
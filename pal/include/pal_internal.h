@@ -48,6 +48,15 @@ struct handle_ops {
     int64_t (*read)(PAL_HANDLE handle, uint64_t offset, uint64_t count, void* buffer);
     int64_t (*write)(PAL_HANDLE handle, uint64_t offset, uint64_t count, const void* buffer);
 
+    /* 'batch' is used by PalStreamBatch. It is optional and called for runs of consecutive
+     * operations on handles of the same type; it must set `result` (and `count`) of each of them */
+    void (*batch)(struct pal_batch_op* ops, size_t ops_cnt);
+
+    /* 'transfer' is used by PalStreamTransfer, and is called on the source handle. It is optional,
+     * and must return PAL_ERROR_NOTSUPPORT for destination handles it cannot transfer data to */
+    int64_t (*transfer)(PAL_HANDLE src_handle, uint64_t src_offset, PAL_HANDLE dst_handle,
+                        uint64_t dst_offset, uint64_t count);
+
     /* 'delete' is used by PalStreamDelete: for files and dirs it corresponds to unlinking, for
      * sockets it corresponds to shutting down a socket connection. */
     int (*delete)(PAL_HANDLE handle, enum pal_delete_mode delete_mode);
@@ -217,6 +226,8 @@ int _PalEventWait(PAL_HANDLE handle, uint64_t* timeout_us);
 int _PalVirtualMemoryAlloc(void* addr, uint64_t size, pal_prot_flags_t prot);
 int _PalVirtualMemoryFree(void* addr, uint64_t size);
 int _PalVirtualMemoryProtect(void* addr, uint64_t size, pal_prot_flags_t prot);
+int _PalVirtualMemoryReclaim(void);
+int _PalVirtualMemoryReclaimStatsQuery(struct pal_memory_reclaim_stats* stats);
 
 /* PalObject calls */
 void _PalObjectDestroy(PAL_HANDLE object_handle);
@@ -244,6 +255,7 @@ int _PalAttestationReport(const void* user_report_data, size_t* user_report_data
 int _PalAttestationQuote(const void* user_report_data, size_t user_report_data_size, void* quote,
                          size_t* quote_size);
 int _PalGetSpecialKey(const char* name, void* key, size_t* key_size);
+int _PalHostCallStatsQuery(struct pal_host_call_stats* stats, size_t* stats_cnt);
 
 #define INIT_FAIL(msg, ...)                                                              \
     do {                                                                                 \
@@ -314,7 +326,8 @@ const char* pal_event_name(enum pal_event event);
     } while (0)
 #include "uthash.h"
 
-extern int (*g_mem_bkeep_get_vma_info_upcall)(uintptr_t addr, pal_prot_flags_t* out_flags);
+extern int (*g_mem_bkeep_get_vma_info_upcall)(uintptr_t addr, pal_prot_flags_t* out_flags,
+                                              uintptr_t* out_begin, uintptr_t* out_end);
 
 void _PalGetLazyCommitPages(uintptr_t addr, size_t size, uint8_t* bitvector);
 int _PalFreeThenLazyReallocCommittedPages(void* addr, uint64_t size);
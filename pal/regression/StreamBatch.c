@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * Tests `PalStreamBatch()` on a regular file and compares the time of issuing many small writes one
+ * by one vs. in a single batch (on Linux-SGX the latter needs only one enclave exit). The timings
+ * are only printed, the test never fails because of them.
+ */
+
+#include "api.h"
+#include "pal.h"
+#include "pal_regression.h"
+
+#define FILE_URI    "file:stream_batch.tmp"
+#define CHUNK_SIZE  4096
+#define CHUNKS_CNT  32
+#define LARGE_SIZE  (1024 * 1024) /* doesn't fit on untrusted stack, must be executed on its own */
+#define ITERATIONS  100
+
+static char g_chunks[CHUNKS_CNT][CHUNK_SIZE];
+static char g_large[LARGE_SIZE];
+static char g_read_chunks[CHUNKS_CNT][CHUNK_SIZE];
+static char g_read_large[LARGE_SIZE];
+
+static struct pal_batch_op g_ops[CHUNKS_CNT + 2];
+
+static void prepare_ops(PAL_HANDLE handle, enum pal_batch_op_type type, char (*chunks)[CHUNK_SIZE],
+                        char* large) {
+    for (size_t i = 0; i < CHUNKS_CNT; i++) {
+        /* place chunks in reverse order to check that each operation uses its own offset */
+        g_ops[i] = (struct pal_batch_op){
+            .handle = handle,
+            .type   = type,
+            .offset = (CHUNKS_CNT - 1 - i) * CHUNK_SIZE,
+            .count  = CHUNK_SIZE,
+            .buffer = chunks[i],
+        };
+    }
+    g_ops[CHUNKS_CNT] = (struct pal_batch_op){
+        .handle = handle,
+        .type   = type,
+        .offset = CHUNKS_CNT * CHUNK_SIZE,
+        .count  = LARGE_SIZE,
+        .buffer = large,
+    };
+    /* invalid operation in the middle of a batch must not affect the other ones */
+    g_ops[CHUNKS_CNT + 1] = (struct pal_batch_op){
+        .handle = NULL,
+        .type   = type,
+        .count  = 1,
+        .buffer = large,
+    };
+}
+
+static void check_chunk_ops(const char* what) {
+    for (size_t i = 0; i < CHUNKS_CNT; i++)
+        if (g_ops[i].result < 0 || g_ops[i].count != CHUNK_SIZE)
+            FAIL("%s: chunk %lu failed: %d", what, i, g_ops[i].result);
+}
+
+static void check_ops(const char* what) {
+    check_chunk_ops(what);
+    if (g_ops[CHUNKS_CNT].result < 0 || g_ops[CHUNKS_CNT].count != LARGE_SIZE)
+        FAIL("%s: large op failed: %d", what, g_ops[CHUNKS_CNT].result);
+    if (g_ops[CHUNKS_CNT + 1].result != PAL_ERROR_INVAL)
+        FAIL("%s: invalid op returned %d", what, g_ops[CHUNKS_CNT + 1].result);
+}
+
+int main(int argc, char** argv, char** envp) {
+    PAL_HANDLE handle = NULL;
+    CHECK(PalStreamOpen(FILE_URI, PAL_ACCESS_RDWR, PAL_SHARE_OWNER_W | PAL_SHARE_OWNER_R,
+                        PAL_CREATE_ALWAYS, /*options=*/0, &handle));
+
+    for (size_t i = 0; i < CHUNKS_CNT; i++)
+        memset(g_chunks[i], 'a' + i % 26, CHUNK_SIZE);
+    memset(g_large, 'L', LARGE_SIZE);
+
+    prepare_ops(handle, PAL_BATCH_OP_WRITE, g_chunks, g_large);
+    CHECK(PalStreamBatch(g_ops, ARRAY_LEN(g_ops)));
+    check_ops("write");
+
+    prepare_ops(handle, PAL_BATCH_OP_READ, g_read_chunks, g_read_large);
+    CHECK(PalStreamBatch(g_ops, ARRAY_LEN(g_ops)));
+    check_ops("read");
+
+    if (memcmp(g_chunks, g_read_chunks, sizeof(g_chunks)) || memcmp(g_large, g_read_large,
+                                                                     sizeof(g_large)))
+        FAIL("read data differs from written data");
+
+    /* compare only small writes, which can all be batched together */
+    uint64_t start, end;
+    CHECK(PalSystemTimeQuery(&start));
+    for (size_t iter = 0; iter < ITERATIONS; iter++) {
+        for (size_t i = 0; i < CHUNKS_CNT; i++) {
+            size_t count = CHUNK_SIZE;
+            CHECK(PalStreamWrite(handle, i * CHUNK_SIZE, &count, g_chunks[i]));
+        }
+    }
+    CHECK(PalSystemTimeQuery(&end));
+    pal_printf("individual writes: %lu us\n", end - start);
+
+    prepare_ops(handle, PAL_BATCH_OP_WRITE, g_chunks, g_large);
+    CHECK(PalSystemTimeQuery(&start));
+    for (size_t iter = 0; iter < ITERATIONS; iter++)
+        CHECK(PalStreamBatch(g_ops, CHUNKS_CNT));
+    CHECK(PalSystemTimeQuery(&end));
+    pal_printf("batched writes: %lu us\n", end - start);
+    check_chunk_ops("batched write");
+
+    CHECK(PalStreamDelete(handle, PAL_DELETE_ALL));
+    PalObjectDestroy(handle);
+
+    pal_printf("TEST OK\n");
+    return 0;
+}
@@ -23,6 +23,8 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(PalStreamWaitForClient);
     PRINT_SYMBOL(PalStreamRead);
     PRINT_SYMBOL(PalStreamWrite);
+    PRINT_SYMBOL(PalStreamBatch);
+    PRINT_SYMBOL(PalStreamTransfer);
     PRINT_SYMBOL(PalStreamDelete);
     PRINT_SYMBOL(PalStreamSetLength);
     PRINT_SYMBOL(PalStreamFlush);
@@ -46,6 +46,8 @@ struct A {
     struct avl_tree_node node;
     int64_t key;
     bool freed;
+    /* Augmented data: number of nodes in the subtree rooted at this node. */
+    size_t subtree_size;
 };
 
 static struct A* node2struct(struct avl_tree_node* node) {
@@ -60,9 +62,17 @@ static bool cmp_gen(void* x, struct avl_tree_node* y) {
     return *(int64_t*)x <= node2struct(y)->key;
 }
 
+static size_t subtree_size(struct avl_tree_node* node) {
+    return node ? node2struct(node)->subtree_size : 0;
+}
+
+static void update(struct avl_tree_node* node) {
+    node2struct(node)->subtree_size = subtree_size(node->left) + 1 + subtree_size(node->right);
+}
+
 #define ELEMENTS_COUNT 0x1000
 #define RAND_DEL_COUNT 0x100
-static struct avl_tree tree = {.root = NULL, .cmp = cmp};
+static struct avl_tree tree = {.root = NULL, .cmp = cmp, .update = update};
 static struct A t[ELEMENTS_COUNT];
 
 __attribute__((unused)) static void debug_print(struct avl_tree_node* node) {
@@ -85,12 +95,34 @@ static size_t get_tree_size(struct avl_tree_node* node) {
     return get_tree_size(node->left) + 1 + get_tree_size(node->right);
 }
 
+/* Checks that the augmented data (see `update`) is up to date in the whole subtree, and sets
+ * `*size` to the number of nodes in it. */
+static bool is_augmented_data_valid(struct avl_tree_node* node, size_t* size) {
+    if (!node) {
+        *size = 0;
+        return true;
+    }
+
+    size_t a = 0;
+    size_t b = 0;
+    bool ret = is_augmented_data_valid(node->left, &a);
+    ret &= is_augmented_data_valid(node->right, &b);
+
+    *size = a + 1 + b;
+    return ret && subtree_size(node) == *size;
+}
+
+static bool is_tree_valid(void) {
+    size_t size;
+    return debug_avl_tree_is_balanced(&tree) && is_augmented_data_valid(tree.root, &size);
+}
+
 static void try_node_swap(struct avl_tree_node* node, struct avl_tree_node* swap_node) {
     avl_tree_swap_node(&tree, node, swap_node);
     node->left   = (void*)1;
     node->right  = (void*)2;
     node->parent = (void*)3;
-    if (!debug_avl_tree_is_balanced(&tree)) {
+    if (!is_tree_valid()) {
         EXIT_UNBALANCED();
     }
     size_t size = get_tree_size(tree.root);
@@ -103,7 +135,7 @@ static void try_node_swap(struct avl_tree_node* node, struct avl_tree_node* swap
     swap_node->left   = (void*)1;
     swap_node->right  = (void*)2;
     swap_node->parent = (void*)3;
-    if (!debug_avl_tree_is_balanced(&tree)) {
+    if (!is_tree_valid()) {
         EXIT_UNBALANCED();
     }
     size = get_tree_size(tree.root);
@@ -120,7 +152,7 @@ static void do_test(int32_t (*get_num)(void)) {
         t[i].key   = get_num();
         t[i].freed = false;
         avl_tree_insert(&tree, &t[i].node);
-        if (!debug_avl_tree_is_balanced(&tree)) {
+        if (!is_tree_valid()) {
             EXIT_UNBALANCED();
         }
     }
@@ -198,7 +230,7 @@ static void do_test(int32_t (*get_num)(void)) {
     /* get_num returns int32_t, but tmp.key is a int64_t, so this cannot overflow. */
     struct A tmp = {.key = val + 100};
     avl_tree_insert(&tree, &tmp.node);
-    if (!debug_avl_tree_is_balanced(&tree)) {
+    if (!is_tree_valid()) {
         EXIT_UNBALANCED();
     }
 
@@ -223,7 +255,7 @@ static void do_test(int32_t (*get_num)(void)) {
     }
 
     avl_tree_delete(&tree, &tmp.node);
-    if (!debug_avl_tree_is_balanced(&tree)) {
+    if (!is_tree_valid()) {
         EXIT_UNBALANCED();
     }
 
@@ -234,7 +266,7 @@ static void do_test(int32_t (*get_num)(void)) {
             t[r].freed = true;
             avl_tree_delete(&tree, &t[r].node);
             i--;
-            if (!debug_avl_tree_is_balanced(&tree)) {
+            if (!is_tree_valid()) {
                 EXIT_UNBALANCED();
             }
         }
@@ -243,7 +275,7 @@ static void do_test(int32_t (*get_num)(void)) {
         if (!t[i].freed) {
             avl_tree_delete(&tree, &t[i].node);
             t[i].freed = true;
-            if (!debug_avl_tree_is_balanced(&tree)) {
+            if (!is_tree_valid()) {
                 EXIT_UNBALANCED();
             }
         }
@@ -261,7 +293,7 @@ static void test_ordering(void) {
     for (i = ELEMENTS_COUNT - 1; i >= 0; i--) {
         t[i].key = i / (ELEMENTS_COUNT / DIFF_ELEMENTS);
         avl_tree_insert(&tree, &t[i].node);
-        if (!debug_avl_tree_is_balanced(&tree)) {
+        if (!is_tree_valid()) {
             EXIT_UNBALANCED();
         }
     }
@@ -281,7 +313,7 @@ static void test_ordering(void) {
 
     for (i = 0; i < ELEMENTS_COUNT; i++) {
         avl_tree_delete(&tree, &t[i].node);
-        if (!debug_avl_tree_is_balanced(&tree)) {
+        if (!is_tree_valid()) {
             EXIT_UNBALANCED();
         }
     }
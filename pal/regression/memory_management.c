@@ -64,7 +64,8 @@ int mem_bkeep_free(uintptr_t addr, size_t size) {
     return PAL_ERROR_NOMEM;
 }
 
-int mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags) {
+int mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags, uintptr_t* out_begin,
+                           uintptr_t* out_end) {
     assert(g_vmas_len);
 
     *out_prot_flags = 0;
@@ -72,6 +73,8 @@ int mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags) {
     for (size_t i = 0; i < g_vmas_len; i++) {
         if (g_vmas[i].begin <= addr && addr < g_vmas[i].end) {
             *out_prot_flags = g_vmas[i].prot_flags;
+            *out_begin = g_vmas[i].begin;
+            *out_end = g_vmas[i].end;
             return 0;
         }
     }
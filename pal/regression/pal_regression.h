@@ -34,7 +34,8 @@ void __attribute__((format(printf, 1, 2))) pal_printf(const char* fmt, ...);
 void init_memory_management(void);
 int mem_bkeep_alloc(size_t size, uintptr_t* out_addr);
 int mem_bkeep_free(uintptr_t addr, size_t size);
-int mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags);
+int mem_bkeep_get_vma_info(uintptr_t addr, pal_prot_flags_t* out_prot_flags, uintptr_t* out_begin,
+                           uintptr_t* out_end);
 int memory_alloc(size_t size, pal_prot_flags_t prot, void** out_addr);
 int memory_free(void* addr, size_t size);
 int memory_protect(void* addr, size_t size, pal_prot_flags_t prot);
@@ -148,6 +148,7 @@ class TC_02_Symbols(RegressionTestCase):
         'PalStreamWaitForClient',
         'PalStreamRead',
         'PalStreamWrite',
+        'PalStreamBatch',
         'PalStreamDelete',
         'PalStreamSetLength',
         'PalStreamFlush',
@@ -331,6 +332,23 @@ class TC_20_SingleProcess(RegressionTestCase):
         self.assertFalse(pathlib.Path('dir_rename.tmp').exists())
         self.assertFalse(pathlib.Path('dir_rename_delete.tmp').exists())
 
+    def test_120_stream_batch(self):
+        _, stderr = self.run_binary(['StreamBatch'])
+        self.assertIn('TEST OK', stderr)
+        self.assertFalse(pathlib.Path('stream_batch.tmp').exists())
+
+    @unittest.skipUnless(HAS_SGX, 'This test is only meaningful on SGX PAL')
+    def test_121_stream_batch_io_uring(self):
+        _, stderr = self.run_binary(['StreamBatch_io_uring'])
+        self.assertIn('TEST OK', stderr)
+        self.assertFalse(pathlib.Path('stream_batch.tmp').exists())
+
+    def test_122_copy_throughput(self):
+        _, stderr = self.run_binary(['CopyThroughput'])
+        self.assertIn('read size 4194304: ', stderr)
+        self.assertIn('TEST OK', stderr)
+        self.assertFalse(pathlib.Path('copy_throughput.tmp').exists())
+
     def test_200_event(self):
         _, stderr = self.run_binary(['Event'])
         self.assertIn('TEST OK', stderr)
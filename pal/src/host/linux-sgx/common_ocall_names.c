@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/* Names of OCALLs, used in both untrusted and trusted PAL to report per-OCALL statistics. */
+
+#include "pal_ocall_types.h"
+
+const char* const g_ocall_names[OCALL_NR] = {
+    [OCALL_EXIT]                     = "exit",
+    [OCALL_MMAP_UNTRUSTED]           = "mmap_untrusted",
+    [OCALL_MUNMAP_UNTRUSTED]         = "munmap_untrusted",
+    [OCALL_CPUID]                    = "cpuid",
+    [OCALL_OPEN]                     = "open",
+    [OCALL_CLOSE]                    = "close",
+    [OCALL_READ]                     = "read",
+    [OCALL_WRITE]                    = "write",
+    [OCALL_PREAD]                    = "pread",
+    [OCALL_PWRITE]                   = "pwrite",
+    [OCALL_FSTAT]                    = "fstat",
+    [OCALL_FIONREAD]                 = "fionread",
+    [OCALL_FSETNONBLOCK]             = "fsetnonblock",
+    [OCALL_FCHMOD]                   = "fchmod",
+    [OCALL_FSYNC]                    = "fsync",
+    [OCALL_FTRUNCATE]                = "ftruncate",
+    [OCALL_MKDIR]                    = "mkdir",
+    [OCALL_GETDENTS]                 = "getdents",
+    [OCALL_RESUME_THREAD]            = "resume_thread",
+    [OCALL_SCHED_SETAFFINITY]        = "sched_setaffinity",
+    [OCALL_SCHED_GETAFFINITY]        = "sched_getaffinity",
+    [OCALL_CLONE_THREAD]             = "clone_thread",
+    [OCALL_CREATE_PROCESS]           = "create_process",
+    [OCALL_FUTEX]                    = "futex",
+    [OCALL_SOCKET]                   = "socket",
+    [OCALL_BIND]                     = "bind",
+    [OCALL_LISTEN_SIMPLE]            = "listen_simple",
+    [OCALL_LISTEN]                   = "listen",
+    [OCALL_ACCEPT]                   = "accept",
+    [OCALL_CONNECT]                  = "connect",
+    [OCALL_CONNECT_SIMPLE]           = "connect_simple",
+    [OCALL_RECV]                     = "recv",
+    [OCALL_SEND]                     = "send",
+    [OCALL_SETSOCKOPT]               = "setsockopt",
+    [OCALL_SHUTDOWN]                 = "shutdown",
+    [OCALL_GETTIME]                  = "gettime",
+    [OCALL_SCHED_YIELD]              = "sched_yield",
+    [OCALL_POLL]                     = "poll",
+    [OCALL_RENAME]                   = "rename",
+    [OCALL_DELETE]                   = "delete",
+    [OCALL_DEBUG_MAP_ADD]            = "debug_map_add",
+    [OCALL_DEBUG_MAP_REMOVE]         = "debug_map_remove",
+    [OCALL_DEBUG_DESCRIBE_LOCATION]  = "debug_describe_location",
+    [OCALL_EVENTFD]                  = "eventfd",
+    [OCALL_IOCTL]                    = "ioctl",
+    [OCALL_GET_QUOTE]                = "get_quote",
+    [OCALL_GET_QE_TARGETINFO]        = "get_qe_targetinfo",
+    [OCALL_EDMM_RESTRICT_PAGES_PERM] = "edmm_restrict_pages_perm",
+    [OCALL_EDMM_MODIFY_PAGES_TYPE]   = "edmm_modify_pages_type",
+    [OCALL_EDMM_REMOVE_PAGES]        = "edmm_remove_pages",
+    [OCALL_EDMM_AUGMENT_PAGES]       = "edmm_augment_pages",
+    [OCALL_BATCH]                    = "batch",
+    [OCALL_GET_OCALL_STATS]          = "get_ocall_stats",
+    [OCALL_SENDFILE]                 = "sendfile",
+    [OCALL_COPY_FILE_RANGE]          = "copy_file_range",
+};
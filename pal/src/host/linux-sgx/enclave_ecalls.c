@@ -66,7 +66,8 @@ void handle_ecall(long ecall_index, void* ecall_args, void* exit_target, void* e
     SET_ENCLAVE_TCB(ustack,          (void*)ursp);
     SET_ENCLAVE_TCB(ustack_top,      (void*)ursp);
     SET_ENCLAVE_TCB(clear_child_tid, NULL);
-    SET_ENCLAVE_TCB(untrusted_area_cache.in_use, 0UL);
+    for (size_t i = 0; i < UNTRUSTED_AREA_CACHE_SLOTS; i++)
+        pal_get_enclave_tcb()->untrusted_area_cache[i].in_use = 0;
 
     int64_t t = 0;
     if (__atomic_compare_exchange_n(&g_enclave_start_called, &t, 1, /*weak=*/false,
@@ -35,6 +35,31 @@ enclave_lazy_commit_page_tracker_t* g_enclave_lazy_commit_page_tracker = NULL;
 
 static spinlock_t g_enclave_lazy_commit_page_tracker_lock = INIT_SPINLOCK_UNLOCKED;
 
+/*
+ * Reclaimer of freed enclave memory (enabled with `sgx.edmm_reclaim_watermark`).
+ *
+ * Removing pages from the enclave is slow: it takes two OCALLs and one EACCEPT per page. So with the
+ * reclaimer, freed pages are not removed immediately but only marked as reclaimable in the tracker.
+ * A subsequent allocation of the same addresses recycles them (they only need to be zeroed and to
+ * get the new permissions, see `recycle_pages()`), and a dedicated thread (provided by the LibOS,
+ * see `PalVirtualMemoryReclaim()`) removes them in large batches when there are more reclaimable
+ * pages than the watermark, or when they were not reused for `EDMM_RECLAIM_IDLE_TIMEOUT_US`.
+ *
+ * The counters below are modified only under `g_enclave_lazy_commit_page_tracker_lock`, but read
+ * without it.
+ */
+#define EDMM_RECLAIM_IDLE_TIMEOUT_US (1000 * 1000)
+#define EDMM_RECLAIM_BATCH_PAGES 512UL
+
+static size_t g_reclaimable_pages = 0;
+static uint64_t g_recycled_pages = 0;
+static uint64_t g_reclaimed_pages = 0;
+/* incremented on each free and reuse of reclaimable pages, to detect that they are idle */
+static uint64_t g_reclaim_activity = 0;
+/* index of the page where the reclaimer continues searching for reclaimable pages */
+static size_t g_reclaim_cursor = 0;
+static PAL_HANDLE g_reclaim_event = NULL;
+
 static int sgx_eaccept(uint64_t addr, uint64_t flags) {
     alignas(64) sgx_arch_sec_info_t secinfo = {
         .flags = flags,
@@ -60,6 +85,21 @@ int sgx_edmm_add_pages(uint64_t addr, size_t count, uint64_t prot) {
         prot |= SGX_SECINFO_FLAGS_R;
     }
 
+/* The host adds the pages to the enclave (EAUG) when they are first accessed, also by itself. If
+ * some of them are concurrently accessed by another enclave thread, the unpatched SGX driver may
+ * fail the host access with SIGBUS (see the comment in `_PalExceptionHandler()`), which would be
+ * fatal in the untrusted PAL. */
+#ifdef LINUX_KERNEL_SGX_EDMM_DATA_RACES_PATCHED
+    if (count > 1) {
+        /* add all pages in one enclave exit instead of an AEX on the EACCEPT of each page; this is
+         * only an optimization, EACCEPT below still verifies each page */
+        ret = ocall_edmm_augment_pages(addr, count);
+        if (ret < 0)
+            log_debug("failed to augment pages at %#lx-%#lx: %s", addr,
+                      addr + count * PAGE_SIZE, unix_strerror(ret));
+    }
+#endif
+
     for (size_t i = 0; i < count; i++) {
         /* SGX2 HW requires initial page permissions to be RW. */
         ret = sgx_eaccept(addr + i * PAGE_SIZE, (SGX_PAGE_TYPE_REG << SGX_SECINFO_FLAGS_TYPE_SHIFT)
@@ -245,6 +285,14 @@ void init_enclave_lazy_commit_page_tracker(uintptr_t enclave_base_address, size_
         INIT_FAIL("Reserving bitvector for lazily committed pages failed");
     tracker->is_lazily_committed = (uint8_t*)lazy_commit_bitvector_addr;
 
+    /* the pages of this bitvector are committed together with the corresponding pages of
+     * `is_lazily_committed`, even if the reclaimer is not used (it is not known at this point) */
+    uintptr_t reclaimable_bitvector_addr;
+    ret = initial_mem_bkeep(lazy_commit_bitvector_size, &reclaimable_bitvector_addr);
+    if (ret < 0)
+        INIT_FAIL("Reserving bitvector for reclaimable pages failed");
+    tracker->is_reclaimable = (uint8_t*)reclaimable_bitvector_addr;
+
     size_t bitvector_page_alloc_status_size =
         UDIV_ROUND_UP(UDIV_ROUND_UP(lazy_commit_bitvector_size, PAGE_SIZE), 8);
     tracker->is_bitvector_page_allocated = calloc(1, bitvector_page_alloc_status_size);
@@ -291,6 +339,32 @@ static inline bool is_enclave_lazy_commit_page_set(size_t index) {
             (1 << (index % 8))) != 0;
 }
 
+/* sets an enclave page as reclaimable in the tracker */
+static inline void set_enclave_reclaimable_page(size_t index) {
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
+    g_enclave_lazy_commit_page_tracker->is_reclaimable[index / 8] |= 1 << (index % 8);
+}
+
+/* unsets a reclaimable enclave page in the tracker */
+static inline void unset_enclave_reclaimable_page(size_t index) {
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
+    g_enclave_lazy_commit_page_tracker->is_reclaimable[index / 8] &= ~(1 << (index % 8));
+}
+
+/* checks if an enclave page is reclaimable in the tracker */
+static inline bool is_enclave_reclaimable_page_set(size_t index) {
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
+    return (g_enclave_lazy_commit_page_tracker->is_reclaimable[index / 8] &
+            (1 << (index % 8))) != 0;
+}
+
+/* checks if the pages of the tracker bitvectors holding the bits of an enclave page are allocated */
+static inline bool is_bitvector_page_allocated(size_t index) {
+    size_t bitvector_page_index = index / (PAGE_SIZE * 8);
+    return (g_enclave_lazy_commit_page_tracker->is_bitvector_page_allocated[bitvector_page_index / 8]
+            & (1 << (bitvector_page_index % 8))) != 0;
+}
+
 /* sets a range of enclave pages as lazily-committed according to the memory address and number
  * of pages */
 void set_enclave_lazy_commit_pages(uintptr_t start_addr, size_t page_count) {
@@ -321,6 +395,25 @@ static int unset_enclave_lazy_commit_pages_callback(uintptr_t start_addr, size_t
     return 0;
 }
 
+static int set_enclave_lazy_commit_pages_callback(uintptr_t start_addr, size_t page_count,
+                                                  void* unused __attribute__((unused))) {
+    set_enclave_lazy_commit_pages(start_addr, page_count);
+    return 0;
+}
+
+/* marks freed committed pages as reclaimable instead of removing them from the enclave */
+static int set_enclave_reclaimable_pages_callback(uintptr_t start_addr, size_t page_count,
+                                                  void* unused __attribute__((unused))) {
+    size_t start = address_to_index(start_addr);
+    for (size_t i = start; i < start + page_count; i++) {
+        assert(!is_enclave_reclaimable_page_set(i));
+        set_enclave_reclaimable_page(i);
+    }
+    __atomic_store_n(&g_reclaimable_pages, g_reclaimable_pages + page_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_reclaim_activity, g_reclaim_activity + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
 static void copy_bitvector_with_offset(uint8_t* dest_bitvector, const uint8_t* src_bitvector,
                                        size_t src_offset_bits, size_t size_bits) {
     assert(dest_bitvector != NULL);
@@ -375,18 +468,18 @@ void get_lazy_commit_pages_bitvector_slice(uintptr_t addr, size_t page_count, ui
  * when enclave pages have mismatched set/unset status recorded and from the input,
  * `callback_mismatch()` will be executed if specified; otherwise they will be skipped by default.
  * This function returns an error when `callback()` or `callback_mismatch()` failed. */
-static int walk_pages(uintptr_t start_addr, size_t page_count, bool walk_set_pages,
-                      int (*callback)(uintptr_t, size_t, void*), void* arg,
-                      int (*callback_mismatch)(uintptr_t, size_t, void*), void* arg_mismatch) {
+static int walk_pages_locked(uintptr_t start_addr, size_t page_count, bool walk_set_pages,
+                             int (*callback)(uintptr_t, size_t, void*), void* arg,
+                             int (*callback_mismatch)(uintptr_t, size_t, void*),
+                             void* arg_mismatch) {
     assert(completely_within_tracked_range(start_addr, page_count));
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
 
     int ret = 0;
     size_t start = address_to_index(start_addr);
     size_t end = start + page_count;
     assert(end <= g_enclave_lazy_commit_page_tracker->enclave_pages);
 
-    spinlock_lock(&g_enclave_lazy_commit_page_tracker_lock);
-
     size_t i = start;
     while (i < end) {
         /* find consecutive set/unset pages */
@@ -422,11 +515,80 @@ static int walk_pages(uintptr_t start_addr, size_t page_count, bool walk_set_pag
         }
     }
 
-    spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
+    return ret;
+}
 
+static int walk_pages(uintptr_t start_addr, size_t page_count, bool walk_set_pages,
+                      int (*callback)(uintptr_t, size_t, void*), void* arg,
+                      int (*callback_mismatch)(uintptr_t, size_t, void*), void* arg_mismatch) {
+    spinlock_lock(&g_enclave_lazy_commit_page_tracker_lock);
+    int ret = walk_pages_locked(start_addr, page_count, walk_set_pages, callback, arg,
+                                callback_mismatch, arg_mismatch);
+    spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
     return ret;
 }
 
+/* Reuses reclaimable pages for a new allocation with SGX permissions `prot`. The pages are still
+ * committed, so they only have to be zeroed and get the new permissions. `EMODPE` can only extend
+ * the permissions, so the pages get `prot` together with RW (needed for zeroing them); their old
+ * permissions are not known, so they are then restricted to `prot`, unless it is RWX. */
+static int recycle_pages(uintptr_t start_addr, size_t page_count, uint64_t prot) {
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
+
+    uint64_t rwx = SGX_SECINFO_FLAGS_R | SGX_SECINFO_FLAGS_W | SGX_SECINFO_FLAGS_X;
+    for (size_t i = 0; i < page_count; i++) {
+        sgx_emodpe(start_addr + i * PAGE_SIZE,
+                   (prot & rwx) | SGX_SECINFO_FLAGS_R | SGX_SECINFO_FLAGS_W);
+    }
+    memset((void*)start_addr, 0, page_count * PAGE_SIZE);
+
+    if ((prot & rwx) != rwx) {
+        int ret = sgx_edmm_set_page_permissions(start_addr, page_count, prot & rwx);
+        if (ret < 0)
+            return ret;
+    }
+
+    size_t start = address_to_index(start_addr);
+    for (size_t i = start; i < start + page_count; i++)
+        unset_enclave_reclaimable_page(i);
+    __atomic_store_n(&g_reclaimable_pages, g_reclaimable_pages - page_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_recycled_pages, g_recycled_pages + page_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_reclaim_activity, g_reclaim_activity + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int commit_pages_callback(uintptr_t start_addr, size_t page_count, void* prot) {
+    return walk_pages_locked(start_addr, page_count, /*walk_set_pages=*/false,
+                             sgx_edmm_add_pages_callback, prot,
+                             /*callback_mismatch=*/NULL, /*arg_mismatch=*/NULL);
+}
+
+/* Prepares a range of enclave pages for a new allocation with SGX permissions `prot`: recycles the
+ * reclaimable pages and invokes `callback()` on the consecutive other pages. */
+static int alloc_pages_locked(uintptr_t start_addr, size_t page_count, uint64_t prot,
+                              int (*callback)(uintptr_t, size_t, void*), void* arg) {
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
+
+    if (!g_reclaimable_pages)
+        return callback(start_addr, page_count, arg);
+
+    size_t i = address_to_index(start_addr);
+    size_t end = i + page_count;
+    while (i < end) {
+        size_t run_start = i;
+        bool is_reclaimable = is_enclave_reclaimable_page_set(i);
+        while (i < end && is_enclave_reclaimable_page_set(i) == is_reclaimable)
+            i++;
+
+        int ret = is_reclaimable
+                  ? recycle_pages(index_to_address(run_start), i - run_start, prot)
+                  : callback(index_to_address(run_start), i - run_start, arg);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
 static int maybe_alloc_bitvector_pages_eagerly(uintptr_t start_addr, size_t page_count) {
     assert(completely_within_tracked_range(start_addr, page_count));
 
@@ -452,6 +614,14 @@ static int maybe_alloc_bitvector_pages_eagerly(uintptr_t start_addr, size_t page
                 spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
                 return ret;
             }
+            ret = sgx_edmm_add_pages(
+                (uintptr_t)g_enclave_lazy_commit_page_tracker->is_reclaimable +
+                bitvector_page_index * PAGE_SIZE,
+                /*count=*/1, PAL_TO_SGX_PROT(PAL_PROT_READ | PAL_PROT_WRITE));
+            if (ret < 0) {
+                spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
+                return ret;
+            }
 
             g_enclave_lazy_commit_page_tracker->is_bitvector_page_allocated[alloc_status_index]
                                                 |= bit_mask;
@@ -471,9 +641,30 @@ int uncommit_pages(uintptr_t start_addr, size_t page_count) {
     if (ret < 0)
         return ret;
 
-    return walk_pages(start_addr, page_count, /*walk_set_pages=*/false,
-                      sgx_edmm_remove_pages_callback, /*arg=*/NULL,
-                      unset_enclave_lazy_commit_pages_callback, /*arg_mismatch=*/NULL);
+    size_t watermark = g_pal_linuxsgx_state.edmm_reclaim_watermark_pages;
+    if (!watermark) {
+        return walk_pages(start_addr, page_count, /*walk_set_pages=*/false,
+                          sgx_edmm_remove_pages_callback, /*arg=*/NULL,
+                          unset_enclave_lazy_commit_pages_callback, /*arg_mismatch=*/NULL);
+    }
+
+    spinlock_lock(&g_enclave_lazy_commit_page_tracker_lock);
+    size_t prev_reclaimable_pages = g_reclaimable_pages;
+    ret = walk_pages_locked(start_addr, page_count, /*walk_set_pages=*/false,
+                            set_enclave_reclaimable_pages_callback, /*arg=*/NULL,
+                            unset_enclave_lazy_commit_pages_callback, /*arg_mismatch=*/NULL);
+    size_t reclaimable_pages = g_reclaimable_pages;
+    spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
+
+    /* wake up the reclaimer when it has to start tracking idle pages or to reclaim pages over the
+     * watermark; it does not need to be woken up on every free */
+    if ((!prev_reclaimable_pages && reclaimable_pages)
+            || (prev_reclaimable_pages <= watermark && reclaimable_pages > watermark)) {
+        PAL_HANDLE event = __atomic_load_n(&g_reclaim_event, __ATOMIC_ACQUIRE);
+        if (event)
+            _PalEventSet(event);
+    }
+    return ret;
 }
 
 int uncommit_then_lazy_realloc_pages(uintptr_t start_addr, size_t page_count) {
@@ -484,6 +675,9 @@ int uncommit_then_lazy_realloc_pages(uintptr_t start_addr, size_t page_count) {
     if (ret < 0)
         return ret;
 
+    /* Not deferred to the reclaimer (even if enabled): the pages stay in a live mapping, so they
+     * would have to be made inaccessible until reclaimed (to not be removed while in use), which
+     * costs as much as removing them right away. */
     return walk_pages(start_addr, page_count, /*walk_set_pages=*/false,
                       sgx_edmm_remove_then_lazy_realloc_pages_callback, /*arg=*/NULL,
                       /*callback_mismatch=*/NULL, /*arg_mismatch=*/NULL);
@@ -500,17 +694,17 @@ int maybe_commit_pages(uintptr_t start_addr, size_t page_count, pal_prot_flags_t
         if (ret < 0)
             return ret;
 
+        spinlock_lock(&g_enclave_lazy_commit_page_tracker_lock);
         if (prot & PAL_PROT_LAZYALLOC) {
-            /* defer page accepts to page-fault events when `PAL_PROT_LAZYALLOC` is set */
-            spinlock_lock(&g_enclave_lazy_commit_page_tracker_lock);
-            set_enclave_lazy_commit_pages(start_addr, page_count);
-            spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
-            return 0;
+            /* defer page accepts to page-fault events when `PAL_PROT_LAZYALLOC` is set (but reuse
+             * reclaimable pages right away, they are committed anyway) */
+            ret = alloc_pages_locked(start_addr, page_count, prot_flags,
+                                     set_enclave_lazy_commit_pages_callback, /*arg=*/NULL);
+        } else {
+            ret = alloc_pages_locked(start_addr, page_count, prot_flags,
+                                     commit_pages_callback, &prot_flags);
         }
-
-        ret = walk_pages(start_addr, page_count, /*walk_set_pages=*/false,
-                         sgx_edmm_add_pages_callback, &prot_flags,
-                         /*callback_mismatch=*/NULL, /*arg_mismatch=*/NULL);
+        spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
     } else {
         /* for enclave pages allocated when the tracker is not ready (on bootstrap) */
         ret = sgx_edmm_add_pages(start_addr, page_count, prot_flags);
@@ -536,6 +730,42 @@ int commit_lazy_alloc_pages(uintptr_t start_addr, size_t page_count, pal_prot_fl
     return 0;
 }
 
+/*
+ * Commits the lazily allocated page containing `addr` and, depending on the access pattern of the
+ * current thread, also some of the following or preceding lazily allocated pages in
+ * `[range_begin; range_end)` (which must all have permissions `prot`). If the fault is right after
+ * (or right before, for memory growing downwards like stacks) the pages committed on the previous
+ * lazy allocation fault of this thread, the window of committed pages doubles, up to
+ * `sgx.edmm_fault_around_size`; otherwise only the faulting page is committed. This way, memory
+ * touched sequentially (e.g. a growing heap) takes few page faults, while randomly accessed memory
+ * does not commit pages that are never used.
+ */
+int commit_lazy_alloc_pages_around(uintptr_t addr, uintptr_t range_begin, uintptr_t range_end,
+                                   pal_prot_flags_t prot) {
+    uintptr_t page = ALIGN_DOWN(addr, PAGE_SIZE);
+    range_begin = ALIGN_DOWN(range_begin, PAGE_SIZE);
+    range_end = ALIGN_UP(range_end, PAGE_SIZE);
+    assert(range_begin <= page && page < range_end);
+
+    uintptr_t last_start = GET_ENCLAVE_TCB(edmm_fault_around_start);
+    uintptr_t last_end = GET_ENCLAVE_TCB(edmm_fault_around_end);
+    size_t window = MIN((last_end - last_start) * 2,
+                        g_pal_linuxsgx_state.edmm_fault_around_pages * PAGE_SIZE);
+
+    uintptr_t start = page;
+    uintptr_t end = page + PAGE_SIZE;
+    if (page == last_end) {
+        end = page + MIN(window, range_end - page);
+    } else if (page + PAGE_SIZE == last_start) {
+        start = page + PAGE_SIZE - MIN(window, page + PAGE_SIZE - range_begin);
+    }
+
+    SET_ENCLAVE_TCB(edmm_fault_around_start, start);
+    SET_ENCLAVE_TCB(edmm_fault_around_end, end);
+
+    return commit_lazy_alloc_pages(start, (end - start) / PAGE_SIZE, prot);
+}
+
 int set_committed_pages_permissions(uintptr_t start_addr, size_t page_count,
                                     pal_prot_flags_t prot) {
     assert(g_enclave_lazy_commit_page_tracker);
@@ -550,3 +780,118 @@ int set_committed_pages_permissions(uintptr_t start_addr, size_t page_count,
                       sgx_edmm_set_page_permissions_callback, &prot_flags,
                       /*callback_mismatch=*/NULL, /*arg_mismatch=*/NULL);
 }
+
+/* returns the index of the first reclaimable page at or after `index`, or the number of enclave
+ * pages if there is none */
+static size_t find_reclaimable_page(size_t index) {
+    assert(spinlock_is_locked(&g_enclave_lazy_commit_page_tracker_lock));
+
+    size_t enclave_pages = g_enclave_lazy_commit_page_tracker->enclave_pages;
+    while (index < enclave_pages) {
+        if (!is_bitvector_page_allocated(index)) {
+            /* no page covered by this (not allocated) bitvector page was ever used */
+            index = ALIGN_DOWN(index, PAGE_SIZE * 8) + PAGE_SIZE * 8;
+            continue;
+        }
+        if (index % 8 == 0 && !g_enclave_lazy_commit_page_tracker->is_reclaimable[index / 8]) {
+            index += 8;
+            continue;
+        }
+        if (is_enclave_reclaimable_page_set(index))
+            return index;
+        index++;
+    }
+    return enclave_pages;
+}
+
+/* Removes up to `max_pages` reclaimable pages from the enclave. The tracker lock is released after
+ * each batch of consecutive pages, so that page faults and allocations in other threads are not
+ * blocked for long. */
+static int reclaim_pages(size_t max_pages) {
+    size_t enclave_pages = g_enclave_lazy_commit_page_tracker->enclave_pages;
+    size_t reclaimed = 0;
+
+    while (reclaimed < max_pages) {
+        spinlock_lock(&g_enclave_lazy_commit_page_tracker_lock);
+
+        size_t start = find_reclaimable_page(g_reclaim_cursor);
+        if (start == enclave_pages && g_reclaim_cursor)
+            start = find_reclaimable_page(0);
+        if (start == enclave_pages) {
+            spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
+            break;
+        }
+
+        size_t end = start + 1;
+        size_t max_end = MIN(start + MIN(max_pages - reclaimed, EDMM_RECLAIM_BATCH_PAGES),
+                             enclave_pages);
+        while (end < max_end && is_bitvector_page_allocated(end)
+                && is_enclave_reclaimable_page_set(end))
+            end++;
+
+        int ret = sgx_edmm_remove_pages(index_to_address(start), end - start);
+        if (ret < 0) {
+            spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
+            return ret;
+        }
+
+        for (size_t i = start; i < end; i++)
+            unset_enclave_reclaimable_page(i);
+        __atomic_store_n(&g_reclaimable_pages, g_reclaimable_pages - (end - start),
+                         __ATOMIC_RELAXED);
+        __atomic_store_n(&g_reclaimed_pages, g_reclaimed_pages + (end - start), __ATOMIC_RELAXED);
+        g_reclaim_cursor = end;
+
+        spinlock_unlock(&g_enclave_lazy_commit_page_tracker_lock);
+        reclaimed += end - start;
+    }
+
+    return 0;
+}
+
+/* Waits until there are more reclaimable pages than the watermark, or until the reclaimable pages
+ * are idle (there was no free or reuse of them for `EDMM_RECLAIM_IDLE_TIMEOUT_US`), and reclaims
+ * them. In the former case, the pages are reclaimed down to half of the watermark, so that the
+ * reclaimer does not wake up again on the next free. Called in a loop by the reclaimer thread. */
+int wait_and_reclaim_pages(void) {
+    assert(g_enclave_lazy_commit_page_tracker);
+
+    size_t watermark = g_pal_linuxsgx_state.edmm_reclaim_watermark_pages;
+    assert(watermark);
+
+    if (!g_reclaim_event) {
+        PAL_HANDLE event;
+        int ret = _PalEventCreate(&event, /*init_signaled=*/false, /*auto_clear=*/true);
+        if (ret < 0)
+            return ret;
+        __atomic_store_n(&g_reclaim_event, event, __ATOMIC_RELEASE);
+    }
+
+    uint64_t activity = __atomic_load_n(&g_reclaim_activity, __ATOMIC_RELAXED);
+    size_t reclaimable_pages = __atomic_load_n(&g_reclaimable_pages, __ATOMIC_RELAXED);
+    if (reclaimable_pages <= watermark) {
+        /* if there are no reclaimable pages, there is nothing to time out */
+        uint64_t timeout_us = EDMM_RECLAIM_IDLE_TIMEOUT_US;
+        int ret = _PalEventWait(g_reclaim_event, reclaimable_pages ? &timeout_us : NULL);
+        if (ret < 0 && ret != PAL_ERROR_TRYAGAIN && ret != PAL_ERROR_INTERRUPTED)
+            return ret;
+
+        reclaimable_pages = __atomic_load_n(&g_reclaimable_pages, __ATOMIC_RELAXED);
+        if (reclaimable_pages <= watermark) {
+            if (ret != PAL_ERROR_TRYAGAIN
+                    || activity != __atomic_load_n(&g_reclaim_activity, __ATOMIC_RELAXED)) {
+                /* woken up or interrupted, or the pages are still being freed and reused */
+                return 0;
+            }
+            return reclaim_pages(reclaimable_pages);
+        }
+    }
+
+    return reclaim_pages(reclaimable_pages - watermark / 2);
+}
+
+void get_reclaim_stats(struct pal_memory_reclaim_stats* stats) {
+    stats->reclaimable = __atomic_load_n(&g_reclaimable_pages, __ATOMIC_RELAXED) * PAGE_SIZE;
+    stats->recycled = __atomic_load_n(&g_recycled_pages, __ATOMIC_RELAXED) * PAGE_SIZE;
+    stats->reclaimed = __atomic_load_n(&g_reclaimed_pages, __ATOMIC_RELAXED) * PAGE_SIZE;
+}
@@ -135,9 +135,106 @@ static void copy_u64s(void* dst, const void* src, size_t count) {
     );
 }
 
+/*
+ * Bulk copies from untrusted memory into the enclave may use wide vector loads. Each vector load is
+ * naturally aligned to its size (32B for AVX2, 64B for AVX-512), thus it reads whole 8-byte aligned
+ * chunks of untrusted memory, which satisfies the CVE-2022-21233 mitigation requirement described
+ * in `sgx_copy_to_enclave_verified()`. Writes to untrusted memory always use `rep movsq` (the
+ * CVE-2022-21166 mitigation requires 8-byte writes). Each loop iteration copies one block of four
+ * vector registers; vector registers are caller-saved and are anyway reset on enclave exit.
+ */
+#define COPY_VEC_MIN_SIZE 1024 /* smaller copies are not worth the alignment prologue */
+
+static void copy_blocks_avx2(void* dst, const void* untrusted_src, size_t count) {
+    __asm__ volatile (
+        "1:\n"
+        "vmovdqa 0x00(%[src]), %%ymm0\n"
+        "vmovdqa 0x20(%[src]), %%ymm1\n"
+        "vmovdqa 0x40(%[src]), %%ymm2\n"
+        "vmovdqa 0x60(%[src]), %%ymm3\n"
+        "vmovdqu %%ymm0, 0x00(%[dst])\n"
+        "vmovdqu %%ymm1, 0x20(%[dst])\n"
+        "vmovdqu %%ymm2, 0x40(%[dst])\n"
+        "vmovdqu %%ymm3, 0x60(%[dst])\n"
+        "add $0x80, %[src]\n"
+        "add $0x80, %[dst]\n"
+        "dec %[count]\n"
+        "jnz 1b\n"
+        "vzeroupper\n"
+        : [dst]"+r"(dst), [src]"+r"(untrusted_src), [count]"+r"(count)
+        :
+        : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3"
+    );
+}
+
+static void copy_blocks_avx512(void* dst, const void* untrusted_src, size_t count) {
+    __asm__ volatile (
+        "1:\n"
+        "vmovdqa64 0x00(%[src]), %%zmm0\n"
+        "vmovdqa64 0x40(%[src]), %%zmm1\n"
+        "vmovdqa64 0x80(%[src]), %%zmm2\n"
+        "vmovdqa64 0xc0(%[src]), %%zmm3\n"
+        "vmovdqu64 %%zmm0, 0x00(%[dst])\n"
+        "vmovdqu64 %%zmm1, 0x40(%[dst])\n"
+        "vmovdqu64 %%zmm2, 0x80(%[dst])\n"
+        "vmovdqu64 %%zmm3, 0xc0(%[dst])\n"
+        "add $0x100, %[src]\n"
+        "add $0x100, %[dst]\n"
+        "dec %[count]\n"
+        "jnz 1b\n"
+        "vzeroupper\n"
+        : [dst]"+r"(dst), [src]"+r"(untrusted_src), [count]"+r"(count)
+        :
+        : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3"
+    );
+}
+
+/* selected in `init_untrusted_copy()`; NULL if the enclave cannot use AVX2 nor AVX-512 */
+static void (*g_copy_blocks_fn)(void* dst, const void* untrusted_src, size_t count) = NULL;
+static size_t g_copy_vec_size = 0; /* size of one vector load, block is 4 vectors */
+
+void init_untrusted_copy(void) {
+    uint64_t xfrm = g_pal_linuxsgx_state.enclave_info.attributes.xfrm;
+    if ((xfrm & SGX_XFRM_AVX) != SGX_XFRM_AVX)
+        return;
+
+    uint32_t values[4];
+    if (_PalCpuIdRetrieve(EXTENDED_FEATURE_FLAGS_LEAF, 0, values) < 0)
+        return;
+
+    if ((xfrm & SGX_XFRM_AVX512) == SGX_XFRM_AVX512 && (values[CPUID_WORD_EBX] & (1U << 16))) {
+        /* AVX512F */
+        g_copy_vec_size  = 64;
+        g_copy_blocks_fn = copy_blocks_avx512;
+    } else if (values[CPUID_WORD_EBX] & (1U << 5)) {
+        /* AVX2 */
+        g_copy_vec_size  = 32;
+        g_copy_blocks_fn = copy_blocks_avx2;
+    }
+}
+
 static void copy_u64s_from_untrusted(void* dst, const void* untrusted_src, size_t count) {
     assert((uintptr_t)untrusted_src % 8 == 0);
 
+    if (g_copy_blocks_fn && count * 8 >= COPY_VEC_MIN_SIZE) {
+        /* align the untrusted source to the vector size, then copy whole blocks of 4 vectors */
+        size_t head = (ALIGN_UP_POW2((uintptr_t)untrusted_src, g_copy_vec_size)
+                       - (uintptr_t)untrusted_src) / 8;
+        copy_u64s(dst, untrusted_src, head);
+        dst = (char*)dst + head * 8;
+        untrusted_src = (const char*)untrusted_src + head * 8;
+        count -= head;
+
+        size_t block_size = g_copy_vec_size * 4;
+        size_t blocks = count * 8 / block_size;
+        if (blocks) {
+            g_copy_blocks_fn(dst, untrusted_src, blocks);
+            dst = (char*)dst + blocks * block_size;
+            untrusted_src = (const char*)untrusted_src + blocks * block_size;
+            count -= blocks * block_size / 8;
+        }
+    }
+
     copy_u64s(dst, untrusted_src, count);
 }
 
@@ -41,16 +41,58 @@
  * size of 8MB. Thus, 512KB limit also works well for the main thread. */
 #define MAX_UNTRUSTED_STACK_BUF (THREAD_STACK_SIZE / 4)
 
-/* global pointer to a single untrusted queue, all accesses must be protected by g_rpc_queue->lock
- */
+/* global pointer to the untrusted RPC queue with per-thread rings */
 rpc_queue_t* g_rpc_queue = NULL;
 
+/* number of RPC rings claimed by enclave threads so far (trusted counterpart of
+ * `g_rpc_queue->rings_cnt`) */
+static uint64_t g_rpc_rings_claimed = 0;
+
+/* special value of `rpc_ring_idx` in TCB: all RPC rings were already claimed by other threads */
+#define RPC_RING_IDX_NONE UINT64_MAX
+
+static rpc_ring_t* get_rpc_ring(void) {
+    uint64_t ring_idx = GET_ENCLAVE_TCB(rpc_ring_idx);
+    if (!ring_idx) {
+        /* first exitless OCALL on this TCS, claim a new ring; the ring stays bound to this TCS and
+         * is reused by all threads that later run on it, so there is never more than one producer
+         * per ring */
+        ring_idx = __atomic_add_fetch(&g_rpc_rings_claimed, 1, __ATOMIC_RELAXED);
+        if (ring_idx > MAX_RPC_RINGS) {
+            SET_ENCLAVE_TCB(rpc_ring_idx, RPC_RING_IDX_NONE);
+            return NULL;
+        }
+        SET_ENCLAVE_TCB(rpc_ring_idx, ring_idx);
+
+        /* let RPC threads know they have to poll one more ring; other enclave threads may claim
+         * rings concurrently, so only ever increase the hint */
+        uint64_t rings_cnt = __atomic_load_n(&g_rpc_queue->rings_cnt, __ATOMIC_RELAXED);
+        while (rings_cnt < ring_idx) {
+            if (__atomic_compare_exchange_n(&g_rpc_queue->rings_cnt, &rings_cnt, ring_idx,
+                                            /*weak=*/true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+                break;
+        }
+    }
+
+    if (ring_idx > MAX_RPC_RINGS) {
+        /* RPC_RING_IDX_NONE: no ring for this TCS */
+        return NULL;
+    }
+    return &g_rpc_queue->rings[ring_idx - 1];
+}
+
 static long sgx_exitless_ocall(uint64_t code, void* ocall_args) {
     /* perform OCALL with enclave exit if no RPC queue (i.e., no exitless); no need for atomics
      * because this pointer is set only once at enclave initialization */
     if (!g_rpc_queue)
         return sgx_ocall(code, ocall_args);
 
+    rpc_ring_t* ring = get_rpc_ring();
+    if (!ring) {
+        /* more enclave threads than RPC rings, fallback to normal syscall path with enclave exit */
+        return sgx_ocall(code, ocall_args);
+    }
+
     /* allocate request in a new stack frame on OCALL stack; note that request's lock is used in
      * futex() and must be aligned to at least 4B */
     void* old_ustack = sgx_prepare_ustack();
@@ -69,18 +111,22 @@ static long sgx_exitless_ocall(uint64_t code, void* ocall_args) {
      * of the lock */
     spinlock_lock(&req->lock);
 
-    /* enqueue OCALL request into RPC queue; some RPC thread will dequeue it, issue a syscall
-     * and, after syscall is finished, release the request's spinlock */
-    bool enqueued = rpc_enqueue(g_rpc_queue, req);
+    /* enqueue OCALL request into this thread's RPC ring; some RPC thread will dequeue it, issue a
+     * syscall and, after syscall is finished, release the request's spinlock */
+    bool enqueued = rpc_enqueue(ring, req);
     if (!enqueued) {
-        /* no space in queue: all RPC threads are busy with outstanding ocalls; fallback to normal
-         * syscall path with enclave exit */
+        /* no space in ring: this thread already has RPC_RING_SIZE outstanding ocalls (possible
+         * only with nested exception handlers); fallback to normal syscall path with enclave
+         * exit */
         sgx_reset_ustack(old_ustack);
         return sgx_ocall(code, ocall_args);
     }
 
     /* wait till request processing is finished; try spinlock first */
-    bool locked = spinlock_lock_timeout(&req->lock, RPC_SPINLOCK_TIMEOUT);
+    uint64_t spin_budget = GET_ENCLAVE_TCB(rpc_spin_budget) ?: RPC_SPINLOCK_TIMEOUT;
+    bool locked = spinlock_lock_timeout(&req->lock, spin_budget);
+    SET_ENCLAVE_TCB(rpc_spin_budget, locked ? MIN(spin_budget * 2, RPC_SPINLOCK_TIMEOUT)
+                                            : MAX(spin_budget / 2, RPC_SPINLOCK_TIMEOUT_MIN));
 
     /* at this point:
      * - either RPC thread is done with OCALL and released the request's spinlock,
@@ -279,15 +325,25 @@ int ocall_munmap_untrusted(const void* addr, size_t size) {
 }
 
 /*
- * Memorize untrusted memory area to avoid mmap/munmap per each read/write IO. Because this cache
- * is per-thread, we don't worry about concurrency. The cache will be carried over thread
+ * Memorize untrusted memory areas to avoid mmap/munmap per each read/write IO. Because this cache
+ * is per-thread, we don't worry about concurrency; for the same reason its hit/miss statistics are
+ * counted in the TCB (see `get_untrusted_cache_stats()`). The cache will be carried over thread
  * exit/creation. On fork/exec emulation, untrusted code does vfork/exec, so the mmapped cache
  * will be released by exec host syscall.
  *
+ * The cache has a few slots, each holding one buffer whose size is a power of two (so that slightly
+ * growing requests don't cause remapping every time). The smallest free buffer that fits is used;
+ * if none fits, the largest free buffer is grown (or an empty slot is populated), as long as the
+ * total size of cached buffers of this thread stays within `sgx.ocall_buffer_cache_size`.
+ *
  * In case of AEX and consequent signal handling, current thread may be interrupted in the middle
- * of using the cache. If there are OCALLs during signal handling, they could interfere with the
- * normal-execution use of the cache, so 'in_use' atomic protects against it. OCALLs during signal
- * handling do not use the cache and always explicitly mmap/munmap untrusted memory; 'need_munmap'
+ * of using a cached buffer. If there are OCALLs during signal handling, they must not interfere
+ * with the normal-execution use of the buffer, so 'in_use' atomic of each slot protects against it:
+ * OCALLs during signal handling use other slots. Note that a signal handler runs to completion
+ * before the interrupted code resumes, so the only possible race is that the handler changes
+ * a slot the interrupted code has picked but not yet claimed; this is detected after claiming.
+ *
+ * If the cache cannot be used, untrusted memory is explicitly mmapped/munmapped; 'need_munmap'
  * indicates whether explicit munmap is needed at the end of such OCALL.
  */
 static int ocall_mmap_untrusted_cache(size_t size, void** addrptr, bool* need_munmap) {
@@ -296,59 +352,109 @@ static int ocall_mmap_untrusted_cache(size_t size, void** addrptr, bool* need_mu
     *addrptr = NULL;
     *need_munmap = false;
 
-    struct untrusted_area* cache = &pal_get_enclave_tcb()->untrusted_area_cache;
+    struct untrusted_area* cache = pal_get_enclave_tcb()->untrusted_area_cache;
+
+    struct untrusted_area* fit = NULL;    /* smallest free buffer that fits */
+    struct untrusted_area* victim = NULL; /* largest free buffer, or empty slot if none */
+    size_t cached_size = 0;
+    for (size_t i = 0; i < UNTRUSTED_AREA_CACHE_SLOTS; i++) {
+        struct untrusted_area* area = &cache[i];
+        if (area->valid)
+            cached_size += area->size;
+        if (__atomic_load_n(&area->in_use, __ATOMIC_RELAXED))
+            continue;
+
+        if (area->valid && area->size >= size) {
+            if (!fit || area->size < fit->size)
+                fit = area;
+        } else if (!victim || (area->valid && (!victim->valid || area->size > victim->size))) {
+            victim = area;
+        }
+    }
 
+    struct untrusted_area* area = fit ?: victim;
     uint64_t in_use = 0;
-    if (!__atomic_compare_exchange_n(&cache->in_use, &in_use, 1, /*weak=*/false, __ATOMIC_RELAXED,
-                                     __ATOMIC_RELAXED)) {
-        /* AEX signal handling case: cache is in use, so make explicit mmap/munmap */
-        ret = ocall_mmap_untrusted(addrptr, size, PROT_READ | PROT_WRITE,
-                                   MAP_ANONYMOUS | MAP_PRIVATE, /*fd=*/-1, /*offset=*/0);
-        if (ret < 0) {
-            return ret;
-        }
-        *need_munmap = true;
-        return 0;
+    if (!area || !__atomic_compare_exchange_n(&area->in_use, &in_use, 1, /*weak=*/false,
+                                              __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        goto out_explicit_mmap;
     }
     COMPILER_BARRIER();
 
-    /* normal execution case: cache was not in use, so use it/allocate new one for reuse */
-    if (cache->valid) {
-        if (cache->size >= size) {
-            *addrptr = cache->addr;
+    if (area == fit) {
+        if (area->valid && area->size >= size) {
+            pal_get_enclave_tcb()->untrusted_cache_hits++;
+            *addrptr = area->addr;
             return 0;
         }
-        ret = ocall_munmap_untrusted(cache->addr, cache->size);
-        if (ret < 0) {
-            cache->valid = false;
-            COMPILER_BARRIER();
-            __atomic_store_n(&cache->in_use, 0, __ATOMIC_RELAXED);
-            return ret;
-        }
+        /* raced with a signal handler which reused this slot, don't bother and fall back */
+        goto out_release;
+    }
+
+    size_t new_size = size <= g_page_size ? g_page_size : 1UL << (64 - __builtin_clzl(size - 1));
+    size_t old_size = area->valid ? area->size : 0;
+    if (cached_size - old_size + new_size > g_pal_linuxsgx_state.untrusted_cache_max_size)
+        goto out_release;
+
+    pal_get_enclave_tcb()->untrusted_cache_misses++;
+    if (area->valid) {
+        area->valid = false;
+        ret = ocall_munmap_untrusted(area->addr, area->size);
+        if (ret < 0)
+            goto out_release_err;
     }
 
+    ret = ocall_mmap_untrusted(addrptr, new_size, PROT_READ | PROT_WRITE,
+                               MAP_ANONYMOUS | MAP_PRIVATE, /*fd=*/-1, /*offset=*/0);
+    if (ret < 0)
+        goto out_release_err;
+
+    area->valid = true;
+    area->addr  = *addrptr;
+    area->size  = new_size;
+    return 0;
+
+out_release_err:
+    COMPILER_BARRIER();
+    __atomic_store_n(&area->in_use, 0, __ATOMIC_RELAXED);
+    return ret;
+
+out_release:
+    COMPILER_BARRIER();
+    __atomic_store_n(&area->in_use, 0, __ATOMIC_RELAXED);
+out_explicit_mmap:
+    pal_get_enclave_tcb()->untrusted_cache_misses++;
     ret = ocall_mmap_untrusted(addrptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE,
                                /*fd=*/-1, /*offset=*/0);
     if (ret < 0) {
-        cache->valid = false;
-        COMPILER_BARRIER();
-        __atomic_store_n(&cache->in_use, 0, __ATOMIC_RELAXED);
-    } else {
-        cache->valid = true;
-        cache->addr  = *addrptr;
-        cache->size  = size;
+        return ret;
     }
-    return ret;
+    *need_munmap = true;
+    return 0;
 }
 
 static void ocall_munmap_untrusted_cache(void* addr, size_t size, bool need_munmap) {
     if (need_munmap) {
         ocall_munmap_untrusted(addr, size);
         /* there is not much we can do in case of error */
-    } else {
-        struct untrusted_area* cache = &pal_get_enclave_tcb()->untrusted_area_cache;
-        __atomic_store_n(&cache->in_use, 0, __ATOMIC_RELAXED);
+        return;
     }
+
+    struct untrusted_area* cache = pal_get_enclave_tcb()->untrusted_area_cache;
+    for (size_t i = 0; i < UNTRUSTED_AREA_CACHE_SLOTS; i++) {
+        if (cache[i].valid && cache[i].addr == addr) {
+            COMPILER_BARRIER();
+            __atomic_store_n(&cache[i].in_use, 0, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    BUG();
+}
+
+void log_untrusted_cache_stats(void) {
+    uint64_t hits;
+    uint64_t misses;
+    get_untrusted_cache_stats(&hits, &misses);
+    log_debug("untrusted buffer cache: %lu hits, %lu misses", hits, misses);
 }
 
 int ocall_cpuid(unsigned int leaf, unsigned int subleaf, unsigned int values[static 4]) {
@@ -579,6 +685,29 @@ out:
     return retval;
 }
 
+static long sanitize_pread_retval(long retval, size_t count) {
+    if (retval < 0 && retval != -EAGAIN && retval != -EWOULDBLOCK && retval != -EBADF &&
+            retval != -EINTR && retval != -EINVAL && retval != -EIO && retval != -EISDIR &&
+            retval != -ENXIO && retval != -EOVERFLOW && retval != -ESPIPE) {
+        return -EPERM;
+    }
+    if (retval > 0 && (size_t)retval > count)
+        return -EPERM;
+    return retval;
+}
+
+static long sanitize_pwrite_retval(long retval, size_t count) {
+    if (retval < 0 && retval != -EAGAIN && retval != -EWOULDBLOCK && retval != -EBADF &&
+            retval != -EFBIG && retval != -EINTR && retval != -EINVAL && retval != -EIO &&
+            retval != -ENOSPC && retval != -ENXIO && retval != -EOVERFLOW && retval != -EPIPE &&
+            retval != -ESPIPE) {
+        return -EPERM;
+    }
+    if (retval > 0 && (size_t)retval > count)
+        return -EPERM;
+    return retval;
+}
+
 ssize_t ocall_pread(int fd, void* buf, size_t count, off_t offset) {
     long retval = 0;
     void* obuf = NULL;
@@ -615,23 +744,12 @@ ssize_t ocall_pread(int fd, void* buf, size_t count, off_t offset) {
     COPY_VALUE_TO_UNTRUSTED(&ocall_pread_args->buf, untrusted_buf);
 
     retval = sgx_exitless_ocall(OCALL_PREAD, ocall_pread_args);
+    retval = sanitize_pread_retval(retval, count);
 
-    if (retval < 0 && retval != -EAGAIN && retval != -EWOULDBLOCK && retval != -EBADF &&
-            retval != -EINTR && retval != -EINVAL && retval != -EIO && retval != -EISDIR &&
-            retval != -ENXIO && retval != -EOVERFLOW && retval != -ESPIPE) {
+    if (retval > 0 && !sgx_copy_to_enclave(buf, count, untrusted_buf, retval)) {
         retval = -EPERM;
     }
 
-    if (retval > 0) {
-        if ((size_t)retval > count) {
-            retval = -EPERM;
-            goto out;
-        }
-        if (!sgx_copy_to_enclave(buf, count, untrusted_buf, retval)) {
-            retval = -EPERM;
-        }
-    }
-
 out:
     sgx_reset_ustack(old_ustack);
     if (obuf)
@@ -687,23 +805,182 @@ ssize_t ocall_pwrite(int fd, const void* buf, size_t count, off_t offset) {
     COPY_VALUE_TO_UNTRUSTED(&ocall_pwrite_args->buf, untrusted_buf);
 
     retval = sgx_exitless_ocall(OCALL_PWRITE, ocall_pwrite_args);
+    retval = sanitize_pwrite_retval(retval, count);
+
+out:
+    sgx_reset_ustack(old_ustack);
+    if (obuf)
+        ocall_munmap_untrusted_cache(obuf, ALLOC_ALIGN_UP(count), need_munmap);
+    return retval;
+}
+
+ssize_t ocall_sendfile(int out_fd, int in_fd, off_t offset, size_t count) {
+    long retval;
+    struct ocall_sendfile* ocall_sendfile_args;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ocall_sendfile_args = sgx_alloc_on_ustack_aligned(sizeof(*ocall_sendfile_args),
+                                                      alignof(*ocall_sendfile_args));
+    if (!ocall_sendfile_args) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    COPY_VALUE_TO_UNTRUSTED(&ocall_sendfile_args->out_fd, out_fd);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_sendfile_args->in_fd, in_fd);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_sendfile_args->offset, offset);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_sendfile_args->count, count);
+
+    retval = sgx_exitless_ocall(OCALL_SENDFILE, ocall_sendfile_args);
 
     if (retval < 0 && retval != -EAGAIN && retval != -EWOULDBLOCK && retval != -EBADF &&
-            retval != -EFBIG && retval != -EINTR && retval != -EINVAL && retval != -EIO &&
-            retval != -ENOSPC && retval != -ENXIO && retval != -EOVERFLOW && retval != -EPIPE &&
-            retval != -ESPIPE) {
+            retval != -ECONNRESET && retval != -EINTR && retval != -EINVAL && retval != -EIO &&
+            retval != -ENOMEM && retval != -ENOSYS && retval != -ENOTCONN &&
+            retval != -EOVERFLOW && retval != -EPIPE && retval != -ESPIPE) {
         retval = -EPERM;
     }
+    if (retval > 0 && (size_t)retval > count)
+        retval = -EPERM;
 
-    if (retval > 0 && (size_t)retval > count) {
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+ssize_t ocall_copy_file_range(int fd_in, off_t off_in, int fd_out, off_t off_out, size_t count) {
+    long retval;
+    struct ocall_copy_file_range* ocall_copy_file_range_args;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ocall_copy_file_range_args = sgx_alloc_on_ustack_aligned(sizeof(*ocall_copy_file_range_args),
+                                                             alignof(*ocall_copy_file_range_args));
+    if (!ocall_copy_file_range_args) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    COPY_VALUE_TO_UNTRUSTED(&ocall_copy_file_range_args->fd_in, fd_in);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_copy_file_range_args->off_in, off_in);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_copy_file_range_args->fd_out, fd_out);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_copy_file_range_args->off_out, off_out);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_copy_file_range_args->count, count);
+
+    retval = sgx_exitless_ocall(OCALL_COPY_FILE_RANGE, ocall_copy_file_range_args);
+
+    if (retval < 0 && retval != -EBADF && retval != -EFBIG && retval != -EINTR &&
+            retval != -EINVAL && retval != -EIO && retval != -ENOMEM && retval != -ENOSPC &&
+            retval != -ENOSYS && retval != -EOPNOTSUPP && retval != -EOVERFLOW &&
+            retval != -EXDEV) {
+        retval = -EPERM;
+    }
+    if (retval > 0 && (size_t)retval > count)
+        retval = -EPERM;
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_batch_io(struct ocall_batch_io* ios, size_t ios_cnt) {
+    long retval;
+    void* untrusted_bufs[OCALL_BATCH_MAX_ENTRIES];
+
+    if (!ios_cnt)
+        return 0;
+
+    void* old_ustack = sgx_prepare_ustack();
+
+    /* first find the prefix of operations that can be batched: their buffers must be in enclave
+     * memory and must altogether fit on the untrusted stack */
+    size_t batch_cnt = 0;
+    size_t batch_size = 0;
+    while (batch_cnt < ios_cnt && batch_cnt < OCALL_BATCH_MAX_ENTRIES) {
+        struct ocall_batch_io* io = &ios[batch_cnt];
+        if (io->count > MAX_UNTRUSTED_STACK_BUF - batch_size
+                || !sgx_is_completely_within_enclave(io->buf, io->count))
+            break;
+        batch_size += io->count;
+        batch_cnt++;
+    }
+
+    if (batch_cnt < 2) {
+        /* nothing to gain from batching (or the first operation cannot be batched), so fall back
+         * to a regular OCALL which knows how to handle huge and untrusted buffers */
+        sgx_reset_ustack(old_ustack);
+        struct ocall_batch_io* io = &ios[0];
+        io->result = io->is_write ? ocall_pwrite(io->fd, io->buf, io->count, io->offset)
+                                  : ocall_pread(io->fd, io->buf, io->count, io->offset);
+        return 1;
+    }
+
+    struct ocall_batch* ocall_batch_args = sgx_alloc_on_ustack_aligned(sizeof(*ocall_batch_args),
+                                                                       alignof(*ocall_batch_args));
+    struct ocall_batch_entry* entries = sgx_alloc_on_ustack_aligned(batch_cnt * sizeof(*entries),
+                                                                    alignof(*entries));
+    if (!ocall_batch_args || !entries) {
+        retval = -EPERM;
+        goto out;
+    }
+
+    for (size_t i = 0; i < batch_cnt; i++) {
+        struct ocall_batch_io* io = &ios[i];
+        void* args;
+        if (io->is_write) {
+            untrusted_bufs[i] = sgx_copy_to_ustack(io->buf, io->count);
+            struct ocall_pwrite* ocall_pwrite_args = sgx_alloc_on_ustack_aligned(
+                sizeof(*ocall_pwrite_args), alignof(*ocall_pwrite_args));
+            if (!untrusted_bufs[i] || !ocall_pwrite_args) {
+                retval = -EPERM;
+                goto out;
+            }
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pwrite_args->fd, io->fd);
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pwrite_args->count, io->count);
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pwrite_args->offset, io->offset);
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pwrite_args->buf, untrusted_bufs[i]);
+            args = ocall_pwrite_args;
+        } else {
+            untrusted_bufs[i] = sgx_alloc_on_ustack(io->count);
+            struct ocall_pread* ocall_pread_args = sgx_alloc_on_ustack_aligned(
+                sizeof(*ocall_pread_args), alignof(*ocall_pread_args));
+            if (!untrusted_bufs[i] || !ocall_pread_args) {
+                retval = -EPERM;
+                goto out;
+            }
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pread_args->fd, io->fd);
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pread_args->count, io->count);
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pread_args->offset, io->offset);
+            COPY_VALUE_TO_UNTRUSTED(&ocall_pread_args->buf, untrusted_bufs[i]);
+            args = ocall_pread_args;
+        }
+        COPY_VALUE_TO_UNTRUSTED(&entries[i].ocall_index,
+                                (uint64_t)(io->is_write ? OCALL_PWRITE : OCALL_PREAD));
+        COPY_VALUE_TO_UNTRUSTED(&entries[i].args, args);
+    }
+
+    COPY_VALUE_TO_UNTRUSTED(&ocall_batch_args->entries, entries);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_batch_args->entries_cnt, batch_cnt);
+
+    retval = sgx_exitless_ocall(OCALL_BATCH, ocall_batch_args);
+    if (retval < 0) {
+        /* the host must never fail the batch as a whole */
         retval = -EPERM;
         goto out;
     }
 
+    for (size_t i = 0; i < batch_cnt; i++) {
+        struct ocall_batch_io* io = &ios[i];
+        long result = COPY_UNTRUSTED_VALUE(&entries[i].result);
+        if (io->is_write) {
+            result = sanitize_pwrite_retval(result, io->count);
+        } else {
+            result = sanitize_pread_retval(result, io->count);
+            if (result > 0 && !sgx_copy_to_enclave(io->buf, io->count, untrusted_bufs[i], result))
+                result = -EPERM;
+        }
+        io->result = result;
+    }
+    retval = batch_cnt;
+
 out:
     sgx_reset_ustack(old_ustack);
-    if (obuf)
-        ocall_munmap_untrusted_cache(obuf, ALLOC_ALIGN_UP(count), need_munmap);
     return retval;
 }
 
@@ -2426,3 +2703,68 @@ out:
     sgx_reset_ustack(old_ustack);
     return ret;
 }
+
+int ocall_edmm_augment_pages(uint64_t addr, size_t count) {
+    int ret;
+    void* old_ustack = sgx_prepare_ustack();
+
+    struct ocall_edmm_augment_pages* ocall_args;
+    ocall_args = sgx_alloc_on_ustack_aligned(sizeof(*ocall_args), alignof(*ocall_args));
+    if (!ocall_args) {
+        ret = -EPERM;
+        goto out;
+    }
+
+    COPY_VALUE_TO_UNTRUSTED(&ocall_args->addr, addr);
+    COPY_VALUE_TO_UNTRUSTED(&ocall_args->count, count);
+
+    do {
+        ret = sgx_exitless_ocall(OCALL_EDMM_AUGMENT_PAGES, ocall_args);
+    } while (ret == -EINTR);
+    if (ret < 0) {
+        if (ret != -EINVAL && ret != -EPERM && ret != -EFAULT) {
+            ret = -EPERM;
+        }
+        goto out;
+    }
+
+    ret = 0;
+
+out:
+    sgx_reset_ustack(old_ustack);
+    return ret;
+}
+
+int ocall_get_ocall_stats(struct ocall_stats* stats) {
+    int ret;
+    void* old_ustack = sgx_prepare_ustack();
+
+    struct ocall_get_ocall_stats* ocall_args;
+    ocall_args = sgx_alloc_on_ustack_aligned(sizeof(*ocall_args), alignof(*ocall_args));
+    if (!ocall_args) {
+        ret = -EPERM;
+        goto out;
+    }
+
+    do {
+        ret = sgx_exitless_ocall(OCALL_GET_OCALL_STATS, ocall_args);
+    } while (ret == -EINTR);
+    if (ret < 0) {
+        ret = -EPERM;
+        goto out;
+    }
+
+    /* stats are reported by the untrusted runtime and are only informational, so there is nothing
+     * to verify */
+    if (!sgx_copy_to_enclave(stats, sizeof(ocall_args->stats), ocall_args->stats,
+                             sizeof(ocall_args->stats))) {
+        ret = -EPERM;
+        goto out;
+    }
+
+    ret = 0;
+
+out:
+    sgx_reset_ustack(old_ustack);
+    return ret;
+}
@@ -14,6 +14,9 @@
 
 noreturn void ocall_exit(int exitcode, int is_exitgroup);
 
+/* log hit/miss statistics of the per-thread cache of untrusted buffers used by OCALLs */
+void log_untrusted_cache_stats(void);
+
 int ocall_mmap_untrusted(void** addrptr, size_t size, int prot, int flags, int fd, off_t offset);
 
 int ocall_munmap_untrusted(const void* addr, size_t size);
@@ -32,6 +35,38 @@ ssize_t ocall_pread(int fd, void* buf, size_t count, off_t offset);
 
 ssize_t ocall_pwrite(int fd, const void* buf, size_t count, off_t offset);
 
+/* Data is transferred on the host and never enters the enclave. */
+ssize_t ocall_sendfile(int out_fd, int in_fd, off_t offset, size_t count);
+
+ssize_t ocall_copy_file_range(int fd_in, off_t off_in, int fd_out, off_t off_out, size_t count);
+
+/* maximum number of operations submitted to the host in one OCALL by ocall_batch_io() */
+#define OCALL_BATCH_MAX_ENTRIES 64
+
+struct ocall_batch_io {
+    bool is_write;
+    int fd;
+    void* buf;
+    size_t count;
+    off_t offset;
+    ssize_t result; /* number of bytes read/written or negative errno */
+};
+
+/*!
+ * \brief Execute several independent pread/pwrite operations on host files with a single OCALL.
+ *
+ * \param[in,out] ios      Operations to execute; `result` of each processed operation is set on
+ *                         return.
+ * \param         ios_cnt  Number of operations in \p ios.
+ *
+ * \returns Number of processed operations (a non-empty prefix of \p ios), or negative errno.
+ *
+ * Buffers of all batched operations are bounced through the untrusted stack, so only a prefix of
+ * \p ios that fits there (and has at most OCALL_BATCH_MAX_ENTRIES operations) is processed; the
+ * caller must resubmit the rest. An operation that cannot be batched is executed on its own.
+ */
+int ocall_batch_io(struct ocall_batch_io* ios, size_t ios_cnt);
+
 int ocall_fstat(int fd, struct stat* buf);
 
 int ocall_fionread(int fd);
@@ -140,3 +175,17 @@ int ocall_get_qe_targetinfo(sgx_target_info_t* qe_targetinfo);
 int ocall_edmm_restrict_pages_perm(uint64_t addr, size_t count, uint64_t prot);
 int ocall_edmm_modify_pages_type(uint64_t addr, size_t count, uint64_t type);
 int ocall_edmm_remove_pages(uint64_t addr, size_t count);
+int ocall_edmm_augment_pages(uint64_t addr, size_t count);
+
+struct ocall_stats;
+
+/*!
+ * \brief Get per-OCALL statistics of this process, collected by the untrusted runtime.
+ *
+ * \param[out] stats  Array of OCALL_NR entries, indexed by OCALL number.
+ *
+ * \returns 0 on success, negative Linux error code otherwise.
+ *
+ * The statistics are not validated in any way and must be used for informational purposes only.
+ */
+int ocall_get_ocall_stats(struct ocall_stats* stats);
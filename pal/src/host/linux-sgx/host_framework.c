@@ -439,6 +439,24 @@ int edmm_remove_pages(uint64_t addr, size_t count) {
     return 0;
 }
 
+/*
+ * Adds (EAUGs) the not yet present pages in the range to the enclave, in the pending state. The SGX
+ * driver does this on the first access to such a page, also from outside of the enclave (such
+ * reads return all ones, like for any enclave page). Otherwise the enclave's EACCEPT of each page
+ * would cause an AEX, so committing many pages takes only one enclave exit this way.
+ */
+int edmm_augment_pages(uint64_t addr, size_t count) {
+    uint64_t enclave_end = g_pal_enclave.baseaddr + g_pal_enclave.size;
+    if (addr < g_pal_enclave.baseaddr || addr > enclave_end
+            || count > (enclave_end - addr) / PAGE_SIZE)
+        return -EINVAL;
+
+    for (size_t i = 0; i < count; i++)
+        (void)*(volatile uint8_t*)(addr + i * PAGE_SIZE);
+
+    return 0;
+}
+
 /* must be called after open_sgx_driver() */
 int edmm_supported_by_driver(bool* out_supported) {
     struct sgx_enclave_remove_pages params = { .offset = 0, .length = 0 }; /* dummy */
@@ -43,6 +43,7 @@ struct pal_enclave {
     unsigned long rpc_thread_num;
     unsigned long ssa_frame_size;
     bool edmm_enabled;
+    bool use_io_uring;
     enum sgx_attestation_type attestation_type;
     char* libpal_uri; /* Path to the PAL binary */
 
@@ -77,6 +78,7 @@ int add_pages_to_enclave(sgx_arch_secs_t* secs, void* addr, void* user_addr, uns
 int edmm_restrict_pages_perm(uint64_t addr, size_t count, uint64_t prot);
 int edmm_modify_pages_type(uint64_t addr, size_t count, uint64_t type);
 int edmm_remove_pages(uint64_t addr, size_t count);
+int edmm_augment_pages(uint64_t addr, size_t count);
 int edmm_supported_by_driver(bool* out_supported);
 
 /*!
@@ -123,6 +125,28 @@ int block_async_signals(bool block);
 
 int set_tcs_debug_flag_if_debugging(void* tcs_addrs[], size_t count);
 
+struct ocall_batch_entry;
+
+/*!
+ * \brief Execute entries of a batched OCALL using io_uring.
+ *
+ * \param[in,out] entries      Entries to execute; on success, `result` of each entry is set.
+ * \param         entries_cnt  Number of entries.
+ *
+ * \returns 0 on success, negative error code if io_uring cannot be used (then no entry was
+ *          executed and the caller must fall back to regular syscalls).
+ */
+long io_uring_exec_batch(struct ocall_batch_entry* entries, size_t entries_cnt);
+
+struct ocall_stats;
+
+/* per-OCALL statistics (host_ocalls.c); `stats` arrays have OCALL_NR entries */
+long sgx_ocall_dispatch(uint64_t ocall_index, void* args);
+void add_ocall_stats(struct ocall_stats* stats, const struct ocall_stats* other);
+void collect_ocall_stats(struct ocall_stats* stats);
+void collect_threads_ocall_stats(struct ocall_stats* stats); /* host_thread.c */
+void log_ocall_stats(void);
+
 #ifdef DEBUG
 /* SGX profiling (host_profile.c) */
 
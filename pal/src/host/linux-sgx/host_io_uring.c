@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/* Copyright (C) 2026 Intel Corporation */
+
+/*
+ * io_uring backend for batched OCALLs (`OCALL_BATCH`), enabled with `sgx.use_io_uring = true`.
+ *
+ * All operations of a batch are submitted to the host kernel with a single `io_uring_enter()`
+ * syscall and are executed concurrently (e.g. reads of several file blocks are dispatched to the
+ * storage device together), instead of one blocking syscall after another.
+ *
+ * io_uring instances are not thread-safe, so there is a small pool of them, each protected by a
+ * spinlock. Instances are set up lazily, on first use. A thread that finds all instances busy, or
+ * a host kernel without io_uring support (or with io_uring disabled, e.g. via seccomp or the
+ * `kernel.io_uring_disabled` sysctl), makes the caller fall back to plain blocking syscalls.
+ */
+
+#include <asm/errno.h>
+#include <asm/mman.h>
+#include <linux/io_uring.h>
+
+#include "host_internal.h"
+#include "linux_utils.h"
+#include "pal_ocall_types.h"
+#include "spinlock.h"
+
+/* maximum number of operations in flight on one io_uring instance */
+#define IO_URING_ENTRIES 64
+/* size of the pool of io_uring instances, i.e. the maximum number of concurrent batches */
+#define IO_URING_INSTANCES 16
+
+struct host_io_uring {
+    spinlock_t lock;
+    bool initialized;
+
+    int fd;
+    uint32_t* sq_tail;
+    uint32_t* sq_mask;
+    uint32_t* sq_array;
+    struct io_uring_sqe* sqes;
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    struct iovec iovs[IO_URING_ENTRIES];
+};
+
+static struct host_io_uring g_io_urings[IO_URING_INSTANCES];
+
+/* set if the host kernel failed to set up an io_uring instance, no further attempts are made */
+static bool g_io_uring_unavailable = false;
+
+static int setup_io_uring(struct host_io_uring* ring) {
+    struct io_uring_params params = {0};
+    int fd = DO_SYSCALL(io_uring_setup, IO_URING_ENTRIES, &params);
+    if (fd < 0)
+        return fd;
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        sq_size = cq_size = MAX(sq_size, cq_size);
+
+    int ret;
+    void* sq_ptr = (void*)DO_SYSCALL(mmap, NULL, sq_size, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (IS_PTR_ERR(sq_ptr)) {
+        ret = PTR_TO_ERR(sq_ptr);
+        goto out_close;
+    }
+
+    void* cq_ptr = sq_ptr;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        cq_ptr = (void*)DO_SYSCALL(mmap, NULL, cq_size, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (IS_PTR_ERR(cq_ptr)) {
+            ret = PTR_TO_ERR(cq_ptr);
+            goto out_unmap_sq;
+        }
+    }
+
+    void* sqes = (void*)DO_SYSCALL(mmap, NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+                                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                   IORING_OFF_SQES);
+    if (IS_PTR_ERR(sqes)) {
+        ret = PTR_TO_ERR(sqes);
+        goto out_unmap_cq;
+    }
+
+    ring->fd       = fd;
+    ring->sq_tail  = sq_ptr + params.sq_off.tail;
+    ring->sq_mask  = sq_ptr + params.sq_off.ring_mask;
+    ring->sq_array = sq_ptr + params.sq_off.array;
+    ring->sqes     = sqes;
+    ring->cq_head  = cq_ptr + params.cq_off.head;
+    ring->cq_tail  = cq_ptr + params.cq_off.tail;
+    ring->cq_mask  = cq_ptr + params.cq_off.ring_mask;
+    ring->cqes     = cq_ptr + params.cq_off.cqes;
+    return 0;
+
+out_unmap_cq:
+    if (cq_ptr != sq_ptr)
+        DO_SYSCALL(munmap, cq_ptr, cq_size);
+out_unmap_sq:
+    DO_SYSCALL(munmap, sq_ptr, sq_size);
+out_close:
+    DO_SYSCALL(close, fd);
+    return ret;
+}
+
+static struct host_io_uring* get_io_uring(void) {
+    if (__atomic_load_n(&g_io_uring_unavailable, __ATOMIC_RELAXED))
+        return NULL;
+
+    for (size_t i = 0; i < IO_URING_INSTANCES; i++) {
+        struct host_io_uring* ring = &g_io_urings[i];
+        if (!spinlock_lock_timeout(&ring->lock, /*iterations=*/0))
+            continue;
+
+        if (!ring->initialized) {
+            int ret = setup_io_uring(ring);
+            if (ret < 0) {
+                log_warning("io_uring is not available on the host (error %d), falling back to "
+                            "blocking syscalls", ret);
+                __atomic_store_n(&g_io_uring_unavailable, true, __ATOMIC_RELAXED);
+                spinlock_unlock(&ring->lock);
+                return NULL;
+            }
+            ring->initialized = true;
+        }
+        return ring;
+    }
+    return NULL;
+}
+
+/* Executes up to IO_URING_ENTRIES entries; returns number of operations (operations which could
+ * not be submitted have the submission error as result) or negative errno if none could be
+ * submitted. */
+static long exec_entries(struct host_io_uring* ring, struct ocall_batch_entry* entries,
+                         size_t entries_cnt) {
+    uint32_t sq_tail = *ring->sq_tail;
+    uint32_t sq_mask = *ring->sq_mask;
+    uint32_t to_submit = 0;
+
+    for (size_t i = 0; i < entries_cnt; i++) {
+        struct ocall_batch_entry* entry = &entries[i];
+        uint32_t idx = (sq_tail + to_submit) & sq_mask;
+        struct io_uring_sqe* sqe = &ring->sqes[idx];
+
+        memset(sqe, 0, sizeof(*sqe));
+        if (entry->ocall_index == OCALL_PREAD) {
+            struct ocall_pread* args = entry->args;
+            ring->iovs[i] = (struct iovec){ .iov_base = args->buf, .iov_len = args->count };
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd     = args->fd;
+            sqe->off    = args->offset;
+        } else if (entry->ocall_index == OCALL_PWRITE) {
+            struct ocall_pwrite* args = entry->args;
+            ring->iovs[i] = (struct iovec){ .iov_base = (void*)args->buf, .iov_len = args->count };
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->fd     = args->fd;
+            sqe->off    = args->offset;
+        } else {
+            entry->result = -EINVAL;
+            continue;
+        }
+        sqe->addr      = (uint64_t)&ring->iovs[i];
+        sqe->len       = 1;
+        sqe->user_data = i;
+
+        ring->sq_array[idx] = idx;
+        to_submit++;
+    }
+
+    if (!to_submit)
+        return 0;
+
+    __atomic_store_n(ring->sq_tail, sq_tail + to_submit, __ATOMIC_RELEASE);
+
+    uint32_t submitted = 0;
+    uint32_t completed = 0;
+    /* after a submission error, only the operations already in flight are waited for */
+    bool submit_failed = false;
+    while (completed < submitted || (!submit_failed && submitted < to_submit)) {
+        uint32_t submit_cnt = submit_failed ? 0 : to_submit - submitted;
+        long ret = DO_SYSCALL(io_uring_enter, ring->fd, submit_cnt,
+                              submitted + submit_cnt - completed, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            if (!submitted) {
+                /* nothing was consumed by the kernel, so we can take back the SQEs */
+                __atomic_store_n(ring->sq_tail, sq_tail, __ATOMIC_RELEASE);
+                return ret;
+            }
+            if (!submit_failed) {
+                /* the kernel consumes SQEs in order and did not consume the rest; take them back
+                 * and fail their operations with the error */
+                for (uint32_t i = submitted; i < to_submit; i++) {
+                    uint32_t idx = (sq_tail + i) & sq_mask;
+                    entries[ring->sqes[idx].user_data].result = ret;
+                }
+                __atomic_store_n(ring->sq_tail, sq_tail + submitted, __ATOMIC_RELEASE);
+                log_error("io_uring_enter failed after submitting %u of %u operations "
+                          "(error %ld)", submitted, to_submit, ret);
+                submit_failed = true;
+            }
+            /* the operations in flight must be waited for in any case */
+            ret = 0;
+        }
+        if (ret > 0)
+            submitted += ret;
+
+        uint32_t cq_head = *ring->cq_head;
+        uint32_t cq_tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; cq_head != cq_tail; cq_head++) {
+            struct io_uring_cqe* cqe = &ring->cqes[cq_head & *ring->cq_mask];
+            entries[cqe->user_data].result = cqe->res;
+            completed++;
+        }
+        __atomic_store_n(ring->cq_head, cq_head, __ATOMIC_RELEASE);
+    }
+
+    return to_submit;
+}
+
+long io_uring_exec_batch(struct ocall_batch_entry* entries, size_t entries_cnt) {
+    struct host_io_uring* ring = get_io_uring();
+    if (!ring)
+        return -ENOSYS;
+
+    long ret = 0;
+    for (size_t done = 0; done < entries_cnt; done += IO_URING_ENTRIES) {
+        ret = exec_entries(ring, &entries[done], MIN(entries_cnt - done, (size_t)IO_URING_ENTRIES));
+        if (ret < 0) {
+            if (done) {
+                /* first chunk(s) already executed, cannot report failure for the whole batch */
+                log_error("io_uring_enter failed in the middle of a batch (error %ld)", ret);
+                for (size_t i = done; i < entries_cnt; i++)
+                    entries[i].result = ret;
+                ret = 0;
+            }
+            break;
+        }
+        ret = 0;
+    }
+
+    spinlock_unlock(&ring->lock);
+    return ret;
+}
@@ -689,8 +689,16 @@ static int parse_loader_config(char* manifest, struct pal_enclave* enclave_info,
     }
     enclave_info->rpc_thread_num = rpc_thread_num_int64;
 
-    if (enclave_info->rpc_thread_num && enclave_info->thread_num > RPC_QUEUE_SIZE) {
-        log_error("Too many threads for exitless feature (more than capacity of RPC queue)");
+    if (enclave_info->rpc_thread_num && enclave_info->thread_num > MAX_RPC_RINGS) {
+        log_error("Too many threads for exitless feature (more than number of RPC rings)");
+        ret = -EINVAL;
+        goto out;
+    }
+
+    ret = toml_bool_in(manifest_root, "sgx.use_io_uring", /*defaultval=*/false,
+                       &enclave_info->use_io_uring);
+    if (ret < 0) {
+        log_error("Cannot parse 'sgx.use_io_uring' (the value must be `true` or `false`)");
         ret = -EINVAL;
         goto out;
     }
@@ -30,12 +30,28 @@
 
 rpc_queue_t* g_rpc_queue = NULL; /* pointer to untrusted queue */
 
+/* per-OCALL stats of RPC threads, one array of OCALL_NR entries per RPC thread */
+static struct ocall_stats (*g_rpc_ocall_stats)[OCALL_NR] = NULL;
+static size_t g_rpc_ocall_stats_cnt = 0;
+
+/* Number of RPC threads that poll the RPC rings; RPC threads with index >= this number are parked
+ * on a futex on this variable. Adapts to the load in `rpc_thread_loop()`, between 1 and the total
+ * number of RPC threads `g_rpc_threads_max`. Unless all RPC threads are active, at least one active
+ * RPC thread is kept not busy, so that requests are always picked up even if all other active RPC
+ * threads are blocked in long OCALLs (enclave threads cannot wake up parked RPC threads). */
+static uint32_t g_rpc_active_cnt = 0;
+static uint32_t g_rpc_threads_max = 0;
+/* number of RPC threads currently executing an OCALL */
+static uint32_t g_rpc_busy_cnt = 0;
+
 static noreturn void process_exit(int exitcode) {
 #ifdef DEBUG
     update_sgx_stats_on_exit(/*do_print=*/true);
     sgx_profile_finish();
 #endif
 
+    log_ocall_stats();
+
 #ifdef SGX_VTUNE_PROFILE
     if (g_vtune_profile_enabled) {
         extern void __itt_fini_ittlib(void);
@@ -147,6 +163,22 @@ static long sgx_ocall_pwrite(void* args) {
                                     ocall_pwrite_args->count, ocall_pwrite_args->offset);
 }
 
+static long sgx_ocall_sendfile(void* args) {
+    struct ocall_sendfile* ocall_sendfile_args = args;
+    return DO_SYSCALL_INTERRUPTIBLE(sendfile, ocall_sendfile_args->out_fd,
+                                    ocall_sendfile_args->in_fd, &ocall_sendfile_args->offset,
+                                    ocall_sendfile_args->count);
+}
+
+static long sgx_ocall_copy_file_range(void* args) {
+    struct ocall_copy_file_range* ocall_copy_file_range_args = args;
+    return DO_SYSCALL_INTERRUPTIBLE(copy_file_range, ocall_copy_file_range_args->fd_in,
+                                    &ocall_copy_file_range_args->off_in,
+                                    ocall_copy_file_range_args->fd_out,
+                                    &ocall_copy_file_range_args->off_out,
+                                    ocall_copy_file_range_args->count, /*flags=*/0);
+}
+
 static long sgx_ocall_fstat(void* args) {
     struct ocall_fstat* ocall_fstat_args = args;
     return DO_SYSCALL_INTERRUPTIBLE(fstat, ocall_fstat_args->fd, &ocall_fstat_args->stat);
@@ -732,11 +764,50 @@ static long sgx_ocall_edmm_remove_pages(void* _args) {
     return edmm_remove_pages(args->addr, args->count);
 }
 
+static long sgx_ocall_edmm_augment_pages(void* _args) {
+    struct ocall_edmm_augment_pages* args = _args;
+    return edmm_augment_pages(args->addr, args->count);
+}
+
 static long sgx_ocall_edmm_restrict_pages_perm(void* _args) {
     struct ocall_edmm_restrict_pages_perm* args = _args;
     return edmm_restrict_pages_perm(args->addr, args->count, args->prot);
 }
 
+static long sgx_ocall_batch(void* args) {
+    struct ocall_batch* ocall_batch_args = args;
+
+    if (g_pal_enclave.use_io_uring
+            && io_uring_exec_batch(ocall_batch_args->entries, ocall_batch_args->entries_cnt) == 0)
+        return 0;
+
+    /* Entries are independent of each other, so all of them are executed even if some fail; the
+     * enclave checks per-entry results. Only a small whitelist of OCALLs may be batched: these
+     * cannot block for a long time nor change the state of the enclave. */
+    for (size_t i = 0; i < ocall_batch_args->entries_cnt; i++) {
+        struct ocall_batch_entry* entry = &ocall_batch_args->entries[i];
+        switch (entry->ocall_index) {
+            case OCALL_PREAD:
+                entry->result = sgx_ocall_pread(entry->args);
+                break;
+            case OCALL_PWRITE:
+                entry->result = sgx_ocall_pwrite(entry->args);
+                break;
+            default:
+                entry->result = -EINVAL;
+                break;
+        }
+    }
+    return 0;
+}
+
+static long sgx_ocall_get_ocall_stats(void* args) {
+    struct ocall_get_ocall_stats* ocall_stats_args = args;
+    memset(ocall_stats_args->stats, 0, sizeof(ocall_stats_args->stats));
+    collect_ocall_stats(ocall_stats_args->stats);
+    return 0;
+}
+
 sgx_ocall_fn_t ocall_table[OCALL_NR] = {
     [OCALL_EXIT]                     = sgx_ocall_exit,
     [OCALL_MMAP_UNTRUSTED]           = sgx_ocall_mmap_untrusted,
@@ -787,9 +858,112 @@ sgx_ocall_fn_t ocall_table[OCALL_NR] = {
     [OCALL_GET_QE_TARGETINFO]        = sgx_ocall_get_qe_targetinfo,
     [OCALL_EDMM_MODIFY_PAGES_TYPE]   = sgx_ocall_edmm_modify_pages_type,
     [OCALL_EDMM_REMOVE_PAGES]        = sgx_ocall_edmm_remove_pages,
+    [OCALL_EDMM_AUGMENT_PAGES]       = sgx_ocall_edmm_augment_pages,
     [OCALL_EDMM_RESTRICT_PAGES_PERM] = sgx_ocall_edmm_restrict_pages_perm,
+    [OCALL_BATCH]                    = sgx_ocall_batch,
+    [OCALL_GET_OCALL_STATS]          = sgx_ocall_get_ocall_stats,
+    [OCALL_SENDFILE]                 = sgx_ocall_sendfile,
+    [OCALL_COPY_FILE_RANGE]          = sgx_ocall_copy_file_range,
 };
 
+/* Returns the number of bytes read or written by an OCALL, or 0 if it doesn't perform I/O. */
+static uint64_t ocall_io_bytes(uint64_t ocall_index, void* args, long result) {
+    switch (ocall_index) {
+        case OCALL_READ:
+        case OCALL_WRITE:
+        case OCALL_PREAD:
+        case OCALL_PWRITE:
+        case OCALL_RECV:
+        case OCALL_SEND:
+        case OCALL_SENDFILE:
+        case OCALL_COPY_FILE_RANGE:
+            return result > 0 ? (uint64_t)result : 0;
+        case OCALL_BATCH: {
+            struct ocall_batch* ocall_batch_args = args;
+            uint64_t bytes = 0;
+            for (size_t i = 0; i < ocall_batch_args->entries_cnt; i++)
+                if (ocall_batch_args->entries[i].result > 0)
+                    bytes += ocall_batch_args->entries[i].result;
+            return bytes;
+        }
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Per-OCALL stats are always collected, so this must be cheap: each thread updates only its own
+ * counters (in the host TCB for enclave threads, in `g_rpc_ocall_stats` for RPC threads), without
+ * atomic read-modify-write instructions. Readers (`collect_ocall_stats()`) only need each counter
+ * to be written with a single store.
+ */
+static void record_ocall_stats(struct ocall_stats* stats, uint64_t ocall_index, void* args,
+                               long result, uint64_t cycles, bool exitless) {
+    struct ocall_stats* s = &stats[ocall_index];
+    __atomic_store_n(&s->calls, s->calls + 1, __ATOMIC_RELAXED);
+    if (exitless)
+        __atomic_store_n(&s->exitless_calls, s->exitless_calls + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->cycles, s->cycles + cycles, __ATOMIC_RELAXED);
+    if (cycles > s->max_cycles)
+        __atomic_store_n(&s->max_cycles, cycles, __ATOMIC_RELAXED);
+
+    uint64_t bytes = ocall_io_bytes(ocall_index, args, result);
+    if (bytes)
+        __atomic_store_n(&s->bytes, s->bytes + bytes, __ATOMIC_RELAXED);
+}
+
+/* called from host_entry.S on each OCALL which exits the enclave */
+long sgx_ocall_dispatch(uint64_t ocall_index, void* args) {
+    uint64_t start = get_tsc();
+    long result = ocall_table[ocall_index](args);
+    record_ocall_stats(pal_get_host_tcb()->ocall_stats, ocall_index, args, result,
+                       get_tsc() - start, /*exitless=*/false);
+    return result;
+}
+
+void add_ocall_stats(struct ocall_stats* stats, const struct ocall_stats* other) {
+    for (size_t i = 0; i < OCALL_NR; i++) {
+        stats[i].calls          += __atomic_load_n(&other[i].calls, __ATOMIC_RELAXED);
+        stats[i].exitless_calls += __atomic_load_n(&other[i].exitless_calls, __ATOMIC_RELAXED);
+        stats[i].cycles         += __atomic_load_n(&other[i].cycles, __ATOMIC_RELAXED);
+        stats[i].bytes          += __atomic_load_n(&other[i].bytes, __ATOMIC_RELAXED);
+        stats[i].max_cycles = MAX(stats[i].max_cycles,
+                                  __atomic_load_n(&other[i].max_cycles, __ATOMIC_RELAXED));
+    }
+}
+
+/* adds up per-OCALL stats of all enclave and RPC threads of this process into `stats` */
+void collect_ocall_stats(struct ocall_stats* stats) {
+    collect_threads_ocall_stats(stats);
+
+    size_t rpc_stats_cnt = __atomic_load_n(&g_rpc_ocall_stats_cnt, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < rpc_stats_cnt; i++)
+        add_ocall_stats(stats, g_rpc_ocall_stats[i]);
+}
+
+void log_ocall_stats(void) {
+    static struct ocall_stats stats[OCALL_NR];
+    memset(stats, 0, sizeof(stats));
+    collect_ocall_stats(stats);
+
+    log_debug("----- OCALL stats for process %d -----", g_host_pid);
+    log_debug("%-28s %12s %12s %16s %12s %16s", "ocall", "calls", "exitless", "cycles",
+              "max_cycles", "bytes");
+    for (size_t i = 0; i < OCALL_NR; i++) {
+        if (!stats[i].calls)
+            continue;
+        log_debug("%-28s %12lu %12lu %16lu %12lu %16lu", g_ocall_names[i], stats[i].calls,
+                  stats[i].exitless_calls, stats[i].cycles, stats[i].max_cycles, stats[i].bytes);
+    }
+}
+
+static bool rpc_rings_pending(uint64_t rings_cnt) {
+    for (uint64_t i = 0; i < rings_cnt; i++)
+        if (rpc_ring_pending(&g_rpc_queue->rings[i]))
+            return true;
+    return false;
+}
+
 static int rpc_thread_loop(void* arg) {
     __UNUSED(arg);
     long mytid = DO_SYSCALL(gettid);
@@ -801,41 +975,115 @@ static int rpc_thread_loop(void* arg) {
     DO_SYSCALL(rt_sigprocmask, SIG_SETMASK, &mask, NULL, sizeof(mask));
 
     spinlock_lock(&g_rpc_queue->lock);
-    g_rpc_queue->rpc_threads[g_rpc_queue->rpc_threads_cnt] = mytid;
+    size_t my_idx = g_rpc_queue->rpc_threads_cnt;
+    g_rpc_queue->rpc_threads[my_idx] = mytid;
     g_rpc_queue->rpc_threads_cnt++;
     spinlock_unlock(&g_rpc_queue->lock);
 
+    struct ocall_stats* my_stats = g_rpc_ocall_stats[my_idx];
+
     static const uint64_t SPIN_ATTEMPTS_MAX = 10000;     /* rather arbitrary */
+    static const uint64_t SPIN_ATTEMPTS_MIN = 100;
     static const uint64_t SLEEP_TIME_MAX    = 100000000; /* nanoseconds (0.1 seconds) */
     static const uint64_t SLEEP_TIME_STEP   = 1000000;   /* 100 steps before capped */
 
     /* no races possible since vars are thread-local and RPC threads don't receive signals */
+    uint64_t spin_budget   = SPIN_ATTEMPTS_MAX;
     uint64_t spin_attempts = 0;
     uint64_t sleep_time    = 0;
 
     while (1) {
-        rpc_request_t* req = rpc_dequeue(g_rpc_queue);
-        if (!req) {
-            if (spin_attempts == SPIN_ATTEMPTS_MAX) {
-                if (sleep_time < SLEEP_TIME_MAX)
-                    sleep_time += SLEEP_TIME_STEP;
+        uint32_t active_cnt = __atomic_load_n(&g_rpc_active_cnt, __ATOMIC_ACQUIRE);
+        if (my_idx >= active_cnt) {
+            /* this RPC thread is deactivated, sleep until the pool grows (returns immediately if
+             * `g_rpc_active_cnt` changed in the meantime) */
+            int ret = DO_SYSCALL(futex, &g_rpc_active_cnt, FUTEX_WAIT_PRIVATE, active_cnt, NULL,
+                                 NULL, 0);
+            if (ret < 0 && ret != -EAGAIN && ret != -EINTR)
+                log_error("RPC thread failed to wait on futex (error %d)", ret);
+            spin_attempts = 0;
+            sleep_time    = 0;
+            continue;
+        }
 
-                struct timespec tv = {.tv_sec = 0, .tv_nsec = sleep_time};
-                (void)DO_SYSCALL(nanosleep, &tv, /*rem=*/NULL);
-            } else {
+        /* the value is written by the enclave; clamp it just in case */
+        uint64_t rings_cnt = MIN(__atomic_load_n(&g_rpc_queue->rings_cnt, __ATOMIC_ACQUIRE),
+                                 (uint64_t)MAX_RPC_RINGS);
+
+        /* poll the "home" ring of this RPC thread first, then steal from all other rings */
+        rpc_request_t* req = NULL;
+        for (uint64_t i = 0; i < rings_cnt && !req; i++)
+            req = rpc_dequeue(&g_rpc_queue->rings[(my_idx + i) % rings_cnt]);
+
+        if (!req) {
+            if (spin_attempts < spin_budget) {
                 spin_attempts++;
                 CPU_RELAX();
+                continue;
             }
+
+            if (sleep_time == 0) {
+                /* spinning timed out, spin less next time (requests arrive rarely) */
+                spin_budget = MAX(spin_budget / 2, SPIN_ATTEMPTS_MIN);
+            }
+
+            if (sleep_time < SLEEP_TIME_MAX) {
+                sleep_time += SLEEP_TIME_STEP;
+            } else if (my_idx + 1 == active_cnt && active_cnt > 1
+                           && __atomic_load_n(&g_rpc_busy_cnt, __ATOMIC_SEQ_CST) + 1 < active_cnt
+                           && !rpc_rings_pending(rings_cnt)) {
+                /* idle for a long time and the last active RPC thread, deactivate itself if some
+                 * other active RPC thread is not busy; the pool shrinks one thread at a time, from
+                 * the highest index */
+                uint32_t new_active_cnt = active_cnt - 1;
+                if (__atomic_compare_exchange_n(&g_rpc_active_cnt, &active_cnt, new_active_cnt,
+                                                /*weak=*/false, __ATOMIC_SEQ_CST,
+                                                __ATOMIC_RELAXED)
+                        && __atomic_load_n(&g_rpc_busy_cnt, __ATOMIC_SEQ_CST) >= new_active_cnt) {
+                    /* raced with the remaining RPC threads becoming busy (they saw the old active
+                     * count and didn't grow the pool), stay active; failure means that the pool
+                     * was grown by another thread in the meantime */
+                    __atomic_compare_exchange_n(&g_rpc_active_cnt, &new_active_cnt, active_cnt,
+                                                /*weak=*/false, __ATOMIC_SEQ_CST,
+                                                __ATOMIC_RELAXED);
+                }
+                continue;
+            }
+
+            struct timespec tv = {.tv_sec = 0, .tv_nsec = sleep_time};
+            (void)DO_SYSCALL(nanosleep, &tv, /*rem=*/NULL);
             continue;
         }
 
+        if (sleep_time == 0) {
+            /* request came while spinning, spinning pays off so spin longer next time */
+            spin_budget = MIN(spin_budget * 2, SPIN_ATTEMPTS_MAX);
+        }
+
         /* new request came, reset spin/sleep heuristics */
         spin_attempts = 0;
         sleep_time    = 0;
 
+        uint32_t busy_cnt = __atomic_add_fetch(&g_rpc_busy_cnt, 1, __ATOMIC_SEQ_CST);
+        active_cnt = __atomic_load_n(&g_rpc_active_cnt, __ATOMIC_SEQ_CST);
+        if (busy_cnt >= active_cnt && active_cnt < g_rpc_threads_max) {
+            /* all active RPC threads are busy (and this OCALL may block for long), activate one
+             * more so that new requests don't wait for the busy ones */
+            if (__atomic_compare_exchange_n(&g_rpc_active_cnt, &active_cnt, active_cnt + 1,
+                                            /*weak=*/false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                int ret = DO_SYSCALL(futex, &g_rpc_active_cnt, FUTEX_WAKE_PRIVATE, INT_MAX, NULL,
+                                     NULL, 0);
+                if (ret < 0)
+                    log_error("RPC thread failed to wake up other RPC threads (error %d)", ret);
+            }
+        }
+
         /* call actual function and notify awaiting enclave thread when done */
+        uint64_t start = get_tsc();
         sgx_ocall_fn_t f = ocall_table[req->ocall_index];
         req->result = f(req->buffer);
+        record_ocall_stats(my_stats, req->ocall_index, req->buffer, req->result,
+                           get_tsc() - start, /*exitless=*/true);
 
         /* this code is based on Mutex 2 from Futexes are Tricky */
         int old_lock_state = __atomic_fetch_sub(&req->lock.lock, 1, __ATOMIC_ACQ_REL);
@@ -846,6 +1094,8 @@ static int rpc_thread_loop(void* arg) {
             if (ret == -1)
                 log_error("RPC thread failed to wake up enclave thread");
         }
+
+        __atomic_sub_fetch(&g_rpc_busy_cnt, 1, __ATOMIC_RELAXED);
     }
 
     /* NOTREACHED */
@@ -863,6 +1113,18 @@ int start_rpc(size_t threads_cnt) {
     /* initialize g_rpc_queue just for sanity, it will be overwritten by in-enclave code */
     rpc_queue_init(g_rpc_queue);
 
+    /* start with all RPC threads active, idle ones deactivate themselves soon */
+    g_rpc_threads_max = threads_cnt;
+    g_rpc_active_cnt  = threads_cnt;
+
+    g_rpc_ocall_stats = (void*)DO_SYSCALL(mmap, NULL,
+                                          ALIGN_UP(threads_cnt * sizeof(*g_rpc_ocall_stats),
+                                                   PRESET_PAGESIZE),
+                                          PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE,
+                                          -1, 0);
+    if (IS_PTR_ERR(g_rpc_ocall_stats))
+        return -ENOMEM;
+
     for (size_t i = 0; i < threads_cnt; i++) {
         void* stack = (void*)DO_SYSCALL(mmap, NULL, RPC_STACK_SIZE, PROT_READ | PROT_WRITE,
                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
@@ -895,5 +1157,7 @@ int start_rpc(size_t threads_cnt) {
         DO_SYSCALL(sched_yield);
     }
 
+    __atomic_store_n(&g_rpc_ocall_stats_cnt, threads_cnt, __ATOMIC_RELEASE);
+
     return 0;
 }
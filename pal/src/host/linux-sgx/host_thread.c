@@ -36,6 +36,9 @@ static uint64_t g_aex_cnt          = 0;
 static uint64_t g_sync_signal_cnt  = 0;
 static uint64_t g_async_signal_cnt = 0;
 
+/* per-OCALL stats of threads which already exited; protected by g_enclave_thread_map_lock */
+static struct ocall_stats g_exited_threads_ocall_stats[OCALL_NR];
+
 static void print_global_sgx_stats(void) {
     assert(spinlock_is_locked(&g_enclave_thread_map_lock));
 
@@ -128,6 +131,7 @@ void pal_host_tcb_init(PAL_HOST_TCB* tcb, void* stack, void* alt_stack) {
     tcb->sync_signal_cnt  = 0;
     tcb->async_signal_cnt = 0;
     tcb->reset_stats      = false;
+    memset(tcb->ocall_stats, 0, sizeof(tcb->ocall_stats));
 
     tcb->profile_sample_time = 0;
 
@@ -245,6 +249,12 @@ static void map_tcs(unsigned int tid, PAL_HOST_TCB* tcb) {
 void unmap_my_tcs(void) {
     size_t i = 0;
     spinlock_lock(&g_enclave_thread_map_lock);
+
+    /* this thread doesn't perform any more OCALLs, so we can move away its stats */
+    PAL_HOST_TCB* tcb = pal_get_host_tcb();
+    add_ocall_stats(g_exited_threads_ocall_stats, tcb->ocall_stats);
+    memset(tcb->ocall_stats, 0, sizeof(tcb->ocall_stats));
+
     for (i = 0; i < g_enclave_thread_num; i++)
         if (g_enclave_thread_map[i].tcs == pal_get_host_tcb()->tcs) {
             g_enclave_thread_map[i].tid = 0;
@@ -257,6 +267,20 @@ void unmap_my_tcs(void) {
     spinlock_unlock(&g_enclave_thread_map_lock);
 }
 
+/* Adds up per-OCALL stats of all enclave threads, including the ones which already exited. Stats
+ * of running threads are read without synchronization with these threads, which is fine: each
+ * counter is updated by its thread with a single store, so we never see torn values. */
+void collect_threads_ocall_stats(struct ocall_stats* stats) {
+    spinlock_lock(&g_enclave_thread_map_lock);
+    add_ocall_stats(stats, g_exited_threads_ocall_stats);
+    for (size_t i = 0; i < g_enclave_thread_num; i++) {
+        if (!g_enclave_thread_map[i].tcs || !g_enclave_thread_map[i].tid)
+            continue;
+        add_ocall_stats(stats, g_enclave_thread_map[i].tcb->ocall_stats);
+    }
+    spinlock_unlock(&g_enclave_thread_map_lock);
+}
+
 int current_enclave_thread_cnt(void) {
     int ret = 0;
     spinlock_lock(&g_enclave_thread_map_lock);
@@ -523,8 +523,10 @@ void _PalExceptionHandler(uint32_t trusted_exit_info_,
 #endif
 
         pal_prot_flags_t prot_flags;
+        uintptr_t range_begin;
+        uintptr_t range_end;
 
-        if (g_mem_bkeep_get_vma_info_upcall(addr, &prot_flags) == 0) {
+        if (g_mem_bkeep_get_vma_info_upcall(addr, &prot_flags, &range_begin, &range_end) == 0) {
             prot_flags &= ~PAL_PROT_LAZYALLOC;
 
             if (((ctx.err & ERRCD_W) && !(prot_flags & PAL_PROT_WRITE)) ||
@@ -546,8 +548,9 @@ void _PalExceptionHandler(uint32_t trusted_exit_info_,
              *
              * This avoids a potential security issue where a malicious host could trick us into
              * committing the page twice (which would effectively allow the host to replace a
-             * lazily-allocated page with 0s) by removing the page and forcing a page fault. */
-            int ret = commit_lazy_alloc_pages(ALLOC_ALIGN_DOWN_PTR(addr), /*count=*/1, prot_flags);
+             * lazily-allocated page with 0s) by removing the page and forcing a page fault. Pages
+             * around the faulting one may be committed as well. */
+            int ret = commit_lazy_alloc_pages_around(addr, range_begin, range_end, prot_flags);
             if (ret < 0) {
                 log_error("failed to lazily allocate page at 0x%lx: %s", addr, pal_strerror(ret));
                 _PalProcessExit(1);
@@ -68,6 +68,15 @@ static int file_open(PAL_HANDLE* handle, const char* type, const char* uri,
 
     hdl->file.fd = fd;
     hdl->file.seekable = !S_ISFIFO(st.st_mode);
+    if (g_pal_linuxsgx_state.zero_copy_file_reads && pal_access == PAL_ACCESS_RDONLY
+            && S_ISREG(st.st_mode)) {
+        /* on failure, the file is simply read via regular preads */
+        PAL_HANDLE umem_lock;
+        if (_PalEventCreate(&umem_lock, /*init_signaled=*/true, /*auto_clear=*/true) == 0) {
+            hdl->file.umem_lock = umem_lock;
+            hdl->file.umem_enabled = true;
+        }
+    }
 
     *handle = hdl;
     return 0;
@@ -79,8 +88,142 @@ fail:
     return ret;
 }
 
+/* Size of the window of a host file mapped in untrusted memory for zero-copy reads. Sequential
+ * reads within one window don't need any enclave exits. */
+#define FILE_UMEM_WINDOW_SIZE (4UL * 1024 * 1024)
+
+struct file_umem {
+    uint64_t refcount; /* one reference is held by the handle while the window is current */
+    void* addr;
+    uint64_t offset;
+    size_t size; /* size of file data in the window */
+};
+
+static void file_umem_lock(PAL_HANDLE handle) {
+    while (_PalEventWait(handle->file.umem_lock, /*timeout=*/NULL) < 0)
+        /* nop */;
+}
+
+static void file_umem_unlock(PAL_HANDLE handle) {
+    _PalEventSet(handle->file.umem_lock);
+}
+
+static void file_umem_put(struct file_umem* umem) {
+    if (__atomic_sub_fetch(&umem->refcount, 1, __ATOMIC_ACQ_REL))
+        return;
+
+    int ret = ocall_munmap_untrusted(umem->addr, ALIGN_UP(umem->size, PAGE_SIZE));
+    if (ret < 0)
+        log_warning("unmapping file window failed: %s", unix_strerror(ret));
+    free(umem);
+}
+
+/* Replaces the current window with the window of the host file which contains `offset`. Nothing is
+ * mapped if `offset` is at or past the end of file. Must be called with `umem_lock` held. */
+static int file_umem_map(PAL_HANDLE handle, uint64_t offset) {
+    if (handle->file.umem) {
+        file_umem_put(handle->file.umem);
+        handle->file.umem = NULL;
+    }
+
+    /* file may have been resized since the last mapping; never map pages past the end of file, as
+     * accessing them results in SIGBUS */
+    struct stat st;
+    int ret = ocall_fstat(handle->file.fd, &st);
+    if (ret < 0)
+        return ret;
+    if (st.st_size < 0 || (uint64_t)st.st_size <= offset)
+        return 0;
+
+    struct file_umem* umem = malloc(sizeof(*umem));
+    if (!umem)
+        return -ENOMEM;
+
+    umem->offset = ALIGN_DOWN(offset, FILE_UMEM_WINDOW_SIZE);
+    umem->size = MIN((uint64_t)st.st_size - umem->offset, FILE_UMEM_WINDOW_SIZE);
+
+    /* no MAP_POPULATE: the host kernel maps pages of the page cache on first access (with its
+     * fault-around), so only the part of the window which is actually read costs anything */
+    ret = ocall_mmap_untrusted(&umem->addr, ALIGN_UP(umem->size, PAGE_SIZE), PROT_READ, MAP_SHARED,
+                               handle->file.fd, umem->offset);
+    if (ret < 0) {
+        free(umem);
+        return ret;
+    }
+
+    umem->refcount = 1;
+    handle->file.umem = umem;
+    return 0;
+}
+
+/*
+ * Reads the file by copying data directly from the host page cache, mapped in untrusted memory, to
+ * the enclave buffer. Compared to `ocall_pread()`, this saves the copy done by the host kernel into
+ * the untrusted buffer, and the enclave exit for each read which hits the currently mapped window.
+ *
+ * Only sequential reads (continuing where the previous one ended) map new windows; other reads
+ * which miss the current window return -EAGAIN, and the caller falls back to `ocall_pread()`.
+ *
+ * Data is always copied into the enclave before it is used (e.g. verified against trusted-file
+ * hashes), so a malicious host changing the mapped data concurrently is not a problem.
+ */
+static int64_t file_read_umem(PAL_HANDLE handle, uint64_t offset, uint64_t count, void* buffer) {
+    int64_t ret = 0;
+    size_t copied = 0;
+
+    while (copied < count) {
+        uint64_t pos = offset + copied;
+
+        file_umem_lock(handle);
+        struct file_umem* umem = handle->file.umem;
+        if (!umem || pos < umem->offset || pos >= umem->offset + umem->size) {
+            uint64_t next_offset = __atomic_load_n(&handle->file.umem_next_offset,
+                                                   __ATOMIC_RELAXED);
+            if (!copied && pos != next_offset) {
+                /* random access; mapping a new window for it would be mostly wasted */
+                file_umem_unlock(handle);
+                return -EAGAIN;
+            }
+            ret = file_umem_map(handle, pos);
+            umem = handle->file.umem;
+            if (ret < 0 || !umem) {
+                file_umem_unlock(handle);
+                break;
+            }
+        }
+        __atomic_add_fetch(&umem->refcount, 1, __ATOMIC_RELAXED);
+        file_umem_unlock(handle);
+
+        size_t size = MIN(count - copied, umem->offset + umem->size - pos);
+        bool ok = sgx_copy_to_enclave(buffer + copied, size, umem->addr + (pos - umem->offset),
+                                      size);
+        file_umem_put(umem);
+        if (!ok) {
+            ret = -EPERM;
+            break;
+        }
+        copied += size;
+    }
+
+    if (copied)
+        __atomic_store_n(&handle->file.umem_next_offset, offset + copied, __ATOMIC_RELAXED);
+    return copied ? (int64_t)copied : ret;
+}
+
 static int64_t file_read(PAL_HANDLE handle, uint64_t offset, uint64_t count, void* buffer) {
     int64_t ret;
+    if (__atomic_load_n(&handle->file.umem_enabled, __ATOMIC_RELAXED)) {
+        ret = file_read_umem(handle, offset, count, buffer);
+        if (ret >= 0)
+            return ret;
+        if (ret != -EAGAIN) {
+            /* e.g. the host file system doesn't support mmap; fall back to regular reads */
+            log_debug("zero-copy read of file %s failed (%s), falling back to pread",
+                      handle->file.realpath, unix_strerror(ret));
+            __atomic_store_n(&handle->file.umem_enabled, false, __ATOMIC_RELAXED);
+        }
+    }
+
     if (handle->file.seekable) {
         ret = ocall_pread(handle->file.fd, buffer, count, offset);
     } else {
@@ -99,9 +242,103 @@ static int64_t file_write(PAL_HANDLE handle, uint64_t offset, uint64_t count, co
     return ret < 0 ? unix_to_pal_error(ret) : ret;
 }
 
+/* The data never enters the enclave, so it is up to LibOS to use this only for unprotected files. */
+static int64_t file_transfer(PAL_HANDLE src_handle, uint64_t src_offset, PAL_HANDLE dst_handle,
+                             uint64_t dst_offset, uint64_t count) {
+    assert(src_handle->hdr.type == PAL_TYPE_FILE);
+
+    if (!src_handle->file.seekable)
+        return PAL_ERROR_NOTSUPPORT;
+
+    int64_t ret;
+    if (dst_handle->hdr.type == PAL_TYPE_FILE) {
+        if (!dst_handle->file.seekable)
+            return PAL_ERROR_NOTSUPPORT;
+        ret = ocall_copy_file_range(src_handle->file.fd, src_offset, dst_handle->file.fd,
+                                    dst_offset, count);
+        /* Old kernels do not support `copy_file_range` at all, or between different filesystems;
+         * some filesystems do not support it either */
+        if (ret == -ENOSYS || ret == -EXDEV || ret == -EINVAL || ret == -EOPNOTSUPP)
+            return PAL_ERROR_NOTSUPPORT;
+    } else if (dst_handle->hdr.type == PAL_TYPE_SOCKET
+                   && dst_handle->sock.type == PAL_SOCKET_TCP) {
+        ret = ocall_sendfile(dst_handle->sock.fd, src_handle->file.fd, src_offset, count);
+        if (ret == -ENOSYS || ret == -EINVAL)
+            return PAL_ERROR_NOTSUPPORT;
+    } else {
+        return PAL_ERROR_NOTSUPPORT;
+    }
+    return ret < 0 ? unix_to_pal_error(ret) : ret;
+}
+
+static void batch_op_set_result(struct pal_batch_op* op, int64_t ret) {
+    if (ret < 0) {
+        op->result = ret;
+    } else {
+        op->count = ret;
+        op->result = 0;
+    }
+}
+
+static void file_batch(struct pal_batch_op* ops, size_t ops_cnt) {
+    struct ocall_batch_io ios[OCALL_BATCH_MAX_ENTRIES];
+    struct pal_batch_op* batched_ops[OCALL_BATCH_MAX_ENTRIES];
+
+    size_t i = 0;
+    while (i < ops_cnt) {
+        /* collect the next group of operations on seekable files; all other operations are cheap
+         * to execute one by one (there are no exits saved on non-seekable files anyway) */
+        size_t ios_cnt = 0;
+        for (; i < ops_cnt && ios_cnt < OCALL_BATCH_MAX_ENTRIES; i++) {
+            struct pal_batch_op* op = &ops[i];
+            if (op->type != PAL_BATCH_OP_READ && op->type != PAL_BATCH_OP_WRITE) {
+                op->result = PAL_ERROR_INVAL;
+                continue;
+            }
+            if (!op->handle->file.seekable) {
+                batch_op_set_result(op, op->type == PAL_BATCH_OP_READ
+                                        ? file_read(op->handle, op->offset, op->count, op->buffer)
+                                        : file_write(op->handle, op->offset, op->count,
+                                                     op->buffer));
+                continue;
+            }
+            ios[ios_cnt] = (struct ocall_batch_io){
+                .is_write = op->type == PAL_BATCH_OP_WRITE,
+                .fd       = op->handle->file.fd,
+                .buf      = op->buffer,
+                .count    = op->count,
+                .offset   = op->offset,
+            };
+            batched_ops[ios_cnt] = op;
+            ios_cnt++;
+        }
+
+        size_t done_cnt = 0;
+        while (done_cnt < ios_cnt) {
+            int ret = ocall_batch_io(&ios[done_cnt], ios_cnt - done_cnt);
+            if (ret < 0) {
+                for (size_t j = done_cnt; j < ios_cnt; j++)
+                    batched_ops[j]->result = unix_to_pal_error(ret);
+                break;
+            }
+            for (size_t j = done_cnt; j < done_cnt + ret; j++) {
+                batch_op_set_result(batched_ops[j], ios[j].result < 0
+                                                    ? unix_to_pal_error(ios[j].result)
+                                                    : ios[j].result);
+            }
+            done_cnt += ret;
+        }
+    }
+}
+
 static void file_destroy(PAL_HANDLE handle) {
     assert(handle->hdr.type == PAL_TYPE_FILE);
 
+    if (handle->file.umem)
+        file_umem_put(handle->file.umem);
+    if (handle->file.umem_lock)
+        _PalObjectDestroy(handle->file.umem_lock);
+
     int ret = ocall_close(handle->file.fd);
     if (ret < 0) {
         log_error("closing file host fd %d failed: %s", handle->file.fd, unix_strerror(ret));
@@ -363,6 +600,8 @@ struct handle_ops g_file_ops = {
     .open           = &file_open,
     .read           = &file_read,
     .write          = &file_write,
+    .batch          = &file_batch,
+    .transfer       = &file_transfer,
     .destroy        = &file_destroy,
     .delete         = &file_delete,
     .setlength      = &file_setlength,
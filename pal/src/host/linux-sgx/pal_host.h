@@ -22,6 +22,8 @@ DEFINE_LIST(pal_handle_thread);
 struct pal_handle_thread {
     PAL_HDR reserved;
     void* tcs;
+    /* TCB of the running thread (for collecting per-thread statistics), NULL if not running */
+    struct pal_enclave_tcb* tcb;
     LIST_TYPE(pal_handle_thread) list;
     void* param;
 };
@@ -49,6 +51,15 @@ typedef struct {
             PAL_IDX fd;
             char* realpath;
             bool seekable; /* regular files are seekable, FIFO pipes are not */
+
+            /* Window of the host file mapped in untrusted memory, for zero-copy sequential reads
+             * (see `sgx.zero_copy_file_reads`). `umem_lock` is a sleeping lock (auto-clear event)
+             * protecting `umem`; the window is refcounted, so data is copied out of it without
+             * holding the lock. `umem_next_offset` is the end of the last read through `umem`. */
+            bool umem_enabled;
+            void* umem_lock;
+            struct file_umem* umem;
+            uint64_t umem_next_offset;
         } file;
 
         struct {
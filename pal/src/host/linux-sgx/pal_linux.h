@@ -35,6 +35,10 @@ extern struct pal_linuxsgx_state {
     bool enclave_initialized;        /* thread creation ECALL is allowed only after this is set */
     bool edmm_enabled;
     bool memfaults_without_exinfo_allowed;
+    uint64_t untrusted_cache_max_size; /* per-thread budget of cached untrusted buffers for OCALLs */
+    bool zero_copy_file_reads;       /* read-only host files are read via untrusted mappings */
+    size_t edmm_fault_around_pages;  /* max pages committed on a lazy allocation page fault */
+    size_t edmm_reclaim_watermark_pages; /* max freed pages kept committed; 0 if freed at once */
     sgx_report_body_t enclave_info;  /* cached self-report result, trusted */
 
     /* remaining heap usable by application */
@@ -70,6 +74,8 @@ noreturn void pal_linux_main(void* uptr_libpal_uri, size_t libpal_uri_len, void*
                              void* uptr_rpc_queue, void* uptr_dns_conf, bool edmm_enabled,
                              void* urts_reserved_mem_ranges, size_t urts_reserved_mem_ranges_size);
 void pal_start_thread(void);
+/* sums up hit/miss statistics of the per-thread caches of untrusted buffers of all threads */
+void get_untrusted_cache_stats(uint64_t* out_hits, uint64_t* out_misses);
 
 extern char __text_start, __text_end, __data_start, __data_end;
 #define TEXT_START ((void*)(&__text_start))
@@ -99,6 +105,8 @@ void init_tsc(void);
 
 int init_cpuid(void);
 
+void init_untrusted_copy(void);
+
 int init_enclave(void);
 
 int init_reserved_ranges(void* urts_ptr, size_t urts_size);
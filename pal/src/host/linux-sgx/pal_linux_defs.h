@@ -39,6 +39,12 @@ static_assert(SSA_XSAVE_SIZE_MAX + /* GPRs size in SSA */176 <= SSA_FRAME_SIZE -
 #define MAX_ARGS_SIZE 10000000
 #define MAX_ENV_SIZE  10000000
 
+/* default per-thread budget of untrusted buffers cached for large OCALLs */
+#define DEFAULT_OCALL_BUFFER_CACHE_SIZE (64 * 1024 * 1024)
+
+/* default maximum size of lazily allocated memory committed on one page fault with EDMM */
+#define DEFAULT_EDMM_FAULT_AROUND_SIZE (256 * 1024)
+
 /*
  * The address should be in untrusted memory (outside of enclave), and should not overlap with the
  * ASan shadow memory area (see `asan.h`) or DBGINFO_ADDR (see `sgx_gdb.h`).
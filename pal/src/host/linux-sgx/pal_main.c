@@ -485,6 +485,8 @@ noreturn void pal_linux_main(void* uptr_libpal_uri, size_t libpal_uri_len, void*
     g_pal_linuxsgx_state.heap_min = GET_ENCLAVE_TCB(heap_min);
     g_pal_linuxsgx_state.heap_max = GET_ENCLAVE_TCB(heap_max);
     g_pal_linuxsgx_state.edmm_enabled = edmm_enabled;
+    /* SGX1 enclave pages are always accessible, page permissions can be changed only with EDMM */
+    g_pal_public_state.memory_protection_enforced = edmm_enabled;
 
     /* No need for adding any initial memory ranges - they are all outside of the available memory
      * set below. */
@@ -600,6 +602,9 @@ noreturn void pal_linux_main(void* uptr_libpal_uri, size_t libpal_uri_len, void*
         ocall_exit(1, /*is_exitgroup=*/true);
     }
 
+    /* select the fastest way to copy bulk data from untrusted memory, must be after init_cpuid() */
+    init_untrusted_copy();
+
     /* initialize master key (used for pipes' encryption for all enclaves of an application); it
      * will be overwritten below in init_child_process() with inherited-from-parent master key if
      * this enclave is child */
@@ -655,6 +660,45 @@ noreturn void pal_linux_main(void* uptr_libpal_uri, size_t libpal_uri_len, void*
         ocall_exit(1, /*is_exitgroup=*/true);
     }
 
+    ret = toml_sizestring_in(g_pal_public_state.manifest_root, "sgx.ocall_buffer_cache_size",
+                             DEFAULT_OCALL_BUFFER_CACHE_SIZE,
+                             &g_pal_linuxsgx_state.untrusted_cache_max_size);
+    if (ret < 0) {
+        log_error("Cannot parse 'sgx.ocall_buffer_cache_size'");
+        ocall_exit(1, /*is_exitgroup=*/true);
+    }
+
+    uint64_t edmm_fault_around_size;
+    ret = toml_sizestring_in(g_pal_public_state.manifest_root, "sgx.edmm_fault_around_size",
+                             DEFAULT_EDMM_FAULT_AROUND_SIZE, &edmm_fault_around_size);
+    if (ret < 0 || !IS_ALIGNED(edmm_fault_around_size, PAGE_SIZE)) {
+        log_error("Cannot parse 'sgx.edmm_fault_around_size' (the value must be a multiple of the "
+                  "page size)");
+        ocall_exit(1, /*is_exitgroup=*/true);
+    }
+    g_pal_linuxsgx_state.edmm_fault_around_pages = MAX(edmm_fault_around_size / PAGE_SIZE,
+                                                       (uint64_t)1);
+
+    uint64_t edmm_reclaim_watermark;
+    ret = toml_sizestring_in(g_pal_public_state.manifest_root, "sgx.edmm_reclaim_watermark",
+                             /*defaultval=*/0, &edmm_reclaim_watermark);
+    if (ret < 0 || !IS_ALIGNED(edmm_reclaim_watermark, PAGE_SIZE)) {
+        log_error("Cannot parse 'sgx.edmm_reclaim_watermark' (the value must be a multiple of the "
+                  "page size)");
+        ocall_exit(1, /*is_exitgroup=*/true);
+    }
+    /* without EDMM, freed enclave memory is never returned to the host anyway */
+    g_pal_linuxsgx_state.edmm_reclaim_watermark_pages = edmm_enabled
+                                                        ? edmm_reclaim_watermark / PAGE_SIZE
+                                                        : 0;
+
+    ret = toml_bool_in(g_pal_public_state.manifest_root, "sgx.zero_copy_file_reads",
+                       /*defaultval=*/false, &g_pal_linuxsgx_state.zero_copy_file_reads);
+    if (ret < 0) {
+        log_error("Cannot parse 'sgx.zero_copy_file_reads'");
+        ocall_exit(1, /*is_exitgroup=*/true);
+    }
+
     int64_t thread_num_int64;
     ret = toml_int_in(g_pal_public_state.manifest_root, "sgx.max_threads",
             /*defaultval=*/-1, &thread_num_int64);
@@ -750,6 +794,7 @@ noreturn void pal_linux_main(void* uptr_libpal_uri, size_t libpal_uri_len, void*
 
     init_handle_hdr(first_thread, PAL_TYPE_THREAD);
     first_thread->thread.tcs = (void*)((uintptr_t)g_enclave_base + GET_ENCLAVE_TCB(tcs_offset));
+    first_thread->thread.tcb = pal_get_enclave_tcb();
     g_pal_public_state.first_thread = first_thread;
     SET_ENCLAVE_TCB(thread, &first_thread->thread);
 
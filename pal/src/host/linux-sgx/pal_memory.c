@@ -115,6 +115,21 @@ int _PalVirtualMemoryProtect(void* addr, uint64_t size, pal_prot_flags_t prot) {
     return 0;
 }
 
+int _PalVirtualMemoryReclaim(void) {
+    if (!g_pal_linuxsgx_state.edmm_reclaim_watermark_pages)
+        return PAL_ERROR_NOTIMPLEMENTED;
+
+    return wait_and_reclaim_pages();
+}
+
+int _PalVirtualMemoryReclaimStatsQuery(struct pal_memory_reclaim_stats* stats) {
+    if (!g_pal_linuxsgx_state.edmm_reclaim_watermark_pages)
+        return PAL_ERROR_NOTIMPLEMENTED;
+
+    get_reclaim_stats(stats);
+    return 0;
+}
+
 uint64_t _PalMemoryQuota(void) {
     return g_pal_linuxsgx_state.heap_max - g_pal_linuxsgx_state.heap_min;
 }
@@ -21,6 +21,7 @@
 #include "pal_internal.h"
 #include "pal_linux.h"
 #include "pal_linux_error.h"
+#include "pal_ocall_types.h"
 #include "pal_sgx.h"
 #include "seqlock.h"
 #include "sgx_arch.h"
@@ -753,6 +754,38 @@ int _PalGetSpecialKey(const char* name, void* key, size_t* key_size) {
     return 0;
 }
 
+int _PalHostCallStatsQuery(struct pal_host_call_stats* stats, size_t* stats_cnt) {
+    if (*stats_cnt < OCALL_NR) {
+        *stats_cnt = OCALL_NR;
+        return PAL_ERROR_INVAL;
+    }
+
+    struct ocall_stats* ocall_stats = malloc(OCALL_NR * sizeof(*ocall_stats));
+    if (!ocall_stats)
+        return PAL_ERROR_NOMEM;
+
+    int ret = ocall_get_ocall_stats(ocall_stats);
+    if (ret < 0) {
+        free(ocall_stats);
+        return unix_to_pal_error(ret);
+    }
+
+    for (size_t i = 0; i < OCALL_NR; i++) {
+        stats[i] = (struct pal_host_call_stats){
+            .calls          = ocall_stats[i].calls,
+            .exitless_calls = ocall_stats[i].exitless_calls,
+            .cycles         = ocall_stats[i].cycles,
+            .max_cycles     = ocall_stats[i].max_cycles,
+            .bytes          = ocall_stats[i].bytes,
+        };
+        snprintf(stats[i].name, sizeof(stats[i].name), "%s", g_ocall_names[i]);
+    }
+    *stats_cnt = OCALL_NR;
+
+    free(ocall_stats);
+    return 0;
+}
+
 ssize_t read_file_buffer(const char* filename, char* buf, size_t buf_size) {
     int fd;
 
@@ -74,6 +74,11 @@ enum {
     OCALL_EDMM_RESTRICT_PAGES_PERM,
     OCALL_EDMM_MODIFY_PAGES_TYPE,
     OCALL_EDMM_REMOVE_PAGES,
+    OCALL_EDMM_AUGMENT_PAGES,
+    OCALL_BATCH,
+    OCALL_GET_OCALL_STATS,
+    OCALL_SENDFILE,
+    OCALL_COPY_FILE_RANGE,
     OCALL_NR,
 };
 
@@ -138,6 +143,21 @@ struct ocall_pwrite {
     off_t offset;
 };
 
+struct ocall_sendfile {
+    int out_fd;
+    int in_fd;
+    off_t offset;
+    size_t count;
+};
+
+struct ocall_copy_file_range {
+    int fd_in;
+    off_t off_in;
+    int fd_out;
+    off_t off_out;
+    size_t count;
+};
+
 struct ocall_fstat {
     int fd;
     struct stat stat;
@@ -363,4 +383,37 @@ struct ocall_edmm_remove_pages {
     size_t count;
 };
 
+struct ocall_edmm_augment_pages {
+    uint64_t addr;
+    size_t count;
+};
+
+/* All fields are 8 bytes, so that every entry in the untrusted array is naturally aligned. */
+struct ocall_batch_entry {
+    uint64_t ocall_index;
+    void* args;
+    long result;
+};
+
+struct ocall_batch {
+    struct ocall_batch_entry* entries;
+    size_t entries_cnt;
+};
+
+/* Statistics of one OCALL type, collected by the untrusted runtime. */
+struct ocall_stats {
+    uint64_t calls;          /* # of calls, including exitless ones */
+    uint64_t exitless_calls; /* # of calls serviced by RPC threads (without enclave exit) */
+    uint64_t cycles;         /* total time spent in the untrusted runtime, in TSC cycles */
+    uint64_t max_cycles;     /* time of the longest call, in TSC cycles */
+    uint64_t bytes;          /* # of bytes read or written by I/O OCALLs */
+};
+
+struct ocall_get_ocall_stats {
+    struct ocall_stats stats[OCALL_NR];
+};
+
 #pragma pack(pop)
+
+/* human-readable names of OCALLs, indexed by OCALL number (see `common_ocall_names.c`) */
+extern const char* const g_ocall_names[OCALL_NR];
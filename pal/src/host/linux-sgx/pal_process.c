@@ -246,6 +246,7 @@ out_error:
 noreturn void _PalProcessExit(int exitcode) {
     if (exitcode)
         log_debug("PalProcessExit: Returning exit code %d", exitcode);
+    log_untrusted_cache_stats();
     ocall_exit(exitcode, /*is_exitgroup=*/true);
     /* Unreachable. */
 }
@@ -15,24 +15,38 @@
  * RPC threads. If user specifies "0" or omits this directive, then no RPC threads are created and
  * all syscalls perform an enclave exit (as in previous versions of Gramine).
  *
- * All enclave and RPC threads work on a single shared RPC queue (global variable `g_rpc_queue`).
- * To issue a syscall, enclave thread enqueues syscall request in the queue and spins waiting for
- * result. RPC threads spin waiting for syscall requests; when request comes, first lucky RPC
- * thread grabs request, issues syscall to OS, and notifies enclave thread by releasing the request
- * lock. RPC queue is implemented as a FIFO ring buffer with one global lock.
+ * Each enclave thread owns a private RPC ring (single producer, multiple consumers) in the shared
+ * RPC queue (global variable `g_rpc_queue`). To issue a syscall, enclave thread pushes syscall
+ * request into its own ring and spins waiting for result. Pushing never takes a lock: the enclave
+ * thread is the only writer of its ring's `head` and slots. RPC threads spin polling the rings;
+ * each RPC thread starts with its "home" ring and steals requests from all other rings, so that
+ * no ring is left unserved when there are fewer RPC threads than enclave threads. The RPC thread
+ * that wins the compare-and-swap on the ring's `tail` grabs the request, issues syscall to OS, and
+ * notifies enclave thread by releasing the request lock.
  *
- * The RPC queue with its ring buffer resides in *untrusted memory*. The enclave code accessing the
- * RPC queue must be carefully written to withstand attacks tampering with the queue.
+ * The RPC queue with its rings resides in *untrusted memory*. The enclave code accessing the RPC
+ * queue must be carefully written to withstand attacks tampering with the queue. All ring fields
+ * accessed by the enclave are 8-byte naturally aligned and are accessed with 8-byte loads/stores.
  *
- * RPC queue can have up to RPC_QUEUE_SIZE requests simultaneously. All requests are allocated on
- * the untrusted stack of the enclave thread; enclave thread owns its requests and pops them off
- * stack when done with the system call. After enqueuing the request, enclave thread first spins
- * for some time in hope the system call returns immediately (fast path), then sleeps waiting on
- * futex (slow path, useful for blocking syscalls).
+ * Rings are claimed lazily by enclave threads on their first exitless OCALL and stay bound to the
+ * TCS of the thread (TCSes are reused by subsequent threads). Each ring can have up to
+ * RPC_RING_SIZE requests simultaneously (more than one request can be in flight only if the thread
+ * issues an OCALL from a nested exception handler). All requests are allocated on the untrusted
+ * stack of the enclave thread; enclave thread owns its requests and pops them off stack when done
+ * with the system call. After enqueuing the request, enclave thread first spins for some time in
+ * hope the system call returns immediately (fast path), then sleeps waiting on futex (slow path,
+ * useful for blocking syscalls). If the ring is full or no ring is available for the thread, the
+ * OCALL falls back to a normal enclave exit.
  *
- * NOTE: number of created RPC threads must match max number of simultaneous enclave threads. If
- * there are more RPC threads, CPU time is wasted. If there are less, some enclave threads may
- * starve, especially if there are many blocking syscalls by other enclave threads.
+ * NOTE: "sgx.insecure__rpc_thread_num" is the maximum number of RPC threads. If there are more
+ * RPC threads than simultaneous enclave threads, CPU time is wasted. If there are less, some
+ * enclave threads may starve, especially if there are many blocking syscalls by other enclave
+ * threads. Thus the untrusted runtime adapts the number of *active* RPC threads to the load: an
+ * RPC thread which is idle for a long time deactivates itself (sleeps on a futex, not polling the
+ * rings) unless that would leave only busy RPC threads, and an inactive RPC thread is woken up
+ * when all active RPC threads become busy with OCALLs. Thus, until the pool is exhausted, some RPC
+ * thread always polls the rings, even if others are blocked in long OCALLs (enclave threads cannot
+ * wake up inactive RPC threads without an enclave exit). See `rpc_thread_loop()` in host_ocalls.c.
  *
  * NOTE: The Exitless feature trades slow OCALLs/ECALLs for fast RPC-queue communication at the
  * cost of occupying more CPU cores and burning more CPU cycles. For example, a single-threaded
@@ -44,20 +58,27 @@
  */
 #pragma once
 
+#include <stdalign.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "spinlock.h"
 
-/* Number of iterations to spin before sleeping. We choose 1M as follows: we want to sleep on
- * blocking syscalls but we want to allow ample time for fast syscalls to complete. We choose
- * 1 millisecond -- more than enough time to complete any non-blocking syscall. Assuming a 1GHz
- * CPU and no pipelining (and ignoring the pause instruction), 1 millisecond is 1M cycles. This
- * works well in practice. */
-#define RPC_SPINLOCK_TIMEOUT 1000000
-
-#define RPC_QUEUE_SIZE  1024 /* max # of requests in RPC queue */
+/* Maximum number of iterations an enclave thread spins waiting for its OCALL before sleeping. We
+ * choose 1M as follows: we want to sleep on blocking syscalls but we want to allow ample time for
+ * fast syscalls to complete. We choose 1 millisecond -- more than enough time to complete any
+ * non-blocking syscall. Assuming a 1GHz CPU and no pipelining (and ignoring the pause instruction),
+ * 1 millisecond is 1M cycles. This works well in practice.
+ *
+ * The actual spin budget is kept per enclave thread and adapts to the OCALLs it issues: it is
+ * halved each time spinning times out (the thread issues blocking syscalls, spinning only burns
+ * CPU) and doubled each time the OCALL completes while spinning, within the below bounds. */
+#define RPC_SPINLOCK_TIMEOUT     1000000UL
+#define RPC_SPINLOCK_TIMEOUT_MIN 10000UL
+
+#define RPC_RING_SIZE   8    /* max # of in-flight requests in one RPC ring, must be power of 2 */
+#define MAX_RPC_RINGS   1024 /* max # of RPC rings, i.e. of enclave threads using exitless */
 #define MAX_RPC_THREADS 256  /* max number of RPC threads */
 
 typedef struct {
@@ -67,90 +88,98 @@ typedef struct {
     void* buffer;
 } rpc_request_t;
 
+/* Per-enclave-thread ring; `head` and `tail` live on separate cache lines so that the enclave
+ * thread publishing new requests does not bounce the line RPC threads are competing on. */
+typedef struct {
+    alignas(64) uint64_t head;       /* next slot to fill, written only by the owner thread */
+    alignas(64) uint64_t tail;       /* next slot to serve, advanced by RPC threads via CAS */
+    rpc_request_t* q[RPC_RING_SIZE]; /* slots with syscall requests */
+} rpc_ring_t;
+
 typedef struct rpc_queue {
-    spinlock_t lock;                  /* global lock for enclave and RPC threads */
-    uint64_t front, rear;             /* indexes into front and rear ends of q */
-    rpc_request_t* q[RPC_QUEUE_SIZE]; /* queue of syscall requests */
+    spinlock_t lock;                  /* protects RPC threads registration, untrusted-only */
     int rpc_threads[MAX_RPC_THREADS]; /* RPC threads (thread IDs) */
     size_t rpc_threads_cnt;           /* number of RPC threads */
+    uint64_t rings_cnt;               /* number of rings claimed by enclave threads (hint for RPC
+                                       * threads, never trusted by the enclave) */
+    rpc_ring_t rings[MAX_RPC_RINGS];  /* per-enclave-thread rings of syscall requests */
 } rpc_queue_t;
 
+static_assert((RPC_RING_SIZE & (RPC_RING_SIZE - 1)) == 0, "RPC_RING_SIZE must be a power of 2");
+
 extern rpc_queue_t* g_rpc_queue;  /* global RPC queue */
 
 static inline void rpc_queue_init(rpc_queue_t* q) {
     spinlock_init(&q->lock);
-    q->front = 0;
-    q->rear  = 0;
-    for (size_t i = 0; i < RPC_QUEUE_SIZE; i++)
-        q->q[i] = NULL;
+    q->rpc_threads_cnt = 0;
+    q->rings_cnt = 0;
+    for (size_t i = 0; i < MAX_RPC_RINGS; i++) {
+        q->rings[i].head = 0;
+        q->rings[i].tail = 0;
+        for (size_t j = 0; j < RPC_RING_SIZE; j++)
+            q->rings[i].q[j] = NULL;
+    }
 }
 
 /*!
- * \brief Enqueue OCALL request `req` in the shared RPC queue `q`.
+ * \brief Enqueue OCALL request `req` in the RPC ring `ring` owned by the current enclave thread.
  *
  * This function is called from the enclave code and thus must be written carefully to withstand
- * attacks tampering with untrusted `req` and untrusted `q`. In particular, `req` and `q` must not
- * have arbitrary pointers (or alternatively the code below must sanitize possible pointer values)
- * to prevent arbitrary writes to/reads from the enclave memory. Similarly, `q->q[idx]` code must
- * ensure that `idx` points inside the `q->q` array to prevent buffer overflows.
+ * attacks tampering with untrusted `req` and untrusted `ring`. In particular, `req` and `ring`
+ * must not have arbitrary pointers (or alternatively the code below must sanitize possible pointer
+ * values) to prevent arbitrary writes to/reads from the enclave memory. Similarly,
+ * `ring->q[idx]` code must ensure that `idx` points inside the `ring->q` array to prevent buffer
+ * overflows.
+ *
+ * Only the owner thread writes `ring->head` and the slots, so no lock is needed; the slot is
+ * published to RPC threads by the release store of the new `head`. A tampered `head` or `tail` can
+ * only make the ring look full (the caller then falls back to a normal OCALL) or make the request
+ * never served (same as a malicious host refusing to serve OCALLs).
  */
-static inline bool rpc_enqueue(rpc_queue_t* q, rpc_request_t* req) {
-    bool ret = false;
-    spinlock_lock(&q->lock);
-
-    if (q->rear - q->front >= RPC_QUEUE_SIZE) {
-        /* queue is full, cannot enqueue */
-        goto out;
-    }
+static inline bool rpc_enqueue(rpc_ring_t* ring, rpc_request_t* req) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
 
-    if (q->q[q->rear % RPC_QUEUE_SIZE]) {
-        /* current slot is occupied, cannot enqueue but the caller can try again */
-        q->rear++;
-        goto out;
+    if (head - tail >= RPC_RING_SIZE) {
+        /* ring is full (or the host tampered with it), cannot enqueue */
+        return false;
     }
 
-    q->q[q->rear % RPC_QUEUE_SIZE] = req;
-    q->rear++;
-    ret = true;
-out:
-    spinlock_unlock(&q->lock);
-    return ret;
+    __atomic_store_n(&ring->q[head % RPC_RING_SIZE], req, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
 }
 
 /*!
- * \brief Dequeue OCALL request `req` from the shared RPC queue `q`.
+ * \brief Dequeue OCALL request from the RPC ring `ring`.
  *
- * This function is called only from the untrusted code and thus has no security implications.
+ * This function is called only from the untrusted code and thus has no security implications. Any
+ * number of RPC threads may call it on the same ring concurrently; the one which advances
+ * `ring->tail` owns the request. The slot is read before the compare-and-swap: the enclave thread
+ * cannot overwrite it until `tail` moves past it, in which case the compare-and-swap fails.
  */
-static inline rpc_request_t* rpc_dequeue(rpc_queue_t* q) {
-    if (__atomic_load_n(&q->front, __ATOMIC_RELAXED) ==
-            __atomic_load_n(&q->rear,  __ATOMIC_RELAXED)) {
-        /* quick check that queue is empty; this doesn't acquire a spinlock and thus lowers latency
-         * on rpc_enqueue() performed by enclave threads (they don't have to wait for spinlock
-         * release); note that untrusted RPC threads will simply retry again if this check fails */
-        return NULL;
-    }
-
-    rpc_request_t* ret = NULL;
-    spinlock_lock(&q->lock);
-
-    if (q->front == q->rear) {
-        /* queue is empty, nothing to dequeue */
-        goto out;
-    }
-
-    if (!q->q[q->front % RPC_QUEUE_SIZE]) {
-        /* current slot is empty, cannot dequeue but the caller can try next one */
-        q->front++;
-        goto out;
+static inline rpc_request_t* rpc_dequeue(rpc_ring_t* ring) {
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    while (tail < __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        rpc_request_t* req = __atomic_load_n(&ring->q[tail % RPC_RING_SIZE], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&ring->tail, &tail, tail + 1, /*weak=*/false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return req;
+        }
+        /* another RPC thread grabbed this request; `tail` now holds the updated value, retry */
     }
+    return NULL;
+}
 
-    ret = q->q[q->front % RPC_QUEUE_SIZE];
-    q->q[q->front % RPC_QUEUE_SIZE] = NULL;
-    q->front++;
-out:
-    spinlock_unlock(&q->lock);
-    return ret;
+/*!
+ * \brief Check whether the RPC ring `ring` has requests not yet grabbed by any RPC thread.
+ *
+ * This function is called only from the untrusted code. The result is only a hint: the requests
+ * may be grabbed by other RPC threads right after the check.
+ */
+static inline bool rpc_ring_pending(rpc_ring_t* ring) {
+    return __atomic_load_n(&ring->tail, __ATOMIC_RELAXED)
+           < __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
 }
 
 int start_rpc(size_t threads_cnt);
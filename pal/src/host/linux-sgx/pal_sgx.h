@@ -22,8 +22,14 @@ typedef struct {
     uintptr_t enclave_base_address; /* base address of the enclave memory space */
     size_t enclave_pages;           /* number of pages in the enclave memory space */
 
+    /* bitvector to store the reclaimable enclave pages (only with `sgx.edmm_reclaim_watermark`):
+     * `1` -- a committed page which was freed but not yet removed from the enclave, so that it can
+     *        be reused by a subsequent allocation or returned to the host by the reclaimer;
+     * `0` -- any other page (a reclaimable page is never lazily-committed) */
+    uint8_t* is_reclaimable;
+
     /* meta bitvector to store the allocation status of the enclave pages used by the
-     * `is_lazily_committed` bitvector:
+     * `is_lazily_committed` and `is_reclaimable` bitvectors (both have the same layout):
      * `1` -- a page of the bitvector is allocated
      * `0` -- a page of the bitvector is unallocated */
     uint8_t* is_bitvector_page_allocated;
@@ -40,4 +46,8 @@ int uncommit_pages(uintptr_t start_addr, size_t page_count);
 int uncommit_then_lazy_realloc_pages(uintptr_t start_addr, size_t page_count);
 int maybe_commit_pages(uintptr_t start_addr, size_t page_count, pal_prot_flags_t prot);
 int commit_lazy_alloc_pages(uintptr_t start_addr, size_t page_count, pal_prot_flags_t prot);
+int commit_lazy_alloc_pages_around(uintptr_t addr, uintptr_t range_begin, uintptr_t range_end,
+                                   pal_prot_flags_t prot);
 int set_committed_pages_permissions(uintptr_t start_addr, size_t page_count, pal_prot_flags_t prot);
+int wait_and_reclaim_pages(void);
+void get_reclaim_stats(struct pal_memory_reclaim_stats* stats);
@@ -164,6 +164,17 @@ static int handle_deserialize(PAL_HANDLE* handle, const void* data, size_t size,
                 free(hdl);
                 return PAL_ERROR_NOMEM;
             }
+            /* mapped window of the file is not inherited, it will be mapped again on first read */
+            hdl->file.umem_lock = NULL;
+            hdl->file.umem = NULL;
+            if (hdl->file.umem_enabled) {
+                PAL_HANDLE umem_lock;
+                if (_PalEventCreate(&umem_lock, /*init_signaled=*/true, /*auto_clear=*/true) < 0) {
+                    hdl->file.umem_enabled = false;
+                } else {
+                    hdl->file.umem_lock = umem_lock;
+                }
+            }
             break;
         }
         case PAL_TYPE_DIR: {
@@ -5,13 +5,16 @@
 #include <stdint.h>
 
 #include "pal.h"
+#include "pal_ocall_types.h"
 #include "sgx_arch.h"
 
+/* number of untrusted buffers cached per thread (see `ocall_mmap_untrusted_cache()`) */
+#define UNTRUSTED_AREA_CACHE_SLOTS 4
+
 struct untrusted_area {
     void* addr;
     size_t size;
-    uint64_t in_use; /* must be uint64_t, because SET_ENCLAVE_TCB() currently supports only 8-byte
-                      * types. TODO: fix this. */
+    uint64_t in_use;
     bool valid;
 };
 
@@ -46,7 +49,16 @@ struct pal_enclave_tcb {
     void*     heap_min;
     void*     heap_max;
     int*      clear_child_tid;
-    struct untrusted_area untrusted_area_cache;
+    struct untrusted_area untrusted_area_cache[UNTRUSTED_AREA_CACHE_SLOTS];
+    /* statistics of `untrusted_area_cache`, see `log_untrusted_cache_stats()` */
+    uint64_t  untrusted_cache_hits;
+    uint64_t  untrusted_cache_misses;
+    uint64_t  rpc_ring_idx; /* 1-based index of the RPC ring claimed by this TCS, 0 if none yet */
+    uint64_t  rpc_spin_budget; /* iterations to spin waiting for exitless OCALL, 0 if unset */
+    /* pages committed on the last lazy allocation page fault of this thread, see
+     * `commit_lazy_alloc_pages_around()` */
+    uint64_t  edmm_fault_around_start;
+    uint64_t  edmm_fault_around_end;
 };
 
 #ifdef IN_ENCLAVE
@@ -102,6 +114,7 @@ typedef struct pal_host_tcb {
     int32_t last_async_event;      /* last async signal, reported to the enclave on ocall return */
     int* start_status_ptr;         /* pointer to return value of clone_thread */
     bool reset_stats;              /* if true, dump SGX stats and reset them on next AEX/OCALL */
+    struct ocall_stats ocall_stats[OCALL_NR]; /* OCALLs of this thread, see `record_ocall_stats()` */
 } PAL_HOST_TCB;
 
 extern void pal_host_tcb_init(PAL_HOST_TCB* tcb, void* stack, void* alt_stack);
@@ -21,6 +21,11 @@ static spinlock_t g_thread_list_lock = INIT_SPINLOCK_UNLOCKED;
 DEFINE_LISTP(pal_handle_thread);
 static LISTP_TYPE(pal_handle_thread) g_thread_list = LISTP_INIT;
 
+/* statistics of the untrusted buffer cache of exited threads (the TCB of an exited thread may be
+ * reused by a new thread); protected by g_thread_list_lock */
+static uint64_t g_exited_untrusted_cache_hits = 0;
+static uint64_t g_exited_untrusted_cache_misses = 0;
+
 struct thread_param {
     int (*callback)(void*);
     void* param;
@@ -131,6 +136,7 @@ void pal_start_thread(void) {
     LISTP_FOR_EACH_ENTRY(tmp, &g_thread_list, list)
         if (!tmp->tcs) {
             new_thread = tmp;
+            new_thread->tcb = pal_get_enclave_tcb();
             __atomic_store_n(&new_thread->tcs,
                              (void*)(g_enclave_base + GET_ENCLAVE_TCB(tcs_offset)),
                              __ATOMIC_RELEASE);
@@ -233,12 +239,21 @@ noreturn void _PalThreadExit(int* clear_child_tid) {
     SET_ENCLAVE_TCB(clear_child_tid, clear_child_tid);
     static_assert(sizeof(*clear_child_tid) == 4, "unexpected clear_child_tid size");
 
+    struct pal_enclave_tcb* tcb = pal_get_enclave_tcb();
+    bool is_first_thread = exiting_thread == &g_pal_public_state.first_thread->thread;
+
+    spinlock_lock(&g_thread_list_lock);
+    g_exited_untrusted_cache_hits += tcb->untrusted_cache_hits;
+    g_exited_untrusted_cache_misses += tcb->untrusted_cache_misses;
+    tcb->untrusted_cache_hits = 0;
+    tcb->untrusted_cache_misses = 0;
+    exiting_thread->tcb = NULL;
     /* main thread is not part of the g_thread_list */
-    if (exiting_thread != &g_pal_public_state.first_thread->thread) {
-        spinlock_lock(&g_thread_list_lock);
+    if (!is_first_thread)
         LISTP_DEL(exiting_thread, &g_thread_list, list);
-        spinlock_unlock(&g_thread_list_lock);
+    spinlock_unlock(&g_thread_list_lock);
 
+    if (!is_first_thread) {
         if (g_pal_linuxsgx_state.edmm_enabled) {
             spinlock_lock(&g_unused_tcs_pages_num_lock);
             g_unused_tcs_pages_num++;
@@ -249,6 +264,30 @@ noreturn void _PalThreadExit(int* clear_child_tid) {
     ocall_exit(0, /*is_exitgroup=*/false);
 }
 
+void get_untrusted_cache_stats(uint64_t* out_hits, uint64_t* out_misses) {
+    spinlock_lock(&g_thread_list_lock);
+    uint64_t hits = g_exited_untrusted_cache_hits;
+    uint64_t misses = g_exited_untrusted_cache_misses;
+
+    struct pal_handle_thread* first_thread = &g_pal_public_state.first_thread->thread;
+    if (first_thread->tcb) {
+        hits += __atomic_load_n(&first_thread->tcb->untrusted_cache_hits, __ATOMIC_RELAXED);
+        misses += __atomic_load_n(&first_thread->tcb->untrusted_cache_misses, __ATOMIC_RELAXED);
+    }
+
+    struct pal_handle_thread* thread;
+    LISTP_FOR_EACH_ENTRY(thread, &g_thread_list, list) {
+        if (!thread->tcb)
+            continue;
+        hits += __atomic_load_n(&thread->tcb->untrusted_cache_hits, __ATOMIC_RELAXED);
+        misses += __atomic_load_n(&thread->tcb->untrusted_cache_misses, __ATOMIC_RELAXED);
+    }
+    spinlock_unlock(&g_thread_list_lock);
+
+    *out_hits = hits;
+    *out_misses = misses;
+}
+
 int _PalThreadResume(PAL_HANDLE thread_handle) {
     int ret = ocall_resume_thread(thread_handle->thread.tcs);
     return ret < 0 ? unix_to_pal_error(ret) : ret;
@@ -103,6 +103,36 @@ static int64_t file_write(PAL_HANDLE handle, uint64_t offset, uint64_t count, co
     return ret < 0 ? unix_to_pal_error(ret) : ret;
 }
 
+static int64_t file_transfer(PAL_HANDLE src_handle, uint64_t src_offset, PAL_HANDLE dst_handle,
+                             uint64_t dst_offset, uint64_t count) {
+    assert(src_handle->hdr.type == PAL_TYPE_FILE);
+
+    if (!src_handle->file.seekable)
+        return PAL_ERROR_NOTSUPPORT;
+
+    int64_t ret;
+    int64_t src_off = src_offset;
+    if (dst_handle->hdr.type == PAL_TYPE_FILE) {
+        if (!dst_handle->file.seekable)
+            return PAL_ERROR_NOTSUPPORT;
+        int64_t dst_off = dst_offset;
+        ret = DO_SYSCALL(copy_file_range, src_handle->file.fd, &src_off, dst_handle->file.fd,
+                         &dst_off, count, /*flags=*/0);
+        /* Old kernels do not support `copy_file_range` at all, or between different filesystems;
+         * some filesystems do not support it either */
+        if (ret == -ENOSYS || ret == -EXDEV || ret == -EINVAL || ret == -EOPNOTSUPP)
+            return PAL_ERROR_NOTSUPPORT;
+    } else if (dst_handle->hdr.type == PAL_TYPE_SOCKET
+                   && dst_handle->sock.type == PAL_SOCKET_TCP) {
+        ret = DO_SYSCALL(sendfile, dst_handle->sock.fd, src_handle->file.fd, &src_off, count);
+        if (ret == -ENOSYS || ret == -EINVAL)
+            return PAL_ERROR_NOTSUPPORT;
+    } else {
+        return PAL_ERROR_NOTSUPPORT;
+    }
+    return ret < 0 ? unix_to_pal_error(ret) : ret;
+}
+
 static void file_destroy(PAL_HANDLE handle) {
     assert(handle->hdr.type == PAL_TYPE_FILE);
 
@@ -356,6 +386,7 @@ struct handle_ops g_file_ops = {
     .open           = &file_open,
     .read           = &file_read,
     .write          = &file_write,
+    .transfer       = &file_transfer,
     .destroy        = &file_destroy,
     .delete         = &file_delete,
     .setlength      = &file_setlength,
@@ -188,6 +188,7 @@ noreturn void pal_linux_main(void* initial_rsp, void* fini_callback) {
     /* Initialize alloc_align as early as possible, a lot of PAL APIs depend on this being set. */
     g_pal_public_state.alloc_align = g_page_size;
     assert(IS_POWER_OF_2(g_pal_public_state.alloc_align));
+    g_pal_public_state.memory_protection_enforced = true;
 
     /* Force stack to grow for at least `THREAD_STACK_SIZE`. `init_memory_bookkeeping()` below
      * requires the stack to be fully present and visible in "/proc/self/maps". */
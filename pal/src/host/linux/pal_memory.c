@@ -68,6 +68,16 @@ int _PalVirtualMemoryProtect(void* addr, size_t size, pal_prot_flags_t prot) {
     return ret < 0 ? unix_to_pal_error(ret) : 0;
 }
 
+/* freed memory is unmapped immediately, the host kernel reclaims it */
+int _PalVirtualMemoryReclaim(void) {
+    return PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _PalVirtualMemoryReclaimStatsQuery(struct pal_memory_reclaim_stats* stats) {
+    __UNUSED(stats);
+    return PAL_ERROR_NOTIMPLEMENTED;
+}
+
 static int read_proc_meminfo(const char* key, unsigned long* val) {
     int fd = DO_SYSCALL(open, "/proc/meminfo", O_RDONLY | O_CLOEXEC, 0);
 
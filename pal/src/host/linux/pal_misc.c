@@ -80,6 +80,12 @@ int _PalGetSpecialKey(const char* name, void* key, size_t* key_size) {
     return PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _PalHostCallStatsQuery(struct pal_host_call_stats* stats, size_t* stats_cnt) {
+    __UNUSED(stats);
+    __UNUSED(stats_cnt);
+    return PAL_ERROR_NOTIMPLEMENTED;
+}
+
 int _PalValidateEntrypoint(const void* buf, size_t size) {
     __UNUSED(buf);
     __UNUSED(size);
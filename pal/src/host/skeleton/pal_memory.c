@@ -22,6 +22,14 @@ int _PalVirtualMemoryProtect(void* addr, uint64_t size, pal_prot_flags_t prot) {
     return PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _PalVirtualMemoryReclaim(void) {
+    return PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _PalVirtualMemoryReclaimStatsQuery(struct pal_memory_reclaim_stats* stats) {
+    return PAL_ERROR_NOTIMPLEMENTED;
+}
+
 unsigned long _PalMemoryQuota(void) {
     return 0;
 }
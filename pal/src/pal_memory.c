@@ -36,6 +36,17 @@ int PalVirtualMemoryProtect(void* addr, size_t size, pal_prot_flags_t prot) {
     return _PalVirtualMemoryProtect(addr, size, prot);
 }
 
+int PalVirtualMemoryReclaim(void) {
+    return _PalVirtualMemoryReclaim();
+}
+
+int PalVirtualMemoryReclaimStatsQuery(struct pal_memory_reclaim_stats* stats) {
+    if (!stats)
+        return PAL_ERROR_INVAL;
+
+    return _PalVirtualMemoryReclaimStatsQuery(stats);
+}
+
 /*
  * Allocator for PAL internal memory.
  * There are a few phases, which differ in how memory is allocated.
@@ -60,7 +71,8 @@ int PalVirtualMemoryProtect(void* addr, size_t size, pal_prot_flags_t prot) {
  */
 static int (*g_mem_bkeep_alloc_upcall)(size_t size, uintptr_t* out_addr) = NULL;
 static int (*g_mem_bkeep_free_upcall)(uintptr_t addr, size_t size) = NULL;
-int (*g_mem_bkeep_get_vma_info_upcall)(uintptr_t addr, pal_prot_flags_t* out_prot_flags) = NULL;
+int (*g_mem_bkeep_get_vma_info_upcall)(uintptr_t addr, pal_prot_flags_t* out_prot_flags,
+                                       uintptr_t* out_begin, uintptr_t* out_end) = NULL;
 
 static bool g_initial_mem_disabled = false;
 static uintptr_t g_last_alloc_addr = UINTPTR_MAX;
@@ -70,7 +82,9 @@ struct pal_initial_mem_range g_initial_mem_ranges[0x100] = { 0 };
 void PalSetMemoryBookkeepingUpcalls(int (*alloc)(size_t size, uintptr_t* out_addr),
                                     int (*free)(uintptr_t addr, size_t size),
                                     int (*get_vma_info)(uintptr_t addr,
-                                                        pal_prot_flags_t* out_prot_flags)) {
+                                                        pal_prot_flags_t* out_prot_flags,
+                                                        uintptr_t* out_begin,
+                                                        uintptr_t* out_end)) {
     if (!FIRST_TIME()) {
         BUG();
     }
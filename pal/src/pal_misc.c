@@ -52,6 +52,10 @@ int PalGetSpecialKey(const char* name, void* key, size_t* key_size) {
     return _PalGetSpecialKey(name, key, key_size);
 }
 
+int PalHostCallStatsQuery(struct pal_host_call_stats* stats, size_t* stats_cnt) {
+    return _PalHostCallStatsQuery(stats, stats_cnt);
+}
+
 void PalGetLazyCommitPages(uintptr_t addr, size_t size, uint8_t* bitvector) {
     if (!addr || !IS_ALLOC_ALIGNED_PTR(addr) || !size || !IS_ALLOC_ALIGNED(size) || !bitvector) {
         BUG();
@@ -197,6 +197,71 @@ int PalStreamWrite(PAL_HANDLE handle, uint64_t offset, size_t* count, void* buff
     return 0;
 }
 
+int PalStreamTransfer(PAL_HANDLE src_handle, uint64_t src_offset, PAL_HANDLE dst_handle,
+                      uint64_t dst_offset, size_t* count) {
+    if (!src_handle || !dst_handle) {
+        return PAL_ERROR_INVAL;
+    }
+
+    const struct handle_ops* ops = HANDLE_OPS(src_handle);
+    if (!ops || !HANDLE_OPS(dst_handle))
+        return PAL_ERROR_BADHANDLE;
+
+    if (!ops->transfer)
+        return PAL_ERROR_NOTSUPPORT;
+
+    int64_t ret = ops->transfer(src_handle, src_offset, dst_handle, dst_offset, *count);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    *count = ret;
+    return 0;
+}
+
+int PalStreamBatch(struct pal_batch_op* ops, size_t ops_cnt) {
+    if (!ops && ops_cnt)
+        return PAL_ERROR_INVAL;
+
+    size_t i = 0;
+    while (i < ops_cnt) {
+        struct pal_batch_op* op = &ops[i];
+        const struct handle_ops* hops = op->handle ? HANDLE_OPS(op->handle) : NULL;
+
+        if (hops && hops->batch) {
+            /* hand over the whole run of operations on handles of the same type */
+            size_t run_cnt = 1;
+            while (i + run_cnt < ops_cnt && ops[i + run_cnt].handle
+                    && HANDLE_OPS(ops[i + run_cnt].handle) == hops)
+                run_cnt++;
+            hops->batch(op, run_cnt);
+            i += run_cnt;
+            continue;
+        }
+
+        int64_t ret;
+        if (!op->handle) {
+            ret = PAL_ERROR_INVAL;
+        } else if (op->type == PAL_BATCH_OP_READ) {
+            ret = _PalStreamRead(op->handle, op->offset, op->count, op->buffer);
+        } else if (op->type == PAL_BATCH_OP_WRITE) {
+            ret = _PalStreamWrite(op->handle, op->offset, op->count, op->buffer);
+        } else {
+            ret = PAL_ERROR_INVAL;
+        }
+
+        if (ret < 0) {
+            op->result = ret;
+        } else {
+            op->count = ret;
+            op->result = 0;
+        }
+        i++;
+    }
+    return 0;
+}
+
 int _PalStreamAttributesQuery(const char* typed_uri, PAL_STREAM_ATTR* attr) {
     char type[URI_PREFIX_MAX_LEN + 1];
     const char* uri;
@@ -15,6 +15,7 @@ import hashlib
 import os
 import pathlib
 import posixpath
+import struct
 import sys
 
 import tomli
@@ -27,6 +28,13 @@ DEFAULT_ENCLAVE_SIZE_NO_EDMM = '256M'
 DEFAULT_ENCLAVE_SIZE_WITH_EDMM = '1024G'  # 1TB; note that DebugInfo is at 1TB and ASan at 1.5TB
 DEFAULT_THREAD_NUM = 4
 
+# Merkle trees of trusted files, must be kept in sync with libos/src/fs/chroot/trusted.c
+TRUSTED_CHUNK_SIZE = 16 * 1024
+MERKLE_TREE_NODE_SIZE = 4096
+MERKLE_TREE_NODE_HASHES = MERKLE_TREE_NODE_SIZE // hashlib.sha256().digest_size
+#: smaller trusted files are cheap to verify on open, so they don't get a Merkle tree
+MERKLE_TREE_MIN_FILE_SIZE = 1024 * 1024
+
 class ManifestError(Exception):
     """Thrown at errors in manifest parsing and handling.
 
@@ -115,23 +123,56 @@ def resolve_symlinks(path, *, chroot, seen=None):
     return inner_current_path
 
 
+def gen_merkle_tree(chunk_hashes, file_size):
+    """Generate Merkle tree of a trusted file.
+
+    See ``libos/src/fs/chroot/trusted.c`` for the description of the format.
+
+    Args:
+        chunk_hashes (list(bytes)): SHA256 hashes of consecutive file chunks (of size
+            :py:data:`TRUSTED_CHUNK_SIZE`)
+        file_size (int): size of the file
+
+    Returns:
+        tuple(str, bytes): the root of the tree as str of hex digits and contents of the tree file
+    """
+    levels = []
+    hashes = chunk_hashes
+    while True:
+        nodes = [b''.join(hashes[i:i + MERKLE_TREE_NODE_HASHES]).ljust(MERKLE_TREE_NODE_SIZE, b'\0')
+            for i in range(0, max(len(hashes), 1), MERKLE_TREE_NODE_HASHES)]
+        levels.append(nodes)
+        if len(nodes) == 1:
+            break
+        hashes = [hashlib.sha256(node).digest() for node in nodes]
+
+    root = hashlib.sha256(struct.pack('<Q', file_size) + levels[-1][0]).hexdigest()
+    return root, b''.join(node for nodes in reversed(levels) for node in nodes)
+
+
 class TrustedFile:
     """Represents a single entry in sgx.trusted_files.
 
     Args:
         uri (str): URI
         sha256 (str or None): sha256
+        merkle_root (str or None): root of the Merkle tree of the file
+        merkle_tree (str or None): URI of the Merkle tree file
         chroot (pathlib.Path or None): optional path to chroot, if being measured in chroot dir
 
     Raises:
         graminelibos.ManifestError: on invalid URI values, or when *chroot* is not None and realpath
             is not absolute
     """
-    def __init__(self, uri, sha256=None, *, chroot=None):
+    def __init__(self, uri, sha256=None, *, merkle_root=None, merkle_tree=None, chroot=None):
         #: URI of the trusted file
         self.uri = uri
         #: sha256 of the trusted file as str of hex digits, or None if not measured
         self.sha256 = sha256
+        #: root of the Merkle tree of the trusted file as str of hex digits, or None if no tree
+        self.merkle_root = merkle_root
+        #: URI of the Merkle tree file, or None if no tree
+        self.merkle_tree = merkle_tree
         #: optional chroot, if the file is to be measured in a subdirectory
         self.chroot = pathlib.Path(chroot) if chroot is not None else chroot
 
@@ -159,19 +200,25 @@ class TrustedFile:
         Raises:
             graminelibos.ManifestError: on errors in data
         """
+        merkle_root, merkle_tree = None, None
+
         if isinstance(data, str):
             uri, sha256 = data, None
 
         elif isinstance(data, dict):
             uri, sha256 = data.pop('uri'), data.pop('sha256', None)
+            merkle_root, merkle_tree = data.pop('merkle_root', None), data.pop('merkle_tree', None)
             if data:
-                # there are some unknown keys left after two .pop()s above
+                # there are some unknown keys left after .pop()s above
                 raise ManifestError(f'Leftover trusted file items: {data!r}')
+            if (merkle_root is None) != (merkle_tree is None):
+                raise ManifestError(
+                    f'Trusted file {uri!r} must have both merkle_root and merkle_tree, or neither')
 
         else:
             raise ManifestError(f'Unknown trusted file format: {data!r}')
 
-        return cls(uri, sha256, chroot=chroot)
+        return cls(uri, sha256, merkle_root=merkle_root, merkle_tree=merkle_tree, chroot=chroot)
 
     @classmethod
     def from_realpath(cls, realpath, *, chroot=None):
@@ -210,26 +257,64 @@ class TrustedFile:
         """
         if self.sha256 is None:
             return self.uri
-        return {
+        data = {
             'uri': self.uri,
             'sha256': self.sha256,
         }
+        if self.merkle_root is not None:
+            data['merkle_root'] = self.merkle_root
+            data['merkle_tree'] = self.merkle_tree
+        return data
 
 
-    def ensure_hash(self):
+    def ensure_hash(self, *, merkle_tree_dir=None):
         """Ensures that the trusted file carries the sha256 sum.
 
         If not, this method will open the file and measure it.
 
+        Args:
+            merkle_tree_dir (pathlib.Path or None): If specified, files of at least
+                :py:data:`MERKLE_TREE_MIN_FILE_SIZE` bytes also get a Merkle tree (unless they
+                already have one), which is written to this directory. The file is then verified
+                lazily at runtime, only the parts actually read. The directory must be accessible
+                under the same path when running Gramine.
+
         Returns:
             TrustedFile: self
+
+        Raises:
+            graminelibos.ManifestError: when the file does not match the sha256 sum already present
         """
+        want_tree = (merkle_tree_dir is not None and self.merkle_root is None
+            and self.realpath.is_file()
+            and self.realpath.stat().st_size >= MERKLE_TREE_MIN_FILE_SIZE)
+
+        if self.sha256 is not None and not want_tree:
+            return self
+
+        with open(self.realpath, 'rb') as file:
+            sha = hashlib.sha256()
+            chunk_hashes = []
+            for chunk in iter(lambda: file.read(TRUSTED_CHUNK_SIZE), b''):
+                sha.update(chunk)
+                if want_tree:
+                    chunk_hashes.append(hashlib.sha256(chunk).digest())
+            file_size = file.tell()
+
         if self.sha256 is None:
-            with open(self.realpath, 'rb') as file:
-                sha = hashlib.sha256()
-                for chunk in iter(lambda: file.read(128 * sha.block_size), b''):
-                    sha.update(chunk)
-                self.sha256 = sha.hexdigest()
+            self.sha256 = sha.hexdigest()
+        elif self.sha256 != sha.hexdigest():
+            raise ManifestError(f'Trusted file {self.uri!r} does not match its sha256 value')
+
+        if want_tree:
+            merkle_root, tree = gen_merkle_tree(chunk_hashes, file_size)
+            merkle_tree_dir = pathlib.Path(merkle_tree_dir)
+            merkle_tree_dir.mkdir(parents=True, exist_ok=True)
+            tree_path = merkle_tree_dir / f'{merkle_root}.merkle'
+            tree_path.write_bytes(tree)
+            self.merkle_root = merkle_root
+            self.merkle_tree = f'file:{tree_path}'
+
         return self
 
 
@@ -402,7 +487,7 @@ class Manifest:
 
         return GramineManifestSchema(self._manifest)
 
-    def expand_all_trusted_files(self, chroot=None):
+    def expand_all_trusted_files(self, chroot=None, merkle_tree_dir=None):
         """Expand all trusted files entries.
 
         Collects all trusted files entries, hashes each of them (skipping these which already had a
@@ -413,6 +498,8 @@ class Manifest:
         Args:
             chroot (pathlib.Path or None): Optional chroot directory. If specified, trusted files
                 are expected to be found inside this directory, not in root of filesystem.
+            merkle_tree_dir (pathlib.Path or None): Optional directory for Merkle trees of large
+                trusted files, see :py:meth:`TrustedFile.ensure_hash`.
 
         Raises:
             graminelibos.ManifestError: There was an error with the format of some trusted files in
@@ -438,7 +525,7 @@ class Manifest:
                 trusted_files[tf.uri] = tf
 
         for tf in trusted_files.values():
-            tf.ensure_hash()
+            tf.ensure_hash(merkle_tree_dir=merkle_tree_dir)
 
         self['sgx']['trusted_files'] = [tf.to_manifest() for tf in trusted_files.values()]
         return [tf.realpath for tf in trusted_files.values()]
@@ -30,6 +30,7 @@ _fs_base = (
         Required('type'): 'encrypted',
         Required('uri'): _uri,
         'key_name': str,
+        'cache_size': _size,
     },
     {
         Required('type'): 'tmpfs',
@@ -50,6 +51,7 @@ GramineManifestSchema = Schema({
         'root': _fs_root,
         'start_dir': str,
         'insecure__keys': {str: str},
+        'experimental__enable_lazy_mmap': bool,
     },
 
     Required('libos'): {
@@ -81,6 +83,8 @@ GramineManifestSchema = Schema({
         },
         'debug': bool,
         'edmm_enable': bool,
+        'edmm_fault_around_size': _size,
+        'edmm_reclaim_watermark': _size,
         'enable_stats': bool,
         'enclave_size': _size,
         'file_check_policy': Any('strict', 'allow_all_but_log'),
@@ -89,6 +93,7 @@ GramineManifestSchema = Schema({
         'isvprodid': int,
         'isvsvn': int,
         'max_threads': int,
+        'ocall_buffer_cache_size': _size,
         'preheat_enclave': bool,
         'profile': {
             'enable': Any('none', 'main', 'all'),
@@ -103,9 +108,13 @@ GramineManifestSchema = Schema({
             'misc_mask': _mask32,
         },
         # TODO: validator for sha256
-        'trusted_files': [Any(str, {'uri': _uri, 'sha256': str})],
+        'trusted_files': [Any(str, {'uri': _uri, 'sha256': str, 'merkle_root': str,
+            'merkle_tree': _uri})],
+        'trusted_files_cache_size': _size,
         'use_exinfo': bool,
+        'use_io_uring': bool,
         'vtune_profile': bool,
+        'zero_copy_file_reads': bool,
     },
 
     'sys': {
@@ -38,6 +38,11 @@ class TestConfig:
 
     - `libc`: name of the libc to build against, currently supported: 'glibc' (default), 'musl'
 
+    - `templates`: table mapping manifest names to names of templates to build them from (without
+      the `.manifest.template` suffix), for several manifests sharing one template parametrized by
+      `entrypoint`; by default, `NAME.manifest.template` is used, or `manifest.template` if it
+      doesn't exist
+
     Ninja handles the following targets:
 
     - `NAME.manifest`, `NAME.manifest.sgx`, `NAME.sig`
@@ -67,6 +72,8 @@ class TestConfig:
 
         self.libc = data.get('libc', 'glibc')
 
+        self.templates = data.get('templates', {})
+
         self.no_check = data.get('gramine-manifest-no-check', False)
 
         self.arch_libdir = _CONFIG_SYSLIBDIR
@@ -178,7 +185,7 @@ class TestConfig:
         ninja.newline()
 
         for name in self.all_manifests:
-            template = f'{name}.manifest.template'
+            template = f'{self.templates.get(name, name)}.manifest.template'
             if not os.path.exists(template):
                 template = 'manifest.template'
 